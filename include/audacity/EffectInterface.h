@@ -129,6 +129,13 @@ public:
    virtual sampleCount GetLatency() = 0;
    virtual size_t GetTailSize() = 0;
 
+   // True if each output sample depends only on the input at the same time,
+   // with no latency and no tail, so that ProcessBlock may be called for
+   // disjoint ranges at once, from several threads, between
+   // ProcessInitialize and ProcessFinalize.  Not pure, so that clients
+   // built before it was added still compile; they are processed serially.
+   virtual bool SupportsIndependentBlocks() { return false; }
+
    virtual bool IsReady() = 0;
    virtual bool ProcessInitialize(sampleCount totalLen, ChannelNames chanMap = NULL) = 0;
    virtual bool ProcessFinalize() = 0;
@@ -1403,6 +1403,12 @@ bool AudacityApp::OnInit()
       exit(0);
    }
 
+   // The block size for NEW projects, unless the command line gives one
+   long blockMegabytes = gPrefs->Read(wxT("/Directories/BlockSizeMB"), 1L);
+   if (blockMegabytes < 1 || blockMegabytes > 16)
+      blockMegabytes = 1;
+   Sequence::SetMaxDiskBlockSize((size_t)blockMegabytes << 20);
+
    long lval;
    if (parser->Found(wxT("b"), &lval))
    {
@@ -300,6 +300,7 @@ writing audio.
 #include "MixerBoard.h"
 #include "Resample.h"
 #include "RingBuffer.h"
+#include "WorkerPool.h"
 #include "prefs/GUISettings.h"
 #include "Prefs.h"
 #include "Project.h"
@@ -1888,6 +1889,17 @@ int AudioIO::StartStream(const ConstWaveTrackArray &playbackTracks,
                                                mRate, floatSample, false);
                mPlaybackMixers[i]->ApplyTrackGains(false);
             }
+
+            // Each track has its own mixer and ring buffer, so the audio
+            // thread can have the tracks mixed in parallel.
+            long mixerThreads = 0;
+            gPrefs->Read(wxT("/AudioIO/MixerThreads"), &mixerThreads, 0L);
+            auto nThreads = mixerThreads > 0
+               ? (size_t)mixerThreads
+               : WorkerPool::GetProcessorCount();
+            nThreads = std::min(nThreads, mPlaybackTracks.size());
+            if (nThreads > 1)
+               mPlaybackMixerPool = std::make_unique<WorkerPool>(nThreads);
          }
 
          if( mNumCaptureChannels > 0 )
@@ -2095,6 +2107,8 @@ void AudioIO::StartStreamCleanup(bool bOnlyBuffers)
       mPlaybackBuffers = NULL;
    }
 
+   mPlaybackMixerPool.reset();
+
    if(mPlaybackMixers)
    {
       for (unsigned int i = 0; i < mPlaybackTracks.size(); i++)
@@ -2443,6 +2457,8 @@ void AudioIO::StopStream()
 
       if (mPlaybackTracks.size() > 0)
       {
+         mPlaybackMixerPool.reset();
+
          for (unsigned int i = 0; i < mPlaybackTracks.size(); i++)
          {
             delete mPlaybackBuffers[i];
@@ -3518,14 +3534,15 @@ void AudioIO::FillBuffers()
             if (!progress)
                frames = available;
 
-            for (i = 0; i < mPlaybackTracks.size(); i++)
+            // The tracks don't share mixers or ring buffers, so they can be
+            // mixed in parallel.  ForEach returns when all are done.
+            const auto mixTrack = [&](size_t ii)
             {
                // The mixer here isn't actually mixing: it's just doing
                // resampling, format conversion, and possibly time track
                // warping
-               decltype(mPlaybackMixers[i]->Process(frames))
+               decltype(mPlaybackMixers[ii]->Process(frames))
                   processed = 0;
-               samplePtr warpedSamples;
                //don't do anything if we have no length.  In particular, Process() will fail an wxAssert
                //that causes a crash since this is not the GUI thread and wxASSERT is a GUI call.
 
@@ -3538,14 +3555,12 @@ void AudioIO::FillBuffers()
 
                if (progress && !silent && frames > 0)
                {
-                  processed = mPlaybackMixers[i]->Process(frames);
-                  wxASSERT(processed <= frames);
-                  warpedSamples = mPlaybackMixers[i]->GetBuffer();
-                  const auto put = mPlaybackBuffers[i]->Put
-                     (warpedSamples, floatSample, processed);
-                  // wxASSERT(put == processed);
+                  // The mixer writes straight into the ring buffer's
+                  // free space, rather than into its own buffer first
+                  processed =
+                     mPlaybackMixers[ii]->Process(frames, &mPlaybackBuffers[ii]);
+                  // wxASSERT(processed <= frames);
                   // but we can't assert in this thread
-                  wxUnusedVar(put);
                }
                
                //if looping and processed is less than the full chunk/block/buffer that gets pulled from
@@ -3557,15 +3572,22 @@ void AudioIO::FillBuffers()
                // numbers of samples for all channels for this pass of the do-loop.
                if(processed < frames && mPlayMode != PLAY_STRAIGHT)
                {
-                  mSilentBuf.Resize(frames, floatSample);
-                  ClearSamples(mSilentBuf.ptr(), floatSample, 0, frames);
-                  const auto put = mPlaybackBuffers[i]->Put
-                     (mSilentBuf.ptr(), floatSample, frames - processed);
-                  // wxASSERT(put == frames - processed);
+                  // Write the silence in place
+                  const auto regions =
+                     mPlaybackBuffers[ii]->GetWritableRegions(frames - processed);
+                  for (const auto &region : regions)
+                     ClearSamples(region.ptr, floatSample, 0, region.len);
+                  mPlaybackBuffers[ii]->Produced(regions.Total());
+                  // wxASSERT(regions.Total() == frames - processed);
                   // but we can't assert in this thread
-                  wxUnusedVar(put);
                }
-            }
+            };
+
+            if (mPlaybackMixerPool)
+               mPlaybackMixerPool->ForEach(mPlaybackTracks.size(), mixTrack);
+            else
+               for (i = 0; i < mPlaybackTracks.size(); i++)
+                  mixTrack(i);
 
             available -= frames;
             wxASSERT(available >= 0);
@@ -3654,6 +3676,8 @@ void AudioIO::FillBuffers()
 
             if( mFactor == 1.0 )
             {
+               // Copy the samples out first, so that the ring buffer space
+               // is free for the callback while Append is writing blocks
                SampleBuffer temp(avail, trackFormat);
                const auto got =
                   mCaptureBuffers[i]->Get(temp.ptr(), trackFormat, avail);
@@ -4593,6 +4617,31 @@ int audacityAudioCallback(const void *inputBuffer, void *outputBuffer,
 
          if (len > 0) {
             for(unsigned t = 0; t < numCaptureChannels; t++) {
+               RingBuffer *captureBuffer = gAudioIO->mCaptureBuffers[t];
+
+               // When the ring buffer has the same format as the device,
+               // un-interleave directly into its free space.
+               if (captureBuffer->GetFormat() == gAudioIO->mCaptureFormat &&
+                   gAudioIO->mCaptureFormat != int24Sample) {
+                  const auto regions = captureBuffer->GetWritableRegions(len);
+                  size_t frame = 0;
+                  for (const auto &region : regions) {
+                     if (gAudioIO->mCaptureFormat == floatSample) {
+                        const float *inputFloats = (const float *)inputBuffer;
+                        float *dest = (float *)region.ptr;
+                        for (size_t j = 0; j < region.len; j++, frame++)
+                           dest[j] = inputFloats[numCaptureChannels*frame+t];
+                     }
+                     else {
+                        const short *inputShorts = (const short *)inputBuffer;
+                        short *dest = (short *)region.ptr;
+                        for (size_t j = 0; j < region.len; j++, frame++)
+                           dest[j] = inputShorts[numCaptureChannels*frame+t];
+                     }
+                  }
+                  captureBuffer->Produced(regions.Total());
+                  continue;
+               }
 
                // dmazzoni:
                // Un-interleave.  Ugly special-case code required because the
@@ -50,6 +50,7 @@ class Mixer;
 class Resample;
 class TimeTrack;
 class AudioThread;
+class WorkerPool;
 class Meter;
 class SelectedRegion;
 class TimeTrack;
@@ -562,6 +563,8 @@ private:
    ConstWaveTrackArray mPlaybackTracks;
 
    Mixer             **mPlaybackMixers;
+   // Null when the tracks are mixed on the audio thread alone
+   std::unique_ptr<WorkerPool> mPlaybackMixerPool;
    volatile int        mStreamToken;
    static int          mNextStreamToken;
    double              mFactor;
@@ -631,8 +634,6 @@ private:
    double              mCutPreviewGapStart;
    double              mCutPreviewGapLen;
 
-   GrowableSampleBuffer mSilentBuf;
-
    AudioIOListener*    mListener;
 
    friend class AudioThread;
@@ -30,6 +30,11 @@ recover previous Audacity projects that were closed incorrectly.
 
 #include "WaveTrack.h"
 
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
 enum {
    ID_RECOVER_ALL = 10000,
    ID_RECOVER_NONE,
@@ -428,6 +433,174 @@ XMLTagHandler* RecordingRecoveryHandler::HandleXMLChild(const wxChar *tag)
    return NULL;
 }
 
+////////////////////////////////////////////////////////////////////////////
+/// Journal recovery handler
+
+JournalRecoveryHandler::JournalRecoveryHandler(TrackList &tracks,
+                                               XMLTagHandler &parent,
+                                               const ViewReader &readView)
+: mTracks(tracks)
+, mParent(parent)
+, mReadView(readView)
+{
+   mNumTracks = -1;
+   mValid = false;
+}
+
+JournalRecoveryHandler::~JournalRecoveryHandler()
+{
+   // A replaced version of a track may hold the only references to blocks
+   // of the project as last saved, which recovery does not read otherwise.
+   // Lock those so that their files stay on disk, as the files of blocks
+   // never read do.
+   std::unordered_set<BlockFile*> live;
+   WaveTrackArray tracks = mTracks.GetWaveTrackArray(false);
+   for (const auto track : tracks)
+      for (const auto &clip : track->GetClips())
+         for (const auto &block : *clip->GetSequenceBlockArray())
+            live.insert(block.f.get());
+
+   for (const auto &track : mDropped)
+   {
+      if (track->GetKind() != Track::Wave)
+         continue;
+      for (const auto &clip : static_cast<WaveTrack*>(track.get())->GetClips())
+         for (const auto &block : *clip->GetSequenceBlockArray())
+            if (live.insert(block.f.get()).second)
+               block.f->Lock();
+   }
+}
+
+bool JournalRecoveryHandler::HandleXMLTag(const wxChar *tag,
+                                          const wxChar **attrs)
+{
+   if (wxStrcmp(tag, wxT("journal")) == 0)
+   {
+      // Records count tracks in the order the previous one left them
+      mPrevious.clear();
+      TrackListIterator iter(&mTracks);
+      for (Track *t = iter.First(); t; t = iter.Next())
+         mPrevious.push_back(t);
+      mNext.clear();
+      mNumTracks = -1;
+      mValid = true;
+
+      long nValue;
+      while (*attrs)
+      {
+         const wxChar *attr = *attrs++;
+         const wxChar *value = *attrs++;
+
+         if (!value || !XMLValueChecker::IsGoodString(value))
+            break;
+
+         const wxString strValue = value;
+         if (wxStrcmp(attr, wxT("tracks")) == 0)
+         {
+            if (!XMLValueChecker::IsGoodInt(strValue) || !strValue.ToLong(&nValue) || nValue < 0)
+               return false;
+            mNumTracks = nValue;
+         }
+         else
+            mReadView(attr, value);
+      }
+   }
+   else if (wxStrcmp(tag, wxT("journaltrack")) == 0)
+   {
+      // Either a run of tracks of the previous record, or else a NEW
+      // version of one track as the child
+      long from = -1, count = -1;
+      while (*attrs)
+      {
+         const wxChar *attr = *attrs++;
+         const wxChar *value = *attrs++;
+
+         if (!value)
+            break;
+
+         const wxString strValue = value;
+         long nValue;
+         if (!XMLValueChecker::IsGoodInt(strValue) || !strValue.ToLong(&nValue) || nValue < 0)
+            return false;
+         if (wxStrcmp(attr, wxT("from")) == 0)
+            from = nValue;
+         else if (wxStrcmp(attr, wxT("count")) == 0)
+            count = nValue;
+      }
+
+      if (from >= 0 && count >= 0)
+      {
+         if (from + count > (long)mPrevious.size())
+            mValid = false;
+         else
+            mNext.insert(mNext.end(),
+               mPrevious.begin() + from, mPrevious.begin() + from + count);
+      }
+   }
+
+   return true;
+}
+
+void JournalRecoveryHandler::HandleXMLEndTag(const wxChar *tag)
+{
+   if (wxStrcmp(tag, wxT("journal")) != 0)
+      return;
+
+   // The file may end in a record cut short while it was appended; its
+   // element is then closed early by the decoder.  Go back to the tracks
+   // of the previous record, dropping those this one added.
+   std::unordered_set<Track*> keep(mNext.begin(), mNext.end());
+   if (!mValid || mNumTracks != (long)mNext.size() || keep.size() != mNext.size())
+   {
+      mNext = mPrevious;
+      keep = std::unordered_set<Track*>(mNext.begin(), mNext.end());
+   }
+
+   std::unordered_map<Track*, TrackNodePointer> nodes;
+   for (auto iter = mTracks.begin(); iter != mTracks.end();)
+   {
+      Track *t = iter->get();
+      if (keep.count(t))
+      {
+         nodes[t] = iter;
+         ++iter;
+      }
+      else
+      {
+         mDropped.push_back(std::move(*iter));
+         iter = mTracks.erase(iter);
+      }
+   }
+
+   std::vector<TrackNodePointer> permutation;
+   permutation.reserve(mNext.size());
+   for (const auto t : mNext)
+      permutation.push_back(nodes[t]);
+   mTracks.Permute(permutation);
+}
+
+XMLTagHandler* JournalRecoveryHandler::HandleXMLChild(const wxChar *tag)
+{
+   if (wxStrcmp(tag, wxT("journaltrack")) == 0)
+      return this; // HandleXMLTag also handles <journaltrack>
+
+   if (wxStrcmp(tag, wxT("wavetrack")) == 0 ||
+#ifdef USE_MIDI
+       wxStrcmp(tag, wxT("notetrack")) == 0 ||
+#endif
+       wxStrcmp(tag, wxT("labeltrack")) == 0 ||
+       wxStrcmp(tag, wxT("timetrack")) == 0)
+   {
+      // The project adds the NEW track at the end
+      XMLTagHandler *handler = mParent.HandleXMLChild(tag);
+      if (handler)
+         mNext.push_back(mTracks.back().get());
+      return handler;
+   }
+
+   return NULL;
+}
+
 ///
 /// AutoSaveFile class
 ///
@@ -680,6 +853,26 @@ bool AutoSaveFile::IsEmpty() const
    return mBuffer.GetLength() == 0;
 }
 
+size_t AutoSaveFile::GetLength() const
+{
+   return mDict.GetOutputStreamBuffer()->GetIntPosition() +
+      mBuffer.GetOutputStreamBuffer()->GetIntPosition();
+}
+
+bool AutoSaveFile::IsSameAs(const AutoSaveFile & other) const
+{
+   auto same = [](const wxMemoryOutputStream &a, const wxMemoryOutputStream &b)
+   {
+      wxStreamBuffer *bufA = a.GetOutputStreamBuffer();
+      wxStreamBuffer *bufB = b.GetOutputStreamBuffer();
+      size_t len = bufA->GetIntPosition();
+      return len == bufB->GetIntPosition() &&
+         memcmp(bufA->GetBufferStart(), bufB->GetBufferStart(), len) == 0;
+   };
+
+   return same(mBuffer, other.mBuffer) && same(mDict, other.mDict);
+}
+
 bool AutoSaveFile::Decode(const wxString & fileName)
 {
    char ident[sizeof(AutoSaveIdent)];
@@ -985,3 +1178,193 @@ bool AutoSaveFile::Decode(const wxString & fileName)
 
    return true;
 }
+
+///
+/// AutoSaveJournal class
+///
+
+// After a checkpoint, an auto-save file written whole as before, each
+// auto-save appends one record:
+//
+//    <journal tracks="N" sel0=... (the other view attributes)>
+//       <journaltrack from="i" count="n"/>     tracks i..i+n-1 of the last record
+//       <journaltrack><wavetrack ...>...</wavetrack></journaltrack>
+//       ...
+//    </journal>
+//
+// listing, in order, all N tracks of the project: runs of tracks that did not
+// change since the last record, counted in its order, and each NEW or changed
+// track whole.  Recovery applies a record only if it finds all N, so that a
+// record cut short by a crash is ignored.  Recording recovery appends its
+// <recordingrecovery> elements to the same file in between.
+//
+// When the records grow larger than the checkpoint, the next auto-save writes
+// a NEW checkpoint instead.
+
+const size_t AutoSaveJournal::PieceAllocSize;
+
+AutoSaveJournal::AutoSaveJournal()
+{
+   mLastIdent = 0;
+   Reset();
+}
+
+AutoSaveJournal::~AutoSaveJournal()
+{
+}
+
+void AutoSaveJournal::Reset()
+{
+   mHasCheckpoint = false;
+   mLast.head = std::make_unique<AutoSaveFile>(PieceAllocSize);
+   mLast.tracks.clear();
+   mCheckpointBytes = 0;
+   mRecordBytes = 0;
+}
+
+void AutoSaveJournal::WriteState(TrackList &tracks, State &state)
+{
+   AssignIdents(tracks.GetWaveTrackArray(false));
+   TrackListIterator iter(&tracks);
+   for (Track *t = iter.First(); t; t = iter.Next())
+   {
+      auto stamp = t->GetXMLStamp();
+      auto file = FindTrack(stamp);
+      if (!file)
+      {
+         file = std::make_shared<AutoSaveFile>(PieceAllocSize);
+         t->WriteXML(*file);
+         // The track may have changed while it was written, as when a
+         // block was truncated or an on-demand summary finished; then
+         // do not let the next auto-save take this for it
+         if (t->GetXMLStamp() != stamp)
+            stamp = 0;
+      }
+      state.tracks.push_back({ stamp, file });
+   }
+}
+
+void AutoSaveJournal::AssignIdents(const WaveTrackArray &tracks)
+{
+   for (const auto track : tracks)
+      mLastIdent = std::max(mLastIdent, track->GetAutoSaveIdent());
+
+   std::set<int> idents;
+   for (const auto track : tracks)
+   {
+      if (!idents.insert(track->GetAutoSaveIdent()).second ||
+          track->GetAutoSaveIdent() == 0)
+      {
+         track->SetAutoSaveIdent(++mLastIdent);
+         idents.insert(mLastIdent);
+      }
+   }
+}
+
+std::shared_ptr<AutoSaveFile>
+AutoSaveJournal::FindTrack(unsigned long long stamp) const
+{
+   if (stamp != 0)
+   {
+      for (const auto &piece : mLast.tracks)
+         if (piece.stamp == stamp)
+            return piece.file;
+   }
+   return {};
+}
+
+bool AutoSaveJournal::CanAppend(const State &state) const
+{
+   return mHasCheckpoint && state.head->IsSameAs(*mLast.head);
+}
+
+bool AutoSaveJournal::NeedsCompaction(const AutoSaveFile &record) const
+{
+   return mRecordBytes + record.GetLength() > mCheckpointBytes;
+}
+
+void AutoSaveJournal::Checkpoint(State &state, size_t bytes)
+{
+   mLast.head.swap(state.head);
+   mLast.tracks.swap(state.tracks);
+   mHasCheckpoint = true;
+   mCheckpointBytes = bytes;
+   mRecordBytes = 0;
+}
+
+void AutoSaveJournal::Appended(State &state, const AutoSaveFile &record)
+{
+   mLast.head.swap(state.head);
+   mLast.tracks.swap(state.tracks);
+   mRecordBytes += record.GetLength();
+}
+
+void AutoSaveJournal::WriteTracks(AutoSaveFile &record, const State &state) const
+{
+   const auto &previous = mLast.tracks;
+   const size_t nPrevious = previous.size();
+   std::vector<bool> used(nPrevious, false);
+   size_t expected = 0, runStart = 0, runCount = 0;
+
+   auto endRun = [&]
+   {
+      if (runCount > 0)
+      {
+         record.StartTag(wxT("journaltrack"));
+         record.WriteAttr(wxT("from"), runStart);
+         record.WriteAttr(wxT("count"), runCount);
+         record.EndTag(wxT("journaltrack"));
+         runCount = 0;
+      }
+   };
+
+   // A piece that FindTrack gave is the same one; a track without a stamp
+   // was written again, and is compared by its bytes
+   auto same = [](const Piece &track, const Piece &other)
+   {
+      return track.file == other.file ||
+         (track.stamp == 0 && track.file->IsSameAs(*other.file));
+   };
+
+   for (const auto &track : state.tracks)
+   {
+      // Most tracks are unchanged and where they were, after the track
+      // before; look there first
+      size_t found = nPrevious;
+      if (expected < nPrevious && !used[expected] &&
+          same(track, previous[expected]))
+         found = expected;
+      else
+      {
+         for (size_t ii = 0; ii < nPrevious; ii++)
+         {
+            if (!used[ii] && same(track, previous[ii]))
+            {
+               found = ii;
+               break;
+            }
+         }
+      }
+
+      if (found == nPrevious)
+      {
+         endRun();
+         record.StartTag(wxT("journaltrack"));
+         record.WriteSubTree(*track.file);
+         record.EndTag(wxT("journaltrack"));
+         ++expected;
+         continue;
+      }
+
+      used[found] = true;
+      if (runCount == 0 || found != runStart + runCount)
+      {
+         endRun();
+         runStart = found;
+      }
+      ++runCount;
+      expected = found + 1;
+   }
+
+   endRun();
+}
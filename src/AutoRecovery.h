@@ -12,6 +12,7 @@
 #define __AUDACITY_AUTORECOVERY__
 
 #include "Project.h"
+#include "Track.h"
 
 #include "xml/XMLTagHandler.h"
 #include "xml/XMLWriter.h"
@@ -22,6 +23,9 @@
 #include <wx/hashmap.h>
 #include <wx/mstream.h>
 
+#include <functional>
+#include <vector>
+
 //
 // Show auto recovery dialog if there are projects to recover. Should be
 // called once at Audacity startup.
@@ -62,6 +66,43 @@ private:
    int mAutoSaveIdent;
 };
 
+//
+// XML Handler for a <journal> tag, which changes the tracks read so far to
+// those of a later auto-save; see AutoSaveJournal
+//
+class JournalRecoveryHandler final : public XMLTagHandler
+{
+public:
+   // Reads an attribute of the view from the <journal> tag
+   using ViewReader =
+      std::function<void(const wxChar *attr, const wxChar *value)>;
+
+   // parent is the handler of the <project>, which adds the tracks it reads
+   // to the end of tracks
+   JournalRecoveryHandler(TrackList &tracks, XMLTagHandler &parent,
+                          const ViewReader &readView);
+   ~JournalRecoveryHandler();
+   bool HandleXMLTag(const wxChar *tag, const wxChar **attrs) override;
+   void HandleXMLEndTag(const wxChar *tag) override;
+   XMLTagHandler *HandleXMLChild(const wxChar *tag) override;
+
+private:
+
+   TrackList &mTracks;
+   XMLTagHandler &mParent;
+   ViewReader mReadView;
+
+   // Tracks as of the previous record, which <journaltrack from=...> counts
+   std::vector<Track*> mPrevious;
+   // Tracks of this record, in order
+   std::vector<Track*> mNext;
+   long mNumTracks;
+   bool mValid;
+
+   // Tracks replaced by later records, kept until the recovery is done
+   std::vector<movable_ptr<Track>> mDropped;
+};
+
 ///
 /// AutoSaveFile
 ///
@@ -105,6 +146,10 @@ public:
 
    bool IsEmpty() const;
 
+   // Size of the dictionary and data, as Append writes them
+   size_t GetLength() const;
+   bool IsSameAs(const AutoSaveFile & other) const;
+
    bool Decode(const wxString & fileName);
 
 private:
@@ -120,5 +165,91 @@ private:
    size_t mAllocSize;
 };
 
+///
+/// AutoSaveJournal
+///
+
+// Remembers what the last auto-save wrote, with each track serialized apart,
+// so that the next one may append to the file a <journal> record of only the
+// tracks that changed, instead of writing all the project again.
+class AUDACITY_DLL_API AutoSaveJournal final
+{
+public:
+   // Initial size of the buffers of the pieces
+   static const size_t PieceAllocSize = 4 * 1024;
+
+   // A track serialized, and its Track::GetXMLStamp() when it was
+   struct Piece
+   {
+      unsigned long long stamp;
+      std::shared_ptr<AutoSaveFile> file;
+   };
+   using Pieces = std::vector<Piece>;
+
+   // A project serialized in pieces
+   struct State
+   {
+      // Start tag of the project and the tags, without the view attributes
+      std::unique_ptr<AutoSaveFile> head
+         { std::make_unique<AutoSaveFile>(PieceAllocSize) };
+      Pieces tracks;
+   };
+
+   AutoSaveJournal();
+   ~AutoSaveJournal();
+
+   // Forget the last state, so that the next auto-save is a checkpoint
+   void Reset();
+
+   // Serialize the tracks into state, writing only those that changed since
+   // the last state, and taking what it wrote of the others
+   void WriteState(TrackList &tracks, State &state);
+
+   // Keep the auto-save idents of wave tracks from one auto-save to the
+   // next, so that unchanged tracks serialize the same, but give tracks
+   // without one, or sharing one with a copy, NEW idents
+   void AssignIdents(const WaveTrackArray &tracks);
+
+   // What the last state wrote of a track with the given stamp, to be used
+   // again instead of writing the track; null if the stamp is 0 or unknown.
+   // Call AssignIdents first, because the idents are in the stamps.
+   std::shared_ptr<AutoSaveFile> FindTrack(unsigned long long stamp) const;
+
+   // Whether a record can take the project from the last state to the given
+   // one, which it cannot if anything but the view and the tracks changed
+   bool CanAppend(const State &state) const;
+
+   // Write a <journal> element into record, whose attributes writeView
+   // writes, and which lists the tracks of the given state
+   template<typename ViewWriter>
+   void WriteRecord(AutoSaveFile &record, const State &state,
+                    const ViewWriter &writeView) const
+   {
+      record.StartTag(wxT("journal"));
+      record.WriteAttr(wxT("tracks"), state.tracks.size());
+      writeView(record);
+      WriteTracks(record, state);
+      record.EndTag(wxT("journal"));
+   }
+
+   // Whether appending the record would grow the records larger than the
+   // checkpoint, so that a NEW checkpoint should be written instead
+   bool NeedsCompaction(const AutoSaveFile &record) const;
+
+   // The state was written whole, in a file of the given size; takes the
+   // pieces from state
+   void Checkpoint(State &state, size_t bytes);
+   // The state was appended in the given record; takes the pieces from state
+   void Appended(State &state, const AutoSaveFile &record);
+
+private:
+   void WriteTracks(AutoSaveFile &record, const State &state) const;
+
+   bool mHasCheckpoint;
+   State mLast;
+   size_t mCheckpointBytes;
+   size_t mRecordBytes;
+   int mLastIdent;
+};
 
 #endif
@@ -55,6 +55,7 @@ out.
 
 #include "Internat.h"
 #include "MemoryX.h"
+#include "SummaryPyramid.h"
 
 // msmeyer: Define this to add debug output via printf()
 //#define DEBUG_BLOCKFILE
@@ -86,8 +87,6 @@ SummaryInfo::SummaryInfo(size_t samples)
    totalSummaryBytes = offset256 + (frames256 * bytesPerFrame);
 }
 
-ArrayOf<char> BlockFile::fullSummary;
-
 /// Initializes the base BlockFile data.  The block is initially
 /// unlocked and its reference count is 1.
 ///
@@ -100,18 +99,26 @@ ArrayOf<char> BlockFile::fullSummary;
 /// @param samples  The number of samples this BlockFile contains.
 BlockFile::BlockFile(wxFileNameWrapper &&fileName, size_t samples):
    mLockCount(0),
+   mSerial(++gBlockFileSerial),
    mFileName(std::move(fileName)),
    mLen(samples),
    mSummaryInfo(samples)
 {
    mSilentLog=FALSE;
+   mRenames = 0;
+   mHaveStatistics = false;
+   mSum = mSumSquares = 0.0;
+   mClipCount = 0;
 }
 
 // static
-unsigned long BlockFile::gBlockFileDestructionCount { 0 };
+std::atomic<unsigned long> BlockFile::gBlockFileDestructionCount { 0 };
+std::atomic<unsigned long long> BlockFile::gBlockFileSerial { 0 };
 
 BlockFile::~BlockFile()
 {
+   SummaryPyramidCache::Get().Invalidate(this);
+
    if (!IsLocked() && mFileName.HasName())
       wxRemoveFile(mFileName.GetFullPath());
 
@@ -132,6 +139,23 @@ auto BlockFile::GetFileName() const -> GetFileNameResult
 void BlockFile::SetFileName(wxFileNameWrapper &&name)
 {
    mFileName=std::move(name);
+   ++mRenames;
+}
+
+/// The serial number stands for everything that is fixed when the block is
+/// made; mix in what may change after, so that an auto-save can reuse what
+/// it wrote of a track last time if the stamp of the track is the same.
+unsigned long long BlockFile::GetXMLStamp() const
+{
+   double sum, sumSquares;
+   size_t clipCount;
+   return XMLStamp{}
+      .Add(mSerial)
+      .Add(mLen)
+      .Add(mRenames)
+      .Add(GetKnownStatistics(&sum, &sumSquares, &clipCount))
+      .Add(IsSummaryAvailable())
+      .Get();
 }
 
 
@@ -163,6 +187,24 @@ bool BlockFile::IsLocked()
    return mLockCount > 0;
 }
 
+// Samples of this magnitude or more are counted as clipped.  It is the
+// largest 16 bit value, so that clipping in any of the sample formats counts.
+static const float clipLevel = 32767.0f / 32768.0f;
+
+// static
+void BlockFile::AccumulateStatistics(const float *fbuffer, size_t len,
+                                     double *sum, double *sumSquares,
+                                     size_t *clipCount)
+{
+   for (decltype(len) i = 0; i < len; i++) {
+      const double f = fbuffer[i];
+      *sum += f;
+      *sumSquares += f * f;
+      if (fabs(f) >= clipLevel)
+         ++*clipCount;
+   }
+}
+
 /// Get a buffer containing a summary block describing this sample
 /// data.  This must be called by derived classes when they
 /// are constructed, to allow them to construct their summary data,
@@ -171,8 +213,8 @@ bool BlockFile::IsLocked()
 /// This method also has the side effect of setting the mMin, mMax,
 /// and mRMS members of this class.
 ///
-/// You must not DELETE the returned buffer; it is static to this
-/// method.
+/// The returned buffer belongs to cleanup, so that each call has its
+/// own, and blocks may be made on several threads at once.
 ///
 /// @param buffer A buffer containing the sample data to be analyzed
 /// @param len    The length of the sample data
@@ -180,15 +222,13 @@ bool BlockFile::IsLocked()
 void *BlockFile::CalcSummary(samplePtr buffer, size_t len,
                              sampleFormat format, ArrayOf<char> &cleanup)
 {
-   // Caller has nothing to deallocate
-   cleanup.reset();
-
-   fullSummary.reinit(mSummaryInfo.totalSummaryBytes);
+   cleanup.reinit(mSummaryInfo.totalSummaryBytes);
+   char *fullSummary = cleanup.get();
 
-   memcpy(fullSummary.get(), headerTag, headerTagLen);
+   memcpy(fullSummary, headerTag, headerTagLen);
 
-   float *summary64K = (float *)(fullSummary.get() + mSummaryInfo.offset64K);
-   float *summary256 = (float *)(fullSummary.get() + mSummaryInfo.offset256);
+   float *summary64K = (float *)(fullSummary + mSummaryInfo.offset64K);
+   float *summary256 = (float *)(fullSummary + mSummaryInfo.offset256);
 
    float *fbuffer = new float[len];
    CopySamples(buffer, format,
@@ -198,7 +238,7 @@ void *BlockFile::CalcSummary(samplePtr buffer, size_t len,
 
    delete[] fbuffer;
 
-   return fullSummary.get();
+   return fullSummary;
 }
 
 void BlockFile::CalcSummaryFromBuffer(const float *fbuffer, size_t len,
@@ -296,6 +336,40 @@ void BlockFile::CalcSummaryFromBuffer(const float *fbuffer, size_t len,
 
    mMin = min;
    mMax = max;
+
+   double sum = 0.0, sumSquares = 0.0;
+   size_t clipCount = 0;
+   AccumulateStatistics(fbuffer, len, &sum, &sumSquares, &clipCount);
+   SetStatistics(sum, sumSquares, clipCount);
+}
+
+void BlockFile::SetStatistics(double sum, double sumSquares, size_t clipCount)
+{
+   ODLocker locker{ &mStatisticsMutex };
+   mSum = sum;
+   mSumSquares = sumSquares;
+   mClipCount = clipCount;
+   mHaveStatistics = true;
+}
+
+void BlockFile::CopyStatisticsTo(BlockFile &other) const
+{
+   double sum, sumSquares;
+   size_t clipCount;
+   if (GetKnownStatistics(&sum, &sumSquares, &clipCount))
+      other.SetStatistics(sum, sumSquares, clipCount);
+}
+
+bool BlockFile::GetKnownStatistics(double *outSum, double *outSumSquares,
+                                   size_t *outClipCount) const
+{
+   ODLocker locker{ &mStatisticsMutex };
+   if (!mHaveStatistics)
+      return false;
+   *outSum = mSum;
+   *outSumSquares = mSumSquares;
+   *outClipCount = mClipCount;
+   return true;
 }
 
 static void ComputeMinMax256(float *summary256,
@@ -419,6 +493,39 @@ void BlockFile::GetMinMax(float *outMin, float *outMax, float *outRMS) const
    *outRMS = mRMS;
 }
 
+/// Retrieves the sum, the sum of squares and the number of clipped samples
+/// of a region of this block, by reading the samples.
+///
+/// @param start The offset in this block where the region should begin
+/// @param len   The number of samples to include in the region
+bool BlockFile::GetStatistics(size_t start, size_t len,
+                              double *outSum, double *outSumSquares,
+                              size_t *outClipCount) const
+{
+   *outSum = *outSumSquares = 0.0;
+   *outClipCount = 0;
+
+   if (!IsDataAvailable())
+      return false;
+
+   SampleBuffer blockData(len, floatSample);
+   this->ReadData(blockData.ptr(), floatSample, start, len);
+
+   AccumulateStatistics((const float *)blockData.ptr(), len,
+                        outSum, outSumSquares, outClipCount);
+   return true;
+}
+
+/// Retrieves the sum, the sum of squares and the number of clipped samples
+/// of this entire block, if they are known.  Reading all the samples of a
+/// block that lacks them would cost more than the summaries that callers
+/// use instead.
+bool BlockFile::GetStatistics(double *outSum, double *outSumSquares,
+                              size_t *outClipCount) const
+{
+   return GetKnownStatistics(outSum, outSumSquares, outClipCount);
+}
+
 /// Retrieves a portion of the 256-byte summary buffer from this BlockFile.  This
 /// data provides information about the minimum value, the maximum
 /// value, and the maximum RMS value for every group of 256 samples in the
@@ -498,6 +605,53 @@ bool BlockFile::Read64K(float *buffer,
    return true;
 }
 
+/// Retrieves a portion of one level of the summary pyramid of this
+/// BlockFile.  Each frame is a triple of minimum, maximum and RMS values.
+///
+/// @param level   A SummaryPyramid::Level
+/// @param *buffer The area where the summary information will be
+///                written.  It must be at least len*3 long.
+/// @param start   The offset in frames of the level
+/// @param len     The number of frames to read
+bool BlockFile::ReadSummaryLevel(int level, float *buffer,
+                                 size_t start, size_t len)
+{
+   const bool fine = (level < SummaryPyramid::Level256);
+   auto &cache = SummaryPyramidCache::Get();
+   auto pyramid = cache.Find(this, fine);
+
+   if (!pyramid) {
+      if (fine) {
+         if (!IsDataAvailable())
+            return false;
+         SampleBuffer samples(mLen, floatSample);
+         this->ReadData(samples.ptr(), floatSample, 0, mLen);
+         pyramid = std::make_shared<SummaryPyramid>(
+            (const float *)samples.ptr(), mLen);
+      }
+      else {
+         if (!IsSummaryAvailable())
+            return false;
+         const auto frames256 = (mLen + 255) / 256;
+         // Room for the conversion of two-field summaries in Read256
+         std::vector<float> triples(3 * frames256);
+         if (!this->Read256(triples.data(), 0, frames256))
+            return false;
+         pyramid = std::make_shared<SummaryPyramid>(
+            SummaryPyramid::Level256, std::move(triples), mLen);
+      }
+      cache.Insert(this, fine, pyramid);
+   }
+
+   const auto frames = pyramid->GetFrames(level);
+   start = std::min(start, frames);
+   len = std::min(len, frames - start);
+   memcpy(buffer, pyramid->GetTriples(level) + 3 * start,
+          3 * len * sizeof(float));
+
+   return true;
+}
+
 /// Constructs an AliasBlockFile based on the given information about
 /// the aliased file.
 ///
@@ -629,6 +783,7 @@ bool AliasBlockFile::ReadSummary(void *data)
 void AliasBlockFile::ChangeAliasedFileName(wxFileNameWrapper &&newAliasedFile)
 {
    mAliasedFileName = std::move(newAliasedFile);
+   ++mRenames;
 }
 
 auto AliasBlockFile::GetSpaceUsage() const -> DiskByteCount
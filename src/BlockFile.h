@@ -13,6 +13,7 @@
 #define __AUDACITY_BLOCKFILE__
 
 #include "MemoryX.h"
+#include <atomic>
 #include <wx/string.h>
 #include <wx/ffile.h>
 #include <wx/filename.h>
@@ -26,6 +27,8 @@
 
 #include "ondemand/ODTaskThread.h"
 
+class MappedFile;
+using MappedFilePtr = std::shared_ptr<const MappedFile>;
 
 class SummaryInfo {
  public:
@@ -61,7 +64,8 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
    BlockFile(wxFileNameWrapper &&fileName, size_t samples);
    virtual ~BlockFile();
 
-   static unsigned long gBlockFileDestructionCount;
+   // Blocks may be destroyed on worker threads, as by WriteBehindQueue
+   static std::atomic<unsigned long> gBlockFileDestructionCount;
 
    // Reading
 
@@ -69,6 +73,12 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
    virtual size_t ReadData(samplePtr data, sampleFormat format,
                         size_t start, size_t len) const = 0;
 
+   /// All the samples of the block in place, if it stores them as floats
+   /// in a file that can be mapped; else null.  The pointer is valid while
+   /// holder lives.
+   virtual const float *GetFloatData(MappedFilePtr &holder) const
+   { return nullptr; }
+
    // Other Properties
 
    // Write cache to disk, if it has any
@@ -81,6 +91,8 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
 
    /// Stores a representation of this file in XML
    virtual void SaveXML(XMLWriter &xmlFile) = 0;
+   /// Changes whenever SaveXML would write something different
+   virtual unsigned long long GetXMLStamp() const;
 
    /// Gets the filename of the disk file associated with this BlockFile
    /// (can be empty -- some BlockFiles, like SilentBlockFile, correspond to
@@ -108,6 +120,11 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
    size_t GetLength() const { return mLen; }
    void SetLength(size_t newLen) { mLen = newLen; }
 
+   /// A number that no other BlockFile of this session has.  An edit of a
+   /// sequence makes NEW blocks, so caches can tell an edited block from
+   /// the one it replaced by this, even at the same address.
+   unsigned long long GetSerial() const { return mSerial; }
+
    /// Locks this BlockFile, to prevent it from being moved
    virtual void Lock();
    /// Unlock this BlockFile, allowing it to be moved
@@ -120,10 +137,32 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
                           float *outMin, float *outMax, float *outRMS) const;
    /// Gets extreme values for the entire block
    virtual void GetMinMax(float *outMin, float *outMax, float *outRMS) const;
+   /// Gets the sum and the sum of squares of the samples, and the number of
+   /// them at full scale, for the specified region, reading the samples
+   virtual bool GetStatistics(size_t start, size_t len,
+                              double *outSum, double *outSumSquares,
+                              size_t *outClipCount) const;
+   /// Gets the same for the entire block.  Unlike the float summaries these
+   /// are exact, so they add up over many blocks.  They are found with the
+   /// summary, and saved with simple and alias blocks.  Fails, without
+   /// reading, if they are not known, as for OD data not yet available or
+   /// blocks of older projects; callers fall back to the summaries.
+   virtual bool GetStatistics(double *outSum, double *outSumSquares,
+                              size_t *outClipCount) const;
+   /// Adds the sum, the sum of squares and the number of samples at full
+   /// scale of the buffer to the outputs, as GetStatistics finds them
+   static void AccumulateStatistics(const float *buffer, size_t len,
+                                    double *sum, double *sumSquares,
+                                    size_t *clipCount);
    /// Returns the 256 byte summary data block
    virtual bool Read256(float *buffer, size_t start, size_t len);
    /// Returns the 64K summary data block
    virtual bool Read64K(float *buffer, size_t start, size_t len);
+   /// Returns min, max and RMS triples at a level of the SummaryPyramid,
+   /// which is made from the stored summaries, or from the samples for
+   /// the finest level, and then cached.  Fails if the data it needs are
+   /// not yet available (for OD).
+   bool ReadSummaryLevel(int level, float *buffer, size_t start, size_t len);
 
    /// Returns TRUE if this block references another disk file
    virtual bool IsAlias() const { return false; }
@@ -173,11 +212,20 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
    virtual void *CalcSummary(samplePtr buffer, size_t len,
                              sampleFormat format,
                              // This gets filled, if the caller needs to deallocate.  Else it is null.
+                             // BlockFile's own fills it always.
                              ArrayOf<char> &cleanup);
    // Common, nonvirtual calculation routine for the use of the above
    void CalcSummaryFromBuffer(const float *fbuffer, size_t len,
                               float *summary256, float *summary64K);
 
+   /// For blocks that are built from saved values
+   void SetStatistics(double sum, double sumSquares, size_t clipCount);
+   /// For copies of this block
+   void CopyStatisticsTo(BlockFile &other) const;
+   /// The values to save; false if they are not yet known
+   bool GetKnownStatistics(double *outSum, double *outSumSquares,
+                           size_t *outClipCount) const;
+
    /// Read the summary section of the file.  Derived classes implement.
    virtual bool ReadSummary(void *data) = 0;
 
@@ -187,8 +235,8 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
 
  private:
    int mLockCount;
-
-   static ArrayOf<char> fullSummary;
+   const unsigned long long mSerial;
+   static std::atomic<unsigned long long> gBlockFileSerial;
 
  protected:
    wxFileNameWrapper mFileName;
@@ -196,6 +244,15 @@ class PROFILE_DLL_API BlockFile /* not final, abstract */ {
    SummaryInfo mSummaryInfo;
    float mMin, mMax, mRMS;
    mutable bool mSilentLog;
+   // Counts changes of the names that SaveXML writes, for GetXMLStamp
+   unsigned mRenames;
+
+ private:
+   // Exact statistics of the whole block, if mHaveStatistics
+   mutable ODLock mStatisticsMutex;
+   mutable bool mHaveStatistics;
+   mutable double mSum, mSumSquares;
+   mutable size_t mClipCount;
 };
 
 /// A BlockFile that refers to data in an existing file
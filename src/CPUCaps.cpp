@@ -0,0 +1,92 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  CPUCaps.cpp
+
+*******************************************************************//*!
+
+\file CPUCaps.cpp
+\brief Detects the vector instruction sets of the processor at run time,
+so that code compiled for the baseline can choose faster paths.
+
+  AVX and AVX2 need the operating system to save the YMM registers too,
+  which XGETBV reports; the processor's own flags are not enough.
+
+*//*******************************************************************/
+
+#include "CPUCaps.h"
+
+#ifdef CPUCAPS_X86
+#ifdef _WIN32
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#ifdef CPUCAPS_X86
+
+static void CPUID(unsigned int info[4], unsigned int leaf)
+{
+#ifdef _WIN32
+   __cpuidex((int *)info, leaf, 0);
+#else
+   __cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+// The register state that the operating system saves on context switch
+static unsigned long long XGETBV()
+{
+#ifdef _WIN32
+   return _xgetbv(0);
+#else
+   unsigned int eax, edx;
+   __asm__ __volatile__ ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+   return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+static CPUCaps DetectCPUCaps()
+{
+   CPUCaps caps = {};
+   unsigned int info[4];
+
+   CPUID(info, 0);
+   const unsigned int nIds = info[0];
+   if (nIds < 1)
+      return caps;
+
+   CPUID(info, 1);
+   caps.SSE2  = (info[3] & (1u << 26)) != 0;
+   caps.SSE41 = (info[2] & (1u << 19)) != 0;
+
+   const bool osxsave = (info[2] & (1u << 27)) != 0;
+   // XMM and YMM state both enabled
+   const bool ymm = osxsave && (XGETBV() & 6) == 6;
+   caps.AVX   = ymm && (info[2] & (1u << 28)) != 0;
+   caps.FMA3  = caps.AVX && (info[2] & (1u << 12)) != 0;
+
+   if (nIds >= 7) {
+      CPUID(info, 7);
+      caps.AVX2 = caps.AVX && (info[1] & (1u << 5)) != 0;
+   }
+
+   return caps;
+}
+
+#else
+
+static CPUCaps DetectCPUCaps()
+{
+   return {};
+}
+
+#endif
+
+const CPUCaps &GetCPUCaps()
+{
+   static const CPUCaps caps = DetectCPUCaps();
+   return caps;
+}
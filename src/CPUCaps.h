@@ -0,0 +1,31 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  CPUCaps.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_CPU_CAPS__
+#define __AUDACITY_CPU_CAPS__
+
+#if defined(__i386__) || defined(__x86_64__) || \
+    defined(_M_IX86) || defined(_M_X64)
+#define CPUCAPS_X86 1
+#endif
+
+/// The vector instruction sets that this processor and operating system
+/// support.  All false on processors other than x86.
+struct CPUCaps
+{
+   bool SSE2;
+   bool SSE41;
+   bool AVX;
+   bool AVX2;
+   bool FMA3;
+};
+
+/// Detected once, on first use
+const CPUCaps &GetCPUCaps();
+
+#endif
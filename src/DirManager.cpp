@@ -94,8 +94,11 @@
 #include "blockfile/SimpleBlockFile.h"
 #include "blockfile/SilentBlockFile.h"
 #include "blockfile/PCMAliasBlockFile.h"
+#include "blockfile/MappedFileCache.h"
+#include "blockfile/PCMAliasFileCache.h"
 #include "blockfile/ODPCMAliasBlockFile.h"
 #include "blockfile/ODDecodeBlockFile.h"
+#include "blockfile/WriteBehindQueue.h"
 #include "Internat.h"
 #include "Project.h"
 #include "Prefs.h"
@@ -366,6 +369,20 @@ DirManager::DirManager()
    mLoadingTarget = NULL;
    mLoadingTargetIdx = 0;
    mMaxSamples = ~size_t(0);
+   mMaxDiskBlockSize = Sequence::GetMaxDiskBlockSize();
+
+   // Write NEW block files on other threads, holding at most so many
+   // megabytes of them in memory meanwhile.  Two writers let the disk
+   // have the next file while the last one is finishing.
+   bool writeBehind = true;
+   gPrefs->Read(wxT("/Directories/WriteBehind"), &writeBehind, true);
+   if (writeBehind) {
+      long memory = gPrefs->Read(wxT("/Directories/WriteBehindMemory"), 64l);
+      if (memory < 1)
+         memory = 1;
+      mWriteQueue =
+         std::make_unique<WriteBehindQueue>(2, size_t(memory) << 20);
+   }
 
    // toplevel pool hash is fully populated to begin
    {
@@ -388,6 +405,27 @@ DirManager::DirManager()
 
 DirManager::~DirManager()
 {
+   // Finish writing before the files are let go
+   mWriteQueue.reset();
+
+   // Don't keep the files of a closed project open, but leave those of
+   // other projects cached
+   BlockHash::iterator iter = mBlockFileHash.begin();
+   while (iter != mBlockFileHash.end())
+   {
+      BlockFilePtr b = iter->second.lock();
+      if (b) {
+         if (b->IsAlias()) {
+            auto ab = static_cast< AliasBlockFile * > ( &*b );
+            PCMAliasFileCache::Get().Invalidate(
+               ab->GetAliasedFileName().GetFullPath());
+         }
+         MappedFileCache::Get().Invalidate(
+            b->GetFileName().name.GetFullPath());
+      }
+      ++iter;
+   }
+
    numDirManagers--;
    if (numDirManagers == 0) {
       CleanTempDir();
@@ -454,6 +492,9 @@ bool DirManager::SetProject(wxString& newProjPath, wxString& newProjName, const
    wxString cleanupLoc1=oldLoc;
    wxString cleanupLoc2=projFull;
 
+   // The files are moved below, so they must all exist
+   WaitForWrites();
+
    if (bCreate) {
       if (!wxDirExists(projFull))
          if (!wxMkdir(projFull))
@@ -559,6 +600,7 @@ bool DirManager::SetProject(wxString& newProjPath, wxString& newProjName, const
 
       CleanDir(
          cleanupLoc1, wxEmptyString, _("Cleaning up cache directories"), true);
+      ForgetKnownDirs();
 
       //This destroys the empty dirs of the OD block files, which are yet to come.
       //Dont know if this will make the project dirty, but I doubt it. (mchinen)
@@ -606,6 +648,7 @@ wxString DirManager::GetDataFilesDir() const
 void DirManager::SetLocalTempDir(const wxString &path)
 {
    mytemp = path;
+   ForgetKnownDirs();
 }
 
 wxFileNameWrapper DirManager::MakeBlockFilePath(const wxString &value) {
@@ -619,8 +662,7 @@ wxFileNameWrapper DirManager::MakeBlockFilePath(const wxString &value) {
       wxString subdir=value.Mid(0,location);
       dir.AppendDir(subdir);
 
-      if(!dir.DirExists())
-         dir.Mkdir();
+      MakeDirIfNeeded(dir, 0);
    }
 
    if(value.GetChar(0)==wxT('e')){
@@ -632,7 +674,7 @@ wxFileNameWrapper DirManager::MakeBlockFilePath(const wxString &value) {
       dir.AppendDir(topdir);
       dir.AppendDir(middir);
 
-      if(!dir.DirExists() && !dir.Mkdir(0777,wxPATH_MKDIR_FULL))
+      if(!MakeDirIfNeeded(dir, wxPATH_MKDIR_FULL))
       { // need braces to avoid compiler warning about ambiguous else, see the macro
          wxLogSysError(_("mkdir in DirManager::MakeBlockFilePath failed."));
       }
@@ -640,6 +682,29 @@ wxFileNameWrapper DirManager::MakeBlockFilePath(const wxString &value) {
    return dir;
 }
 
+bool DirManager::MakeDirIfNeeded(const wxFileName &dir, int flags)
+{
+   const wxString path = dir.GetPath();
+   {
+      ODLocker locker{ &mKnownDirsMutex };
+      if (mKnownDirs.count(path))
+         return true;
+   }
+
+   if (!dir.DirExists() && !dir.Mkdir(0777, flags))
+      return false;
+
+   ODLocker locker{ &mKnownDirsMutex };
+   mKnownDirs.insert(path);
+   return true;
+}
+
+void DirManager::ForgetKnownDirs()
+{
+   ODLocker locker{ &mKnownDirsMutex };
+   mKnownDirs.clear();
+}
+
 bool DirManager::AssignFile(wxFileNameWrapper &fileName,
                             const wxString &value,
                             bool diskcheck)
@@ -756,7 +821,7 @@ auto DirManager::GetBalanceInfo() -> BalanceInfo &
    // see whether any block files have disappeared,
    // and if so update
 
-   auto count = BlockFile::gBlockFileDestructionCount;
+   const unsigned long count = BlockFile::gBlockFileDestructionCount;
    if ( mLastBlockFileDestructionCount != count ) {
       auto it = mBlockFileHash.begin(), end = mBlockFileHash.end();
       while (it != end)
@@ -823,6 +888,7 @@ void DirManager::BalanceInfoDel(const wxString &file)
             dir += wxT("d");
             dir += file.Mid(3,2);
             wxFileName::Rmdir(dir);
+            ForgetKnownDirs();
 
             // also need to remove from toplevel
             if(dirTopFull.find(topnum) != dirTopFull.end()){
@@ -943,7 +1009,8 @@ wxFileNameWrapper DirManager::MakeBlockFileName()
 
       baseFileName.Printf(wxT("e%02x%02x%03x"),topnum,midnum,filenum);
 
-      if (!ContainsBlockFile(baseFileName)) {
+      if (!ContainsBlockFile(baseFileName) &&
+          !mPendingBlockFileNames.count(baseFileName)) {
          // not in the hash, good.
          if (!this->AssignFile(ret, baseFileName, true))
          {
@@ -970,13 +1037,29 @@ BlockFilePtr DirManager::NewSimpleBlockFile(
                                  sampleFormat format,
                                  bool allowDeferredWrite)
 {
-   wxFileNameWrapper filePath{ MakeBlockFileName() };
+   // Several importers may make blocks at once (see BatchImporter).  The
+   // name stays reserved until the block is in the hash, and the block,
+   // with its summary and perhaps its file, is made without the lock.
+   wxFileNameWrapper filePath;
+   {
+      ODLocker locker{ &mNewBlockFileMutex };
+      filePath = MakeBlockFileName();
+      mPendingBlockFileNames.insert(filePath.GetName());
+   }
    const wxString fileName{ filePath.GetName() };
 
    auto newBlockFile = make_blockfile<SimpleBlockFile>
-      (std::move(filePath), sampleData, sampleLen, format, allowDeferredWrite);
+      (std::move(filePath), sampleData, sampleLen, format,
+       allowDeferredWrite, false, mWriteQueue != nullptr);
 
-   mBlockFileHash[fileName] = newBlockFile;
+   {
+      ODLocker locker{ &mNewBlockFileMutex };
+      mBlockFileHash[fileName] = newBlockFile;
+      mPendingBlockFileNames.erase(fileName);
+   }
+
+   if (mWriteQueue)
+      mWriteQueue->Enqueue(newBlockFile, sampleLen * SAMPLE_SIZE(format));
 
    return newBlockFile;
 }
@@ -1092,6 +1175,8 @@ BlockFilePtr DirManager::CopyBlockFile(const BlockFilePtr &b)
       //a summary file, so we should check before we copy.
       if(b->IsSummaryAvailable())
       {
+         WaitForWrites();
+
          if( !wxCopyFile(fn.GetFullPath(),
                   newFile.GetFullPath()) )
             return {};
@@ -1236,6 +1321,8 @@ bool DirManager::MoveOrCopyToNewProjectDirectory(BlockFile *f, bool copy)
       auto oldPath = oldFileNameRef.GetFullPath();
       auto newPath = newFileName.GetFullPath();
       if (summaryExisted) {
+         if (!copy)
+            MappedFileCache::Get().Invalidate(oldPath);
          auto success = copy
          ? wxCopyFile(oldPath, newPath)
          : wxRenameFile(oldPath, newPath);
@@ -1267,8 +1354,10 @@ bool DirManager::MoveOrCopyToNewProjectDirectory(BlockFile *f, bool copy)
          if (oldFileName.FileExists())
          {
             bool ok = wxCopyFile(oldPath, newPath);
-            if(ok && !copy)
+            if(ok && !copy) {
+               MappedFileCache::Get().Invalidate(oldPath);
                wxRemoveFile(oldPath);
+            }
             else if (!ok)
                return false;
          }
@@ -1302,6 +1391,9 @@ bool DirManager::EnsureSafeFilename(const wxFileName &fName)
    if (aliasList.Index(fullPath) == wxNOT_FOUND)
       return true;
 
+   // Don't rename files while they are being written
+   WaitForWrites();
+
    /* i18n-hint: 'old' is part of a filename used when a file is renamed. */
    // Figure out what the NEW name for the existing file would be.
    /* i18n-hint: e.g. Try to go from "mysong.wav" to "mysong-old1.wav". */
@@ -1380,6 +1472,10 @@ bool DirManager::EnsureSafeFilename(const wxFileName &fName)
    }
 
    if (needToRename) {
+      // Alias blocks may hold the file open; it can't be renamed on Windows
+      PCMAliasFileCache::Get().Invalidate(fullPath);
+      MappedFileCache::Get().Invalidate(fullPath);
+
       if (!wxRenameFile(fullPath,
                         renamedFullPath))
       {
@@ -1469,6 +1565,9 @@ int DirManager::ProjectFSCK(const bool bForceError, const bool bAutoRecoverMode)
    // so the log always shows all found errors.
 
    int action; // choice of action for each type of error
+
+   // Look only at files that are completely written
+   WaitForWrites();
    int nResult = 0;
 
    if (bForceError && !bAutoRecoverMode)
@@ -1756,6 +1855,7 @@ other projects. \
       // nDirCount is for updating pProgress. +1 because we may DELETE dirPath.
       int nDirCount = RecursivelyCountSubdirs(dirPath) + 1;
       RecursivelyRemoveEmptyDirs(dirPath, nDirCount, &pProgress);
+      ForgetKnownDirs();
    }
 
    // Summarize and flush the log.
@@ -1991,6 +2091,9 @@ void DirManager::FillBlockfilesCache()
 
 void DirManager::WriteCacheToDisk()
 {
+   // Any that failed to be written in the background are tried again below
+   WaitForWrites();
+
    BlockHash::iterator iter;
    int numNeed = 0;
 
@@ -2028,3 +2131,15 @@ void DirManager::WriteCacheToDisk()
    }
 }
 
+void DirManager::WaitForWrites()
+{
+   if (mWriteQueue)
+      mWriteQueue->Wait();
+}
+
+bool DirManager::FlushWrites()
+{
+   if (mWriteQueue)
+      return mWriteQueue->Flush();
+   return true;
+}
@@ -18,7 +18,10 @@
 #include <wx/hashmap.h>
 #include <wx/utils.h>
 
+#include <set>
+
 #include "audacity/Types.h"
+#include "ondemand/ODTaskThread.h"
 #include "xml/XMLTagHandler.h"
 #include "wxFileNameWrapper.h"
 
@@ -26,6 +29,7 @@ class wxHashTable;
 class BlockArray;
 class BlockFile;
 class SequenceTest;
+class WriteBehindQueue;
 
 #define FSCKstatus_CLOSE_REQ 0x1
 #define FSCKstatus_CHANGED   0x2
@@ -113,6 +117,11 @@ class PROFILE_DLL_API DirManager final : public XMLTagHandler {
    // Note: following affects only the loading of block files when opening a project
    void SetLoadingMaxSamples(size_t max) { mMaxSamples = max; }
 
+   // Bytes per block of the sequences made in this project, which starts
+   // as Sequence::GetMaxDiskBlockSize() and is saved with the project
+   void SetMaxDiskBlockSize(size_t bytes) { mMaxDiskBlockSize = bytes; }
+   size_t GetMaxDiskBlockSize() const { return mMaxDiskBlockSize; }
+
    bool HandleXMLTag(const wxChar *tag, const wxChar **attrs);
    XMLTagHandler *HandleXMLChild(const wxChar * WXUNUSED(tag)) { return NULL; }
    void WriteXML(XMLWriter & WXUNUSED(xmlFile)) { wxASSERT(false); } // This class only reads tags.
@@ -166,6 +175,14 @@ class PROFILE_DLL_API DirManager final : public XMLTagHandler {
    // Write all write-cached block files to disc, if any
    void WriteCacheToDisk();
 
+   // Wait until the NEW block files queued to be written in the
+   // background are on disk
+   void WaitForWrites();
+   // Wait for them, then make sure that all the block files written since
+   // the last flush have reached the disk.  Call before saving the project.
+   // Returns false if some block file could not be written or committed.
+   bool FlushWrites();
+
    // Fill cache of blockfiles, if caching is enabled (otherwise do nothing)
    void FillBlockfilesCache();
 
@@ -173,6 +190,10 @@ class PROFILE_DLL_API DirManager final : public XMLTagHandler {
 
    wxFileNameWrapper MakeBlockFileName();
    wxFileNameWrapper MakeBlockFilePath(const wxString &value);
+   // Make the directory unless known to exist; false if that fails
+   bool MakeDirIfNeeded(const wxFileName &dir, int flags);
+   // Call after removing any directory
+   void ForgetKnownDirs();
 
    bool MoveOrCopyToNewProjectDirectory(BlockFile *f, bool copy);
 
@@ -202,6 +223,18 @@ class PROFILE_DLL_API DirManager final : public XMLTagHandler {
 
    wxString lastProject;
 
+   // Block file directories known to exist, so that opening a project
+   // looks on disk once for each directory, not once for each block file
+   std::set<wxString> mKnownDirs;
+   ODLock mKnownDirsMutex;
+
+   // Guards the naming and hashing of NEW simple block files, which
+   // importers may make on several threads at once
+   ODLock mNewBlockFileMutex;
+   // Names given to simple block files still being made, and not yet in
+   // mBlockFileHash; guarded by mNewBlockFileMutex
+   std::set<wxString> mPendingBlockFileNames;
+
    wxArrayString aliasList;
 
    BlockArray *mLoadingTarget;
@@ -210,9 +243,14 @@ class PROFILE_DLL_API DirManager final : public XMLTagHandler {
    size_t mLoadingBlockLen;
 
    size_t mMaxSamples; // max samples per block
+   size_t mMaxDiskBlockSize;
 
    unsigned long mLastBlockFileDestructionCount { 0 };
 
+   // Writes NEW simple block files in the background; null if the
+   // preference turns that off
+   std::unique_ptr<WriteBehindQueue> mWriteQueue;
+
    static wxString globaltemp;
    wxString mytemp;
    static int numDirManagers;
@@ -32,6 +32,10 @@ state. Call Dither::Apply() to apply the dither. You can call
 Reset() between subsequent dithers to reset the dither state
 and get deterministic behaviour.
 
+Contiguous samples are converted with the SampleConverters for the
+processor's best vector instructions, when it has any.  Shaped dither
+and interleaved samples take the scalar loops below.
+
 *//*******************************************************************/
 
 
@@ -208,6 +212,14 @@ Dither::Dither()
 {
     // On startup, initialize dither by resetting values
     Reset();
+
+    SetVectorLevel(SampleConverters::GetBestLevel());
+    mSIMDState.Seed(1);
+}
+
+void Dither::SetVectorLevel(SampleConverters::VectorLevel level)
+{
+    mConverters = SampleConverters::Get(level);
 }
 
 void Dither::Reset()
@@ -256,6 +268,11 @@ void Dither::Apply(enum DitherType ditherType,
     if (len == 0)
         return; // nothing to do
 
+    if (mConverters && sourceStride == 1 && destStride == 1 &&
+        ApplyVectorized(ditherType, source, sourceFormat,
+                        dest, destFormat, len))
+        return;
+
     if (destFormat == sourceFormat)
     {
         // No need to dither, because source and destination
@@ -345,6 +362,63 @@ void Dither::Apply(enum DitherType ditherType,
     }
 }
 
+// Returns false if there is no vectorized converter for the formats and
+// dither, and then does nothing
+bool Dither::ApplyVectorized(enum DitherType ditherType,
+                             const samplePtr source, sampleFormat sourceFormat,
+                             samplePtr dest, sampleFormat destFormat,
+                             unsigned int len)
+{
+    const auto &c = *mConverters;
+
+    if (destFormat == sourceFormat)
+        return false; // memcpy is as good
+
+    if (destFormat == floatSample)
+    {
+        if (sourceFormat == int16Sample)
+            c.Int16ToFloat((const short*)source, (float*)dest, len);
+        else if (sourceFormat == int24Sample)
+            c.Int24ToFloat((const int*)source, (float*)dest, len);
+        else
+            return false;
+        return true;
+    }
+
+    if (destFormat == int24Sample && sourceFormat == int16Sample)
+    {
+        c.Int16ToInt24((const short*)source, (int*)dest, len);
+        return true;
+    }
+
+    int index;
+    switch (ditherType)
+    {
+    case none:
+        index = SampleConverters::NoDither;
+        break;
+    case rectangle:
+        index = SampleConverters::RectangleDither;
+        break;
+    case triangle:
+        mSIMDState.triangle = 0; // as Reset() does for the scalar dither
+        index = SampleConverters::TriangleDither;
+        break;
+    default:
+        return false; // shaped dither is inherently serial
+    }
+
+    if (sourceFormat == int24Sample && destFormat == int16Sample)
+        c.Int24ToInt16[index]((const int*)source, (short*)dest, len, mSIMDState);
+    else if (sourceFormat == floatSample && destFormat == int16Sample)
+        c.FloatToInt16[index]((const float*)source, (short*)dest, len, mSIMDState);
+    else if (sourceFormat == floatSample && destFormat == int24Sample)
+        c.FloatToInt24[index]((const float*)source, (int*)dest, len, mSIMDState);
+    else
+        return false;
+    return true;
+}
+
 // Dither implementations
 
 // No dither, just return sample
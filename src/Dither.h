@@ -11,6 +11,7 @@
 #define __AUDACITY_DITHER_H__
 
 #include "SampleFormat.h"
+#include "SampleFormatSIMD.h"
 
 
 class Dither
@@ -25,6 +26,11 @@ public:
     /// Reset state of the dither.
     void Reset();
 
+    /// Which vectorized converters to use for samples with strides of 1;
+    /// Scalar or a level the processor lacks means none.  By default the
+    /// best that the processor has.
+    void SetVectorLevel(SampleConverters::VectorLevel level);
+
     /// Apply the actual dithering. Expects the source sample in the
     /// 'source' variable, the destination sample in the 'dest' variable,
     /// and hints to the formats of the samples. Even if the sample formats
@@ -37,6 +43,11 @@ public:
                unsigned int destStride = 1);
 
 private:
+    bool ApplyVectorized(DitherType ditherType,
+               const samplePtr source, sampleFormat sourceFormat,
+               samplePtr dest, sampleFormat destFormat,
+               unsigned int len);
+
     // Dither methods
     float NoDither(float sample);
     float RectangleDither(float sample);
@@ -52,6 +63,10 @@ private:
     int mPhase;
     float mTriangleState;
     float mBuffer[8 /* = BUF_SIZE */];
+
+    // Null if not vectorizing
+    const SampleConverters *mConverters;
+    SIMDDitherState mSIMDState;
 };
 
 #endif /* __AUDACITY_DITHER_H__ */
@@ -41,6 +41,7 @@ a draggable point type.
 #include "AColor.h"
 #include "DirManager.h"
 #include "TrackArtist.h"
+#include "xml/XMLWriter.h"
 
 Envelope::Envelope()
 {
@@ -299,6 +300,15 @@ void Envelope::WriteXML(XMLWriter &xmlFile) const
    xmlFile.EndTag(wxT("envelope"));
 }
 
+unsigned long long Envelope::GetXMLStamp() const
+{
+   XMLStamp stamp;
+   stamp.Add(mEnv.size());
+   for (const auto &point : mEnv)
+      stamp.AddDouble(point.GetT()).AddDouble(point.GetVal());
+   return stamp.Get();
+}
+
 namespace
 {
 inline int SQR(int x) { return x * x; }
@@ -1011,22 +1021,26 @@ void Envelope::BinarySearchForTime( int &Lo, int &Hi, double t ) const
 
    // Optimizations for the usual pattern of repeated calls with
    // small increases of t.
+   // Work on a copy of the guess: a time track envelope is read by the
+   // playback mixers of several tracks at once.
    {
-      if (mSearchGuess >= 0 && mSearchGuess < (int)(mEnv.size()) - 1) {
-         if (t >= mEnv[mSearchGuess].GetT() &&
-            t < mEnv[1 + mSearchGuess].GetT()) {
-            Lo = mSearchGuess;
-            Hi = 1 + mSearchGuess;
+      int guess = mSearchGuess.load(std::memory_order_relaxed);
+      if (guess >= 0 && guess < (int)(mEnv.size()) - 1) {
+         if (t >= mEnv[guess].GetT() &&
+            t < mEnv[1 + guess].GetT()) {
+            Lo = guess;
+            Hi = 1 + guess;
             return;
          }
       }
 
-      ++mSearchGuess;
-      if (mSearchGuess >= 0 && mSearchGuess < (int)(mEnv.size()) - 1) {
-         if (t >= mEnv[mSearchGuess].GetT() &&
-            t < mEnv[1 + mSearchGuess].GetT()) {
-            Lo = mSearchGuess;
-            Hi = 1 + mSearchGuess;
+      ++guess;
+      if (guess >= 0 && guess < (int)(mEnv.size()) - 1) {
+         if (t >= mEnv[guess].GetT() &&
+            t < mEnv[1 + guess].GetT()) {
+            Lo = guess;
+            Hi = 1 + guess;
+            mSearchGuess.store(guess, std::memory_order_relaxed);
             return;
          }
       }
@@ -1041,7 +1055,7 @@ void Envelope::BinarySearchForTime( int &Lo, int &Hi, double t ) const
    }
    wxASSERT( Hi == ( Lo+1 ));
 
-   mSearchGuess = Lo;
+   mSearchGuess.store(Lo, std::memory_order_relaxed);
 }
 
 /// GetInterpolationStartValueAtPoint() is used to select either the
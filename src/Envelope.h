@@ -13,6 +13,7 @@
 
 #include <stdlib.h>
 #include <algorithm>
+#include <atomic>
 #include <vector>
 
 #include <wx/dynarray.h>
@@ -105,6 +106,8 @@ class Envelope final : public XMLTagHandler {
    bool HandleXMLTag(const wxChar *tag, const wxChar **attrs) override;
    XMLTagHandler *HandleXMLChild(const wxChar *tag) override;
    void WriteXML(XMLWriter &xmlFile) const /* not override */;
+   // Changes whenever WriteXML would write something different
+   unsigned long long GetXMLStamp() const;
 
    void DrawPoints(wxDC & dc, const wxRect & r, const ZoomInfo &zoomInfo,
              bool dB, double dBRange,
@@ -246,7 +249,8 @@ private:
    double lastIntegral_t1;
    double lastIntegral_result;
 
-   mutable int mSearchGuess;
+   // Only a hint, which several mixers may read and store at once
+   mutable std::atomic<int> mSearchGuess;
 
 };
 
@@ -24,14 +24,6 @@ This class actually does the graph display.
 Has a feature that finds peaks and reports their value as you move
 the mouse around.
 
-*//****************************************************************//**
-
-\class SpectrumAnalyst
-\brief Used for finding the peaks, for snapping to peaks.
-
-This class is used to do the 'find peaks' snapping both in FreqPlot
-and in the spectrogram spectral selection.
-
 *//*******************************************************************/
 
 /*
@@ -51,6 +43,7 @@ and in the spectrogram spectral selection.
 #include <wx/font.h>
 #include <wx/image.h>
 #include <wx/dcmemory.h>
+#include <wx/evtloop.h>
 #include <wx/msgdlg.h>
 #include <wx/file.h>
 #include <wx/filedlg.h>
@@ -173,23 +166,11 @@ BEGIN_EVENT_TABLE(FreqWindow, wxDialogWrapper)
    EVT_COMMAND(wxID_ANY, EVT_FREQWINDOW_RECALC, FreqWindow::OnRecalc)
 END_EVENT_TABLE()
 
-SpectrumAnalyst::SpectrumAnalyst()
-: mAlg(Spectrum)
-, mRate(0.0)
-, mWindowSize(0)
-{
-}
-
-SpectrumAnalyst::~SpectrumAnalyst()
-{
-}
-
 FreqWindow::FreqWindow(wxWindow * parent, wxWindowID id,
                            const wxString & title,
                            const wxPoint & pos)
 :  wxDialogWrapper(parent, id, title, pos, wxDefaultSize,
             wxDEFAULT_DIALOG_STYLE | wxRESIZE_BORDER | wxMAXIMIZE_BOX),
-   mData(NULL),
    mAnalyst(std::make_unique<SpectrumAnalyst>())
 {
    SetName(GetTitle());
@@ -197,7 +178,10 @@ FreqWindow::FreqWindow(wxWindow * parent, wxWindowID id,
    mMouseX = 0;
    mMouseY = 0;
    mRate = 0;
+   mT0 = mT1 = 0;
    mDataLen = 0;
+   mRecalculating = false;
+   mCancelRecalc = false;
 
    p = GetActiveProject();
    if (!p)
@@ -514,8 +498,6 @@ FreqWindow::FreqWindow(wxWindow * parent, wxWindowID id,
 
 FreqWindow::~FreqWindow()
 {
-   if (mData)
-      delete[] mData;
 }
 
 bool FreqWindow::Show(bool show)
@@ -523,86 +505,64 @@ bool FreqWindow::Show(bool show)
    if (!show)
    {
       mFreqPlot->SetCursor(*mArrowCursor);
+      // Stop any calculation in progress
+      mCancelRecalc = true;
    }
 
    bool shown = IsShown();
 
-   if (show && !shown)
+   // Don't replace the tracks while they are being analyzed
+   if (show && !shown && !mRecalculating)
    {
       gPrefs->Read(ENV_DB_KEY, &dBRange, ENV_DB_RANGE);
       if(dBRange < 90.)
          dBRange = 90.;
       GetAudio();
-      // Don't send an event.  We need the recalc right away.
-      // so that mAnalyst is valid when we paint.
-      //SendRecalcEvent();
-      Recalc();
+      // Plot nothing until the analysis of these tracks is done
+      mAnalyst = std::make_unique<SpectrumAnalyst>();
    }
 
    bool res = wxDialogWrapper::Show(show);
 
+   // Analyze once the dialog is up, so that the progress bar shows and
+   // the Close button can cancel
+   if (show && !shown && !mRecalculating)
+      SendRecalcEvent();
+
    return res;
 }
 
 void FreqWindow::GetAudio()
 {
-   if (mData) {
-      delete [] mData;
-      mData = NULL;
-   }
+   mTracks.clear();
    mDataLen = 0;
 
-   int selcount = 0;
-   bool warning = false;
    TrackListIterator iter(p->GetTracks());
    Track *t = iter.First();
    while (t) {
       if (t->GetSelected() && t->GetKind() == Track::Wave) {
          WaveTrack *track = (WaveTrack *)t;
-         if (selcount==0) {
+         if (mTracks.empty()) {
             mRate = track->GetRate();
-            auto start = track->TimeToLongSamples(p->mViewInfo.selectedRegion.t0());
-            auto end = track->TimeToLongSamples(p->mViewInfo.selectedRegion.t1());
-            auto dataLen = end - start;
-            if (dataLen > 10485760) {
-               warning = true;
-               mDataLen = 10485760;
-            }
-            else
-               // dataLen is not more than 10 * 2 ^ 20
-               mDataLen = dataLen.as_size_t();
-            mData = new float[mDataLen];
-            track->Get((samplePtr)mData, floatSample, start, mDataLen);
+            mT0 = p->mViewInfo.selectedRegion.t0();
+            mT1 = p->mViewInfo.selectedRegion.t1();
+            auto start = track->TimeToLongSamples(mT0);
+            auto end = track->TimeToLongSamples(mT1);
+            mDataLen = end - start;
          }
-         else {
-            if (track->GetRate() != mRate) {
-               wxMessageBox(_("To plot the spectrum, all selected tracks must be the same sample rate."));
-               delete[] mData;
-               mData = NULL;
-               mDataLen = 0;
-               return;
-            }
-            auto start = track->TimeToLongSamples(p->mViewInfo.selectedRegion.t0());
-            float *buffer2 = new float[mDataLen];
-            track->Get((samplePtr)buffer2, floatSample, start, mDataLen);
-            for (size_t i = 0; i < mDataLen; i++)
-               mData[i] += buffer2[i];
-            delete[] buffer2;
+         else if (track->GetRate() != mRate) {
+            wxMessageBox(_("To plot the spectrum, all selected tracks must be the same sample rate."));
+            mTracks.clear();
+            mDataLen = 0;
+            return;
          }
-         selcount++;
+         // Duplicating shares the sample blocks, so this is cheap, and
+         // the analysis is not disturbed by edits while it runs
+         mTracks.push_back(std::unique_ptr<WaveTrack>(
+            static_cast<WaveTrack*>(track->Duplicate().release())));
       }
       t = iter.Next();
    }
-
-   if (selcount == 0)
-      return;
-
-   if (warning) {
-      wxString msg;
-      msg.Printf(_("Too much audio was selected.  Only the first %.1f seconds of audio will be analyzed."),
-                          (mDataLen / mRate));
-      wxMessageBox(msg);
-   }
 }
 
 void FreqWindow::OnSize(wxSizeEvent & WXUNUSED(event))
@@ -638,7 +598,7 @@ void FreqWindow::DrawBackground(wxMemoryDC & dc)
 
 void FreqWindow::DrawPlot()
 {
-   if (!mData || mDataLen < mWindowSize || mAnalyst->GetProcessedSize() == 0) {
+   if (mTracks.empty() || mDataLen < mWindowSize || mAnalyst->GetProcessedSize() == 0) {
       wxMemoryDC memDC;
 
       vRuler->ruler.SetLog(false);
@@ -855,7 +815,7 @@ void FreqWindow::PlotPaint(wxPaintEvent & event)
 
    dc.DrawBitmap( *mBitmap, 0, 0, true );
    // Fix for Bug 1226 "Plot Spectrum freezes... if insufficient samples selected"
-   if (!mData || mDataLen < mWindowSize)
+   if (mTracks.empty() || mDataLen < mWindowSize)
       return;
 
    dc.SetFont(mFreqFont);
@@ -979,7 +939,12 @@ void FreqWindow::SendRecalcEvent()
 
 void FreqWindow::Recalc()
 {
-   if (!mData || mDataLen < mWindowSize) {
+   // The progress callback yields, so a pending recalc event can arrive
+   // while calculating
+   if (mRecalculating)
+      return;
+
+   if (mTracks.empty() || mDataLen < mWindowSize) {
       DrawPlot();
       return;
    }
@@ -994,19 +959,52 @@ void FreqWindow::Recalc()
    // controls while the plot was being recalculated.  This doesn't appear to be necessary
    // so just use the the top level window instead.
    {
-      Maybe<wxWindowDisabler> blocker;
-      if (IsShown())
-         blocker.create(this);
+      // The progress callback yields, so other windows must not take
+      // input meanwhile, whether or not this one is shown
+      wxWindowDisabler blocker(this);
       wxYieldIfNeeded();
 
-      mAnalyst->Calculate(alg, windowFunc, mWindowSize, mRate,
-         mData, mDataLen,
-         &mYMin, &mYMax, mProgress);
+      // Only the Close button stays enabled, to cancel
+      wxWindow *const controls[] = {
+         mAlgChoice, mSizeChoice, mFuncChoice, mAxisChoice,
+         mExportButton, mReplotButton,
+      };
+      for (auto control : controls)
+         control->Disable();
+
+      std::vector<const WaveTrack*> tracks;
+      for (const auto &track : mTracks)
+         tracks.push_back(track.get());
+
+      const int progressRange = 1000;
+      mProgress->SetRange(progressRange);
+      auto progress = [&](double fraction) {
+         mProgress->SetValue(fraction * progressRange);
+         wxEventLoopBase::GetActive()->YieldFor(
+            wxEVT_CATEGORY_UI | wxEVT_CATEGORY_USER_INPUT);
+         return !mCancelRecalc;
+      };
+
+      mRecalculating = true;
+      mCancelRecalc = false;
+      mAnalyst->Calculate(alg, windowFunc, mWindowSize,
+         tracks, mT0, mT1,
+         &mYMin, &mYMax, progress);
+      mRecalculating = false;
+
+      // Reset for next time
+      mProgress->Reset();
+
+      for (auto control : controls)
+         control->Enable();
    }
    if (hadFocus) {
       hadFocus->SetFocus();
    }
 
+   if (mCancelRecalc)
+      return;
+
    if (alg == SpectrumAnalyst::Spectrum) {
       if(mYMin < -dBRange)
          mYMin = -dBRange;
@@ -1168,427 +1166,3 @@ void FreqGauge::Reset()
    mRange = 0;
    Refresh(true);
 }
-
-bool SpectrumAnalyst::Calculate(Algorithm alg, int windowFunc,
-                                size_t windowSize, double rate,
-                                const float *data, size_t dataLen,
-                                float *pYMin, float *pYMax,
-                                FreqGauge *progress)
-{
-   // Wipe old data
-   mProcessed.resize(0);
-   mRate = 0.0;
-   mWindowSize = 0;
-
-   // Validate inputs
-   int f = NumWindowFuncs();
-
-   if (!(windowSize >= 32 && windowSize <= 65536 &&
-         alg >= SpectrumAnalyst::Spectrum &&
-         alg < SpectrumAnalyst::NumAlgorithms &&
-         windowFunc >= 0 && windowFunc < f)) {
-      return false;
-   }
-
-   if (dataLen < windowSize) {
-      return false;
-   }
-
-   // Now repopulate
-   mRate = rate;
-   mWindowSize = windowSize;
-   mAlg = alg;
-
-   auto half = mWindowSize / 2;
-   mProcessed.resize(mWindowSize);
-
-   float *in = new float[mWindowSize];
-   float *out = new float[mWindowSize];
-   float *out2 = new float[mWindowSize];
-   float *win = new float[mWindowSize];
-
-   for (size_t i = 0; i < mWindowSize; i++) {
-      mProcessed[i] = 0.0f;
-      win[i] = 1.0f;
-   }
-
-   WindowFunc(windowFunc, mWindowSize, win);
-
-   // Scale window such that an amplitude of 1.0 in the time domain
-   // shows an amplitude of 0dB in the frequency domain
-   double wss = 0;
-   for(size_t i = 0; i < mWindowSize; i++)
-      wss += win[i];
-   if(wss > 0)
-      wss = 4.0 / (wss*wss);
-   else
-      wss = 1.0;
-
-   if (progress) {
-      progress->SetRange(dataLen);
-   }
-
-   size_t start = 0;
-   int windows = 0;
-   while (start + mWindowSize <= dataLen) {
-      for (size_t i = 0; i < mWindowSize; i++)
-         in[i] = win[i] * data[start + i];
-
-      switch (alg) {
-         case Spectrum:
-            PowerSpectrum(mWindowSize, in, out);
-
-            for (size_t i = 0; i < half; i++)
-               mProcessed[i] += out[i];
-            break;
-
-         case Autocorrelation:
-         case CubeRootAutocorrelation:
-         case EnhancedAutocorrelation:
-
-            // Take FFT
-            RealFFT(mWindowSize, in, out, out2);
-            // Compute power
-            for (size_t i = 0; i < mWindowSize; i++)
-               in[i] = (out[i] * out[i]) + (out2[i] * out2[i]);
-
-            if (alg == Autocorrelation) {
-               for (size_t i = 0; i < mWindowSize; i++)
-                  in[i] = sqrt(in[i]);
-            }
-            if (alg == CubeRootAutocorrelation ||
-                alg == EnhancedAutocorrelation) {
-               // Tolonen and Karjalainen recommend taking the cube root
-               // of the power, instead of the square root
-
-               for (size_t i = 0; i < mWindowSize; i++)
-                  in[i] = pow(in[i], 1.0f / 3.0f);
-            }
-            // Take FFT
-            RealFFT(mWindowSize, in, out, out2);
-
-            // Take real part of result
-            for (size_t i = 0; i < half; i++)
-               mProcessed[i] += out[i];
-            break;
-
-         case Cepstrum:
-            RealFFT(mWindowSize, in, out, out2);
-            // Compute log power
-            // Set a sane lower limit assuming maximum time amplitude of 1.0
-            {
-               float power;
-               float minpower = 1e-20*mWindowSize*mWindowSize;
-               for (size_t i = 0; i < mWindowSize; i++)
-               {
-                  power = (out[i] * out[i]) + (out2[i] * out2[i]);
-                  if(power < minpower)
-                     in[i] = log(minpower);
-                  else
-                     in[i] = log(power);
-               }
-               // Take IFFT
-               InverseRealFFT(mWindowSize, in, NULL, out);
-
-               // Take real part of result
-               for (size_t i = 0; i < half; i++)
-                  mProcessed[i] += out[i];
-            }
-
-            break;
-
-         default:
-            wxASSERT(false);
-            break;
-      }                         //switch
-
-      // Update the progress bar
-      if (progress) {
-         progress->SetValue(start);
-      }
-
-      start += half;
-      windows++;
-   }
-
-   if (progress) {
-      // Reset for next time
-      progress->Reset();
-   }
-
-   float mYMin = 1000000, mYMax = -1000000;
-   double scale;
-   switch (alg) {
-   case Spectrum:
-      // Convert to decibels
-      mYMin = 1000000.;
-      mYMax = -1000000.;
-      scale = wss / (double)windows;
-      for (size_t i = 0; i < half; i++)
-      {
-         mProcessed[i] = 10 * log10(mProcessed[i] * scale);
-         if(mProcessed[i] > mYMax)
-            mYMax = mProcessed[i];
-         else if(mProcessed[i] < mYMin)
-            mYMin = mProcessed[i];
-      }
-      break;
-
-   case Autocorrelation:
-   case CubeRootAutocorrelation:
-      for (size_t i = 0; i < half; i++)
-         mProcessed[i] = mProcessed[i] / windows;
-
-      // Find min/max
-      mYMin = mProcessed[0];
-      mYMax = mProcessed[0];
-      for (size_t i = 1; i < half; i++)
-         if (mProcessed[i] > mYMax)
-            mYMax = mProcessed[i];
-         else if (mProcessed[i] < mYMin)
-            mYMin = mProcessed[i];
-      break;
-
-   case EnhancedAutocorrelation:
-      for (size_t i = 0; i < half; i++)
-         mProcessed[i] = mProcessed[i] / windows;
-
-      // Peak Pruning as described by Tolonen and Karjalainen, 2000
-
-      // Clip at zero, copy to temp array
-      for (size_t i = 0; i < half; i++) {
-         if (mProcessed[i] < 0.0)
-            mProcessed[i] = float(0.0);
-         out[i] = mProcessed[i];
-      }
-
-      // Subtract a time-doubled signal (linearly interp.) from the original
-      // (clipped) signal
-      for (size_t i = 0; i < half; i++)
-         if ((i % 2) == 0)
-            mProcessed[i] -= out[i / 2];
-         else
-            mProcessed[i] -= ((out[i / 2] + out[i / 2 + 1]) / 2);
-
-      // Clip at zero again
-      for (size_t i = 0; i < half; i++)
-         if (mProcessed[i] < 0.0)
-            mProcessed[i] = float(0.0);
-
-      // Find NEW min/max
-      mYMin = mProcessed[0];
-      mYMax = mProcessed[0];
-      for (size_t i = 1; i < half; i++)
-         if (mProcessed[i] > mYMax)
-            mYMax = mProcessed[i];
-         else if (mProcessed[i] < mYMin)
-            mYMin = mProcessed[i];
-      break;
-
-   case Cepstrum:
-      for (size_t i = 0; i < half; i++)
-         mProcessed[i] = mProcessed[i] / windows;
-
-      // Find min/max, ignoring first and last few values
-      {
-         size_t ignore = 4;
-         mYMin = mProcessed[ignore];
-         mYMax = mProcessed[ignore];
-         for (size_t i = ignore + 1; i + ignore < half; i++)
-            if (mProcessed[i] > mYMax)
-               mYMax = mProcessed[i];
-            else if (mProcessed[i] < mYMin)
-               mYMin = mProcessed[i];
-      }
-      break;
-
-   default:
-      wxASSERT(false);
-      break;
-   }
-
-   delete[]in;
-   delete[]out;
-   delete[]out2;
-   delete[]win;
-
-   if (pYMin)
-      *pYMin = mYMin;
-   if (pYMax)
-      *pYMax = mYMax;
-
-   return true;
-}
-
-const float *SpectrumAnalyst::GetProcessed() const
-{
-   return &mProcessed[0];
-}
-
-int SpectrumAnalyst::GetProcessedSize() const
-{
-   return mProcessed.size() / 2;
-}
-
-float SpectrumAnalyst::GetProcessedValue(float freq0, float freq1) const
-{
-   float bin0, bin1, binwidth;
-
-   if (mAlg == Spectrum) {
-      bin0 = freq0 * mWindowSize / mRate;
-      bin1 = freq1 * mWindowSize / mRate;
-   } else {
-      bin0 = freq0 * mRate;
-      bin1 = freq1 * mRate;
-   }
-   binwidth = bin1 - bin0;
-
-   float value = float(0.0);
-
-   if (binwidth < 1.0) {
-      float binmid = (bin0 + bin1) / 2.0;
-      int ibin = (int)(binmid) - 1;
-      if (ibin < 1)
-         ibin = 1;
-      if (ibin >= GetProcessedSize() - 3)
-         ibin = std::max(0, GetProcessedSize() - 4);
-
-      value = CubicInterpolate(mProcessed[ibin],
-                               mProcessed[ibin + 1],
-                               mProcessed[ibin + 2],
-                               mProcessed[ibin + 3], binmid - ibin);
-
-   } else {
-      if (bin0 < 0)
-         bin0 = 0;
-      if (bin1 >= GetProcessedSize())
-         bin1 = GetProcessedSize() - 1;
-
-      if ((int)(bin1) > (int)(bin0))
-         value += mProcessed[(int)(bin0)] * ((int)(bin0) + 1 - bin0);
-      bin0 = 1 + (int)(bin0);
-      while (bin0 < (int)(bin1)) {
-         value += mProcessed[(int)(bin0)];
-         bin0 += 1.0;
-      }
-      value += mProcessed[(int)(bin1)] * (bin1 - (int)(bin1));
-
-      value /= binwidth;
-   }
-
-   return value;
-}
-
-float SpectrumAnalyst::FindPeak(float xPos, float *pY) const
-{
-   float bestpeak = 0.0f;
-   float bestValue = 0.0;
-   if (GetProcessedSize() > 1) {
-      bool up = (mProcessed[1] > mProcessed[0]);
-      float bestdist = 1000000;
-      for (int bin = 3; bin < GetProcessedSize() - 1; bin++) {
-         bool nowUp = mProcessed[bin] > mProcessed[bin - 1];
-         if (!nowUp && up) {
-            // Local maximum.  Find actual value by cubic interpolation
-            int leftbin = bin - 2;
-            /*
-            if (leftbin < 1)
-               leftbin = 1;
-               */
-            float valueAtMax = 0.0;
-            float max = leftbin + CubicMaximize(mProcessed[leftbin],
-                                                mProcessed[leftbin + 1],
-                                                mProcessed[leftbin + 2],
-                                                mProcessed[leftbin + 3],
-                                                &valueAtMax);
-
-            float thispeak;
-            if (mAlg == Spectrum)
-               thispeak = max * mRate / mWindowSize;
-            else
-               thispeak = max / mRate;
-
-            if (fabs(thispeak - xPos) < bestdist) {
-               bestpeak = thispeak;
-               bestdist = fabs(thispeak - xPos);
-               bestValue = valueAtMax;
-               // Should this test come after the enclosing if?
-               if (thispeak > xPos)
-                  break;
-            }
-         }
-         up = nowUp;
-      }
-   }
-
-   if (pY)
-      *pY = bestValue;
-   return bestpeak;
-}
-
-// If f(0)=y0, f(1)=y1, f(2)=y2, and f(3)=y3, this function finds
-// the degree-three polynomial which best fits these points and
-// returns the value of this polynomial at a value x.  Usually
-// 0 < x < 3
-
-float SpectrumAnalyst::CubicInterpolate(float y0, float y1, float y2, float y3, float x) const
-{
-   float a, b, c, d;
-
-   a = y0 / -6.0 + y1 / 2.0 - y2 / 2.0 + y3 / 6.0;
-   b = y0 - 5.0 * y1 / 2.0 + 2.0 * y2 - y3 / 2.0;
-   c = -11.0 * y0 / 6.0 + 3.0 * y1 - 3.0 * y2 / 2.0 + y3 / 3.0;
-   d = y0;
-
-   float xx = x * x;
-   float xxx = xx * x;
-
-   return (a * xxx + b * xx + c * x + d);
-}
-
-float SpectrumAnalyst::CubicMaximize(float y0, float y1, float y2, float y3, float * max) const
-{
-   // Find coefficients of cubic
-
-   float a, b, c, d;
-
-   a = y0 / -6.0 + y1 / 2.0 - y2 / 2.0 + y3 / 6.0;
-   b = y0 - 5.0 * y1 / 2.0 + 2.0 * y2 - y3 / 2.0;
-   c = -11.0 * y0 / 6.0 + 3.0 * y1 - 3.0 * y2 / 2.0 + y3 / 3.0;
-   d = y0;
-
-   // Take derivative
-
-   float da, db, dc;
-
-   da = 3 * a;
-   db = 2 * b;
-   dc = c;
-
-   // Find zeroes of derivative using quadratic equation
-
-   float discriminant = db * db - 4 * da * dc;
-   if (discriminant < 0.0)
-      return float(-1.0);              // error
-
-   float x1 = (-db + sqrt(discriminant)) / (2 * da);
-   float x2 = (-db - sqrt(discriminant)) / (2 * da);
-
-   // The one which corresponds to a local _maximum_ in the
-   // cubic is the one we want - the one with a negative
-   // second derivative
-
-   float dda = 2 * da;
-   float ddb = db;
-
-   if (dda * x1 + ddb < 0)
-   {
-      *max = a*x1*x1*x1+b*x1*x1+c*x1+d;
-      return x1;
-   }
-   else
-   {
-      *max = a*x2*x2*x2+b*x2*x2+c*x2+d;
-      return x2;
-   }
-}
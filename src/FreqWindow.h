@@ -30,6 +30,8 @@
 #include <wx/textctrl.h>
 #include <wx/utils.h>
 #include "widgets/Ruler.h"
+#include "SpectrumAnalyst.h"
+#include "audacity/Types.h"
 
 class wxStatusBar;
 class wxButton;
@@ -37,51 +39,10 @@ class wxChoice;
 
 class FreqWindow;
 class FreqGauge;
+class WaveTrack;
 
 DECLARE_EXPORTED_EVENT_TYPE(AUDACITY_DLL_API, EVT_FREQWINDOW_RECALC, -1);
 
-class SpectrumAnalyst
-{
-public:
-
-   enum Algorithm {
-      Spectrum,
-      Autocorrelation,
-      CubeRootAutocorrelation,
-      EnhancedAutocorrelation,
-      Cepstrum,
-
-      NumAlgorithms
-   };
-
-   SpectrumAnalyst();
-   ~SpectrumAnalyst();
-
-   // Return true iff successful
-   bool Calculate(Algorithm alg,
-      int windowFunc, // see FFT.h for values
-      size_t windowSize, double rate,
-      const float *data, size_t dataLen,
-      float *pYMin = NULL, float *pYMax = NULL, // outputs
-      FreqGauge *progress = NULL);
-
-   const float *GetProcessed() const;
-   int GetProcessedSize() const;
-
-   float GetProcessedValue(float freq0, float freq1) const;
-   float FindPeak(float xPos, float *pY) const;
-
-private:
-   float CubicInterpolate(float y0, float y1, float y2, float y3, float x) const;
-   float CubicMaximize(float y0, float y1, float y2, float y3, float * max) const;
-
-private:
-   Algorithm mAlg;
-   double mRate;
-   size_t mWindowSize;
-   std::vector<float> mProcessed;
-};
-
 class FreqGauge final : public wxStatusBar
 {
 public:
@@ -197,9 +158,14 @@ private:
 
 
    double mRate;
-   size_t mDataLen;
-   float *mData;
+   // Copies of the selected tracks, which the analysis reads as it goes
+   std::vector< std::unique_ptr<WaveTrack> > mTracks;
+   double mT0;
+   double mT1;
+   sampleCount mDataLen;
    size_t mWindowSize;
+   bool mRecalculating;
+   bool mCancelRecalc;
 
    bool mLogAxis;
    float mYMin;
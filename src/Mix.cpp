@@ -38,6 +38,7 @@
 #include "Prefs.h"
 #include "Project.h"
 #include "Resample.h"
+#include "RingBuffer.h"
 #include "TimeTrack.h"
 #include "float_cast.h"
 
@@ -601,7 +602,7 @@ size_t Mixer::MixSameRate(int *channelFlags, WaveTrackCache &cache,
    return slen;
 }
 
-size_t Mixer::Process(size_t maxToProcess)
+size_t Mixer::Mix(size_t maxToProcess)
 {
    // MB: this is wrong! mT represented warped time, and mTime is too inaccurate to use
    // it here. It's also unnecessary I think.
@@ -609,7 +610,7 @@ size_t Mixer::Process(size_t maxToProcess)
    //   return 0;
 
    int i, j;
-   decltype(Process(0)) maxOut = 0;
+   decltype(Mix(0)) maxOut = 0;
    int *channelFlags = new int[mNumChannels];
 
    mMaxOut = maxToProcess;
@@ -660,6 +661,18 @@ size_t Mixer::Process(size_t maxToProcess)
          // forwards (the usual)
          mTime = std::min(std::max(t, mTime), mT1);
    }
+   // MB: this doesn't take warping into account, replaced with code based on mSamplePos
+   //mT += (maxOut / mRate);
+
+   delete [] channelFlags;
+
+   return maxOut;
+}
+
+size_t Mixer::Process(size_t maxToProcess)
+{
+   auto maxOut = Mix(maxToProcess);
+
    if(mInterleaved) {
       for(int c=0; c<mNumChannels; c++) {
          CopySamples(mTemp[0].ptr() + (c * SAMPLE_SIZE(floatSample)),
@@ -682,10 +695,34 @@ size_t Mixer::Process(size_t maxToProcess)
             mHighQuality);
       }
    }
-   // MB: this doesn't take warping into account, replaced with code based on mSamplePos
-   //mT += (maxOut / mRate);
+   return maxOut;
+}
 
-   delete [] channelFlags;
+size_t Mixer::Process(size_t maxToProcess, RingBuffer *const *destinations)
+{
+   // Only for non-interleaved output.  (No wxASSERT; this runs on the
+   // audio thread.)
+
+   // Don't produce more than every destination can take
+   for(unsigned c=0; c<mNumBuffers; c++)
+      maxToProcess = std::min(maxToProcess, destinations[c]->AvailForPut());
+
+   auto maxOut = Mix(maxToProcess);
+
+   for(unsigned c=0; c<mNumBuffers; c++) {
+      auto src = mTemp[c].ptr();
+      auto dest = destinations[c];
+      for (const auto &region : dest->GetWritableRegions(maxOut)) {
+         CopySamples(src,
+            floatSample,
+            region.ptr,
+            dest->GetFormat(),
+            region.len,
+            mHighQuality);
+         src += region.len * SAMPLE_SIZE(floatSample);
+      }
+      dest->Produced(maxOut);
+   }
 
    return maxOut;
 }
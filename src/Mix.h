@@ -17,6 +17,7 @@
 #include "SampleFormat.h"
 
 class Resample;
+class RingBuffer;
 class DirManager;
 class TimeTrack;
 class TrackFactory;
@@ -117,6 +118,12 @@ class AUDACITY_DLL_API Mixer {
    /// more samples that must be processed.
    size_t Process(size_t maxSamples);
 
+   /// Like Process(), but write each non-interleaved channel directly
+   /// into the free space of the corresponding ring buffer, converting to
+   /// its format, rather than into GetBuffer().  Produces no more than
+   /// all of the destinations have room for.
+   size_t Process(size_t maxSamples, RingBuffer *const *destinations);
+
    /// Restart processing at beginning of buffer next time
    /// Process() is called.
    void Restart();
@@ -141,6 +148,8 @@ class AUDACITY_DLL_API Mixer {
  private:
 
    void Clear();
+   // Mix into mTemp; returns number of output samples
+   size_t Mix(size_t maxSamples);
    size_t MixSameRate(int *channelFlags, WaveTrackCache &cache,
                            sampleCount *pos);
 
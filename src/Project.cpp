@@ -104,6 +104,7 @@ scroll information.  It also has some status flags.
 #include "LyricsWindow.h"
 #include "MixerBoard.h"
 #include "Internat.h"
+#include "import/BatchImporter.h"
 #include "import/Import.h"
 #include "LabelTrack.h"
 #include "Legacy.h"
@@ -124,6 +125,7 @@ scroll information.  It also has some status flags.
 #include "widgets/ErrorDialog.h"
 #include "widgets/Ruler.h"
 #include "widgets/Warning.h"
+#include "xml/XMLBinaryFile.h"
 #include "xml/XMLFileReader.h"
 #include "PlatformCompatibility.h"
 #include "Experimental.h"
@@ -454,10 +456,7 @@ public:
       ODManager::Pauser pauser;
 
       sortednames.Sort(CompareNoCaseFileName);
-      for (unsigned int i = 0; i < sortednames.GetCount(); i++) {
-
-         mProject->Import(sortednames[i]);
-      }
+      mProject->ImportFiles(sortednames);
       mProject->HandleResize(); // Adjust scrollers for NEW track sizes.
 
       return true;
@@ -1150,6 +1149,8 @@ AudacityProject::AudacityProject(wxWindow * parent, wxWindowID id,
    // Create tags object
    mTags = std::make_shared<Tags>();
 
+   mAutoSaveJournal = std::make_unique<AutoSaveJournal>();
+
    InitialState();
    FixScrollbars();
    mRuler->SetLeftOffset(mTrackPanel->GetLeftOffset());  // bevel on AdornedRuler
@@ -1183,6 +1184,7 @@ AudacityProject::AudacityProject(wxWindow * parent, wxWindowID id,
    mStatusBar->SetStatusText(msg, mainStatusBarField);
    GetControlToolBar()->UpdateStatusBar(this);
    mLastStatusUpdateTime = ::wxGetUTCTime();
+   mLastEditTime = mLastStatusUpdateTime;
 
    mTimer = std::make_unique<wxTimer>(this, AudacityProjectTimerID);
    mTimer->Start(200);
@@ -3011,9 +3013,20 @@ void AudacityProject::OpenFile(const wxString &fileNameArg, bool addtohistory)
       }
    }
 
-   XMLFileReader xmlFile;
+   // A project saved in the binary form is read without expat
+   bool bParseSuccess;
+   wxString parseError;
+   if (temp == wxT(XMLBinaryIdent)) {
+      XMLBinaryFileReader binaryFile;
+      bParseSuccess = binaryFile.Parse(this, fileName);
+      parseError = binaryFile.GetErrorStr();
+   }
+   else {
+      XMLFileReader xmlFile;
+      bParseSuccess = xmlFile.Parse(this, fileName);
+      parseError = xmlFile.GetErrorStr();
+   }
 
-   bool bParseSuccess = xmlFile.Parse(this, fileName);
    if (bParseSuccess) {
       // By making a duplicate set of pointers to the existing blocks
       // on disk, we add one to their reference count, guaranteeing
@@ -3163,14 +3176,15 @@ void AudacityProject::OpenFile(const wxString &fileNameArg, bool addtohistory)
       mFileName = wxT("");
       SetProjectTitle();
 
-      wxLogError(wxT("Could not parse file \"%s\". \nError: %s"), fileName.c_str(), xmlFile.GetErrorStr().c_str());
-      wxMessageBox(xmlFile.GetErrorStr(),
+      wxLogError(wxT("Could not parse file \"%s\". \nError: %s"), fileName.c_str(), parseError.c_str());
+      wxMessageBox(parseError,
                    _("Error Opening Project"),
                    wxOK | wxCENTRE, this);
    }
 
    // Clean up now unused recording recovery handler if any
    mRecordingRecoveryHandler.reset();
+   mJournalRecoveryHandler.reset();
 
    if (!bParseSuccess)
       return; // No need to do further processing if parse failed.
@@ -3361,6 +3375,16 @@ bool AudacityProject::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
          requiredTags++;
       }
 
+      else if (!wxStrcmp(attr, wxT("blocksize"))) {
+         // The size of the blocks of tracks made from now on; those saved
+         // give their own in the sequences
+         long nValue;
+         const wxString strValue = value;
+         if (XMLValueChecker::IsGoodInt(strValue) && strValue.ToLong(&nValue) &&
+             nValue >= 256 && nValue <= 100000000)
+            mDirManager->SetMaxDiskBlockSize(nValue);
+      }
+
       else if (!wxStrcmp(attr, wxT("rate"))) {
          Internat::CompatibleToDouble(value, &mRate);
          GetSelectionBar()->SetRate(mRate);
@@ -3490,6 +3514,15 @@ XMLTagHandler *AudacityProject::HandleXMLChild(const wxChar *tag)
       return mRecordingRecoveryHandler.get();
    }
 
+   if (!wxStrcmp(tag, wxT("journal"))) {
+      if (!mJournalRecoveryHandler)
+         mJournalRecoveryHandler = std::make_unique<JournalRecoveryHandler>(
+            *mTracks, *this,
+            [this](const wxChar *attr, const wxChar *value)
+               { mViewInfo.ReadXMLAttribute(attr, value); });
+      return mJournalRecoveryHandler.get();
+   }
+
    if (!wxStrcmp(tag, wxT("import"))) {
       if (!mImportXMLTagHandler)
          mImportXMLTagHandler = std::make_unique<ImportXMLTagHandler>(this);
@@ -3514,9 +3547,8 @@ void AudacityProject::WriteXMLHeader(XMLWriter &xmlFile)
    xmlFile.Write(wxT(">\n"));
 }
 
-void AudacityProject::WriteXML(XMLWriter &xmlFile)
+void AudacityProject::WriteXMLProjectStart(XMLWriter &xmlFile, bool withView)
 {
-   //TIMER_START( "AudacityProject::WriteXML", xml_writer_timer );
    // Warning: This block of code is duplicated in Save, for now...
    wxString project = mFileName;
    if (project.Len() > 4 && project.Mid(project.Len() - 4) == wxT(".aup"))
@@ -3549,14 +3581,22 @@ void AudacityProject::WriteXML(XMLWriter &xmlFile)
    xmlFile.WriteAttr(wxT("version"), wxT(AUDACITY_FILE_FORMAT_VERSION));
    xmlFile.WriteAttr(wxT("audacityversion"), AUDACITY_VERSION_STRING);
 
-   mViewInfo.WriteXMLAttributes(xmlFile);
+   if (withView)
+      mViewInfo.WriteXMLAttributes(xmlFile);
    xmlFile.WriteAttr(wxT("rate"), mRate);
+   xmlFile.WriteAttr(wxT("blocksize"), mDirManager->GetMaxDiskBlockSize());
    xmlFile.WriteAttr(wxT("snapto"), GetSnapTo() ? wxT("on") : wxT("off"));
    xmlFile.WriteAttr(wxT("selectionformat"), GetSelectionFormat());
    xmlFile.WriteAttr(wxT("frequencyformat"), GetFrequencySelectionFormatName());
    xmlFile.WriteAttr(wxT("bandwidthformat"), GetBandwidthSelectionFormatName());
 
    mTags->WriteXML(xmlFile);
+}
+
+void AudacityProject::WriteXML(XMLWriter &xmlFile)
+{
+   //TIMER_START( "AudacityProject::WriteXML", xml_writer_timer );
+   WriteXMLProjectStart(xmlFile, true);
 
    Track *t;
    WaveTrack* pWaveTrack;
@@ -3777,17 +3817,44 @@ bool AudacityProject::Save(bool overwrite /* = true */ ,
       }
    }
 
-   // Write the AUP file.
-   XMLFileWriter saveFile;
+   // The AUP file must not refer to block files that are not yet safely
+   // on disk
+   if (!bWantSaveCompressed && !mDirManager->FlushWrites()) {
+      if (safetyFileName != wxT(""))
+         wxRename(safetyFileName, mFileName);
+      wxMessageBox(wxString::Format(_("Could not save project. Some audio data could not be written.\nPerhaps the folder of %s \nis not writable or the disk is full."),
+                                    mFileName.c_str()),
+                   _("Error Saving Project"),
+                   wxICON_ERROR, this);
+      return false;
+   }
+
+   // Write the AUP file.  The binary form opens much faster, but only in
+   // versions of Audacity that know it, so compressed copies, which are
+   // meant to be shared, are always XML.
+   bool bSaveBinary = false;
+   if (!bWantSaveCompressed)
+      gPrefs->Read(wxT("/FileFormats/SaveProjectBinary"), &bSaveBinary, false);
 
    try
    {
-      saveFile.Open(mFileName, wxT("wb"));
+      if (bSaveBinary) {
+         XMLBinaryFileWriter saveFile;
+         saveFile.Open(mFileName);
 
-      WriteXMLHeader(saveFile);
-      WriteXML(saveFile);
+         WriteXML(saveFile);
 
-      saveFile.Close();
+         saveFile.Close();
+      }
+      else {
+         XMLFileWriter saveFile;
+         saveFile.Open(mFileName, wxT("wb"));
+
+         WriteXMLHeader(saveFile);
+         WriteXML(saveFile);
+
+         saveFile.Close();
+      }
    }
    catch (const XMLFileWriterException &exception)
    {
@@ -4111,6 +4178,14 @@ bool AudacityProject::Import(const wxString &fileName, WaveTrackArray* pTrackArr
       return false;
    }
 
+   FinishImport(fileName, std::move(newTracks), pTrackArray);
+   return true;
+}
+
+void AudacityProject::FinishImport(const wxString &fileName,
+                                   TrackHolders &&newTracks,
+                                   WaveTrackArray *pTrackArray)
+{
    // Have to set up newTrackList before calling AddImportedTracks,
    // because AddImportedTracks deletes newTracks.
    if (pTrackArray) {
@@ -4134,7 +4209,36 @@ bool AudacityProject::Import(const wxString &fileName, WaveTrackArray* pTrackArr
    }
 
    GetDirManager()->FillBlockfilesCache();
-   return true;
+}
+
+void AudacityProject::ImportFiles(const wxArrayString &fileNames)
+{
+   BatchImporter importer{ GetTrackFactory() };
+   importer.Import(fileNames,
+      [this](const wxString &fileName, BatchImporter::Outcome outcome,
+             TrackHolders &tracks, const Tags *tags)
+   {
+      switch (outcome) {
+         case BatchImporter::Imported:
+         {
+            // Add the file's metadata to a copy of the tags, as Import does,
+            // leaving those of the undo history alone
+            auto newTags = mTags ? mTags->Duplicate() : std::make_shared<Tags>();
+            for (const auto &pair : tags->GetRange())
+               newTags->SetTag(pair.first, pair.second);
+            mTags = newTags;
+
+            wxGetApp().AddFileToHistory(fileName);
+            FinishImport(fileName, std::move(tracks), nullptr);
+            break;
+         }
+         case BatchImporter::Deferred:
+            Import(fileName);
+            break;
+         case BatchImporter::Cancelled:
+            break;
+      }
+   });
 }
 
 bool AudacityProject::SaveAs(const wxString & newFileName, bool bWantSaveCompressed /*= false*/, bool addToHistory /*= true*/)
@@ -4328,6 +4432,9 @@ void AudacityProject::PushState(const wxString &desc,
                           desc, shortDesc, flags);
 
    mDirty = true;
+   // The state has any merges CompactBlocks made
+   mCompactPending = false;
+   mLastEditTime = ::wxGetUTCTime();
 
    if (mHistoryWindow)
       mHistoryWindow->UpdateDisplay();
@@ -4373,6 +4480,10 @@ void AudacityProject::PopState(const UndoState &state)
    // Restore tags
    mTags = state.tags;
 
+   // Any merges CompactBlocks made are undone with the rest
+   mCompactPending = false;
+   mLastEditTime = ::wxGetUTCTime();
+
    TrackList *const tracks = state.tracks.get();
 
    mTracks->Clear();
@@ -4708,6 +4819,8 @@ void AudacityProject::OnTimer(wxTimerEvent& WXUNUSED(event))
    if( mixerToolBar )
       mixerToolBar->UpdateControls();
 
+   CompactBlocks();
+
    if (::wxGetUTCTime() - mLastStatusUpdateTime < 3)
       return;
 
@@ -4758,6 +4871,64 @@ void AudacityProject::OnTimer(wxTimerEvent& WXUNUSED(event))
    }
 }
 
+// Seconds without a change of the undo state before CompactBlocks starts
+enum { CompactIdleSeconds = 5 };
+// Bytes of samples that CompactBlocks may rewrite on each tick of the timer
+enum { CompactBytesPerTick = 4 * 1024 * 1024 };
+
+void AudacityProject::CompactBlocks()
+{
+   // Only in the main loop itself, not in a dialog or while a progress
+   // indicator yields, when the tracks may be in the middle of a change;
+   // and not while the user drags something, or audio streams
+   const auto loop = wxEventLoopBase::GetActive();
+   if (!loop || loop != wxTheApp->GetMainLoop() || loop->IsYielding())
+      return;
+   if (IsAudioActive() || mbBusyImporting ||
+       (mTrackPanel && mTrackPanel->IsMouseCaptured()))
+      return;
+   if (::wxGetUTCTime() - mLastEditTime < CompactIdleSeconds)
+      return;
+
+   // Blocks that other undo states, the clipboard, or the saved project
+   // still use would stay on disk, so merging them would only take space
+   std::set<const BlockFile*> inUse;
+   GetUndoManager()->GetOtherStatesBlockFiles(inUse);
+   UndoManager::GetBlockFiles(GetClipboardTracks(), inUse);
+   if (mLastSavedTracks)
+      UndoManager::GetBlockFiles(mLastSavedTracks.get(), inUse);
+
+   size_t bytes = 0;
+   TrackListIterator iter(GetTracks());
+   for (Track *t = iter.First(); t && bytes < CompactBytesPerTick; t = iter.Next()) {
+      if (t->GetKind() != Track::Wave)
+         continue;
+      for (const auto &clip : static_cast<WaveTrack*>(t)->GetClips()) {
+         bytes += clip->GetSequence()->Compact(CompactBytesPerTick - bytes,
+                                               &inUse);
+         if (bytes >= CompactBytesPerTick)
+            break;
+      }
+   }
+
+   if (bytes > 0) {
+      mCompactPending = true;
+      return;
+   }
+
+   // The pass is done.  Auto-save the merged blocks before the undo state
+   // lets go of the ones they replace, so that recovery never refers to
+   // deleted files.  The same samples in fewer blocks are not an edit to
+   // undo, but they are a change to save.
+   if (mCompactPending) {
+      mCompactPending = false;
+      AutoSave();
+      ModifyState(false);
+      GetUndoManager()->SetODChangesFlag();
+      mDirty = true;
+   }
+}
+
 //get regions selected by selected labels
 //removes unnecessary regions, overlapping regions are merged
 //regions memory need to be deleted by the caller
@@ -5061,13 +5232,50 @@ void AudacityProject::AutoSave()
    wxString fn = wxFileName(FileNames::AutoSaveDir(),
       projName + wxString(wxT(" - ")) + CreateUniqueName()).GetFullPath();
 
+   // The recovery data should not refer to block files still being
+   // written in the background
+   mDirManager->WaitForWrites();
+
+   // Serialize the tracks apart, so that if only some of them changed since
+   // the last auto-save, only those need be appended to its file
+   AutoSaveJournal::State state;
+   size_t bytes = 0;
+
    try
    {
       VarSetter<bool> setter(&mAutoSaving, true, false);
 
+      WriteXMLProjectStart(*state.head, false);
+
+      // Write only the tracks that changed since the last auto-save, and
+      // take what it wrote of the others
+      mAutoSaveJournal->WriteState(*GetTracks(), state);
+
+      if (!mAutoSaveFileName.IsEmpty() && mAutoSaveJournal->CanAppend(state))
+      {
+         AutoSaveFile record(AutoSaveJournal::PieceAllocSize);
+         mAutoSaveJournal->WriteRecord(record, state,
+            [this](XMLWriter &xmlFile){ mViewInfo.WriteXMLAttributes(xmlFile); });
+
+         if (!mAutoSaveJournal->NeedsCompaction(record))
+         {
+            wxFFile f(mAutoSaveFileName, wxT("ab"));
+            if (f.IsOpened() && record.Append(f) && f.Flush())
+            {
+               mAutoSaveJournal->Appended(state, record);
+               return;
+            }
+            // Else write a NEW checkpoint, replacing a record that might
+            // have been only partly appended
+         }
+      }
+
       AutoSaveFile buffer;
       WriteXMLHeader(buffer);
-      WriteXML(buffer);
+      WriteXMLProjectStart(buffer, true);
+      for (const auto &track : state.tracks)
+         buffer.WriteSubTree(*track.file);
+      bytes = buffer.GetLength();
 
       wxFFile saveFile;
       saveFile.Open(fn + wxT(".tmp"), wxT("wb"));
@@ -5098,6 +5306,7 @@ void AudacityProject::AutoSave()
    }
 
    mAutoSaveFileName += fn + wxT(".autosave");
+   mAutoSaveJournal->Checkpoint(state, bytes);
    // no-op cruft that's not #ifdefed for NoteTrack
    // See above for further comments.
    //   SonifyEndAutoSave();
@@ -5118,6 +5327,7 @@ void AudacityProject::DeleteCurrentAutoSaveFile()
       }
 
       mAutoSaveFileName = wxT("");
+      mAutoSaveJournal->Reset();
    }
 }
 
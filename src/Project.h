@@ -59,6 +59,8 @@ class AutoSaveFile;
 class Importer;
 class ODLock;
 class RecordingRecoveryHandler;
+class JournalRecoveryHandler;
+class AutoSaveJournal;
 class TrackList;
 class Tags;
 class EffectPlugs;
@@ -243,10 +245,19 @@ class AUDACITY_DLL_API AudacityProject final : public wxFrame,
 
    // If pNewTrackList is passed in non-NULL, it gets filled with the pointers to NEW tracks.
    bool Import(const wxString &fileName, WaveTrackArray *pTrackArray = NULL);
+   // Imports the files in order, several at once where the formats allow
+   void ImportFiles(const wxArrayString &fileNames);
 
    void AddImportedTracks(const wxString &fileName,
                           TrackHolders &&newTracks);
 
+ private:
+   // The steps after the tracks of an imported file are made
+   void FinishImport(const wxString &fileName, TrackHolders &&newTracks,
+                     WaveTrackArray *pTrackArray);
+
+ public:
+
    bool Save(bool overwrite = true, bool fromSaveAs = false, bool bWantSaveCompressed = false);
    bool SaveAs(bool bWantSaveCompressed = false);
    bool SaveAs(const wxString & newFileName, bool bWantSaveCompressed = false, bool addToHistory = true);
@@ -257,6 +268,8 @@ class AUDACITY_DLL_API AudacityProject final : public wxFrame,
 
    const wxString &GetFileName() { return mFileName; }
    bool GetDirty() { return mDirty; }
+   // The auto-save file of this project, or empty if none
+   const wxString &GetAutoSaveFileName() const { return mAutoSaveFileName; }
    void SetProjectTitle( int number =-1);
 
    wxPanel *GetTopPanel() { return mTopPanel; }
@@ -327,6 +340,8 @@ class AUDACITY_DLL_API AudacityProject final : public wxFrame,
    void OnScroll(wxScrollEvent & event);
    void OnCloseWindow(wxCloseEvent & event);
    void OnTimer(wxTimerEvent & event);
+   // Merges some of the small blocks that edits leave, when idle
+   void CompactBlocks();
    void OnToolBarUpdate(wxCommandEvent & event);
    void OnOpenAudioFile(wxCommandEvent & event);
    void OnODTaskUpdate(wxCommandEvent & event);
@@ -507,6 +522,9 @@ public:
    void WriteXML(XMLWriter &xmlFile) /* not override */;
 
    void WriteXMLHeader(XMLWriter &xmlFile);
+   // The start tag of the project, its attributes, leaving out those of the
+   // view unless withView, and the tags; not the tracks
+   void WriteXMLProjectStart(XMLWriter &xmlFile, bool withView);
 
    PlayMode mLastPlayMode{ PlayMode::normalPlay };
    ViewInfo mViewInfo;
@@ -604,6 +622,10 @@ private:
 
    std::unique_ptr<wxTimer> mTimer;
    long mLastStatusUpdateTime;
+   // When the undo state last changed, for CompactBlocks to wait for idle
+   long mLastEditTime;
+   // Whether CompactBlocks merged blocks that no undo state has yet
+   bool mCompactPending{ false };
 
    wxStatusBar *mStatusBar;
 
@@ -692,6 +714,12 @@ private:
    // The handler that handles recovery of <recordingrecovery> tags
    std::unique_ptr<RecordingRecoveryHandler> mRecordingRecoveryHandler;
 
+   // The handler that handles recovery of <journal> tags
+   std::unique_ptr<JournalRecoveryHandler> mJournalRecoveryHandler;
+
+   // What the last auto-save wrote, for the next to append only changes
+   std::unique_ptr<AutoSaveJournal> mAutoSaveJournal;
+
    // Dependencies have been imported and a warning should be shown on save
    bool mImportedDependencies{ false };
 
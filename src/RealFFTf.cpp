@@ -42,6 +42,7 @@
 #include "Experimental.h"
 
 #include "RealFFTf.h"
+#include "ondemand/ODTaskThread.h"
 #ifdef EXPERIMENTAL_EQ_SSE_THREADED
 #include "RealFFTf48x.h"
 #endif
@@ -124,11 +125,15 @@ void EndFFT(HFFT h)
 enum : size_t { MAX_HFFT = 10 };
 static HFFT hFFTArray[MAX_HFFT] = { NULL };
 static int nFFTLockCount[MAX_HFFT] = { 0 };
+// Guards the two arrays above, as spectrograms are computed on several
+// threads at once
+static ODLock gFFTArrayMutex;
 
 /* Get a handle to the FFT tables of the desired length */
 /* This version keeps common tables rather than allocating a NEW table every time */
 HFFT GetFFT(size_t fftlen)
 {
+   ODLocker locker{ &gFFTArrayMutex };
    size_t h = 0;
    auto n = fftlen/2;
    for(;
@@ -151,6 +156,7 @@ HFFT GetFFT(size_t fftlen)
 /* Release a previously requested handle to the FFT tables */
 void ReleaseFFT(HFFT hFFT)
 {
+   ODLocker locker{ &gFFTArrayMutex };
    int h;
    for(h=0; (h<MAX_HFFT) && (hFFTArray[h] != hFFT); h++);
    if(h<MAX_HFFT) {
@@ -163,6 +169,7 @@ void ReleaseFFT(HFFT hFFT)
 /* Deallocate any unused FFT tables */
 void CleanupFFT()
 {
+   ODLocker locker{ &gFFTArrayMutex };
    int h;
    for(h=0; (h<MAX_HFFT); h++) {
       if((nFFTLockCount[h] <= 0) && (hFFTArray[h] != NULL)) {
@@ -16,9 +16,23 @@
   need to read, or both need to write, they need to lock this
   class from outside using their own mutex.
 
+  The writer publishes new data by a release-store of mEnd, after
+  the samples are written; the reader acquires mEnd before reading
+  them.  Symmetrically the reader releases space by storing mStart,
+  which the writer acquires before overwriting.  So this does not
+  depend on the memory ordering of any particular processor.
+
+  The writing (or reading) may pass from one thread to another between
+  calls, as when AudioIO mixes tracks on a WorkerPool, provided that
+  the hand-over is itself synchronized.
+
   AvailForPut and AvailForGet may underestimate but will never
   overestimate.
 
+  GetWritableRegions and GetReadableRegions let the two sides work
+  in the storage directly, avoiding an intermediate buffer, and
+  Produced and Consumed then move the indices.
+
 *//*******************************************************************/
 
 
@@ -35,9 +49,18 @@ RingBuffer::~RingBuffer()
 {
 }
 
-size_t RingBuffer::Len()
+size_t RingBuffer::Filled(size_t start, size_t end) const
+{
+   return (end + mBufferSize - start) % mBufferSize;
+}
+
+auto RingBuffer::MakeRegions(size_t pos, size_t samples) -> Regions
 {
-   return (mEnd + mBufferSize - mStart) % mBufferSize;
+   auto first = std::min( samples, mBufferSize - pos );
+   return { {
+      { mBuffer.ptr() + pos * SAMPLE_SIZE(mFormat), first },
+      { mBuffer.ptr(), samples - first },
+   } };
 }
 
 //
@@ -46,31 +69,37 @@ size_t RingBuffer::Len()
 
 size_t RingBuffer::AvailForPut()
 {
-   return std::max<size_t>(mBufferSize - Len(), 4) - 4;
+   auto start = mStart.load( std::memory_order_acquire );
+   auto end = mEnd.load( std::memory_order_relaxed );
+   return std::max<size_t>(mBufferSize - Filled( start, end ), 4) - 4;
+}
+
+auto RingBuffer::GetWritableRegions(size_t samples) -> Regions
+{
+   samples = std::min( samples, AvailForPut() );
+   return MakeRegions( mEnd.load( std::memory_order_relaxed ), samples );
+}
+
+void RingBuffer::Produced(size_t samples)
+{
+   auto end = mEnd.load( std::memory_order_relaxed );
+   mEnd.store( (end + samples) % mBufferSize, std::memory_order_release );
 }
 
 size_t RingBuffer::Put(samplePtr buffer, sampleFormat format,
                     size_t samplesToCopy)
 {
-   samplesToCopy = std::min( samplesToCopy, AvailForPut() );
    auto src = buffer;
    size_t copied = 0;
-   auto pos = mEnd;
-
-   while(samplesToCopy) {
-      auto block = std::min( samplesToCopy, mBufferSize - pos );
 
-      CopySamples(src, format,
-                  mBuffer.ptr() + pos * SAMPLE_SIZE(mFormat), mFormat,
-                  block);
+   for (const auto &region : GetWritableRegions( samplesToCopy )) {
+      CopySamples(src, format, region.ptr, mFormat, region.len);
 
-      src += block * SAMPLE_SIZE(format);
-      pos = (pos + block) % mBufferSize;
-      samplesToCopy -= block;
-      copied += block;
+      src += region.len * SAMPLE_SIZE(format);
+      copied += region.len;
    }
 
-   mEnd = pos;
+   Produced( copied );
 
    return copied;
 }
@@ -81,37 +110,46 @@ size_t RingBuffer::Put(samplePtr buffer, sampleFormat format,
 
 size_t RingBuffer::AvailForGet()
 {
-   return Len();
+   auto end = mEnd.load( std::memory_order_acquire );
+   auto start = mStart.load( std::memory_order_relaxed );
+   return Filled( start, end );
+}
+
+auto RingBuffer::GetReadableRegions(size_t samples) -> Regions
+{
+   samples = std::min( samples, AvailForGet() );
+   return MakeRegions( mStart.load( std::memory_order_relaxed ), samples );
+}
+
+void RingBuffer::Consumed(size_t samples)
+{
+   auto start = mStart.load( std::memory_order_relaxed );
+   mStart.store( (start + samples) % mBufferSize, std::memory_order_release );
 }
 
 size_t RingBuffer::Get(samplePtr buffer, sampleFormat format,
                        size_t samplesToCopy)
 {
-   samplesToCopy = std::min( samplesToCopy, Len() );
    auto dest = buffer;
    size_t copied = 0;
 
-   while(samplesToCopy) {
-      auto block = std::min( samplesToCopy, mBufferSize - mStart );
+   for (const auto &region : GetReadableRegions( samplesToCopy )) {
+      CopySamples(region.ptr, mFormat, dest, format, region.len);
 
-      CopySamples(mBuffer.ptr() + mStart * SAMPLE_SIZE(mFormat), mFormat,
-                  dest, format,
-                  block);
-
-      dest += block * SAMPLE_SIZE(format);
-      mStart = (mStart + block) % mBufferSize;
-      samplesToCopy -= block;
-      copied += block;
+      dest += region.len * SAMPLE_SIZE(format);
+      copied += region.len;
    }
 
+   Consumed( copied );
+
    return copied;
 }
 
 size_t RingBuffer::Discard(size_t samplesToDiscard)
 {
-   samplesToDiscard = std::min( samplesToDiscard, Len() );
+   samplesToDiscard = std::min( samplesToDiscard, AvailForGet() );
 
-   mStart = (mStart + samplesToDiscard) % mBufferSize;
+   Consumed( samplesToDiscard );
 
    return samplesToDiscard;
 }
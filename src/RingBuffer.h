@@ -11,6 +11,7 @@
 #ifndef __AUDACITY_RING_BUFFER__
 #define __AUDACITY_RING_BUFFER__
 
+#include <atomic>
 #include "SampleFormat.h"
 
 class RingBuffer {
@@ -18,6 +19,24 @@ class RingBuffer {
    RingBuffer(sampleFormat format, size_t size);
    ~RingBuffer();
 
+   sampleFormat GetFormat() const { return mFormat; }
+
+   /// A contiguous piece of the storage, in the format of the buffer
+   struct Region {
+      samplePtr ptr;
+      size_t len;
+   };
+
+   /// The storage wraps around, so a span of samples is at most two
+   /// regions; the second is empty unless the span wraps.
+   struct Regions {
+      Region regions[2];
+
+      const Region *begin() const { return regions; }
+      const Region *end() const { return regions + 2; }
+      size_t Total() const { return regions[0].len + regions[1].len; }
+   };
+
    //
    // For the writer only:
    //
@@ -25,6 +44,12 @@ class RingBuffer {
    size_t AvailForPut();
    size_t Put(samplePtr buffer, sampleFormat format, size_t samples);
 
+   /// Up to 'samples' of free space, clipped to AvailForPut(), to be
+   /// filled in place.  Nothing is visible to the reader until Produced().
+   Regions GetWritableRegions(size_t samples);
+   /// Publish samples written into the writable regions
+   void Produced(size_t samples);
+
    //
    // For the reader only:
    //
@@ -33,14 +58,30 @@ class RingBuffer {
    size_t Get(samplePtr buffer, sampleFormat format, size_t samples);
    size_t Discard(size_t samples);
 
+   /// Up to 'samples' of data, clipped to AvailForGet(), to be read in
+   /// place.  The writer does not reuse the space until Consumed().
+   Regions GetReadableRegions(size_t samples);
+   /// Release samples read from the readable regions
+   void Consumed(size_t samples);
+
  private:
-   size_t Len();
+   size_t Filled(size_t start, size_t end) const;
+   Regions MakeRegions(size_t pos, size_t samples);
 
    sampleFormat  mFormat;
-   size_t        mStart { 0 };
-   size_t        mEnd { 0 };
    size_t        mBufferSize;
    SampleBuffer  mBuffer;
+
+   // mStart is stored only by the reader and mEnd only by the writer.
+   // Padding keeps them on separate cache lines, so that the two threads
+   // do not keep stealing one line from each other.  (We pad rather than
+   // use alignas, because operator new need not honor over-alignment.)
+   enum { CacheLineSize = 64 };
+   char          mPad0[CacheLineSize];
+   std::atomic<size_t> mStart { 0 };
+   char          mPad1[CacheLineSize - sizeof(std::atomic<size_t>)];
+   std::atomic<size_t> mEnd { 0 };
+   char          mPad2[CacheLineSize - sizeof(std::atomic<size_t>)];
 };
 
 #endif /*  __AUDACITY_RING_BUFFER__ */
@@ -0,0 +1,206 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleFormatKernels.h
+
+  Not an ordinary header.  SampleFormatSIMD.cpp includes it once per
+  instruction set, inside a namespace that already defines a struct
+  Ops of vector primitives and the macros SIMD_FUNCTION (an inline
+  function for that instruction set) and SIMD_ENTRY (one whose address
+  is taken).  Every function here must be declared with one of those,
+  or it would be compiled for the baseline processor and fail to
+  inline the primitives.
+
+**********************************************************************/
+
+using F = Ops::F;
+using I = Ops::I;
+
+struct NoiseState {
+   I random;
+   // The last noise value of triangle dither, in every lane
+   F carry;
+};
+
+SIMD_FUNCTION NoiseState LoadNoise(const SIMDDitherState &state)
+{
+   return { Ops::LoadInts((const int *)state.random),
+            Ops::Set1(state.triangle) };
+}
+
+SIMD_FUNCTION void SaveNoise(const NoiseState &noise, SIMDDitherState &state)
+{
+   Ops::StoreInts((int *)state.random, noise.random);
+   state.triangle = Ops::First(noise.carry);
+}
+
+// One step of xorshift32 in each lane, giving floats uniform in
+// [-0.5, 0.5) like Dither's DITHER_NOISE
+SIMD_FUNCTION F NextNoise(I &random)
+{
+   I x = random;
+   x = Ops::Xor(x, Ops::ShiftLeft(x, 13));
+   x = Ops::Xor(x, Ops::ShiftRight(x, 17));
+   x = Ops::Xor(x, Ops::ShiftLeft(x, 5));
+   random = x;
+
+   // The high 23 bits as the mantissa of a float in [1, 2)
+   const F one_two =
+      Ops::AsFloat(Ops::Or(Ops::ShiftRight(x, 9), Ops::Set1Int(0x3f800000)));
+   return Ops::Sub(one_two, Ops::Set1(1.5f));
+}
+
+template<int Dither>
+SIMD_FUNCTION F AddNoise(F x, NoiseState &noise)
+{
+   if (Dither == SampleConverters::RectangleDither)
+      return Ops::Sub(x, NextNoise(noise.random));
+   if (Dither == SampleConverters::TriangleDither) {
+      const F r = NextNoise(noise.random);
+      const F previous = Ops::ShiftIn(r, noise.carry);
+      return Ops::Sub(Ops::Add(x, r), previous);
+   }
+   return x;
+}
+
+// Like FROM_FLOAT in Dither.cpp.  The operand order lets NaN through.
+SIMD_FUNCTION F ClipUnit(F x)
+{
+   return Ops::Max(Ops::Set1(-1.0f), Ops::Min(Ops::Set1(1.0f), x));
+}
+
+SIMD_FUNCTION void StoreInt24(int *dst, F x)
+{
+   Ops::StoreInts(dst, Ops::Clamp(Ops::ToInts(x), -8388608, 8388607));
+}
+
+//
+// One vector of each conversion
+//
+
+SIMD_FUNCTION void Int16ToFloatStep(const short *src, float *dst, NoiseState &)
+{
+   Ops::StoreFloat(dst,
+      Ops::Mul(Ops::ToFloat(Ops::LoadInt16(src)), Ops::Set1(1.0f / (1 << 15))));
+}
+
+SIMD_FUNCTION void Int24ToFloatStep(const int *src, float *dst, NoiseState &)
+{
+   Ops::StoreFloat(dst,
+      Ops::Mul(Ops::ToFloat(Ops::LoadInts(src)), Ops::Set1(1.0f / (1 << 23))));
+}
+
+SIMD_FUNCTION void Int16ToInt24Step(const short *src, int *dst, NoiseState &)
+{
+   Ops::StoreInts(dst, Ops::ShiftLeft(Ops::LoadInt16(src), 8));
+}
+
+template<int Dither>
+SIMD_FUNCTION void FloatToInt16Step(const float *src, short *dst,
+                                    NoiseState &noise)
+{
+   const F x = Ops::Mul(ClipUnit(Ops::LoadFloat(src)), Ops::Set1(32768.0f));
+   Ops::StoreInt16(dst, AddNoise<Dither>(x, noise));
+}
+
+template<int Dither>
+SIMD_FUNCTION void FloatToInt24Step(const float *src, int *dst,
+                                    NoiseState &noise)
+{
+   const F x = Ops::Mul(ClipUnit(Ops::LoadFloat(src)), Ops::Set1(8388608.0f));
+   StoreInt24(dst, AddNoise<Dither>(x, noise));
+}
+
+template<int Dither>
+SIMD_FUNCTION void Int24ToInt16Step(const int *src, short *dst,
+                                    NoiseState &noise)
+{
+   // Exactly the 24 bit value scaled to 16 bits, as in Dither.cpp
+   const F x = Ops::Mul(Ops::ToFloat(Ops::LoadInts(src)), Ops::Set1(1.0f / 256));
+   Ops::StoreInt16(dst, AddNoise<Dither>(x, noise));
+}
+
+// Does the whole vectors in place, then the remainder through buffers
+// padded with zeros, so every sample takes the same path
+template<typename Src, typename Dst,
+         void (*Step)(const Src *, Dst *, NoiseState &)>
+SIMD_FUNCTION void Run(const Src *src, Dst *dst, size_t len, NoiseState &noise)
+{
+   size_t i = 0;
+   for (; i + Ops::Width <= len; i += Ops::Width)
+      Step(src + i, dst + i, noise);
+
+   if (i < len) {
+      Src in[Ops::Width] = {};
+      Dst out[Ops::Width];
+      memcpy(in, src + i, (len - i) * sizeof(Src));
+      Step(in, out, noise);
+      memcpy(dst + i, out, (len - i) * sizeof(Dst));
+   }
+}
+
+//
+// The entry points
+//
+
+SIMD_ENTRY void Int16ToFloat(const short *src, float *dst, size_t len)
+{
+   NoiseState noise{};
+   Run<short, float, Int16ToFloatStep>(src, dst, len, noise);
+}
+
+SIMD_ENTRY void Int24ToFloat(const int *src, float *dst, size_t len)
+{
+   NoiseState noise{};
+   Run<int, float, Int24ToFloatStep>(src, dst, len, noise);
+}
+
+SIMD_ENTRY void Int16ToInt24(const short *src, int *dst, size_t len)
+{
+   NoiseState noise{};
+   Run<short, int, Int16ToInt24Step>(src, dst, len, noise);
+}
+
+template<int Dither>
+SIMD_ENTRY void FloatToInt16(const float *src, short *dst, size_t len,
+                             SIMDDitherState &state)
+{
+   NoiseState noise = LoadNoise(state);
+   Run<float, short, FloatToInt16Step<Dither>>(src, dst, len, noise);
+   SaveNoise(noise, state);
+}
+
+template<int Dither>
+SIMD_ENTRY void FloatToInt24(const float *src, int *dst, size_t len,
+                             SIMDDitherState &state)
+{
+   NoiseState noise = LoadNoise(state);
+   Run<float, int, FloatToInt24Step<Dither>>(src, dst, len, noise);
+   SaveNoise(noise, state);
+}
+
+template<int Dither>
+SIMD_ENTRY void Int24ToInt16(const int *src, short *dst, size_t len,
+                             SIMDDitherState &state)
+{
+   NoiseState noise = LoadNoise(state);
+   Run<int, short, Int24ToInt16Step<Dither>>(src, dst, len, noise);
+   SaveNoise(noise, state);
+}
+
+#define SIMD_CONVERTERS(name) { \
+   name, \
+   Int16ToFloat, \
+   Int24ToFloat, \
+   Int16ToInt24, \
+   { FloatToInt16<SampleConverters::NoDither>, \
+     FloatToInt16<SampleConverters::RectangleDither>, \
+     FloatToInt16<SampleConverters::TriangleDither> }, \
+   { FloatToInt24<SampleConverters::NoDither>, \
+     FloatToInt24<SampleConverters::RectangleDither>, \
+     FloatToInt24<SampleConverters::TriangleDither> }, \
+   { Int24ToInt16<SampleConverters::NoDither>, \
+     Int24ToInt16<SampleConverters::RectangleDither>, \
+     Int24ToInt16<SampleConverters::TriangleDither> }, \
+}
@@ -0,0 +1,230 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleFormatSIMD.cpp
+
+*******************************************************************//*!
+
+\file SampleFormatSIMD.cpp
+\brief SSE2 and AVX2 versions of the sample format conversions.
+
+  The conversions are written once, in SampleFormatKernels.h, in terms
+  of a struct Ops of vector primitives, and compiled here for each
+  instruction set.  Rather than building this file with special compiler
+  flags, each function is marked with the instruction set it may use,
+  so the rest of the program still runs on any processor; which version
+  is used is decided at run time from GetCPUCaps().
+
+*//*******************************************************************/
+
+#include "SampleFormatSIMD.h"
+#include "CPUCaps.h"
+
+#include <string.h>
+
+#ifdef CPUCAPS_X86
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define SIMD_TARGET_FUNCTION(isa) static __forceinline
+#define SIMD_TARGET_ENTRY(isa) static
+#else
+#define SIMD_TARGET_FUNCTION(isa) \
+   static inline __attribute__((always_inline, target(isa)))
+#define SIMD_TARGET_ENTRY(isa) static __attribute__((target(isa)))
+#endif
+
+namespace SSE2 {
+
+#define SIMD_FUNCTION SIMD_TARGET_FUNCTION("sse2")
+#define SIMD_ENTRY SIMD_TARGET_ENTRY("sse2")
+
+struct Ops
+{
+   enum { Width = 4 };
+   using F = __m128;
+   using I = __m128i;
+
+   SIMD_FUNCTION F Set1(float x) { return _mm_set1_ps(x); }
+   SIMD_FUNCTION I Set1Int(int x) { return _mm_set1_epi32(x); }
+
+   SIMD_FUNCTION F LoadFloat(const float *p) { return _mm_loadu_ps(p); }
+   SIMD_FUNCTION void StoreFloat(float *p, F x) { _mm_storeu_ps(p, x); }
+   SIMD_FUNCTION I LoadInts(const int *p)
+      { return _mm_loadu_si128((const __m128i *)p); }
+   SIMD_FUNCTION void StoreInts(int *p, I x)
+      { _mm_storeu_si128((__m128i *)p, x); }
+
+   // Sign extended to 32 bits
+   SIMD_FUNCTION I LoadInt16(const short *p)
+   {
+      const I x = _mm_loadl_epi64((const __m128i *)p);
+      return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+   }
+   // Rounded to nearest and saturated
+   SIMD_FUNCTION void StoreInt16(short *p, F x)
+   {
+      const I ints = _mm_cvtps_epi32(x);
+      _mm_storel_epi64((__m128i *)p, _mm_packs_epi32(ints, ints));
+   }
+
+   SIMD_FUNCTION F Add(F a, F b) { return _mm_add_ps(a, b); }
+   SIMD_FUNCTION F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+   SIMD_FUNCTION F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+   SIMD_FUNCTION F Min(F a, F b) { return _mm_min_ps(a, b); }
+   SIMD_FUNCTION F Max(F a, F b) { return _mm_max_ps(a, b); }
+
+   SIMD_FUNCTION F ToFloat(I x) { return _mm_cvtepi32_ps(x); }
+   SIMD_FUNCTION I ToInts(F x) { return _mm_cvtps_epi32(x); }
+   SIMD_FUNCTION F AsFloat(I x) { return _mm_castsi128_ps(x); }
+
+   SIMD_FUNCTION I Xor(I a, I b) { return _mm_xor_si128(a, b); }
+   SIMD_FUNCTION I Or(I a, I b) { return _mm_or_si128(a, b); }
+   SIMD_FUNCTION I ShiftLeft(I x, int n) { return _mm_slli_epi32(x, n); }
+   SIMD_FUNCTION I ShiftRight(I x, int n) { return _mm_srli_epi32(x, n); }
+
+   // SSE2 has no min and max of 32 bit integers
+   SIMD_FUNCTION I Clamp(I x, int lo, int hi)
+   {
+      const I vlo = _mm_set1_epi32(lo), vhi = _mm_set1_epi32(hi);
+      const I below = _mm_cmpgt_epi32(vlo, x);
+      x = _mm_or_si128(_mm_and_si128(below, vlo), _mm_andnot_si128(below, x));
+      const I above = _mm_cmpgt_epi32(x, vhi);
+      return _mm_or_si128(_mm_and_si128(above, vhi), _mm_andnot_si128(above, x));
+   }
+
+   // Returns x moved up one lane with carry's first lane in the bottom,
+   // and sets every lane of carry to the top lane of x
+   SIMD_FUNCTION F ShiftIn(F x, F &carry)
+   {
+      const F shifted = _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4));
+      const F result = _mm_move_ss(shifted, carry);
+      carry = _mm_shuffle_ps(x, x, _MM_SHUFFLE(3, 3, 3, 3));
+      return result;
+   }
+   SIMD_FUNCTION float First(F x) { return _mm_cvtss_f32(x); }
+};
+
+#include "SampleFormatKernels.h"
+
+static const SampleConverters converters = SIMD_CONVERTERS("SSE2");
+
+#undef SIMD_FUNCTION
+#undef SIMD_ENTRY
+#undef SIMD_CONVERTERS
+
+}
+
+namespace AVX2 {
+
+#define SIMD_FUNCTION SIMD_TARGET_FUNCTION("avx2")
+#define SIMD_ENTRY SIMD_TARGET_ENTRY("avx2")
+
+struct Ops
+{
+   enum { Width = 8 };
+   using F = __m256;
+   using I = __m256i;
+
+   SIMD_FUNCTION F Set1(float x) { return _mm256_set1_ps(x); }
+   SIMD_FUNCTION I Set1Int(int x) { return _mm256_set1_epi32(x); }
+
+   SIMD_FUNCTION F LoadFloat(const float *p) { return _mm256_loadu_ps(p); }
+   SIMD_FUNCTION void StoreFloat(float *p, F x) { _mm256_storeu_ps(p, x); }
+   SIMD_FUNCTION I LoadInts(const int *p)
+      { return _mm256_loadu_si256((const __m256i *)p); }
+   SIMD_FUNCTION void StoreInts(int *p, I x)
+      { _mm256_storeu_si256((__m256i *)p, x); }
+
+   SIMD_FUNCTION I LoadInt16(const short *p)
+      { return _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)p)); }
+   SIMD_FUNCTION void StoreInt16(short *p, F x)
+   {
+      // The 256 bit pack works within each half, so pack the halves
+      const I ints = _mm256_cvtps_epi32(x);
+      _mm_storeu_si128((__m128i *)p,
+                       _mm_packs_epi32(_mm256_castsi256_si128(ints),
+                                       _mm256_extracti128_si256(ints, 1)));
+   }
+
+   SIMD_FUNCTION F Add(F a, F b) { return _mm256_add_ps(a, b); }
+   SIMD_FUNCTION F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+   SIMD_FUNCTION F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+   SIMD_FUNCTION F Min(F a, F b) { return _mm256_min_ps(a, b); }
+   SIMD_FUNCTION F Max(F a, F b) { return _mm256_max_ps(a, b); }
+
+   SIMD_FUNCTION F ToFloat(I x) { return _mm256_cvtepi32_ps(x); }
+   SIMD_FUNCTION I ToInts(F x) { return _mm256_cvtps_epi32(x); }
+   SIMD_FUNCTION F AsFloat(I x) { return _mm256_castsi256_ps(x); }
+
+   SIMD_FUNCTION I Xor(I a, I b) { return _mm256_xor_si256(a, b); }
+   SIMD_FUNCTION I Or(I a, I b) { return _mm256_or_si256(a, b); }
+   SIMD_FUNCTION I ShiftLeft(I x, int n) { return _mm256_slli_epi32(x, n); }
+   SIMD_FUNCTION I ShiftRight(I x, int n) { return _mm256_srli_epi32(x, n); }
+
+   SIMD_FUNCTION I Clamp(I x, int lo, int hi)
+   {
+      return _mm256_min_epi32(_mm256_max_epi32(x, _mm256_set1_epi32(lo)),
+                              _mm256_set1_epi32(hi));
+   }
+
+   SIMD_FUNCTION F ShiftIn(F x, F &carry)
+   {
+      const F rotated =
+         _mm256_permutevar8x32_ps(x, _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6));
+      const F result = _mm256_blend_ps(rotated, carry, 1);
+      carry = _mm256_permutevar8x32_ps(x, _mm256_set1_epi32(7));
+      return result;
+   }
+   SIMD_FUNCTION float First(F x) { return _mm256_cvtss_f32(x); }
+};
+
+#include "SampleFormatKernels.h"
+
+static const SampleConverters converters = SIMD_CONVERTERS("AVX2");
+
+#undef SIMD_FUNCTION
+#undef SIMD_ENTRY
+#undef SIMD_CONVERTERS
+
+}
+
+#endif // CPUCAPS_X86
+
+void SIMDDitherState::Seed(unsigned int seed)
+{
+   // Spread the seed over the lanes with an LCG; xorshift must not
+   // start from zero
+   for (auto &state : random) {
+      seed = seed * 1664525u + 1013904223u;
+      state = seed ? seed : 1;
+   }
+   triangle = 0;
+}
+
+auto SampleConverters::GetBestLevel() -> VectorLevel
+{
+   const auto &caps = GetCPUCaps();
+   if (caps.AVX2)
+      return AVX2;
+   if (caps.SSE2)
+      return SSE2;
+   return Scalar;
+}
+
+const SampleConverters *SampleConverters::Get(VectorLevel level)
+{
+#ifdef CPUCAPS_X86
+   const auto &caps = GetCPUCaps();
+   switch (level) {
+   case SSE2:
+      return caps.SSE2 ? &::SSE2::converters : nullptr;
+   case AVX2:
+      return caps.AVX2 ? &::AVX2::converters : nullptr;
+   default:
+      break;
+   }
+#endif
+   return nullptr;
+}
@@ -0,0 +1,70 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SampleFormatSIMD.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_SAMPLE_FORMAT_SIMD__
+#define __AUDACITY_SAMPLE_FORMAT_SIMD__
+
+#include <stddef.h>
+
+/// State carried between calls of the dithering converters: one
+/// pseudo-random generator per vector lane, and the last noise value
+/// for triangle dither.
+struct SIMDDitherState
+{
+   enum { MaxLanes = 8 };
+
+   unsigned int random[MaxLanes];
+   float triangle;
+
+   void Seed(unsigned int seed);
+};
+
+/// Vectorized conversions between the sample formats, for buffers of
+/// contiguous samples.  Dither::Apply uses them when both strides are 1.
+///
+/// Without dither the results are identical to those of Dither::Apply.
+/// The rectangle and triangle dithers make the same noise distribution
+/// as Dither's, from a different generator.  Shaped dither feeds back
+/// the error of each sample into the next, so it stays scalar.
+struct SampleConverters
+{
+   enum VectorLevel {
+      Scalar,
+      SSE2,
+      AVX2,
+      nVectorLevels
+   };
+
+   /// Index of the integer conversions
+   enum DitherIndex {
+      NoDither,
+      RectangleDither,
+      TriangleDither,
+      nDithers
+   };
+
+   /// The best level that the processor supports
+   static VectorLevel GetBestLevel();
+   /// The converters for a level, or null for Scalar or an unsupported level
+   static const SampleConverters *Get(VectorLevel level);
+
+   const char *name;
+
+   void (*Int16ToFloat)(const short *src, float *dst, size_t len);
+   void (*Int24ToFloat)(const int *src, float *dst, size_t len);
+   void (*Int16ToInt24)(const short *src, int *dst, size_t len);
+
+   void (*FloatToInt16[nDithers])(const float *src, short *dst, size_t len,
+                                  SIMDDitherState &state);
+   void (*FloatToInt24[nDithers])(const float *src, int *dst, size_t len,
+                                  SIMDDitherState &state);
+   void (*Int24ToInt16[nDithers])(const int *src, short *dst, size_t len,
+                                  SIMDDitherState &state);
+};
+
+#endif
@@ -44,6 +44,7 @@
 #include "BlockFile.h"
 #include "blockfile/ODDecodeBlockFile.h"
 #include "DirManager.h"
+#include "SummaryPyramid.h"
 
 #include "blockfile/SimpleBlockFile.h"
 #include "blockfile/SilentBlockFile.h"
@@ -54,7 +55,8 @@ size_t Sequence::sMaxDiskBlockSize = 1048576;
 Sequence::Sequence(const std::shared_ptr<DirManager> &projDirManager, sampleFormat format)
    : mDirManager(projDirManager)
    , mSampleFormat(format)
-   , mMinSamples(sMaxDiskBlockSize / SAMPLE_SIZE(mSampleFormat) / 2)
+   , mMinSamples(projDirManager->GetMaxDiskBlockSize() /
+                 SAMPLE_SIZE(mSampleFormat) / 2)
    , mMaxSamples(mMinSamples * 2)
 {
 }
@@ -68,6 +70,16 @@ Sequence::Sequence(const Sequence &orig, const std::shared_ptr<DirManager> &proj
    , mMinSamples(orig.mMinSamples)
    , mMaxSamples(orig.mMaxSamples)
 {
+   if (mDirManager == orig.mDirManager) {
+      // Within one project, copying each block would only add a reference
+      // to its file, so share the whole array instead, until one of the
+      // sequences changes.  (Only the locked blocks of the last saved
+      // version would be copied, and no copies are made while they are.)
+      mBlock = orig.mBlock;
+      mNumSamples = orig.mNumSamples;
+      return;
+   }
+
    bool bResult = Paste(0, &orig);
    wxASSERT(bResult); // TO DO: Actually handle this.
    (void)bResult;
@@ -89,24 +101,24 @@ size_t Sequence::GetIdealBlockSize() const
 
 bool Sequence::Lock()
 {
-   for (unsigned int i = 0; i < mBlock.size(); i++)
-      mBlock[i].f->Lock();
+   for (const auto &block : mBlock.Get())
+      block.f->Lock();
 
    return true;
 }
 
 bool Sequence::CloseLock()
 {
-   for (unsigned int i = 0; i < mBlock.size(); i++)
-      mBlock[i].f->CloseLock();
+   for (const auto &block : mBlock.Get())
+      block.f->CloseLock();
 
    return true;
 }
 
 bool Sequence::Unlock()
 {
-   for (unsigned int i = 0; i < mBlock.size(); i++)
-      mBlock[i].f->Unlock();
+   for (const auto &block : mBlock.Get())
+      block.f->Unlock();
 
    return true;
 }
@@ -147,8 +159,10 @@ bool Sequence::ConvertToSampleFormat(sampleFormat format, bool* pbChanged)
    mSampleFormat = format;
 
    const auto oldMinSamples = mMinSamples, oldMaxSamples = mMaxSamples;
-   // These are the same calculations as in the constructor.
-   mMinSamples = sMaxDiskBlockSize / SAMPLE_SIZE(mSampleFormat) / 2;
+   // These are the same calculations as in the constructor, keeping the
+   // size of the blocks in bytes, which may not be that of NEW projects.
+   mMinSamples =
+      oldMaxSamples * SAMPLE_SIZE(oldFormat) / SAMPLE_SIZE(mSampleFormat) / 2;
    mMaxSamples = mMinSamples * 2;
 
    BlockArray newBlockArray;
@@ -198,7 +212,7 @@ bool Sequence::ConvertToSampleFormat(sampleFormat format, bool* pbChanged)
       // Aliased files will be converted at save, per comment above.
 
       // Replace with NEW blocks.
-      mBlock.swap(newBlockArray);
+      mBlock.Replace(std::move(newBlockArray));
    }
    else
    {
@@ -322,6 +336,17 @@ bool Sequence::GetRMS(sampleCount start, sampleCount len,
       return true;
    }
 
+   {
+      double sum, sumSquares;
+      sampleCount clipCount;
+      if (GetStatistics(start, len, &sum, &sumSquares, &clipCount)) {
+         *outRMS = sqrt(sumSquares / len.as_double());
+         return true;
+      }
+   }
+
+   // Some data are not yet available, or some blocks do not know their
+   // exact statistics; the summaries stand in for them.
    double sumsq = 0.0;
    sampleCount length = 0; // this is the cumulative length of the bits we have the ms of so far, and should end up == len
 
@@ -385,6 +410,93 @@ bool Sequence::GetRMS(sampleCount start, sampleCount len,
    return true;
 }
 
+bool Sequence::GetMean(sampleCount start, sampleCount len,
+                       double * outMean) const
+{
+   *outMean = 0.0;
+   if (len == 0 || mBlock.size() == 0)
+      return true;
+
+   double sum, sumSquares;
+   sampleCount clipCount;
+   if (!GetStatistics(start, len, &sum, &sumSquares, &clipCount))
+      return false;
+
+   *outMean = sum / len.as_double();
+   return true;
+}
+
+bool Sequence::GetClipCount(sampleCount start, sampleCount len,
+                            sampleCount * outCount) const
+{
+   *outCount = 0;
+   if (len == 0 || mBlock.size() == 0)
+      return true;
+
+   double sum, sumSquares;
+   return GetStatistics(start, len, &sum, &sumSquares, outCount);
+}
+
+bool Sequence::GetStatistics(sampleCount start, sampleCount len,
+                             double * outSum, double * outSumSquares,
+                             sampleCount * outClipCount) const
+{
+   *outSum = *outSumSquares = 0.0;
+   *outClipCount = 0;
+
+   unsigned int block0 = FindBlock(start);
+   unsigned int block1 = FindBlock(start + len - 1);
+
+   double sum, sumSquares;
+   size_t clipCount;
+
+   // The whole blocks in the middle of the region need no reading of
+   // samples; fail for blocks that were loaded without statistics
+   for (unsigned b = block0 + 1; b < block1; b++) {
+      if (!mBlock[b].f->GetStatistics(&sum, &sumSquares, &clipCount))
+         return false;
+      *outSum += sum;
+      *outSumSquares += sumSquares;
+      *outClipCount += clipCount;
+   }
+
+   // The first and last blocks may be only partly in the region
+   {
+      const SeqBlock &theBlock = mBlock[block0];
+      const auto &theFile = theBlock.f;
+      const auto s0 = ( start - theBlock.start ).as_size_t();
+      const auto maxl0 =
+         (theBlock.start + theFile->GetLength() - start).as_size_t();
+      const auto l0 = limitSampleBufferSize( maxl0, len );
+
+      const bool ok = (s0 == 0 && l0 == theFile->GetLength())
+         ? theFile->GetStatistics(&sum, &sumSquares, &clipCount)
+         : theFile->GetStatistics(s0, l0, &sum, &sumSquares, &clipCount);
+      if (!ok)
+         return false;
+      *outSum += sum;
+      *outSumSquares += sumSquares;
+      *outClipCount += clipCount;
+   }
+
+   if (block1 > block0) {
+      const SeqBlock &theBlock = mBlock[block1];
+      const auto &theFile = theBlock.f;
+      const auto l0 = ( start + len - theBlock.start ).as_size_t();
+
+      const bool ok = (l0 == theFile->GetLength())
+         ? theFile->GetStatistics(&sum, &sumSquares, &clipCount)
+         : theFile->GetStatistics(0, l0, &sum, &sumSquares, &clipCount);
+      if (!ok)
+         return false;
+      *outSum += sum;
+      *outSumSquares += sumSquares;
+      *outClipCount += clipCount;
+   }
+
+   return true;
+}
+
 bool Sequence::Copy(sampleCount s0, sampleCount s1, std::unique_ptr<Sequence> &dest) const
 {
    dest.reset();
@@ -489,7 +601,7 @@ bool Sequence::Paste(sampleCount s, const Sequence *src)
       return false;
    }
 
-   const BlockArray &srcBlock = src->mBlock;
+   const BlockArray &srcBlock = src->mBlock.Get();
    auto addedLen = src->mNumSamples;
    const unsigned int srcNumBlocks = srcBlock.size();
    auto sampleSize = SAMPLE_SIZE(mSampleFormat);
@@ -635,7 +747,7 @@ bool Sequence::Paste(sampleCount s, const Sequence *src)
    for (i = b + 1; i < numBlocks; i++)
       newBlock.push_back(mBlock[i].Plus(addedLen));
 
-   mBlock.swap(newBlock);
+   mBlock.Replace(std::move(newBlock));
 
    mNumSamples += addedLen;
 
@@ -765,8 +877,8 @@ bool Sequence::AppendBlock(const SeqBlock &b)
 unsigned int Sequence::GetODFlags()
 {
    unsigned int ret = 0;
-   for (unsigned int i = 0; i < mBlock.size(); i++) {
-      const auto &file = mBlock[i].f;
+   for (const auto &block : mBlock.Get()) {
+      const auto &file = block.f;
       if(!file->IsDataAvailable())
          ret |= (static_cast< ODDecodeBlockFile * >( &*file ))->GetDecodeType();
       else if(!file->IsSummaryAvailable())
@@ -863,7 +975,7 @@ bool Sequence::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
       } // while
 
       mBlock.push_back(wb);
-      mDirManager->SetLoadingTarget(&mBlock, mBlock.size() - 1);
+      mDirManager->SetLoadingTarget(&mBlock.Mutable(), mBlock.size() - 1);
 
       return true;
    }
@@ -900,6 +1012,9 @@ bool Sequence::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
 
             // nValue is now safe for size_t
             mMaxSamples = nValue;
+            // The saved size of blocks governs the minimum too, whatever
+            // the size for this project's NEW tracks
+            mMinSamples = mMaxSamples / 2;
 
             // PRL:  Is the following really okay?  DirManager might be shared across projects!
             // PRL:  Yes, because it only affects DirManager's behavior in opening the project.
@@ -1035,7 +1150,7 @@ void Sequence::WriteXML(XMLWriter &xmlFile)
    xmlFile.WriteAttr(wxT("numsamples"), mNumSamples.as_long_long() );
 
    for (b = 0; b < mBlock.size(); b++) {
-      SeqBlock &bb = mBlock[b];
+      const SeqBlock &bb = mBlock.Get()[b];
 
       // See http://bugzilla.audacityteam.org/show_bug.cgi?id=451.
       // Also, don't check against mMaxSamples for AliasBlockFiles, because if you convert sample format,
@@ -1063,6 +1178,15 @@ void Sequence::WriteXML(XMLWriter &xmlFile)
    xmlFile.EndTag(wxT("sequence"));
 }
 
+unsigned long long Sequence::GetXMLStamp() const
+{
+   XMLStamp stamp;
+   stamp.Add(mMaxSamples).Add(mSampleFormat).Add(mNumSamples.as_long_long());
+   for (const auto &block : mBlock)
+      stamp.Add(block.start.as_long_long()).Add(block.f->GetXMLStamp());
+   return stamp.Get();
+}
+
 int Sequence::FindBlock(sampleCount pos) const
 {
    wxASSERT(pos >= 0 && pos < mNumSamples);
@@ -1170,6 +1294,22 @@ bool Sequence::Get(samplePtr buffer, sampleFormat format,
    return Get(b, buffer, format, start, len);
 }
 
+const float *Sequence::GetFloatData(sampleCount start, size_t len,
+                                    MappedFilePtr &holder) const
+{
+   if (mSampleFormat != floatSample ||
+       start < 0 || len == 0 || start + len > mNumSamples)
+      return nullptr;
+
+   const SeqBlock &block = mBlock[FindBlock(start)];
+   const auto blockRelativeStart = (start - block.start).as_size_t();
+   if (blockRelativeStart + len > block.f->GetLength())
+      return nullptr;
+
+   const float *data = block.f->GetFloatData(holder);
+   return data ? data + blockRelativeStart : nullptr;
+}
+
 bool Sequence::Get(int b, samplePtr buffer, sampleFormat format,
    sampleCount start, size_t len) const
 {
@@ -1270,7 +1410,9 @@ struct MinMaxSumsq
                max = v;
             sumsq += v * v;
             break;
+         case 16:
          case 256:
+         case 4096:
          case 65536:
             // array holds triples of min, max, and rms values
             v = *pv++;
@@ -1307,6 +1449,11 @@ bool Sequence::GetWaveDisplay(float *min, float *max, float *rms, int* bl,
    // ... unless the mNumSamples ceiling applies, and then there are other defenses
    const auto s1 =
       std::min(mNumSamples, std::max(1 + where[len - 1], where[len]));
+
+   // So zoomed out that whole blocks fall within pixel columns?
+   if ((s1 - s0).as_double() / len >= UpperFrameSize)
+      return GetWaveDisplayUpper(min, max, rms, bl, len, where);
+
    float *temp = new float[mMaxSamples];
 
    decltype(len) pixel = 0;
@@ -1329,7 +1476,7 @@ bool Sequence::GetWaveDisplay(float *min, float *max, float *rms, int* bl,
 
       // Find the range of sample values for this block that
       // are in the display.
-      SeqBlock &seqBlock = mBlock[b];
+      const SeqBlock &seqBlock = mBlock.Get()[b];
       const auto start = seqBlock.start;
       nextSrcX = std::min(s1, start + seqBlock.f->GetLength());
 
@@ -1362,13 +1509,13 @@ bool Sequence::GetWaveDisplay(float *min, float *max, float *rms, int* bl,
       if (nextPixel == len)
          whereNext = s1;
 
-      // Decide the summary level
+      // Decide the summary level:  the coarsest one with frames no
+      // longer than a pixel column, or else the samples
       const double samplesPerPixel =
          (whereNext - whereNow).as_double() / (nextPixel - pixel);
+      const int level = SummaryPyramid::LevelFor(samplesPerPixel);
       const int divisor =
-           (samplesPerPixel >= 65536) ? 65536
-         : (samplesPerPixel >= 256) ? 256
-         : 1;
+         (level < 0) ? 1 : (int)SummaryPyramid::FrameSize(level);
 
       int blockStatus = b;
 
@@ -1395,30 +1542,14 @@ bool Sequence::GetWaveDisplay(float *min, float *max, float *rms, int* bl,
       }
 
       // Read from the block file or its summary
-      switch (divisor) {
-      default:
-      case 1:
+      if (divisor == 1)
          // Read samples
          Read((samplePtr)temp, floatSample, seqBlock, startPosition, num);
-         break;
-      case 256:
-         // Read triples
-         //check to see if summary data has been computed
-         if (seqBlock.f->IsSummaryAvailable())
-            seqBlock.f->Read256(temp, startPosition, num);
-         else
-            //otherwise, mark the display as not yet computed
-            blockStatus = -1 - b;
-         break;
-      case 65536:
-         // Read triples
-         //check to see if summary data has been computed
-         if (seqBlock.f->IsSummaryAvailable())
-            seqBlock.f->Read64K(temp, startPosition, num);
-         else
-            //otherwise, mark the display as not yet computed
-            blockStatus = -1 - b;
-         break;
+      else if (!seqBlock.f->ReadSummaryLevel(level, temp, startPosition, num)) {
+         // Read triples, unless the summary data have not been computed;
+         // then mark the display as not yet computed
+         std::fill(temp, temp + 3 * num, 0.0f);
+         blockStatus = -1 - b;
       }
       
       auto filePosition = startPosition;
@@ -1497,6 +1628,135 @@ bool Sequence::GetWaveDisplay(float *min, float *max, float *rms, int* bl,
    return true;
 }
 
+int Sequence::GetUpperFrame(size_t frame, float &min, float &max, float &rms,
+                            float *temp)
+{
+   const auto s0 = sampleCount( frame ) * UpperFrameSize;
+   const auto s1 = std::min( mNumSamples, s0 + UpperFrameSize );
+   const int b0 = FindBlock(s0);
+   const int nBlocks = mBlock.size();
+
+   // Identify the blocks now covering the frame
+   unsigned long long signature = 0;
+   int b1 = b0;
+   const BlockArray &blocks = mBlock.Get();
+   for (; b1 < nBlocks && blocks[b1].start < s1; ++b1) {
+      const SeqBlock &seqBlock = blocks[b1];
+      for (unsigned long long value :
+              { seqBlock.f->GetSerial(),
+                (unsigned long long)seqBlock.start.as_long_long(),
+                (unsigned long long)seqBlock.f->GetLength() })
+         signature = (signature ^ value) * 1099511628211ull;
+   }
+
+   if (frame < mUpperSummary.size()) {
+      const UpperFrame &cached = mUpperSummary[frame];
+      if (cached.valid && cached.signature == signature) {
+         min = cached.min, max = cached.max, rms = cached.rms;
+         return b0;
+      }
+   }
+
+   const auto frameSize64K = SummaryPyramid::FrameSize(SummaryPyramid::Level64K);
+   min = FLT_MAX, max = -FLT_MAX;
+   double sumsq = 0;
+   for (int b = b0; b < b1; ++b) {
+      const SeqBlock &seqBlock = blocks[b];
+      if (!seqBlock.f->IsSummaryAvailable()) {
+         // Don't remember anything for this frame yet
+         min = max = rms = 0;
+         return -1 - b;
+      }
+
+      const auto fileLength = seqBlock.f->GetLength();
+      // Range of the block within the frame
+      const auto start =
+         ( std::max( s0, seqBlock.start ) - seqBlock.start ).as_size_t();
+      const auto end =
+         ( std::min( s1, seqBlock.start + fileLength ) - seqBlock.start )
+            .as_size_t();
+
+      float blockMin, blockMax, blockRms;
+      if (start == 0 && end == fileLength)
+         seqBlock.f->GetMinMax(&blockMin, &blockMax, &blockRms);
+      else {
+         // Partial blocks, at the frame's edges, use the 64K frames that
+         // overlap them
+         const auto first = start / frameSize64K;
+         const auto num = 1 + (end - 1) / frameSize64K - first;
+         if (!seqBlock.f->ReadSummaryLevel(SummaryPyramid::Level64K,
+                                           temp, first, num)) {
+            min = max = rms = 0;
+            return -1 - b;
+         }
+         MinMaxSumsq values(temp, num, frameSize64K);
+         blockMin = values.min, blockMax = values.max;
+         blockRms = sqrt(values.sumsq / num);
+      }
+
+      min = std::min(min, blockMin);
+      max = std::max(max, blockMax);
+      sumsq += (double)blockRms * blockRms * (end - start);
+   }
+
+   const auto count = ( s1 - s0 ).as_double();
+   rms = count > 0 ? sqrt(sumsq / count) : 0;
+
+   const auto nFrames =
+      ( ( mNumSamples + UpperFrameSize - 1 ) / UpperFrameSize ).as_size_t();
+   if (mUpperSummary.size() != nFrames)
+      mUpperSummary.resize(nFrames, UpperFrame{ 0, 0, 0, 0, false });
+   if (frame < nFrames)
+      mUpperSummary[frame] = UpperFrame{ min, max, rms, signature, true };
+
+   return b0;
+}
+
+bool Sequence::GetWaveDisplayUpper(float *min, float *max, float *rms, int* bl,
+                                   size_t len, const sampleCount *where)
+{
+   const auto nFrames =
+      ( ( mNumSamples + UpperFrameSize - 1 ) / UpperFrameSize ).as_size_t();
+   float *temp = new float[3 * (UpperFrameSize /
+      SummaryPyramid::FrameSize(SummaryPyramid::Level64K) + 1)];
+
+   for (decltype(len) pixel = 0; pixel < len; ++pixel) {
+      // The column for pixel p covers samples from
+      // where[p] up to but excluding where[p + 1].
+      // Round to the nearest frame boundaries, taking at least one frame.
+      const auto half = UpperFrameSize / 2;
+      const auto w0 = std::max( sampleCount( 0 ), where[pixel] );
+      const auto w1 = std::min( mNumSamples, where[pixel + 1] );
+      const auto frame0 = std::min( nFrames - 1,
+         ( ( w0 + half ) / UpperFrameSize ).as_size_t() );
+      const auto frame1 = std::min( nFrames, std::max( frame0 + 1,
+         ( ( std::max( w0, w1 ) + half ) / UpperFrameSize ).as_size_t() ) );
+
+      float pixelMin = FLT_MAX, pixelMax = -FLT_MAX;
+      double sumsq = 0;
+      int status = 0;
+      for (auto frame = frame0; frame < frame1; ++frame) {
+         float frameMin, frameMax, frameRms;
+         const int frameStatus =
+            GetUpperFrame(frame, frameMin, frameMax, frameRms, temp);
+         if (frame == frame0 || frameStatus < 0)
+            status = frameStatus;
+         pixelMin = std::min(pixelMin, frameMin);
+         pixelMax = std::max(pixelMax, frameMax);
+         sumsq += frameRms * frameRms;
+      }
+
+      min[pixel] = pixelMin;
+      max[pixel] = pixelMax;
+      rms[pixel] = sqrt(sumsq / (frame1 - frame0));
+      bl[pixel] = status;
+   }
+
+   delete[] temp;
+
+   return true;
+}
+
 size_t Sequence::GetIdealAppendLen() const
 {
    int numBlocks = mBlock.size();
@@ -1771,7 +2031,7 @@ bool Sequence::Delete(sampleCount start, sampleCount len)
       newBlock.push_back(mBlock[i].Plus(-len));
 
    // Substitute our NEW array for the old one
-   mBlock.swap(newBlock);
+   mBlock.Replace(std::move(newBlock));
 
    // Update total number of samples and do a consistency check.
    mNumSamples -= len;
@@ -1779,6 +2039,85 @@ bool Sequence::Delete(sampleCount start, sampleCount len)
    return ConsistencyCheck(wxT("Delete - branch two"));
 }
 
+size_t Sequence::Compact(size_t maxBytes,
+                         const std::set<const BlockFile*> *inUse)
+{
+   DeleteUpdateMutexLocker locker(*this);
+
+   const auto sampleSize = SAMPLE_SIZE(mSampleFormat);
+
+   // Only blocks whose samples are ours and at hand, and that nothing
+   // else uses, are merged
+   auto canMerge = [inUse](const SeqBlock &block) {
+      const auto &f = block.f;
+      return !f->IsAlias() &&
+         f->IsDataAvailable() && f->IsSummaryAvailable() &&
+         !(inUse && inUse->count(&*f));
+   };
+
+   SampleBuffer scratch;
+   size_t bytes = 0;
+
+   // Don't make a private copy of shared blocks until there is a merge
+   for (size_t b0 = 0; b0 < mBlock.size(); ) {
+      const BlockArray &blocks = mBlock.Get();
+
+      // The longest run from b0 that fits in one block
+      size_t b1 = b0;
+      size_t total = 0;
+      bool anySmall = false;
+      while (b1 < blocks.size() && canMerge(blocks[b1])) {
+         const auto len = blocks[b1].f->GetLength();
+         if (total + len > mMaxSamples)
+            break;
+         total += len;
+         anySmall = anySmall || len < mMinSamples;
+         ++b1;
+      }
+
+      if (b1 - b0 < 2 || !anySmall) {
+         ++b0;
+         continue;
+      }
+
+      if (bytes > 0 && bytes + total * sampleSize > maxBytes)
+         break;
+
+      if (!scratch.ptr())
+         scratch.Allocate(mMaxSamples, mSampleFormat);
+
+      // A block that can't be read is left as it is, with its run
+      bool readOk = true;
+      size_t offset = 0;
+      for (auto b = b0; readOk && b < b1; ++b) {
+         const auto len = blocks[b].f->GetLength();
+         readOk = Read(scratch.ptr() + offset * sampleSize, mSampleFormat,
+                       blocks[b], 0, len);
+         offset += len;
+      }
+      if (!readOk) {
+         b0 = b1;
+         continue;
+      }
+
+      auto file =
+         mDirManager->NewSimpleBlockFile(scratch.ptr(), total, mSampleFormat);
+
+      BlockArray &mutableBlocks = mBlock.Mutable();
+      mutableBlocks[b0].f = file;
+      mutableBlocks.erase(mutableBlocks.begin() + b0 + 1,
+                          mutableBlocks.begin() + b1);
+
+      bytes += total * sampleSize;
+      ++b0;
+   }
+
+   if (bytes > 0)
+      ConsistencyCheck(wxT("Compact"));
+
+   return bytes;
+}
+
 bool Sequence::ConsistencyCheck(const wxChar *whereStr) const
 {
    unsigned int i;
@@ -12,6 +12,7 @@
 #define __AUDACITY_SEQUENCE__
 
 #include "MemoryX.h"
+#include <set>
 #include <vector>
 #include <wx/string.h>
 #include <wx/dynarray.h>
@@ -26,6 +27,9 @@
 class BlockFile;
 using BlockFilePtr = std::shared_ptr<BlockFile>;
 
+class MappedFile;
+using MappedFilePtr = std::shared_ptr<const MappedFile>;
+
 class DirManager;
 
 // This is an internal data structure!  For advanced use only.
@@ -52,6 +56,52 @@ class SeqBlock {
 class BlockArray : public std::vector<SeqBlock> {};
 using BlockPtrArray = std::vector<SeqBlock*>; // non-owning pointers
 
+// The blocks of a sequence, which copies of the sequence share, as the states
+// of the undo history do, until one of them changes.  The const accessors
+// read the shared array; the others first make a private copy of it, if it
+// is shared, so a sequence that is only read is never copied.
+class SharedBlockArray {
+ public:
+   SharedBlockArray()
+      : mArray{ std::make_shared<BlockArray>() }
+   {}
+
+   const BlockArray &Get() const { return *mArray; }
+   BlockArray &Mutable()
+   {
+      if (mArray.use_count() > 1)
+         mArray = std::make_shared<BlockArray>(*mArray);
+      return *mArray;
+   }
+
+   size_t size() const { return mArray->size(); }
+   bool empty() const { return mArray->empty(); }
+
+   const SeqBlock &operator [] (size_t i) const { return Get()[i]; }
+   SeqBlock &operator [] (size_t i) { return Mutable()[i]; }
+   const SeqBlock &back() const { return Get().back(); }
+   SeqBlock &back() { return Mutable().back(); }
+
+   BlockArray::const_iterator begin() const { return Get().begin(); }
+   BlockArray::const_iterator end() const { return Get().end(); }
+   BlockArray::iterator begin() { return Mutable().begin(); }
+   BlockArray::iterator end() { return Mutable().end(); }
+
+   void push_back(const SeqBlock &block) { Mutable().push_back(block); }
+   void reserve(size_t size) { Mutable().reserve(size); }
+
+   // Take the contents of blocks, without copying the old ones first
+   void Replace(BlockArray &&blocks)
+   {
+      if (mArray.use_count() > 1)
+         mArray = std::make_shared<BlockArray>();
+      mArray->swap(blocks);
+   }
+
+ private:
+   std::shared_ptr<BlockArray> mArray;
+};
+
 class PROFILE_DLL_API Sequence final : public XMLTagHandler{
  public:
 
@@ -59,6 +109,8 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    // Static methods
    //
 
+   // The size of blocks for NEW projects; each project's DirManager
+   // remembers its own
    static void SetMaxDiskBlockSize(size_t bytes);
    static size_t GetMaxDiskBlockSize();
 
@@ -84,6 +136,11 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    bool Get(samplePtr buffer, sampleFormat format,
             sampleCount start, size_t len) const;
 
+   // The samples in place, if they lie within one block that can map its
+   // file of floats; else null.  The pointer is valid while holder lives.
+   const float *GetFloatData(sampleCount start, size_t len,
+                             MappedFilePtr &holder) const;
+
    // Note that len is not size_t, because nullptr may be passed for buffer, in
    // which case, silence is inserted, possibly a large amount.
    bool Set(samplePtr buffer, sampleFormat format,
@@ -127,6 +184,16 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    bool SetSilence(sampleCount s0, sampleCount len);
    bool InsertSilence(sampleCount s0, sampleCount len);
 
+   // Merges runs of adjacent blocks that include blocks shorter than the
+   // minimum, as edits leave them, into blocks no longer than the maximum.
+   // Stops after rewriting about maxBytes of samples, but always makes
+   // one merge if there is one to make.  Returns the bytes rewritten,
+   // zero when there is nothing to merge.  Blocks in inUse, if given, are
+   // left as they are:  something else keeps them on disk, so replacing
+   // them would only take more space.
+   size_t Compact(size_t maxBytes,
+                  const std::set<const BlockFile*> *inUse = nullptr);
+
    const std::shared_ptr<DirManager> &GetDirManager() { return mDirManager; }
 
    //
@@ -137,6 +204,8 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    void HandleXMLEndTag(const wxChar *tag) override;
    XMLTagHandler *HandleXMLChild(const wxChar *tag) override;
    void WriteXML(XMLWriter &xmlFile) /* not override */;
+   // Changes whenever WriteXML would write something different
+   unsigned long long GetXMLStamp() const;
 
    bool GetErrorOpening() { return mErrorOpening; }
 
@@ -169,6 +238,13 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
                   float * min, float * max) const;
    bool GetRMS(sampleCount start, sampleCount len,
                   float * outRMS) const;
+   // These two fail, as GetStatistics below does, if the exact sums are
+   // not known, and then the caller must read the samples
+   bool GetMean(sampleCount start, sampleCount len,
+                double * outMean) const;
+   // Number of samples at full scale
+   bool GetClipCount(sampleCount start, sampleCount len,
+                     sampleCount * outCount) const;
 
    //
    // Getting block size and alignment information
@@ -187,7 +263,9 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    // you're doing!
    //
 
-   BlockArray &GetBlockArray() {return mBlock;}
+   // The non-const overload stops sharing the blocks with copies
+   BlockArray &GetBlockArray() {return mBlock.Mutable();}
+   const BlockArray &GetBlockArray() const {return mBlock.Get();}
 
    ///
    void LockDeleteUpdateMutex(){mDeleteUpdateMutex.Lock();}
@@ -222,7 +300,7 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
 
    std::shared_ptr<DirManager> mDirManager;
 
-   BlockArray    mBlock;
+   SharedBlockArray mBlock;
    sampleFormat  mSampleFormat;
 
    // Not size_t!  May need to be large:
@@ -236,12 +314,34 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    ///To block the Delete() method against the ODCalcSummaryTask::Update() method
    ODLock   mDeleteUpdateMutex;
 
+   // A level of summary above those of the block files, in frames of
+   // UpperFrameSize samples aligned to the start of the sequence, for
+   // drawing when zoomed out past the coarsest level of the blocks.
+   // Each frame remembers the serial numbers of the blocks it was made
+   // from, so that it is made again after any edit of them, even when a
+   // NEW block reuses the address of an old one.  Used only by
+   // GetWaveDisplay.
+   enum { UpperFrameSize = 1 << 20 };
+   struct UpperFrame {
+      float min, max, rms;
+      unsigned long long signature;
+      bool valid;
+   };
+   std::vector<UpperFrame> mUpperSummary;
+
    //
    // Private methods
    //
 
    int FindBlock(sampleCount pos) const;
 
+   // Exact sums over the region, from the statistics of the whole blocks
+   // and the samples of those at the ends.  Fails if any of the data are
+   // not yet available (for OD), or a whole block lacks its statistics.
+   bool GetStatistics(sampleCount start, sampleCount len,
+                      double * outSum, double * outSumSquares,
+                      sampleCount * outClipCount) const;
+
    bool AppendBlock(const SeqBlock &b);
 
    bool Read(samplePtr buffer, sampleFormat format,
@@ -257,6 +357,13 @@ class PROFILE_DLL_API Sequence final : public XMLTagHandler{
    bool Get(int b, samplePtr buffer, sampleFormat format,
       sampleCount start, size_t len) const;
 
+   // Returns the status to report in bl for the frame, negative if data
+   // are not yet available
+   int GetUpperFrame(size_t frame, float &min, float &max, float &rms,
+                     float *temp);
+   bool GetWaveDisplayUpper(float *min, float *max, float *rms, int* bl,
+                            size_t len, const sampleCount *where);
+
  public:
 
    //
@@ -0,0 +1,99 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SpectrumAnalyst.h
+
+  Dominic Mazzoni
+
+**********************************************************************/
+
+#ifndef __AUDACITY_SPECTRUM_ANALYST__
+#define __AUDACITY_SPECTRUM_ANALYST__
+
+#include "Audacity.h"
+#include <functional>
+#include <vector>
+
+class WaveTrack;
+
+class AUDACITY_DLL_API SpectrumAnalyst
+{
+public:
+
+   enum Algorithm {
+      Spectrum,
+      Autocorrelation,
+      CubeRootAutocorrelation,
+      EnhancedAutocorrelation,
+      Cepstrum,
+
+      NumAlgorithms
+   };
+
+   // Called with the fraction of the data done; return false to cancel
+   using ProgressCallback = std::function< bool(double fraction) >;
+
+   SpectrumAnalyst();
+   ~SpectrumAnalyst();
+
+   // Return true iff successful
+   bool Calculate(Algorithm alg,
+      int windowFunc, // see FFT.h for values
+      size_t windowSize, double rate,
+      const float *data, size_t dataLen,
+      float *pYMin = NULL, float *pYMax = NULL, // outputs
+      const ProgressCallback &progress = ProgressCallback{});
+
+   // Analyzes the sum of the tracks from t0 to t1.  The tracks must have
+   // the same rate.  The samples are read and analyzed a chunk at a time
+   // on another thread, so memory use does not depend on the length;
+   // progress is called on this thread while waiting.
+   // Return true iff successful and not cancelled
+   bool Calculate(Algorithm alg,
+      int windowFunc,
+      size_t windowSize,
+      const std::vector<const WaveTrack*> &tracks, double t0, double t1,
+      float *pYMin = NULL, float *pYMax = NULL, // outputs
+      const ProgressCallback &progress = ProgressCallback{});
+
+   // The streaming interface, used by both of the above:  Start, then
+   // Process the data in pieces of any length, then Finish.
+   // Start and Finish return true iff successful.
+   bool Start(Algorithm alg, int windowFunc, size_t windowSize, double rate);
+   void Process(const float *data, size_t len);
+   bool Finish(float *pYMin = NULL, float *pYMax = NULL);
+
+   const float *GetProcessed() const;
+   int GetProcessedSize() const;
+
+   float GetProcessedValue(float freq0, float freq1) const;
+   float FindPeak(float xPos, float *pY) const;
+
+private:
+   void ProcessWindow(const float *data);
+
+   float CubicInterpolate(float y0, float y1, float y2, float y3, float x) const;
+   float CubicMaximize(float y0, float y1, float y2, float y3, float * max) const;
+
+private:
+   Algorithm mAlg;
+   double mRate;
+   size_t mWindowSize;
+   std::vector<float> mProcessed;
+
+   // State of the analysis between Start and Finish
+   double mWss;
+   long long mWindows;
+   std::vector<float> mWin;
+   std::vector<float> mIn;
+   std::vector<float> mOut;
+   std::vector<float> mOut2;
+   // Sums over all the windows, in double so that long inputs
+   // don't lose the later windows to rounding
+   std::vector<double> mSums;
+   // Samples that don't yet make a complete window
+   std::vector<float> mPending;
+};
+
+#endif
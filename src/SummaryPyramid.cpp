@@ -0,0 +1,219 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SummaryPyramid.cpp
+
+*******************************************************************//**
+
+\class SummaryPyramid
+\brief Min, max and RMS of a block's samples in frames of 16, 256,
+4096 and 65536 samples.
+
+Block files store summaries at only two resolutions, 256 and 65536
+samples per frame, and each read of either one reads the whole summary
+from disk.  Drawing at a zoom between those levels therefore reduced
+far more data than it drew.  A pyramid fills in the missing levels, so
+that Sequence::GetWaveDisplay can use the coarsest level no longer than
+a pixel column.
+
+The levels from 256 up are reduced from the stored 256-sample summary,
+so summaries of projects saved by older versions are upgraded when
+first drawn, and the file format is unchanged.  The 16-sample level is
+made from the samples themselves, only when zoomed in that far.
+
+RMS values are combined weighting each frame by the number of samples
+it covers, so that the short last frame of a block counts for less.
+
+*//****************************************************************//**
+
+\class SummaryPyramidCache
+\brief Keeps the pyramids of recently drawn block files in memory.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "SummaryPyramid.h"
+
+#include <float.h>
+#include <math.h>
+#include <algorithm>
+
+int SummaryPyramid::LevelFor(double samplesPerPixel)
+{
+   for (int level = nLevels; level--;)
+      if (samplesPerPixel >= FrameSize(level))
+         return level;
+   return -1;
+}
+
+SummaryPyramid::SummaryPyramid(const float *samples, size_t len)
+: mLen{ len }
+, mFinest{ Level16 }
+{
+   const auto frameSize = FrameSize(Level16);
+   const auto frames = (len + frameSize - 1) / frameSize;
+   std::vector<float> triples(3 * frames);
+
+   for (size_t i = 0; i < frames; i++) {
+      const auto count = CountInFrame(Level16, i);
+      const float *pv = samples + i * frameSize;
+      float min = FLT_MAX, max = -FLT_MAX, sumsq = 0;
+      for (size_t j = 0; j < count; j++) {
+         const float v = pv[j];
+         min = std::min(min, v);
+         max = std::max(max, v);
+         sumsq += v * v;
+      }
+      triples[3 * i] = min;
+      triples[3 * i + 1] = max;
+      triples[3 * i + 2] = sqrt(sumsq / count);
+   }
+
+   mLevels.push_back(std::move(triples));
+}
+
+SummaryPyramid::SummaryPyramid(int level, std::vector<float> &&triples,
+                               size_t len)
+: mLen{ len }
+, mFinest{ level }
+{
+   // Drop the padding that stored summaries have after the last frame
+   const auto frameSize = FrameSize(level);
+   triples.resize(3 * ((len + frameSize - 1) / frameSize));
+   mLevels.push_back(std::move(triples));
+
+   while (mFinest + (int)mLevels.size() < nLevels)
+      AddCoarserLevel();
+}
+
+size_t SummaryPyramid::CountInFrame(int level, size_t frame) const
+{
+   const auto frameSize = FrameSize(level);
+   return std::min(frameSize, mLen - frame * frameSize);
+}
+
+void SummaryPyramid::AddCoarserLevel()
+{
+   const int level = mFinest + mLevels.size() - 1;
+   const auto &below = mLevels.back();
+   const size_t nBelow = below.size() / 3;
+   const size_t nAbove = (nBelow + 15) / 16;
+   std::vector<float> above(3 * nAbove);
+
+   for (size_t j = 0; j < nAbove; j++) {
+      float min = FLT_MAX, max = -FLT_MAX;
+      double sumsq = 0;
+      size_t count = 0;
+      for (size_t i = 16 * j, end = std::min(nBelow, i + 16); i < end; i++) {
+         const auto n = CountInFrame(level, i);
+         const float *pv = &below[3 * i];
+         min = std::min(min, pv[0]);
+         max = std::max(max, pv[1]);
+         sumsq += (double)pv[2] * pv[2] * n;
+         count += n;
+      }
+      above[3 * j] = min;
+      above[3 * j + 1] = max;
+      above[3 * j + 2] = count ? sqrt(sumsq / count) : 0;
+   }
+
+   mLevels.push_back(std::move(above));
+}
+
+bool SummaryPyramid::HasLevel(int level) const
+{
+   return level >= mFinest && level < mFinest + (int)mLevels.size();
+}
+
+size_t SummaryPyramid::GetFrames(int level) const
+{
+   return HasLevel(level) ? mLevels[level - mFinest].size() / 3 : 0;
+}
+
+const float *SummaryPyramid::GetTriples(int level) const
+{
+   return HasLevel(level) ? mLevels[level - mFinest].data() : nullptr;
+}
+
+size_t SummaryPyramid::GetBytes() const
+{
+   size_t bytes = sizeof(*this);
+   for (const auto &triples : mLevels)
+      bytes += triples.capacity() * sizeof(float);
+   return bytes;
+}
+
+SummaryPyramidCache &SummaryPyramidCache::Get()
+{
+   // Never destroyed, because block files may outlive static objects,
+   // and their destructors call Invalidate
+   static SummaryPyramidCache *theCache = safenew SummaryPyramidCache;
+   return *theCache;
+}
+
+SummaryPyramidCache::SummaryPyramidCache()
+: mBytes{ 0 }
+, mMaxBytes{ DefaultMaxBytes }
+{
+}
+
+SummaryPyramidCache::~SummaryPyramidCache()
+{
+}
+
+auto SummaryPyramidCache::Find(const BlockFile *block, bool fine)
+   -> PyramidPtr
+{
+   ODLocker locker{ &mMutex };
+   auto iter = mIndex.find({ block, fine });
+   if (iter == mIndex.end())
+      return {};
+
+   // Move to the front of the LRU list
+   mEntries.splice(mEntries.begin(), mEntries, iter->second);
+   return iter->second->pyramid;
+}
+
+void SummaryPyramidCache::Insert(const BlockFile *block, bool fine,
+                                 const PyramidPtr &pyramid)
+{
+   const Key key{ block, fine };
+
+   ODLocker locker{ &mMutex };
+   auto iter = mIndex.find(key);
+   if (iter != mIndex.end())
+      // Another thread made the same pyramid meanwhile; keep ours
+      Remove(iter->second);
+
+   mEntries.push_front({ key, pyramid });
+   mIndex[key] = mEntries.begin();
+   mBytes += pyramid->GetBytes();
+
+   // Always keep the newest, however large
+   while (mBytes > mMaxBytes && mEntries.size() > 1)
+      Remove(std::prev(mEntries.end()));
+}
+
+void SummaryPyramidCache::Invalidate(const BlockFile *block)
+{
+   ODLocker locker{ &mMutex };
+   for (bool fine : { false, true }) {
+      auto iter = mIndex.find({ block, fine });
+      if (iter != mIndex.end())
+         Remove(iter->second);
+   }
+}
+
+size_t SummaryPyramidCache::GetBytes() const
+{
+   ODLocker locker{ &mMutex };
+   return mBytes;
+}
+
+void SummaryPyramidCache::Remove(EntryList::iterator iter)
+{
+   mBytes -= iter->pyramid->GetBytes();
+   mIndex.erase(iter->key);
+   mEntries.erase(iter);
+}
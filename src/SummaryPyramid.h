@@ -0,0 +1,113 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SummaryPyramid.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_SUMMARY_PYRAMID__
+#define __AUDACITY_SUMMARY_PYRAMID__
+
+#include "MemoryX.h"
+#include <list>
+#include <map>
+#include <vector>
+
+#include "ondemand/ODTaskThread.h"
+
+class BlockFile;
+
+/// Min, max and RMS triples for the samples of one block, at several
+/// resolutions.  Each level has frames 16 times as long as the level
+/// below.  A pyramid is immutable once constructed.
+class SummaryPyramid
+{
+ public:
+   enum Level {
+      Level16,
+      Level256,
+      Level4K,
+      Level64K,
+      nLevels
+   };
+
+   /// The number of samples summarized by one frame of the level
+   static size_t FrameSize(int level) { return size_t(16) << (4 * level); }
+
+   /// The coarsest level whose frames are no longer than samplesPerPixel,
+   /// or -1 if even the finest level is too coarse
+   static int LevelFor(double samplesPerPixel);
+
+   /// Summarize samples at the finest level only
+   SummaryPyramid(const float *samples, size_t len);
+   /// Take triples at the given level for a block of len samples,
+   /// and reduce them to make all the coarser levels
+   SummaryPyramid(int level, std::vector<float> &&triples, size_t len);
+
+   bool HasLevel(int level) const;
+   size_t GetFrames(int level) const;
+   const float *GetTriples(int level) const;
+
+   size_t GetBytes() const;
+
+ private:
+   size_t CountInFrame(int level, size_t frame) const;
+   void AddCoarserLevel();
+
+   size_t mLen;
+   int mFinest;
+   // Element i holds the triples of level mFinest + i
+   std::vector<std::vector<float>> mLevels;
+};
+
+/// A process-wide, least-recently-used cache of the summary pyramids of
+/// block files, limited in total size.  Since block files are immutable,
+/// an entry stays valid until its block file is destroyed.
+class SummaryPyramidCache final
+{
+ public:
+   using PyramidPtr = std::shared_ptr<const SummaryPyramid>;
+
+   enum { DefaultMaxBytes = 64 * 1024 * 1024 };
+
+   static SummaryPyramidCache &Get();
+
+   /// The pyramid from the block's stored summaries, or if fine is true,
+   /// the one from its samples.  Null if not cached.
+   PyramidPtr Find(const BlockFile *block, bool fine);
+   void Insert(const BlockFile *block, bool fine, const PyramidPtr &pyramid);
+
+   /// Forget both pyramids of a block
+   void Invalidate(const BlockFile *block);
+
+   size_t GetBytes() const;
+
+ private:
+   SummaryPyramidCache();
+   ~SummaryPyramidCache();
+
+   SummaryPyramidCache(const SummaryPyramidCache&) PROHIBITED;
+   SummaryPyramidCache &operator= (const SummaryPyramidCache&) PROHIBITED;
+
+   using Key = std::pair<const BlockFile *, bool>;
+   struct Entry {
+      Key key;
+      PyramidPtr pyramid;
+   };
+   using EntryList = std::list<Entry>;
+
+   // Must be called with mMutex held
+   void Remove(EntryList::iterator iter);
+
+   mutable ODLock mMutex;
+
+   // Front is most recently used
+   EntryList mEntries;
+   std::map<Key, EntryList::iterator> mIndex;
+
+   size_t mBytes;
+   size_t mMaxBytes;
+};
+
+#endif
@@ -235,6 +235,10 @@ class AUDACITY_DLL_API Track /* not final */ : public XMLTagHandler
 
    // XMLTagHandler callback methods -- NEW virtual for writing
    virtual void WriteXML(XMLWriter &xmlFile) = 0;
+   // Changes whenever WriteXML would write something different, so that
+   // an auto-save need not write the track again if it is the same as last
+   // time; 0 if not known, and then the track must be written
+   virtual unsigned long long GetXMLStamp() const { return 0; }
 
    // Returns true if an error was encountered while trying to
    // open the track from XML
@@ -539,7 +543,10 @@ class AUDACITY_DLL_API TrackFactory
    const std::shared_ptr<DirManager> mDirManager;
    const ZoomInfo *const mZoomInfo;
    friend class AudacityProject;
+   friend class AutoSaveJournalTest;
    friend class BenchmarkDialog;
+   friend class NoiseReductionTest;
+   friend class WaveTrackStatisticsTest;
 
  public:
    // These methods are defined in WaveTrack.cpp, NoteTrack.cpp,
@@ -147,6 +147,7 @@ audio tracks.
 #include "AudacityApp.h"
 #include "float_cast.h"
 
+#include <algorithm>
 #include <math.h>
 #include <float.h>
 #include <limits>
@@ -175,6 +176,7 @@ audio tracks.
 #include "Envelope.h"
 #include "NumberScale.h"
 #include "WaveTrack.h"
+#include "WaveformTileCache.h"
 #include "LabelTrack.h"
 #include "TimeTrack.h"
 #include "Prefs.h"
@@ -284,8 +286,13 @@ TrackArtist::~TrackArtist()
 {
 }
 
+// Changes with the colours, so that cached drawings are made again
+static unsigned sColoursVersion = 0;
+
 void TrackArtist::SetColours()
 {
+   ++sColoursVersion;
+
    theTheme.SetBrushColour( blankBrush,      clrBlank );
    theTheme.SetBrushColour( unselectedBrush, clrUnselected);
    theTheme.SetBrushColour( selectedBrush,   clrSelected);
@@ -1775,25 +1782,27 @@ void TrackArtist::DrawClipWaveform(const WaveTrack *track,
    double *const env = &vEnv[0];
    clip->GetEnvelope()->GetValues(env, mid.width, leftOffset, zoomInfo);
 
+   // The selection, for the background
+   double selT0, selT1;
+   if (track->GetSelected() || track->IsSyncLockSelected()) {
+      selT0 = track->LongSamplesToTime(track->TimeToLongSamples(selectedRegion.t0())),
+         selT1 = track->LongSamplesToTime(track->TimeToLongSamples(selectedRegion.t1()));
+   }
+   else
+      selT0 = selT1 = 0.0;
+
    // Draw the background of the track, outlining the shape of
    // the envelope and using a colored pen for the selected
    // part of the waveform
-   {
-      double t0, t1;
-      if (track->GetSelected() || track->IsSyncLockSelected()) {
-         t0 = track->LongSamplesToTime(track->TimeToLongSamples(selectedRegion.t0())),
-            t1 = track->LongSamplesToTime(track->TimeToLongSamples(selectedRegion.t1()));
-      }
-      else
-         t0 = t1 = 0.0;
+   const auto drawBackground = [&] {
       DrawWaveformBackground(dc, leftOffset, mid,
          env,
          zoomMin, zoomMax,
          track->ZeroLevelYCoordinate(mid),
          dB, dBRange,
-         t0, t1, zoomInfo, drawEnvelope,
+         selT0, selT1, zoomInfo, drawEnvelope,
          !track->GetSelected());
-   }
+   };
 
    WaveDisplay display(hiddenMid.width);
    bool isLoadingOD = false;//true if loading on demand block in sequence.
@@ -1812,32 +1821,53 @@ void TrackArtist::DrawClipWaveform(const WaveTrack *track,
    // Require at least 3 pixels per sample for drawing the draggable points.
    const double threshold2 = 3 * rate;
 
-   {
-      bool showIndividualSamples = false;
-      for (unsigned ii = 0; !showIndividualSamples && ii < nPortions; ++ii) {
-         const WavePortion &portion = portions[ii];
-         showIndividualSamples =
-            !portion.inFisheye && portion.averageZoom > threshold1;
-      }
+   bool showAnyIndividualSamples = false;
+   for (unsigned ii = 0; !showAnyIndividualSamples && ii < nPortions; ++ii) {
+      const WavePortion &portion = portions[ii];
+      showAnyIndividualSamples =
+         !portion.inFisheye && portion.averageZoom > threshold1;
+   }
+
+   // When all the clip is drawn alike, the drawing can be kept in tiles for
+   // the next time, except for the patterned background of sync-lock
+   // selected tracks
+   bool useTiles = !showAnyIndividualSamples &&
+      nPortions == 1 && !portions[0].inFisheye &&
+      (track->GetSelected() || !(selT0 < selT1));
+#ifdef EXPERIMENTAL_OUTPUT_DISPLAY
+   // The tiles don't know the channel gain
+   useTiles = false;
+#endif
 
-      if (!showIndividualSamples) {
-         // The WaveClip class handles the details of computing the shape
-         // of the waveform.  The only way GetWaveDisplay will fail is if
-         // there's a serious error, like some of the waveform data can't
-         // be loaded.  So if the function returns false, we can just exit.
+   if (!showAnyIndividualSamples) {
+      // The WaveClip class handles the details of computing the shape
+      // of the waveform.  The only way GetWaveDisplay will fail is if
+      // there's a serious error, like some of the waveform data can't
+      // be loaded.  So if the function returns false, we can just exit.
 
-         // Note that we compute the full width display even if there is a
-         // fisheye hiding part of it, because of the caching.  If the
-         // fisheye moves over the background, there is then less to do when
-         // redrawing.
+      // Note that we compute the full width display even if there is a
+      // fisheye hiding part of it, because of the caching.  If the
+      // fisheye moves over the background, there is then less to do when
+      // redrawing.
 
-         if (!clip->GetWaveDisplay(display,
-            t0, pps, isLoadingOD))
-            return;
+      if (!clip->GetWaveDisplay(display,
+         t0, pps, isLoadingOD)) {
+         drawBackground();
+         return;
       }
    }
 
-   for (unsigned ii = 0; ii < nPortions; ++ii) {
+   // Columns being loaded on demand are animated, so aren't kept
+   const bool drawnFromTiles = useTiles && !isLoadingOD;
+   if (drawnFromTiles)
+      DrawClipWaveformTiles(track, clip, dc, mid,
+         leftOffset, params.hiddenLeftOffset, zoomInfo, env,
+         zoomMin, zoomMax, dB, dBRange,
+         selT0, selT1, drawEnvelope, display, muted);
+   else
+      drawBackground();
+
+   for (unsigned ii = 0; !drawnFromTiles && ii < nPortions; ++ii) {
       WavePortion &portion = portions[ii];
       const bool showIndividualSamples = portion.averageZoom > threshold1;
       const bool showPoints = portion.averageZoom > threshold2;
@@ -1951,6 +1981,158 @@ void TrackArtist::DrawClipWaveform(const WaveTrack *track,
 }
 
 
+void TrackArtist::DrawClipWaveformTiles(const WaveTrack *track,
+                                        const WaveClip *clip,
+                                        wxDC & dc,
+                                        const wxRect &mid,
+                                        int leftOffset,
+                                        int hiddenLeftOffset,
+                                        const ZoomInfo &zoomInfo,
+                                        const double env[],
+                                        float zoomMin, float zoomMax,
+                                        bool dB, float dBRange,
+                                        double t0, double t1,
+                                        bool drawEnvelope,
+                                        const WaveDisplay &display,
+                                        bool muted)
+{
+   using Cache = WaveformTileCache;
+   const int height = mid.height;
+
+   // The tiles count columns from the one at the start of the clip, and
+   // can be used again while the start stays at the same fraction of a pixel
+   const double clipPosition =
+      zoomInfo.TimeRangeToPixelWidth(clip->GetOffset() - zoomInfo.h);
+   const wxInt64 shift = (wxInt64)floor(clipPosition + 0.5);
+
+   Cache::Key key;
+   key.zoom = zoomInfo.TimeRangeToPixelWidth(1.0);
+   key.phase = (int)floor((clipPosition - shift) * 1000 + 0.5);
+   key.height = height;
+   key.zoomMin = zoomMin;
+   key.zoomMax = zoomMax;
+   key.dB = dB;
+   key.dBRange = dBRange;
+   key.zeroLevel = track->ZeroLevelYCoordinate(mid) - mid.y;
+   key.drawEnvelope = drawEnvelope;
+   key.muted = muted;
+   key.showClipping = (mShowClipping != 0);
+   key.dirty = clip->GetDirty();
+   key.colours = sColoursVersion;
+
+   if (!clip->mWaveformTileCache)
+      clip->mWaveformTileCache = std::make_unique<Cache>();
+   Cache &cache = *clip->mWaveformTileCache;
+   cache.SetKey(key);
+
+   // The columns in view
+   const wxInt64 c0 = leftOffset - shift;
+   const wxInt64 c1 = c0 + mid.width;
+   const auto tileOf = [](wxInt64 column) {
+      return (column >= 0 ? column : column - (Cache::TileWidth - 1))
+         / Cache::TileWidth;
+   };
+   const wxInt64 firstTile = tileOf(c0);
+   const wxInt64 lastTile = tileOf(c1 - 1);
+
+   // Keep a few tiles on either side, for scrolling back and forth
+   cache.Trim(firstTile - 2, lastTile + 2);
+
+   wxMemoryDC memDC;
+   for (auto index = firstTile; index <= lastTile; ++index) {
+      const wxInt64 tileStart = index * Cache::TileWidth;
+      Cache::Tile &tile = cache.GetTile(index);
+
+      // The columns of the tile in view, relative to the tile
+      const int a = (int)(std::max(c0, tileStart) - tileStart);
+      const int b =
+         (int)(std::min<wxInt64>(c1, tileStart + Cache::TileWidth) - tileStart);
+
+      // The selected columns, as DrawWaveformBackground chooses them
+      int selBegin = 0, selEnd = 0;
+      if (t0 < t1) {
+         double time =
+            zoomInfo.PositionToTime(tileStart + shift), nextTime;
+         for (int xx = 0; xx < Cache::TileWidth; ++xx, time = nextTime) {
+            nextTime = zoomInfo.PositionToTime(tileStart + shift + xx + 1);
+            if (t0 <= time && nextTime < t1) {
+               if (selBegin == selEnd)
+                  selBegin = xx;
+               selEnd = xx + 1;
+            }
+         }
+      }
+      if (selBegin != tile.selBegin || selEnd != tile.selEnd) {
+         tile.begin = tile.end = 0;
+         tile.selBegin = selBegin;
+         tile.selEnd = selEnd;
+      }
+
+      // Draw again if the envelope changed, or if the drawn columns would
+      // not be contiguous
+      if (tile.begin < tile.end) {
+         const int lo = std::max(a, tile.begin);
+         const int hi = std::min(b, tile.end);
+         if (lo > hi ||
+             !std::equal(tile.env.begin() + lo, tile.env.begin() + hi,
+                         env + (tileStart + lo - c0)))
+            tile.begin = tile.end = 0;
+      }
+
+      memDC.SelectObject(tile.bitmap);
+
+      // Draw the columns [u, v) of the tile
+      const auto drawColumns = [&](int u, int v) {
+         // Index of the first column in env and in mid
+         const int offset = (int)(tileStart + u - c0);
+         std::copy(env + offset, env + offset + (v - u), tile.env.begin() + u);
+
+         memDC.SetClippingRegion(u, 0, v - u, height);
+         DrawWaveformBackground(memDC, leftOffset + offset,
+            wxRect(u, 0, v - u, height),
+            env + offset,
+            zoomMin, zoomMax,
+            key.zeroLevel,
+            dB, dBRange,
+            t0, t1, zoomInfo, drawEnvelope,
+            !track->GetSelected());
+
+         // Start a column early where there is one, so that the waveform
+         // joins up with the column before, as if drawn together
+         const int early = (offset > 0) ? 1 : 0;
+         const int pos = leftOffset + offset - early - hiddenLeftOffset;
+         DrawMinMaxRMS(memDC, wxRect(u - early, 0, v - u + early, height),
+            env + offset - early,
+            zoomMin, zoomMax,
+            dB, dBRange,
+            display.min + pos, display.max + pos,
+            display.rms + pos, display.bl + pos,
+            false, muted);
+         memDC.DestroyClippingRegion();
+      };
+
+      if (tile.begin == tile.end) {
+         drawColumns(a, b);
+         tile.begin = a;
+         tile.end = b;
+      }
+      else {
+         if (a < tile.begin) {
+            drawColumns(a, tile.begin);
+            tile.begin = a;
+         }
+         if (b > tile.end) {
+            drawColumns(tile.end, b);
+            tile.end = b;
+         }
+      }
+
+      dc.Blit(mid.x + (tileStart + a - c0), mid.y, b - a, height,
+              &memDC, a, 0);
+      memDC.SelectObject(wxNullBitmap);
+   }
+}
+
 void TrackArtist::DrawTimeSlider(wxDC & dc,
                                  const wxRect & rect,
                                  bool rightwards)
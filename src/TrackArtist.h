@@ -133,6 +133,18 @@ class AUDACITY_DLL_API TrackArtist {
                          bool drawEnvelope, bool bigPoints,
                          bool dB, bool muted);
 
+   // Draws the background and the min/max/rms columns of the clip by
+   // copying from its cache of bitmaps, drawing into these only the
+   // columns not yet there.  The display is indexed from hiddenLeftOffset.
+   void DrawClipWaveformTiles(const WaveTrack *track, const WaveClip *clip,
+                              wxDC & dc, const wxRect &mid,
+                              int leftOffset, int hiddenLeftOffset,
+                              const ZoomInfo &zoomInfo, const double env[],
+                              float zoomMin, float zoomMax,
+                              bool dB, float dBRange,
+                              double t0, double t1, bool drawEnvelope,
+                              const WaveDisplay &display, bool muted);
+
    void DrawClipSpectrum(WaveTrackCache &cache, const WaveClip *clip,
                          wxDC & dc, const wxRect & rect,
                          const SelectedRegion &selectedRegion, const ZoomInfo &zoomInfo);
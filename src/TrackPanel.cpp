@@ -165,7 +165,7 @@ is time to refresh some aspect of the screen.
 #include <wx/numdlg.h>
 #include <wx/spinctrl.h>
 
-#include "FreqWindow.h" // for SpectrumAnalyst
+#include "SpectrumAnalyst.h"
 
 #include "AColor.h"
 #include "AllThemeResources.h"
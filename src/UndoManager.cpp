@@ -38,6 +38,8 @@ UndoManager
 
 using ConstBlockFilePtr = const BlockFile*;
 WX_DECLARE_HASH_SET(ConstBlockFilePtr, wxPointerHash, wxPointerEqual, Set );
+using ConstBlockArrayPtr = const BlockArray*;
+WX_DECLARE_HASH_SET(ConstBlockArrayPtr, wxPointerHash, wxPointerEqual, ArraySet );
 
 struct UndoStackElem {
 
@@ -72,7 +74,7 @@ UndoManager::~UndoManager()
 
 namespace {
    SpaceArray::value_type
-   CalculateUsage(TrackList *tracks, Set *seen)
+   CalculateUsage(TrackList *tracks, Set *seen, ArraySet *seenArrays)
    {
       SpaceArray::value_type result = 0;
 
@@ -85,7 +87,14 @@ namespace {
          for(const auto &clip : wt->GetAllClips())
          {
             // Scan all blockfiles within current clip
-            BlockArray *blocks = clip->GetSequenceBlockArray();
+            const BlockArray *blocks = clip->GetSequenceBlockArray();
+
+            // Undo states share the block arrays of sequences that did not
+            // change between them.  All the files of an array already seen
+            // are in the set.
+            if (seenArrays && !seenArrays->insert(blocks).second)
+               continue;
+
             for (const auto &block : *blocks)
             {
                const auto &file = block.f;
@@ -117,6 +126,7 @@ void UndoManager::CalculateSpaceUsage()
    space.resize(stack.size(), 0);
 
    Set seen;
+   ArraySet seenArrays;
 
    // After copies and pastes, a block file may be used in more than
    // one place in one undo history state, and it may be used in more than
@@ -136,15 +146,48 @@ void UndoManager::CalculateSpaceUsage()
    {
       // Scan all tracks at current level
       auto tracks = stack[nn]->state.tracks.get();
-      space[nn] = CalculateUsage(tracks, &seen);
+      space[nn] = CalculateUsage(tracks, &seen, &seenArrays);
    }
 
    mClipboardSpaceUsage = CalculateUsage
-      (AudacityProject::GetClipboardTracks(), nullptr);
+      (AudacityProject::GetClipboardTracks(), nullptr, nullptr);
 
    //TIMER_STOP( space_calc );
 }
 
+namespace {
+   void AddBlockFiles(TrackList *tracks, std::set<const BlockFile*> &files,
+                      std::set<const BlockArray*> *seenArrays)
+   {
+      TrackListOfKindIterator iter(Track::Wave);
+      for (auto wt = (WaveTrack *) iter.First(tracks); wt;
+           wt = (WaveTrack *) iter.Next())
+         for (const auto &clip : wt->GetAllClips()) {
+            const BlockArray *blocks = clip->GetSequenceBlockArray();
+            // As in CalculateUsage, the files of an array already seen
+            // are in the set
+            if (seenArrays && !seenArrays->insert(blocks).second)
+               continue;
+            for (const auto &block : *blocks)
+               files.insert(&*block.f);
+         }
+   }
+}
+
+void UndoManager::GetOtherStatesBlockFiles(std::set<const BlockFile*> &files)
+{
+   std::set<const BlockArray*> seenArrays;
+   for (size_t nn = 0; nn < stack.size(); nn++)
+      if ((int)nn != current)
+         AddBlockFiles(stack[nn]->state.tracks.get(), files, &seenArrays);
+}
+
+void UndoManager::GetBlockFiles(TrackList *tracks,
+                                std::set<const BlockFile*> &files)
+{
+   AddBlockFiles(tracks, files, nullptr);
+}
+
 wxLongLong_t UndoManager::GetLongDescription(unsigned int n, wxString *desc,
                                              wxString *size)
 {
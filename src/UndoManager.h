@@ -9,8 +9,11 @@
   After each operation, call UndoManager's PushState, pass it
   the entire track hierarchy.  The UndoManager makes a duplicate
   of every single track using its Duplicate method, which should
-  increment reference counts.  If we were not at the top of
-  the stack when this is called, DELETE above first.
+  increment reference counts.  Duplicates of a sequence share its
+  array of blocks until one of them changes, so states share the
+  blocks of clips that did not change between them.  If we were
+  not at the top of the stack when this is called, DELETE above
+  first.
 
   If a minor change is made, for example changing the visual
   display of a track or changing the selection, you can call
@@ -49,11 +52,13 @@
 #define __AUDACITY_UNDOMANAGER__
 
 #include "MemoryX.h"
+#include <set>
 #include <vector>
 #include <wx/string.h>
 #include "ondemand/ODTaskThread.h"
 #include "SelectedRegion.h"
 
+class BlockFile;
 class Tags;
 class Track;
 class TrackList;
@@ -130,6 +135,12 @@ class AUDACITY_DLL_API UndoManager {
 
    void CalculateSpaceUsage();
 
+   // Adds to files the block files of every state but the current one
+   void GetOtherStatesBlockFiles(std::set<const BlockFile*> &files);
+   // Adds to files the block files of the tracks
+   static void GetBlockFiles(TrackList *tracks,
+                             std::set<const BlockFile*> &files);
+
    // void Debug(); // currently unused
 
    ///to mark as unsaved changes without changing the state/tracks.
@@ -34,8 +34,10 @@
 #include "Resample.h"
 #include "Project.h"
 #include "WaveTrack.h"
+#include "WaveformTileCache.h"
 #include "FFT.h"
 #include "Profiler.h"
+#include "WorkerPool.h"
 
 #include "prefs/SpectrogramSettings.h"
 
@@ -363,9 +365,11 @@ bool WaveClip::SetSamples(samplePtr buffer, sampleFormat format,
    return bResult;
 }
 
-BlockArray* WaveClip::GetSequenceBlockArray()
+const BlockArray* WaveClip::GetSequenceBlockArray() const
 {
-   return &mSequence->GetBlockArray();
+   // Reading, which does not stop sharing the blocks with copies
+   const Sequence &sequence = *mSequence;
+   return &sequence.GetBlockArray();
 }
 
 double WaveClip::GetStartTime() const
@@ -776,7 +780,8 @@ bool SpecCache::CalculateOneSpectrum
     double offset, double rate, double pixelsPerSecond,
     int lowerBoundX, int upperBoundX,
     const std::vector<float> &gainFactors,
-    float* __restrict scratch, float* __restrict out) const
+    float* __restrict scratch, float* __restrict out,
+    Contributions *contributions) const
 {
    bool result = false;
    const bool reassignment =
@@ -950,13 +955,11 @@ bool SpecCache::CalculateOneSpectrum
 
                   // This is non-negative, because bin and correctedX are
                   auto ind = (int)half * correctedX + bin;
-#ifdef _OPENMP
-                  // This assignment can race if index reaches into another thread's bins.
-                  // The probability of a race very low, so this carries little overhead,
-                  // about 5% slower vs allowing it to race.
-                  #pragma omp atomic update
-#endif
-                  out[ind] += power;
+                  if (contributions)
+                     // The column may belong to another thread
+                     contributions->push_back({ (size_t)ind, power });
+                  else
+                     out[ind] += power;
                }
             }
          }
@@ -985,6 +988,22 @@ bool SpecCache::CalculateOneSpectrum
    return result;
 }
 
+namespace {
+   // Columns of the spectrogram computed by one iteration on the worker pool
+   const int ColumnsPerChunk = 16;
+   // Fewer NEW columns than this are computed on the calling thread only
+   const int MinParallelColumns = 4 * ColumnsPerChunk;
+}
+
+// The columns are computed in chunks on a WorkerPool, each chunk with its
+// own WaveTrackCache and scratch buffers.  The FFT tables in the settings
+// are only read, and so are shared.
+//
+// Reassignment may move power into the columns of other chunks.  The
+// workers collect those powers instead of adding them, and this thread adds
+// them afterwards, chunk by chunk in the order of the columns, which is the
+// order of the loop on one thread.  So the results are the same, whatever
+// the number of threads.
 void SpecCache::Populate
    (const SpectrogramSettings &settings, WaveTrackCache &waveTrackCache,
     int copyBegin, int copyEnd, size_t numPixels,
@@ -1018,46 +1037,55 @@ void SpecCache::Populate
    if (!autocorrelation)
       ComputeSpectrogramGainFactors(fftLen, rate, frequencyGain, gainFactors);
 
+   // A pool for this call only, if there is enough to share; its start-up
+   // is small beside the FFTs of so many columns
+   const int newColumns =
+      copyBegin + std::max(0, (int)numPixels - copyEnd);
+   const size_t nProcessors = WorkerPool::GetProcessorCount();
+   std::unique_ptr<WorkerPool> pool;
+   if (newColumns >= MinParallelColumns && nProcessors > 1)
+      pool = std::make_unique<WorkerPool>(std::min<size_t>(nProcessors,
+         (newColumns + ColumnsPerChunk - 1) / ColumnsPerChunk));
+
    // Loop over the ranges before and after the copied portion and compute anew.
    // One of the ranges may be empty.
    for (int jj = 0; jj < 2; ++jj) {
       const int lowerBoundX = jj == 0 ? 0 : copyEnd;
       const int upperBoundX = jj == 0 ? copyBegin : numPixels;
-
-#ifdef _OPENMP
-      // Storage for mutable per-thread data.
-      // private clause ensures one copy per thread
-      struct ThreadLocalStorage {
-         ThreadLocalStorage()  { cache = nullptr; }
-         ~ThreadLocalStorage() { delete cache; }
-
-         void init(WaveTrackCache &waveTrackCache, size_t scratchSize) {
-            if (!cache) {
-               cache = new WaveTrackCache(waveTrackCache.GetTrack());
-               scratch.resize(scratchSize);
-            }
-         }
-         WaveTrackCache* cache;
-         std::vector<float> scratch;
-      } tls;
-
-      #pragma omp parallel for private(tls)
-#endif
-      for (auto xx = lowerBoundX; xx < upperBoundX; ++xx)
-      {
-#ifdef _OPENMP
-         tls.init(waveTrackCache, scratchSize);
-         WaveTrackCache& cache = *tls.cache;
-         float* buffer = &tls.scratch[0];
-#else
-         WaveTrackCache& cache = waveTrackCache;
-         float* buffer = &scratch[0];
-#endif
-         CalculateOneSpectrum(
-            settings, cache, xx, numSamples,
-            offset, rate, pixelsPerSecond,
-            lowerBoundX, upperBoundX,
-            gainFactors, buffer, &freq[0]);
+      if (upperBoundX <= lowerBoundX)
+         continue;
+
+      const size_t nChunks =
+         (upperBoundX - lowerBoundX + ColumnsPerChunk - 1) / ColumnsPerChunk;
+      if (pool) {
+         std::vector<Contributions> contributions(reassignment ? nChunks : 0);
+         pool->ForEach(nChunks, [&](size_t ii)
+         {
+            WaveTrackCache cache{ waveTrackCache.GetTrack() };
+            std::vector<float> buffer(scratchSize);
+            const int begin = lowerBoundX + ii * ColumnsPerChunk;
+            const int end = std::min(upperBoundX, begin + ColumnsPerChunk);
+            for (auto xx = begin; xx < end; ++xx)
+               CalculateOneSpectrum(
+                  settings, cache, xx, numSamples,
+                  offset, rate, pixelsPerSecond,
+                  lowerBoundX, upperBoundX,
+                  gainFactors, &buffer[0], &freq[0],
+                  reassignment ? &contributions[ii] : nullptr);
+         });
+
+         // In the order of the columns that made them
+         for (const auto &chunk : contributions)
+            for (const auto &contribution : chunk)
+               freq[contribution.index] += contribution.power;
+      }
+      else {
+         for (auto xx = lowerBoundX; xx < upperBoundX; ++xx)
+            CalculateOneSpectrum(
+               settings, waveTrackCache, xx, numSamples,
+               offset, rate, pixelsPerSecond,
+               lowerBoundX, upperBoundX,
+               gainFactors, &scratch[0], &freq[0], nullptr);
       }
 
       if (reassignment) {
@@ -1074,7 +1102,7 @@ void SpecCache::Populate
                   settings, waveTrackCache, --xx, numSamples,
                   offset, rate, pixelsPerSecond,
                   lowerBoundX, upperBoundX,
-                  gainFactors, &scratch[0], &freq[0]);
+                  gainFactors, &scratch[0], &freq[0], nullptr);
             if (!result)
                break;
          }
@@ -1087,32 +1115,39 @@ void SpecCache::Populate
                   settings, waveTrackCache, xx++, numSamples,
                   offset, rate, pixelsPerSecond,
                   lowerBoundX, upperBoundX,
-                  gainFactors, &scratch[0], &freq[0]);
+                  gainFactors, &scratch[0], &freq[0], nullptr);
             if (!result)
                break;
          }
 
          // Now Convert to dB terms.  Do this only after accumulating
          // power values, which may cross columns with the time correction.
-#ifdef _OPENMP
-         #pragma omp parallel for
-#endif
-         for (auto xx = lowerBoundX; xx < upperBoundX; ++xx) {
-            float *const results = &freq[half * xx];
-            const HFFT hFFT = settings.hFFT;
-            for (size_t ii = 0; ii < hFFT->Points; ++ii) {
-               float &power = results[ii];
-               if (power <= 0)
-                  power = -160.0;
-               else
-                  power = 10.0*log10f(power);
-            }
-            if (!gainFactors.empty()) {
-               // Apply a frequency-dependant gain factor
-               for (size_t ii = 0; ii < half; ++ii)
-                  results[ii] += gainFactors[ii];
+         auto toDecibels = [&](size_t chunk)
+         {
+            const int begin = lowerBoundX + chunk * ColumnsPerChunk;
+            const int end = std::min(upperBoundX, begin + ColumnsPerChunk);
+            for (auto xx = begin; xx < end; ++xx) {
+               float *const results = &freq[half * xx];
+               const HFFT hFFT = settings.hFFT;
+               for (size_t ii = 0; ii < hFFT->Points; ++ii) {
+                  float &power = results[ii];
+                  if (power <= 0)
+                     power = -160.0;
+                  else
+                     power = 10.0*log10f(power);
+               }
+               if (!gainFactors.empty()) {
+                  // Apply a frequency-dependant gain factor
+                  for (size_t ii = 0; ii < half; ++ii)
+                     results[ii] += gainFactors[ii];
+               }
             }
-         }
+         };
+         if (pool)
+            pool->ForEach(nChunks, toDecibels);
+         else
+            for (size_t chunk = 0; chunk < nChunks; ++chunk)
+               toDecibels(chunk);
       }
    }
 }
@@ -1159,10 +1194,11 @@ bool WaveClip::GetSpectrogram(WaveTrackCache &waveTrackCache,
       return false;  //hit cache completely
    }
 
-   if (settings.algorithm == SpectrogramSettings::algReassignment)
-      // Caching is not implemented for reassignment, unless for
-      // a complete hit, because of the complications of time reassignment
-      match = false;
+   // Reassignment may reuse the cache too.  Populate looks beyond the edges
+   // of the ranges it computes, and so adds the powers that the copied
+   // columns move into the NEW ones; and the copied columns already have
+   // those that the NEW columns move into them, which the old cache added
+   // when it looked beyond its own edges.
 
    std::unique_ptr<SpecCache> oldCache(std::move(mSpecCache));
 
@@ -1264,6 +1300,42 @@ bool WaveClip::GetRMS(float *rms, double t0,
    return mSequence->GetRMS(s0, s1-s0, rms);
 }
 
+bool WaveClip::GetMean(double *mean, double t0, double t1) const
+{
+   *mean = 0.0;
+
+   if (t0 > t1)
+      return false;
+
+   if (t0 == t1)
+      return true;
+
+   sampleCount s0, s1;
+
+   TimeToSamplesClip(t0, &s0);
+   TimeToSamplesClip(t1, &s1);
+
+   return mSequence->GetMean(s0, s1-s0, mean);
+}
+
+bool WaveClip::GetClipCount(sampleCount *count, double t0, double t1) const
+{
+   *count = 0;
+
+   if (t0 > t1)
+      return false;
+
+   if (t0 == t1)
+      return true;
+
+   sampleCount s0, s1;
+
+   TimeToSamplesClip(t0, &s0);
+   TimeToSamplesClip(t1, &s1);
+
+   return mSequence->GetClipCount(s0, s1-s0, count);
+}
+
 void WaveClip::ConvertToSampleFormat(sampleFormat format)
 {
    bool bChanged;
@@ -1466,6 +1538,18 @@ void WaveClip::WriteXML(XMLWriter &xmlFile)
    xmlFile.EndTag(wxT("waveclip"));
 }
 
+unsigned long long WaveClip::GetXMLStamp() const
+{
+   XMLStamp stamp;
+   stamp.AddDouble(mOffset)
+      .Add(mSequence->GetXMLStamp())
+      .Add(mEnvelope->GetXMLStamp())
+      .Add(mCutLines.size());
+   for (const auto &clip: mCutLines)
+      stamp.Add(clip->GetXMLStamp());
+   return stamp.Get();
+}
+
 bool WaveClip::CreateFromCopy(double t0, double t1, const WaveClip* other)
 {
    sampleCount s0, s1;
@@ -34,6 +34,7 @@ class Envelope;
 class Sequence;
 class SpectrogramSettings;
 class WaveCache;
+class WaveformTileCache;
 class WaveTrackCache;
 
 class SpecCache {
@@ -87,6 +88,15 @@ public:
    bool Matches(int dirty_, double pixelsPerSecond,
       const SpectrogramSettings &settings, double rate) const;
 
+   // A power that time-frequency reassignment adds to freq
+   struct Contribution {
+      size_t index;
+      double power;
+   };
+   using Contributions = std::vector<Contribution>;
+
+   // For reassignment, the powers are added to out, or if contributions is
+   // not null, appended to it instead
    bool CalculateOneSpectrum
       (const SpectrogramSettings &settings,
        WaveTrackCache &waveTrackCache,
@@ -95,7 +105,8 @@ public:
        int lowerBoundX, int upperBoundX,
        const std::vector<float> &gainFactors,
        float* __restrict scratch,
-       float* __restrict out) const;
+       float* __restrict out,
+       Contributions *contributions) const;
 
    void Populate
       (const SpectrogramSettings &settings, WaveTrackCache &waveTrackCache,
@@ -256,7 +267,7 @@ public:
 
    Envelope* GetEnvelope() { return mEnvelope.get(); }
    const Envelope* GetEnvelope() const { return mEnvelope.get(); }
-   BlockArray* GetSequenceBlockArray();
+   const BlockArray* GetSequenceBlockArray() const;
 
    // Get low-level access to the sequence. Whenever possible, don't use this,
    // but use more high-level functions inside WaveClip (or add them if you
@@ -267,6 +278,8 @@ public:
     * called automatically when WaveClip has a chance to know that something
     * has changed, like when member functions SetSamples() etc. are called. */
    void MarkChanged() { mDirty++; }
+   /// Changes whenever MarkChanged is called, for caches of drawing
+   int GetDirty() const { return mDirty; }
 
    /// Create clip from copy, discarding previous information in the clip
    bool CreateFromCopy(double t0, double t1, const WaveClip* other);
@@ -281,6 +294,8 @@ public:
                        double t0, double pixelsPerSecond) const;
    bool GetMinMax(float *min, float *max, double t0, double t1) const;
    bool GetRMS(float *rms, double t0, double t1);
+   bool GetMean(double *mean, double t0, double t1) const;
+   bool GetClipCount(sampleCount *count, double t0, double t1) const;
 
    // Set/clear/get rectangle that this WaveClip fills on screen. This is
    // called by TrackArtist while actually drawing the tracks and clips.
@@ -367,10 +382,15 @@ public:
    void HandleXMLEndTag(const wxChar *tag) override;
    XMLTagHandler *HandleXMLChild(const wxChar *tag) override;
    void WriteXML(XMLWriter &xmlFile) /* not override */;
+   // Changes whenever WriteXML would write something different
+   unsigned long long GetXMLStamp() const;
 
    // Cache of values to colour pixels of Spectrogram - used by TrackArtist
    mutable std::unique_ptr<SpecPxCache> mSpecPxCache;
 
+   // Cache of bitmaps of the waveform - used by TrackArtist
+   mutable std::unique_ptr<WaveformTileCache> mWaveformTileCache;
+
    // AWD, Oct 2009: for pasting whitespace at the end of selection
    bool GetIsPlaceholder() const { return mIsPlaceholder; }
    void SetIsPlaceholder(bool val) { mIsPlaceholder = val; }
@@ -1616,6 +1616,20 @@ sampleCount WaveTrack::GetBlockStart(sampleCount s) const
    return -1;
 }
 
+const float *WaveTrack::GetFloatData(sampleCount start, size_t len,
+                                     MappedFilePtr &holder) const
+{
+   for (const auto &clip : mClips)
+   {
+      const auto clipStart = clip->GetStartSample();
+      if (start >= clipStart && start + len <= clip->GetEndSample())
+         return clip->GetSequence()->GetFloatData(start - clipStart, len,
+                                                  holder);
+   }
+
+   return nullptr;
+}
+
 size_t WaveTrack::GetBestBlockSize(sampleCount s) const
 {
    auto bestBlockSize = GetMaxBlockSize();
@@ -1825,6 +1839,37 @@ void WaveTrack::WriteXML(XMLWriter &xmlFile)
    xmlFile.EndTag(wxT("wavetrack"));
 }
 
+// Mixes in what WriteXML writes, in the same order
+unsigned long long WaveTrack::GetXMLStamp() const
+{
+   XMLStamp stamp;
+   stamp.Add(mAutoSaveIdent)
+      .AddString(mName)
+      .Add(mChannel)
+      .Add(mLinked)
+      .Add(mMute)
+      .Add(mSolo);
+#ifdef EXPERIMENTAL_OUTPUT_DISPLAY
+   if(MONO_PAN)
+      stamp.Add(mHeight + mHeightv);
+   else
+      stamp.Add(mHeight);
+#else
+   stamp.Add(mHeight);
+#endif
+   stamp.Add(this->GetMinimized())
+      .Add(this->GetSelected())
+      .Add(mRate)
+      .AddDouble(mGain)
+      .AddDouble(mPan)
+      .Add(mClips.size());
+
+   for (const auto &clip : mClips)
+      stamp.Add(clip->GetXMLStamp());
+
+   return stamp.Get();
+}
+
 bool WaveTrack::GetErrorOpening()
 {
    for (const auto &clip : mClips)
@@ -2000,6 +2045,72 @@ bool WaveTrack::GetRMS(float *rms, double t0, double t1)
    return result;
 }
 
+bool WaveTrack::GetMean(double *mean, double t0, double t1) const
+{
+   *mean = 0.0;
+
+   if (t0 > t1)
+      return false;
+
+   if (t0 == t1)
+      return true;
+
+   bool result = true;
+   double sum = 0.0;
+   sampleCount length = 0;
+
+   for (const auto &clip: mClips)
+   {
+      if (t1 >= clip->GetStartTime() && t0 <= clip->GetEndTime())
+      {
+         double clipmean;
+         sampleCount clipStart, clipEnd;
+
+         if (clip->GetMean(&clipmean, t0, t1))
+         {
+            clip->TimeToSamplesClip(wxMax(t0, clip->GetStartTime()), &clipStart);
+            clip->TimeToSamplesClip(wxMin(t1, clip->GetEndTime()), &clipEnd);
+            sum += clipmean * (clipEnd - clipStart).as_double();
+            length += (clipEnd - clipStart);
+         }
+         else
+         {
+            result = false;
+         }
+      }
+   }
+   *mean = length > 0 ? sum / length.as_double() : 0.0;
+
+   return result;
+}
+
+bool WaveTrack::GetClipCount(sampleCount *count, double t0, double t1) const
+{
+   *count = 0;
+
+   if (t0 > t1)
+      return false;
+
+   if (t0 == t1)
+      return true;
+
+   bool result = true;
+
+   for (const auto &clip: mClips)
+   {
+      if (t1 >= clip->GetStartTime() && t0 <= clip->GetEndTime())
+      {
+         sampleCount clipcount;
+         if (clip->GetClipCount(&clipcount, t0, t1))
+            *count += clipcount;
+         else
+            result = false;
+      }
+   }
+
+   return result;
+}
+
 bool WaveTrack::Get(samplePtr buffer, sampleFormat format,
                     sampleCount start, size_t len, fillFormat fill ) const
 {
@@ -2710,10 +2821,8 @@ constSamplePtr WaveTrackCache::Get(sampleFormat format,
          if (start0 >= 0) {
             const auto len0 = mPTrack->GetBestBlockSize(start0);
             wxASSERT(len0 <= mBufferSize);
-            if (!mPTrack->Get(samplePtr(mBuffers[0].data), floatSample, start0, len0))
+            if (!Fill(mBuffers[0], start0, len0))
                return 0;
-            mBuffers[0].start = start0;
-            mBuffers[0].len = len0;
             if (!fillSecond &&
                 mBuffers[0].end() != mBuffers[1].start)
                fillSecond = true;
@@ -2736,10 +2845,8 @@ constSamplePtr WaveTrackCache::Get(sampleFormat format,
             if (start1 == end0) {
                const auto len1 = mPTrack->GetBestBlockSize(start1);
                wxASSERT(len1 <= mBufferSize);
-               if (!mPTrack->Get(samplePtr(mBuffers[1].data), floatSample, start1, len1))
+               if (!Fill(mBuffers[1], start1, len1))
                   return 0;
-               mBuffers[1].start = start1;
-               mBuffers[1].len = len1;
                mNValidBuffers = 2;
             }
          }
@@ -2783,7 +2890,7 @@ constSamplePtr WaveTrackCache::Get(sampleFormat format,
             // All is contiguous already.  We can completely avoid copying
             // leni is nonnegative, therefore start falls within mBuffers[ii],
             // so starti is bounded between 0 and buffer length
-            return samplePtr(mBuffers[ii].data + starti.as_size_t() );
+            return constSamplePtr(mBuffers[ii].samples() + starti.as_size_t() );
          }
          else if (leni > 0) {
             // leni is nonnegative, therefore start falls within mBuffers[ii]
@@ -2795,7 +2902,7 @@ constSamplePtr WaveTrackCache::Get(sampleFormat format,
             // leni is positive and not more than remaining
             const size_t size = sizeof(float) * leni.as_size_t();
             // starti is less than mBuffers[ii].len and nonnegative
-            memcpy(buffer, mBuffers[ii].data + starti.as_size_t(), size);
+            memcpy(buffer, mBuffers[ii].samples() + starti.as_size_t(), size);
             wxASSERT( leni <= remaining );
             remaining -= leni.as_size_t();
             start += leni;
@@ -2825,6 +2932,21 @@ constSamplePtr WaveTrackCache::Get(sampleFormat format,
       return 0;
 }
 
+// Reads one block into the buffer, or if the block file can be mapped,
+// just points the buffer at its samples
+bool WaveTrackCache::Fill(Buffer &buffer, sampleCount start, size_t len)
+{
+   buffer.mapped = mPTrack->GetFloatData(start, len, buffer.holder);
+   if (!buffer.mapped) {
+      buffer.holder.reset();
+      if (!mPTrack->Get(samplePtr(buffer.data), floatSample, start, len))
+         return false;
+   }
+   buffer.start = start;
+   buffer.len = len;
+   return true;
+}
+
 void WaveTrackCache::Free()
 {
    mBuffers[0].Free();
@@ -28,6 +28,9 @@ class SpectrogramSettings;
 class WaveformSettings;
 class TimeWarper;
 
+class MappedFile;
+using MappedFilePtr = std::shared_ptr<const MappedFile>;
+
 //
 // Tolerance for merging wave tracks (in seconds)
 //
@@ -237,6 +240,11 @@ class AUDACITY_DLL_API WaveTrack final : public Track {
    ///
    bool Get(samplePtr buffer, sampleFormat format,
                    sampleCount start, size_t len, fillFormat fill=fillZero) const;
+   /// The samples in place, as floats, if they lie within one block of one
+   /// clip whose file can be mapped; else null.  The pointer is valid
+   /// while holder lives.
+   const float *GetFloatData(sampleCount start, size_t len,
+                             MappedFilePtr &holder) const;
    bool Set(samplePtr buffer, sampleFormat format,
                    sampleCount start, size_t len);
    void GetEnvelopeValues(double *buffer, size_t bufferLen,
@@ -244,6 +252,10 @@ class AUDACITY_DLL_API WaveTrack final : public Track {
    bool GetMinMax(float *min, float *max,
                   double t0, double t1) const;
    bool GetRMS(float *rms, double t0, double t1);
+   // Mean of the samples of the clips in the range; gaps don't count
+   bool GetMean(double *mean, double t0, double t1) const;
+   // Number of samples at full scale in the range
+   bool GetClipCount(sampleCount *count, double t0, double t1) const;
 
    //
    // MM: We now have more than one sequence and envelope per track, so
@@ -279,6 +291,7 @@ class AUDACITY_DLL_API WaveTrack final : public Track {
    void HandleXMLEndTag(const wxChar *tag) override;
    XMLTagHandler *HandleXMLChild(const wxChar *tag) override;
    void WriteXML(XMLWriter &xmlFile) override;
+   unsigned long long GetXMLStamp() const override;
 
    // Returns true if an error occurred while reading from XML
    bool GetErrorOpening() override;
@@ -633,12 +646,19 @@ private:
       float *data;
       sampleCount start;
       sampleCount len;
+      // Samples in a mapped block file instead of in data, if not null
+      const float *mapped;
+      MappedFilePtr holder;
 
-      Buffer() : data(0), start(0), len(0) {}
-      void Free() { delete[] data; data = 0; start = 0; len = 0; }
+      Buffer() : data(0), start(0), len(0), mapped(0) {}
+      void Free() { delete[] data; data = 0; start = 0; len = 0;
+                    mapped = 0; holder.reset(); }
       sampleCount end() const { return start + len; }
+      const float *samples() const { return mapped ? mapped : data; }
    };
 
+   bool Fill(Buffer &buffer, sampleCount start, size_t len);
+
    const WaveTrack *mPTrack;
    size_t mBufferSize;
    Buffer mBuffers[2];
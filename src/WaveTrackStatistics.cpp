@@ -0,0 +1,271 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WaveTrackStatistics.cpp
+
+*******************************************************************//**
+
+\class WaveTrackStatistics
+\brief Finds the min, max, RMS and mean of many ranges of wave tracks at
+once, as for normalizing many tracks or scanning a project for peaks.
+
+The ranges are first broken into the parts of blocks that they cover,
+and these are gathered by block file.  Then each block file is visited
+once, on one of the threads of a WorkerPool: whole blocks are answered
+from the statistics that the block keeps, and the samples for all the
+partial parts of a block are read together.  Finally the parts are added
+up into the ranges.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "WaveTrackStatistics.h"
+
+#include <algorithm>
+#include <float.h>
+#include <map>
+#include <cmath>
+
+#include "BlockFile.h"
+#include "Sequence.h"
+#include "WaveClip.h"
+#include "WaveTrack.h"
+#include "WorkerPool.h"
+
+namespace {
+
+// With fewer samples than this to read, Compute() does not start a pool,
+// whose threads would cost more than they save
+const size_t MinPooledSamples = 1024 * 1024;
+
+// The part of one block that one range covers, with its results
+struct Request {
+   size_t range;
+   size_t start, len;
+
+   float min, max;
+   double sum, sumSquares;
+   size_t clipCount;
+   bool ok;
+};
+
+// A block file and the requests for its parts
+struct BlockTask {
+   BlockFilePtr file;
+   std::vector<size_t> requests;
+};
+
+void RunTask(const BlockTask &task, std::vector<Request> &requests)
+{
+   const BlockFile &file = *task.file;
+   const auto blockLen = file.GetLength();
+
+   float blockMin, blockMax, blockRMS;
+   file.GetMinMax(&blockMin, &blockMax, &blockRMS);
+
+   // Read once the span of samples that covers all the partial requests
+   size_t lo = blockLen, hi = 0;
+   for (auto r : task.requests) {
+      const auto &request = requests[r];
+      if (request.len < blockLen) {
+         lo = std::min(lo, request.start);
+         hi = std::max(hi, request.start + request.len);
+      }
+   }
+
+   SampleBuffer samples;
+   bool haveSamples = false;
+   if (lo < hi && file.IsDataAvailable()) {
+      samples.Allocate(hi - lo, floatSample);
+      const auto result =
+         file.ReadData(samples.ptr(), floatSample, lo, hi - lo);
+      if (result < hi - lo)
+         ClearSamples(samples.ptr(), floatSample, result, hi - lo - result);
+      haveSamples = true;
+   }
+
+   for (auto r : task.requests) {
+      auto &request = requests[r];
+      request.sum = request.sumSquares = 0.0;
+      request.clipCount = 0;
+
+      if (request.len == blockLen) {
+         request.min = blockMin;
+         request.max = blockMax;
+         request.ok = file.GetStatistics(
+            &request.sum, &request.sumSquares, &request.clipCount);
+         if (!request.ok)
+            request.sumSquares = (double)blockRMS * blockRMS * blockLen;
+      }
+      else if (haveSamples) {
+         const float *buffer =
+            (const float *)samples.ptr() + (request.start - lo);
+         float min = FLT_MAX, max = -FLT_MAX;
+         for (size_t i = 0; i < request.len; ++i) {
+            min = std::min(min, buffer[i]);
+            max = std::max(max, buffer[i]);
+         }
+         request.min = min;
+         request.max = max;
+         BlockFile::AccumulateStatistics(buffer, request.len,
+            &request.sum, &request.sumSquares, &request.clipCount);
+         request.ok = true;
+      }
+      else {
+         // The data are not yet available; the summary stands in for them
+         request.min = blockMin;
+         request.max = blockMax;
+         request.sumSquares = (double)blockRMS * blockRMS * request.len;
+         request.ok = false;
+      }
+   }
+}
+
+}
+
+WaveTrackStatistics::WaveTrackStatistics()
+{
+}
+
+WaveTrackStatistics::~WaveTrackStatistics()
+{
+}
+
+size_t WaveTrackStatistics::Add(const WaveTrack *track, double t0, double t1)
+{
+   mRanges.push_back(Range{ track, t0, t1 });
+   return mRanges.size() - 1;
+}
+
+void WaveTrackStatistics::Compute()
+{
+   DoCompute(NULL);
+}
+
+void WaveTrackStatistics::Compute(WorkerPool &pool)
+{
+   DoCompute(&pool);
+}
+
+void WaveTrackStatistics::DoCompute(WorkerPool *pool)
+{
+   std::vector<Request> requests;
+   std::vector<BlockTask> tasks;
+   std::map<const BlockFile*, size_t> taskIndices;
+   // Ranges that touch some clip without covering any of its samples, which
+   // WaveTrack::GetMinMax counts as a zero
+   std::vector<bool> touched(mRanges.size(), false);
+
+   for (size_t r = 0; r < mRanges.size(); ++r) {
+      const auto &range = mRanges[r];
+      if (!(range.t0 < range.t1))
+         continue;
+
+      for (const auto &clip : range.track->GetClips()) {
+         // As WaveTrack::GetMinMax chooses the clips
+         if (!(range.t1 >= clip->GetStartTime() &&
+               range.t0 <= clip->GetEndTime()))
+            continue;
+
+         sampleCount s0, s1;
+         clip->TimeToSamplesClip(range.t0, &s0);
+         clip->TimeToSamplesClip(range.t1, &s1);
+         if (!(s0 < s1)) {
+            touched[r] = true;
+            continue;
+         }
+
+         const BlockArray &blocks = *clip->GetSequenceBlockArray();
+
+         // The last block that starts at or before s0
+         auto iter = std::upper_bound(blocks.begin(), blocks.end(), s0,
+            [](sampleCount s, const SeqBlock &block){ return s < block.start; });
+         if (iter == blocks.begin())
+            continue;
+         --iter;
+
+         for (; iter != blocks.end() && iter->start < s1; ++iter) {
+            const auto blockEnd = iter->start + iter->f->GetLength();
+            const auto start = std::max(s0, iter->start);
+            const auto end = std::min(s1, blockEnd);
+
+            Request request{};
+            request.range = r;
+            request.start = (start - iter->start).as_size_t();
+            request.len = (end - start).as_size_t();
+
+            const auto result =
+               taskIndices.insert({ iter->f.get(), tasks.size() });
+            if (result.second)
+               tasks.push_back(BlockTask{ iter->f, {} });
+            tasks[result.first->second].requests.push_back(requests.size());
+            requests.push_back(request);
+         }
+      }
+   }
+
+   // Whole blocks cost nothing to answer; count the samples to read
+   size_t samplesToRead = 0;
+   for (const auto &task : tasks)
+      for (auto r : task.requests)
+         if (requests[r].len < task.file->GetLength())
+            samplesToRead += requests[r].len;
+
+   const auto runTask = [&](size_t i){ RunTask(tasks[i], requests); };
+   if (pool)
+      pool->ForEach(tasks.size(), runTask);
+   else if (tasks.size() > 1 && samplesToRead >= MinPooledSamples) {
+      WorkerPool localPool{ WorkerPool::GetProcessorCount() };
+      localPool.ForEach(tasks.size(), runTask);
+   }
+   else {
+      for (size_t i = 0; i < tasks.size(); ++i)
+         runTask(i);
+   }
+
+   // Add up the parts
+   struct Totals {
+      double sum, sumSquares;
+      sampleCount length, clipCount;
+   };
+   std::vector<Totals> totals(mRanges.size(), Totals{ 0.0, 0.0, 0, 0 });
+
+   for (auto &range : mRanges) {
+      range.min = FLT_MAX;
+      range.max = -FLT_MAX;
+      range.ok = !(range.t0 > range.t1);
+   }
+
+   for (const auto &request : requests) {
+      auto &range = mRanges[request.range];
+      auto &total = totals[request.range];
+      range.min = std::min(range.min, request.min);
+      range.max = std::max(range.max, request.max);
+      range.ok = range.ok && request.ok;
+      total.sum += request.sum;
+      total.sumSquares += request.sumSquares;
+      total.length += request.len;
+      total.clipCount += request.clipCount;
+   }
+
+   for (size_t r = 0; r < mRanges.size(); ++r) {
+      auto &range = mRanges[r];
+      const auto &total = totals[r];
+      if (touched[r]) {
+         range.min = std::min(range.min, 0.0f);
+         range.max = std::max(range.max, 0.0f);
+      }
+      if (total.length > 0) {
+         const auto length = total.length.as_double();
+         range.rms = sqrt(total.sumSquares / length);
+         range.mean = total.sum / length;
+      }
+      else {
+         // sensible defaults if no samples found
+         range.min = range.max = range.rms = 0.0f;
+         range.mean = 0.0;
+      }
+      range.clipCount = total.clipCount;
+   }
+}
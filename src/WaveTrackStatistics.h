@@ -0,0 +1,68 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WaveTrackStatistics.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_WAVE_TRACK_STATISTICS__
+#define __AUDACITY_WAVE_TRACK_STATISTICS__
+
+#include "Audacity.h"
+#include "SampleFormat.h"
+#include <vector>
+
+class WaveTrack;
+class WorkerPool;
+
+/// The min, max, RMS and mean of many ranges of wave tracks, found
+/// together on several threads.  Each block file is visited once for all
+/// the ranges that touch it, so blocks that tracks share, and the blocks
+/// at the ends of adjacent ranges, are read only once.
+class AUDACITY_DLL_API WaveTrackStatistics final
+{
+ public:
+   struct Range {
+      Range(const WaveTrack *track_, double t0_, double t1_)
+         : track{ track_ }, t0{ t0_ }, t1{ t1_ }
+         , min{ 0.0f }, max{ 0.0f }, rms{ 0.0f }, mean{ 0.0 }
+         , clipCount{ 0 }, ok{ false }
+      {}
+
+      const WaveTrack *track;
+      double t0, t1;
+
+      // Results, as WaveTrack::GetMinMax, GetRMS, GetMean and GetClipCount
+      // would give them
+      float min, max, rms;
+      double mean;
+      sampleCount clipCount;
+      // False if some of the data were not yet available (for OD), or some
+      // blocks lacked exact statistics; then the summaries stand in
+      bool ok;
+   };
+
+   WaveTrackStatistics();
+   ~WaveTrackStatistics();
+
+   /// Returns the index of the range among the results
+   size_t Add(const WaveTrack *track, double t0, double t1);
+
+   /// Finds the results for all the ranges added, using the pool
+   void Compute(WorkerPool &pool);
+   /// Finds the results, with a pool of a thread for each processor when
+   /// there are more than a million samples to read, else on this thread
+   void Compute();
+
+   size_t size() const { return mRanges.size(); }
+   const Range &operator [] (size_t index) const { return mRanges[index]; }
+
+ private:
+   // With a null pool, chooses as Compute() says
+   void DoCompute(WorkerPool *pool);
+
+   std::vector<Range> mRanges;
+};
+
+#endif
@@ -0,0 +1,106 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WaveformTileCache.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_WAVEFORM_TILE_CACHE__
+#define __AUDACITY_WAVEFORM_TILE_CACHE__
+
+#include <map>
+#include <vector>
+#include <wx/bitmap.h>
+
+/// Bitmaps of the waveform of a clip as TrackArtist draws it, background
+/// and all, in tiles of columns counted from the start of the clip.
+/// Scrolling copies the columns already drawn and draws only the newly
+/// exposed ones.  Each tile remembers which of its columns are drawn, and
+/// the envelope and selection they were drawn with; all the tiles are
+/// discarded when anything else that changes the drawing changes.
+class WaveformTileCache
+{
+public:
+   enum { TileWidth = 256 };
+
+   // What the drawing of every column depends on, besides its own data,
+   // envelope value and selection
+   struct Key {
+      double zoom;
+      // Thousandths of a pixel from the start of the clip to the column
+      // boundary before it
+      int phase;
+      int height;
+      float zoomMin, zoomMax;
+      bool dB;
+      float dBRange;
+      int zeroLevel;
+      bool drawEnvelope;
+      bool muted;
+      bool showClipping;
+      int dirty;
+      unsigned colours;
+
+      bool operator == (const Key &other) const
+      {
+         return zoom == other.zoom && phase == other.phase &&
+            height == other.height &&
+            zoomMin == other.zoomMin && zoomMax == other.zoomMax &&
+            dB == other.dB && dBRange == other.dBRange &&
+            zeroLevel == other.zeroLevel &&
+            drawEnvelope == other.drawEnvelope &&
+            muted == other.muted && showClipping == other.showClipping &&
+            dirty == other.dirty && colours == other.colours;
+      }
+   };
+
+   struct Tile {
+      Tile() : begin{ 0 }, end{ 0 }, selBegin{ 0 }, selEnd{ 0 } {}
+
+      wxBitmap bitmap;
+      // The drawn columns, relative to the start of the tile
+      int begin, end;
+      // The envelope values they were drawn with, for all the tile
+      std::vector<double> env;
+      // The selected columns, relative to the start of the tile
+      int selBegin, selEnd;
+   };
+
+   WaveformTileCache() : mHaveKey{ false } {}
+
+   // Discards all the tiles if the key is not as before
+   void SetKey(const Key &key)
+   {
+      if (!(mHaveKey && mKey == key)) {
+         mTiles.clear();
+         mKey = key;
+         mHaveKey = true;
+      }
+   }
+
+   // The tile starting at column index * TileWidth, made if absent
+   Tile &GetTile(long long index)
+   {
+      Tile &tile = mTiles[index];
+      if (!tile.bitmap.IsOk()) {
+         tile.bitmap.Create(TileWidth, mKey.height);
+         tile.env.resize(TileWidth);
+      }
+      return tile;
+   }
+
+   // Discards the tiles with indices outside [first, last]
+   void Trim(long long first, long long last)
+   {
+      mTiles.erase(mTiles.begin(), mTiles.lower_bound(first));
+      mTiles.erase(mTiles.upper_bound(last), mTiles.end());
+   }
+
+private:
+   Key mKey;
+   bool mHaveKey;
+   std::map<long long, Tile> mTiles;
+};
+
+#endif
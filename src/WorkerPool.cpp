@@ -0,0 +1,203 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WorkerPool.cpp
+
+*******************************************************************//**
+
+\class WorkerPool
+\brief Runs the iterations of a loop on a fixed set of threads, and
+waits for all of them: in effect a parallel for, with a barrier at the
+end.
+
+The threads are started once, and sleep between loops, so that a loop
+costs only a wake-up rather than thread creation.  Iterations are
+handed out one at a time from an atomic counter, so a slow iteration
+does not hold up the others.  ForEach does not allocate, so it may be
+called from the audio thread.
+
+Everything an iteration writes is visible to the caller of ForEach after
+it returns, and to any thread running a later loop, because each loop
+begins and ends under the pool's lock.
+
+*//*******************************************************************/
+
+#include "Audacity.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+#ifdef __WXMAC__
+
+// On Mac OS X, it's better not to use the wxThread class.
+// We use our own implementation based on pthreads instead.
+
+#include <pthread.h>
+
+class WorkerThread::Impl
+{
+ public:
+   explicit Impl(const std::function<void()> &body) : mBody(body) {}
+
+   bool Start()
+   {
+      return pthread_create(&mThread, NULL, callback, this) == 0;
+   }
+
+   void Join()
+   {
+      pthread_join(mThread, NULL);
+   }
+
+ private:
+   static void *callback(void *p)
+   {
+      static_cast<Impl*>(p)->mBody();
+      return NULL;
+   }
+
+   std::function<void()> mBody;
+   pthread_t mThread;
+};
+
+#else
+
+class WorkerThread::Impl final : public wxThread
+{
+ public:
+   explicit Impl(const std::function<void()> &body)
+   : wxThread(wxTHREAD_JOINABLE), mBody(body) {}
+
+   bool Start()
+   {
+      return Create() == wxTHREAD_NO_ERROR && Run() == wxTHREAD_NO_ERROR;
+   }
+
+   void Join()
+   {
+      Wait();
+   }
+
+ protected:
+   ExitCode Entry() override
+   {
+      mBody();
+      return 0;
+   }
+
+ private:
+   std::function<void()> mBody;
+};
+
+#endif
+
+WorkerThread::WorkerThread(const std::function<void()> &body)
+: mImpl(std::make_unique<Impl>(body))
+{
+}
+
+WorkerThread::~WorkerThread()
+{
+}
+
+bool WorkerThread::Start()
+{
+   return mImpl->Start();
+}
+
+void WorkerThread::Join()
+{
+   mImpl->Join();
+}
+
+size_t WorkerPool::GetProcessorCount()
+{
+   return std::max(1, wxThread::GetCPUCount());
+}
+
+WorkerPool::WorkerPool(size_t nThreads)
+: mStartCondition(&mLock)
+, mDoneCondition(&mLock)
+, mTask(nullptr)
+, mFunction(nullptr)
+, mCount(0)
+, mGeneration(0)
+, mQuit(false)
+, mBusy(0)
+, mNext(0)
+{
+   for (size_t i = 1; i < nThreads; i++) {
+      auto worker = std::make_unique<WorkerThread>([this]{ WorkerLoop(); });
+      if (!worker->Start())
+         break;
+      mWorkers.push_back(std::move(worker));
+   }
+}
+
+WorkerPool::~WorkerPool()
+{
+   {
+      ODLocker locker{ &mLock };
+      mQuit = true;
+      mStartCondition.Broadcast();
+   }
+
+   for (auto &worker : mWorkers)
+      worker->Join();
+}
+
+void WorkerPool::Run(size_t count, Task task, const void *function)
+{
+   if (mWorkers.empty() || count < 2) {
+      for (size_t i = 0; i < count; i++)
+         task(function, i);
+      return;
+   }
+
+   {
+      ODLocker locker{ &mLock };
+      mTask = task;
+      mFunction = function;
+      mCount = count;
+      mNext = 0;
+      mBusy = mWorkers.size();
+      ++mGeneration;
+      mStartCondition.Broadcast();
+   }
+
+   RunTasks();
+
+   // The barrier: wait for the iterations the workers took
+   ODLocker locker{ &mLock };
+   while (mBusy > 0)
+      mDoneCondition.Wait();
+   mTask = nullptr;
+   mFunction = nullptr;
+}
+
+void WorkerPool::RunTasks()
+{
+   for (size_t i; (i = mNext++) < mCount;)
+      mTask(mFunction, i);
+}
+
+void WorkerPool::WorkerLoop()
+{
+   unsigned generation = 0;
+   ODLocker locker{ &mLock };
+   while (true) {
+      while (!mQuit && mGeneration == generation)
+         mStartCondition.Wait();
+      if (mQuit)
+         break;
+      generation = mGeneration;
+
+      locker.reset();
+      RunTasks();
+      locker.reset(&mLock);
+
+      if (--mBusy == 0)
+         mDoneCondition.Signal();
+   }
+}
@@ -0,0 +1,103 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WorkerPool.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_WORKER_POOL__
+#define __AUDACITY_WORKER_POOL__
+
+#include "MemoryX.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "ondemand/ODTaskThread.h"
+
+/// A joinable thread that runs one function.  It uses pthreads on Mac
+/// OS X, where it's better not to use the wxThread class, and wxThread
+/// elsewhere.  Join must be called after a successful Start, before the
+/// thread is destroyed.
+class WorkerThread final
+{
+ public:
+   explicit WorkerThread(const std::function<void()> &body);
+   ~WorkerThread();
+
+   WorkerThread(const WorkerThread&) PROHIBITED;
+   WorkerThread &operator= (const WorkerThread&) PROHIBITED;
+
+   /// Returns false if the system refuses to create the thread, in which
+   /// case the body is not run
+   bool Start();
+   void Join();
+
+ private:
+   class Impl;
+   std::unique_ptr<Impl> mImpl;
+};
+
+/// A fixed set of threads that run the iterations of a loop in parallel.
+/// The thread calling ForEach takes part, so a pool of one thread has no
+/// workers and simply runs the loop.
+class WorkerPool final
+{
+ public:
+   /// The number of processors, or 1 if it can't be found
+   static size_t GetProcessorCount();
+
+   /// nThreads counts the calling thread; fewer workers may be started
+   /// if the system refuses to create more threads.
+   explicit WorkerPool(size_t nThreads);
+   ~WorkerPool();
+
+   WorkerPool(const WorkerPool&) PROHIBITED;
+   WorkerPool &operator= (const WorkerPool&) PROHIBITED;
+
+   size_t GetThreadCount() const { return mWorkers.size() + 1; }
+
+   /// Calls function(i) for each i in [0, count), in no particular order
+   /// and possibly at the same time on different threads, then returns
+   /// once all the calls have returned.  The function must not throw.
+   /// ForEach itself must be called by one thread at a time.
+   template<typename Function>
+   void ForEach(size_t count, const Function &function)
+   {
+      Run(count, &Call<Function>, &function);
+   }
+
+ private:
+   using Task = void (*)(const void *function, size_t index);
+
+   template<typename Function>
+   static void Call(const void *function, size_t index)
+   {
+      (*static_cast<const Function*>(function))(index);
+   }
+
+   void Run(size_t count, Task task, const void *function);
+   void RunTasks();
+   void WorkerLoop();
+
+   ODLock mLock;
+   ODCondition mStartCondition;
+   ODCondition mDoneCondition;
+
+   // Written under mLock before the workers are woken
+   Task mTask;
+   const void *mFunction;
+   size_t mCount;
+   unsigned mGeneration;
+   bool mQuit;
+
+   // Workers still running the current loop
+   size_t mBusy;
+
+   std::atomic<size_t> mNext;
+
+   std::vector<std::unique_ptr<WorkerThread>> mWorkers;
+};
+
+#endif
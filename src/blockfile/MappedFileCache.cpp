@@ -0,0 +1,230 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MappedFileCache.cpp
+
+*******************************************************************//**
+
+\class MappedFileCache
+\brief Keeps the most recently read block files mapped into memory.
+
+SimpleBlockFile used to open, seek, read and close its .au file, through
+libsndfile, for every ReadData call, and again for every ReadSummary.
+Reading the same block in pieces, as export and effects do, repeated all
+of that, and the data passed through the page cache and then a copy.
+
+Block files are never modified once written, so a read-only mapping can
+be shared by all readers on all threads without locking.  Samples are
+converted straight from the mapping, and float blocks can even be used
+in place, with no copy at all.
+
+The total size of the mappings is limited by the preference
+"/Directories/MappedBlockFilesMB"; zero disables mapping, and the block
+files are read as before.  Evicted mappings that are still in use stay
+mapped until their last user lets go of them.  That is harmless where a
+mapped file can still be deleted or renamed, but not on Windows, so
+block files are not mapped there.
+
+*//****************************************************************//**
+
+\class MappedFile
+\brief A read-only mapping of a whole file.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include "MappedFileCache.h"
+
+#include <algorithm>
+
+#include <wx/file.h>
+
+#ifdef __WXMSW__
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
+#include "../Prefs.h"
+
+MappedFile::~MappedFile()
+{
+#ifdef __WXMSW__
+   UnmapViewOfFile(mData);
+#else
+   munmap((void *)mData, mSize);
+#endif
+}
+
+std::unique_ptr<MappedFile> MappedFile::Map(const wxString &fullPath)
+{
+   // Open with wxFile, which copes with Unicode names everywhere; the
+   // mapping outlives the descriptor
+   wxFile file;
+   if (!wxFile::Exists(fullPath) || !file.Open(fullPath))
+      return {};
+
+   const wxFileOffset length = file.Length();
+   if (length <= 0 || (unsigned long long)length > (size_t)-1)
+      return {};
+   const size_t size = length;
+
+#ifdef __WXMSW__
+   HANDLE handle = (HANDLE)_get_osfhandle(file.fd());
+   HANDLE mapping =
+      CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+   if (!mapping)
+      return {};
+   void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+   // The view keeps the mapping object alive
+   CloseHandle(mapping);
+   if (!data)
+      return {};
+#else
+   void *data = mmap(NULL, size, PROT_READ, MAP_SHARED, file.fd(), 0);
+   if (data == MAP_FAILED)
+      return {};
+#endif
+
+   return std::unique_ptr<MappedFile>{
+      safenew MappedFile{ (const char *)data, size } };
+}
+
+MappedFileCache &MappedFileCache::Get()
+{
+   static MappedFileCache theCache;
+   return theCache;
+}
+
+MappedFileCache::MappedFileCache()
+: mMaxBytes{ DefaultMaxMegabytes << 20 }
+, mBytes{ 0 }
+, mHits{ 0 }
+, mMisses{ 0 }
+, mEvictions{ 0 }
+{
+   // gPrefs may not exist yet in the unit tests
+   if (gPrefs) {
+      long megabytes = gPrefs->Read(wxT("/Directories/MappedBlockFilesMB"),
+                                    (long)DefaultMaxMegabytes);
+      mMaxBytes = Supported ? (size_t)std::max(0L, megabytes) << 20 : 0;
+   }
+}
+
+MappedFileCache::~MappedFileCache()
+{
+}
+
+MappedFilePtr MappedFileCache::Acquire(const wxString &fullPath)
+{
+   {
+      ODLocker locker{ &mCacheMutex };
+      if (mMaxBytes == 0)
+         return {};
+
+      auto iter = mIndex.find(fullPath);
+      if (iter != mIndex.end()) {
+         // Move to the front of the LRU list
+         mEntries.splice(mEntries.begin(), mEntries, iter->second);
+         ++mHits;
+         return iter->second->file;
+      }
+      ++mMisses;
+   }
+
+   // Map outside of the cache lock, so that readers of other files
+   // are not held up
+   MappedFilePtr file{ MappedFile::Map(fullPath) };
+   if (!file)
+      return {};
+
+   std::vector<MappedFilePtr> removed;
+   {
+      ODLocker locker{ &mCacheMutex };
+      auto iter = mIndex.find(fullPath);
+      if (iter != mIndex.end())
+         // Another thread mapped the same file meanwhile; use its mapping,
+         // and let ours go
+         return iter->second->file;
+
+      mEntries.push_front({ fullPath, file });
+      mIndex[fullPath] = mEntries.begin();
+      mBytes += file->GetSize();
+      Trim(removed);
+   }
+   // Evicted mappings are unmapped here, outside the cache lock, or later
+   // by their last user
+
+   return file;
+}
+
+void MappedFileCache::Remove(EntryList::iterator iter,
+                             std::vector<MappedFilePtr> &removed)
+{
+   mBytes -= iter->file->GetSize();
+   removed.push_back(std::move(iter->file));
+   mIndex.erase(iter->path);
+   mEntries.erase(iter);
+}
+
+void MappedFileCache::Trim(std::vector<MappedFilePtr> &removed)
+{
+   // Always keep the newest, however large
+   while (mBytes > mMaxBytes && mEntries.size() > 1) {
+      Remove(std::prev(mEntries.end()), removed);
+      ++mEvictions;
+   }
+   if (mMaxBytes == 0 && !mEntries.empty())
+      Remove(mEntries.begin(), removed);
+}
+
+void MappedFileCache::Invalidate(const wxString &fullPath)
+{
+   std::vector<MappedFilePtr> removed;
+   {
+      ODLocker locker{ &mCacheMutex };
+      auto iter = mIndex.find(fullPath);
+      if (iter != mIndex.end())
+         Remove(iter->second, removed);
+   }
+}
+
+void MappedFileCache::Clear()
+{
+   std::vector<MappedFilePtr> removed;
+   {
+      ODLocker locker{ &mCacheMutex };
+      while (!mEntries.empty())
+         Remove(mEntries.begin(), removed);
+   }
+}
+
+void MappedFileCache::SetMaxBytes(size_t maxBytes)
+{
+   std::vector<MappedFilePtr> removed;
+   {
+      ODLocker locker{ &mCacheMutex };
+      mMaxBytes = Supported ? maxBytes : 0;
+      Trim(removed);
+   }
+}
+
+size_t MappedFileCache::GetMaxBytes() const
+{
+   ODLocker locker{ &mCacheMutex };
+   return mMaxBytes;
+}
+
+auto MappedFileCache::GetStatistics() const -> Statistics
+{
+   ODLocker locker{ &mCacheMutex };
+   return { mHits, mMisses, mEvictions, mEntries.size(), mBytes };
+}
+
+void MappedFileCache::ResetStatistics()
+{
+   ODLocker locker{ &mCacheMutex };
+   mHits = mMisses = mEvictions = 0;
+}
@@ -0,0 +1,121 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  MappedFileCache.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_MAPPEDFILECACHE__
+#define __AUDACITY_MAPPEDFILECACHE__
+
+#include "../MemoryX.h"
+#include <list>
+#include <map>
+#include <vector>
+
+#include <wx/string.h>
+
+#include "../ondemand/ODTaskThread.h"
+
+/// The whole of a file mapped read-only into memory.  The mapping stays
+/// valid while any pointer to this object lives, even if the cache has
+/// let go of it.
+class MappedFile final
+{
+ public:
+   ~MappedFile();
+
+   const char *GetData() const { return mData; }
+   size_t GetSize() const { return mSize; }
+
+   /// Map the whole file read-only, outside of any cache.
+   /// Null if the file can't be opened or mapped, or is empty.
+   static std::unique_ptr<MappedFile> Map(const wxString &fullPath);
+
+ private:
+   friend class MappedFileCache;
+   MappedFile(const char *data, size_t size) : mData{ data }, mSize{ size } {}
+
+   MappedFile(const MappedFile&) PROHIBITED;
+   MappedFile &operator= (const MappedFile&) PROHIBITED;
+
+   const char *const mData;
+   const size_t mSize;
+};
+
+using MappedFilePtr = std::shared_ptr<const MappedFile>;
+
+/// A process-wide, least-recently-used cache of read-only mappings of
+/// SimpleBlockFile data files, limited in the total bytes mapped.
+class MappedFileCache final
+{
+ public:
+#ifdef __WXMSW__
+   // Windows won't delete or rename a file while a view of it is mapped,
+   // and readers such as WaveTrackCache may keep a mapping after the
+   // cache lets go of it, so block files are not mapped there
+   enum { Supported = 0, DefaultMaxMegabytes = 0 };
+#else
+   // Less address space on 32 bit systems
+   enum { Supported = 1, DefaultMaxMegabytes = sizeof(void *) >= 8 ? 256 : 64 };
+#endif
+
+   struct Statistics {
+      unsigned long long hits;
+      unsigned long long misses;
+      unsigned long long evictions;
+      size_t mappedFiles;
+      size_t mappedBytes;
+   };
+
+   static MappedFileCache &Get();
+
+   /// The mapping of the file, mapping it if needed.  Null if mapping is
+   /// disabled or fails; such failures are not cached.
+   MappedFilePtr Acquire(const wxString &fullPath);
+
+   /// Forget any mapping of this file.  Call before overwriting, renaming
+   /// or deleting a block file.
+   void Invalidate(const wxString &fullPath);
+   /// Forget all mappings.
+   void Clear();
+
+   /// Zero disables mapping.  Ignored where mapping is not Supported.
+   void SetMaxBytes(size_t maxBytes);
+   size_t GetMaxBytes() const;
+
+   Statistics GetStatistics() const;
+   void ResetStatistics();
+
+ private:
+   MappedFileCache();
+   ~MappedFileCache();
+
+   MappedFileCache(const MappedFileCache&) PROHIBITED;
+   MappedFileCache &operator= (const MappedFileCache&) PROHIBITED;
+
+   struct Entry {
+      wxString path;
+      MappedFilePtr file;
+   };
+   using EntryList = std::list<Entry>;
+
+   // Must be called with mCacheMutex held
+   void Remove(EntryList::iterator iter, std::vector<MappedFilePtr> &removed);
+   void Trim(std::vector<MappedFilePtr> &removed);
+
+   mutable ODLock mCacheMutex;
+
+   // Front is most recently used
+   EntryList mEntries;
+   std::map<wxString, EntryList::iterator> mIndex;
+
+   size_t mMaxBytes;
+   size_t mBytes;
+   unsigned long long mHits;
+   unsigned long long mMisses;
+   unsigned long long mEvictions;
+};
+
+#endif
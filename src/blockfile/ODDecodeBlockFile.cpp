@@ -372,6 +372,7 @@ void ODDecodeBlockFile::SetFileName(wxFileNameWrapper &&name)
    delete [] mFileNameChar;
    mFileNameChar = new char[strlen(mFileName.GetFullPath().mb_str(wxConvUTF8))+1];
    strcpy(mFileNameChar,mFileName.GetFullPath().mb_str(wxConvUTF8)); */
+   ++mRenames;
    mFileNameMutex.Unlock();
 }
 
@@ -381,8 +382,6 @@ auto ODDecodeBlockFile::GetFileName() const -> GetFileNameResult
    return { mFileName, ODLocker{ &mFileNameMutex } };
 }
 
-/// A thread-safe version of CalcSummary.  BlockFile::CalcSummary
-/// uses a static summary array across the class, which we can't use.
 /// Get a buffer containing a summary block describing this sample
 /// data.  This must be called by derived classes when they
 /// are constructed, to allow them to construct their summary data,
@@ -461,6 +460,16 @@ size_t ODDecodeBlockFile::ReadData(samplePtr data, sampleFormat format,
    return ret;
 }
 
+const float *ODDecodeBlockFile::GetFloatData(MappedFilePtr &holder) const
+{
+   const float *result = nullptr;
+   LockRead();
+   if(IsSummaryAvailable())
+      result = SimpleBlockFile::GetFloatData(holder);
+   UnlockRead();
+   return result;
+}
+
 /// Read the summary of this alias block from disk.  Since the audio data
 /// is elsewhere, this consists of reading the entire summary file.
 ///
@@ -505,6 +514,7 @@ void ODDecodeBlockFile::UnlockRead() const
 void ODDecodeBlockFile::ChangeAudioFile(wxFileNameWrapper &&newAudioFile)
 {
    mAudioFileName = std::move(newAudioFile);
+   ++mRenames;
 }
 
 
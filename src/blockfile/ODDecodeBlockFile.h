@@ -110,6 +110,8 @@ class ODDecodeBlockFile final : public SimpleBlockFile
    /// Reads the specified data from the aliased file using libsndfile
    size_t ReadData(samplePtr data, sampleFormat format,
                         size_t start, size_t len) const override;
+   /// Null until decoded
+   const float *GetFloatData(MappedFilePtr &holder) const override;
 
    /// Read the summary into a buffer
    bool ReadSummary(void *data) override;
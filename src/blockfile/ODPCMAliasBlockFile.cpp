@@ -30,6 +30,7 @@ The summary is eventually computed and written to a file in a background thread.
 
 #include "../AudacityApp.h"
 #include "PCMAliasBlockFile.h"
+#include "PCMAliasFileCache.h"
 #include "../FileFormats.h"
 #include "../Internat.h"
 
@@ -204,7 +205,7 @@ BlockFilePtr ODPCMAliasBlockFile::Copy(wxFileNameWrapper &&newFileName)
       newBlockFile  = make_blockfile<PCMAliasBlockFile>
          (std::move(newFileName), wxFileNameWrapper{mAliasedFileName},
           mAliasStart, mLen, mAliasChannel, mMin, mMax, mRMS);
-
+      CopyStatisticsTo(*newBlockFile);
    }
    else
    {
@@ -356,6 +357,7 @@ void ODPCMAliasBlockFile::SetFileName(wxFileNameWrapper &&name)
 {
    mFileNameMutex.Lock();
    mFileName = std::move(name);
+   ++mRenames;
    mFileNameMutex.Unlock();
 }
 
@@ -421,8 +423,6 @@ void ODPCMAliasBlockFile::WriteSummary()
 
 
 
-/// A thread-safe version of CalcSummary.  BlockFile::CalcSummary
-/// uses a static summary array across the class, which we can't use.
 /// Get a buffer containing a summary block describing this sample
 /// data.  This must be called by derived classes when they
 /// are constructed, to allow them to construct their summary data,
@@ -490,29 +490,17 @@ size_t ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
 
    LockRead();
 
-   SF_INFO info;
-
    if(!mAliasedFileName.IsOk()){ // intentionally silenced
       memset(data,0,SAMPLE_SIZE(format)*len);
       UnlockRead();
       return len;
    }
 
-   memset(&info, 0, sizeof(info));
-
    wxString aliasPath = mAliasedFileName.GetFullPath();
 
-   wxFile f;   // will be closed when it goes out of scope
-   SFFile sf;
-
-   if (f.Exists(aliasPath) && f.Open(aliasPath)) {
-      // Even though there is an sf_open() that takes a filename, use the one that
-      // takes a file descriptor since wxWidgets can open a file with a Unicode name and
-      // libsndfile can't (under Windows).
-      sf.reset(SFCall<SNDFILE*>(sf_open_fd, f.fd(), SFM_READ, &info, FALSE));
-   }
-   // FIXME: TRAP_ERR failure of wxFile open incompletely handled in ODPCMAliasBlockFile::ReadData.
-
+   // Shares open handles with PCMAliasBlockFile, and with the other blocks
+   // of the same imported file
+   auto sf = PCMAliasFileCache::Get().Acquire(aliasPath);
 
    if (!sf) {
 
@@ -529,10 +517,12 @@ size_t ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
 
    mSilentAliasLog=FALSE;
 
+   const SF_INFO &info = sf.GetInfo();
+
    // Third party library has its own type alias, check it
    static_assert(sizeof(sampleCount::type) <= sizeof(sf_count_t),
                  "Type sf_count_t is too narrow to hold a sampleCount");
-   SFCall<sf_count_t>(sf_seek, sf.get(),
+   SFCall<sf_count_t>(sf_seek, sf.GetSndFile(),
                       ( mAliasStart + start ).as_long_long(), SEEK_SET);
 
    wxASSERT(info.channels >= 0);
@@ -546,7 +536,7 @@ size_t ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       // and the calling method wants 16-bit data, go ahead and
       // read 16-bit data directly.  This is a pretty common
       // case, as most audio files are 16-bit.
-      framesRead = SFCall<sf_count_t>(sf_readf_short, sf.get(), (short *)buffer.ptr(), len);
+      framesRead = SFCall<sf_count_t>(sf_readf_short, sf.GetSndFile(), (short *)buffer.ptr(), len);
 
       for (int i = 0; i < framesRead; i++)
          ((short *)data)[i] =
@@ -556,7 +546,7 @@ size_t ODPCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       // Otherwise, let libsndfile handle the conversion and
       // scaling, and pass us normalized data as floats.  We can
       // then convert to whatever format we want.
-      framesRead = SFCall<sf_count_t>(sf_readf_float, sf.get(), (float *)buffer.ptr(), len);
+      framesRead = SFCall<sf_count_t>(sf_readf_float, sf.GetSndFile(), (float *)buffer.ptr(), len);
       float *bufferPtr = &((float *)buffer.ptr())[mAliasChannel];
       CopySamples((samplePtr)bufferPtr, floatSample,
                   (samplePtr)data, format,
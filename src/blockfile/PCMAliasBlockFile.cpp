@@ -21,6 +21,7 @@
 #include "../FileFormats.h"
 #include "../Internat.h"
 #include "../MemoryX.h"
+#include "PCMAliasFileCache.h"
 
 #include "../ondemand/ODManager.h"
 #include "../AudioIO.h"
@@ -76,33 +77,20 @@ PCMAliasBlockFile::~PCMAliasBlockFile()
 size_t PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
                                 size_t start, size_t len) const
 {
-   SF_INFO info;
-
    if(!mAliasedFileName.IsOk()){ // intentionally silenced
       memset(data,0,SAMPLE_SIZE(format)*len);
       return len;
    }
 
-   wxFile f;   // will be closed when it goes out of scope
-   SFFile sf;
+   PCMAliasFileCache::Lease sf;
    {
       Maybe<wxLogNull> silence{};
       if (mSilentAliasLog)
          silence.create();
 
-      memset(&info, 0, sizeof(info));
-
-      if (f.Exists(mAliasedFileName.GetFullPath())) { // Don't use Open if file does not exits
-         if (f.Open(mAliasedFileName.GetFullPath())) {
-            // Even though there is an sf_open() that takes a filename, use the one that
-            // takes a file descriptor since wxWidgets can open a file with a Unicode name and
-            // libsndfile can't (under Windows).
-            sf.reset(SFCall<SNDFILE*>(sf_open_fd, f.fd(), SFM_READ, &info, FALSE));
-         }
-         // FIXME: TRAP_ERR failure of wxFile open incompletely handled in PCMAliasBlockFile::ReadData.
-
-      }
-
+      // The cache keeps the file open between calls, so we don't pay for
+      // opening it and parsing its header on every read.
+      sf = PCMAliasFileCache::Get().Acquire(mAliasedFileName.GetFullPath());
       if (!sf) {
          memset(data, 0, SAMPLE_SIZE(format)*len);
          silence.reset();
@@ -116,10 +104,12 @@ size_t PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
    }
    mSilentAliasLog=FALSE;
 
+   const SF_INFO &info = sf.GetInfo();
+
    // Third party library has its own type alias, check it
    static_assert(sizeof(sampleCount::type) <= sizeof(sf_count_t),
                  "Type sf_count_t is too narrow to hold a sampleCount");
-   SFCall<sf_count_t>(sf_seek, sf.get(),
+   SFCall<sf_count_t>(sf_seek, sf.GetSndFile(),
                       ( mAliasStart + start ).as_long_long(), SEEK_SET);
    wxASSERT(info.channels >= 0);
    SampleBuffer buffer(len * info.channels, floatSample);
@@ -132,7 +122,7 @@ size_t PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       // and the calling method wants 16-bit data, go ahead and
       // read 16-bit data directly.  This is a pretty common
       // case, as most audio files are 16-bit.
-      framesRead = SFCall<sf_count_t>(sf_readf_short, sf.get(), (short *)buffer.ptr(), len);
+      framesRead = SFCall<sf_count_t>(sf_readf_short, sf.GetSndFile(), (short *)buffer.ptr(), len);
       for (int i = 0; i < framesRead; i++)
          ((short *)data)[i] =
             ((short *)buffer.ptr())[(info.channels * i) + mAliasChannel];
@@ -141,7 +131,7 @@ size_t PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       // Otherwise, let libsndfile handle the conversion and
       // scaling, and pass us normalized data as floats.  We can
       // then convert to whatever format we want.
-      framesRead = SFCall<sf_count_t>(sf_readf_float, sf.get(), (float *)buffer.ptr(), len);
+      framesRead = SFCall<sf_count_t>(sf_readf_float, sf.GetSndFile(), (float *)buffer.ptr(), len);
       float *bufferPtr = &((float *)buffer.ptr())[mAliasChannel];
       CopySamples((samplePtr)bufferPtr, floatSample,
                   (samplePtr)data, format,
@@ -160,6 +150,7 @@ BlockFilePtr PCMAliasBlockFile::Copy(wxFileNameWrapper &&newFileName)
    auto newBlockFile = make_blockfile<PCMAliasBlockFile>
       (std::move(newFileName), wxFileNameWrapper{mAliasedFileName},
        mAliasStart, mLen, mAliasChannel, mMin, mMax, mRMS);
+   CopyStatisticsTo(*newBlockFile);
 
    return newBlockFile;
 }
@@ -178,6 +169,15 @@ void PCMAliasBlockFile::SaveXML(XMLWriter &xmlFile)
    xmlFile.WriteAttr(wxT("max"), mMax);
    xmlFile.WriteAttr(wxT("rms"), mRMS);
 
+   // As SimpleBlockFile saves them, so that they need not be read again
+   double sum, sumSquares;
+   size_t clipCount;
+   if (GetKnownStatistics(&sum, &sumSquares, &clipCount)) {
+      xmlFile.WriteAttr(wxT("sum"), sum, 9);
+      xmlFile.WriteAttr(wxT("sumsquares"), sumSquares, 9);
+      xmlFile.WriteAttr(wxT("clips"), clipCount);
+   }
+
    xmlFile.EndTag(wxT("pcmaliasblockfile"));
 }
 
@@ -193,6 +193,10 @@ BlockFilePtr PCMAliasBlockFile::BuildFromXML(DirManager &dm, const wxChar **attr
    double dblValue;
    long nValue;
    long long nnValue;
+   // The exact statistics, which older projects lack
+   bool haveSum = false, haveSumSquares = false, haveClipCount = false;
+   double sum = 0.0, sumSquares = 0.0;
+   size_t clipCount = 0;
 
    while(*attrs)
    {
@@ -242,6 +246,18 @@ BlockFilePtr PCMAliasBlockFile::BuildFromXML(DirManager &dm, const wxChar **attr
             max = nValue;
          else if (!wxStricmp(attr, wxT("rms")) && (nValue >= 0))
             rms = nValue;
+         else if (!wxStricmp(attr, wxT("clips")) && (nValue >= 0)) {
+            clipCount = nValue;
+            haveClipCount = true;
+         }
+         else if (!wxStricmp(attr, wxT("sum"))) {
+            sum = nValue;
+            haveSum = true;
+         }
+         else if (!wxStricmp(attr, wxT("sumsquares")) && (nValue >= 0)) {
+            sumSquares = nValue;
+            haveSumSquares = true;
+         }
       }
       // mchinen: the min/max can be (are?) doubles as well, so handle those cases.
       // Vaughan: The code to which I added the XMLValueChecker checks
@@ -256,12 +272,24 @@ BlockFilePtr PCMAliasBlockFile::BuildFromXML(DirManager &dm, const wxChar **attr
             max = dblValue;
          else if (!wxStricmp(attr, wxT("rms")) && (dblValue >= 0.0))
             rms = dblValue;
+         else if (!wxStricmp(attr, wxT("sum"))) {
+            sum = dblValue;
+            haveSum = true;
+         }
+         else if (!wxStricmp(attr, wxT("sumsquares")) && (dblValue >= 0.0)) {
+            sumSquares = dblValue;
+            haveSumSquares = true;
+         }
       }
    }
 
-   return make_blockfile<PCMAliasBlockFile>
+   auto result = make_blockfile<PCMAliasBlockFile>
       (std::move(summaryFileName), std::move(aliasFileName),
        aliasStart, aliasLen, aliasChannel, min, max, rms);
+   if (haveSum && haveSumSquares && haveClipCount &&
+       clipCount <= (size_t)aliasLen)
+      result->SetStatistics(sum, sumSquares, clipCount);
+   return result;
 }
 
 void PCMAliasBlockFile::Recover(void)
@@ -0,0 +1,266 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  PCMAliasFileCache.cpp
+
+*******************************************************************//**
+
+\class PCMAliasFileCache
+\brief Keeps the most recently read aliased audio files open.
+
+Alias block files used to open the aliased file, parse its header,
+seek, read and close it again for every ReadData call.  Playback and
+redraw of a long on-demand import therefore spent much of their time
+in open and close.  This cache hands out exclusive leases on open
+SNDFILE handles, keyed by the full path of the aliased file.
+
+Readers of different files proceed in parallel.  Readers of the same
+file take turns, since they share one seek position.  The number of
+files kept open is limited by the preference
+"/Directories/MaxOpenAliasedFiles".
+
+Evicted handles that are still leased stay open until the lease is
+released.  Existence of a cached file is rechecked at most once per
+second, so that a file deleted behind our back is still reported as
+missing.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include "PCMAliasFileCache.h"
+
+#include <algorithm>
+#include <string.h>
+
+#include <wx/utils.h>
+
+#include "../Prefs.h"
+
+// How often to check that a cached file still exists, in milliseconds
+static const long kRecheckInterval = 1000;
+
+struct PCMAliasFileCache::Entry
+{
+   explicit Entry(const wxString &fullPath)
+   : path{ fullPath }, stale{ false }
+   {
+      memset(&info, 0, sizeof(info));
+   }
+
+   const wxString path;
+
+   // Declared before sf so that it is closed after it
+   wxFile file;
+   SFFile sf;
+   SF_INFO info;
+
+   // Held by the Lease; also guards stale and lastChecked
+   ODLock mutex;
+   bool stale;
+   wxLongLong lastChecked;
+};
+
+SNDFILE *PCMAliasFileCache::Lease::GetSndFile() const
+{
+   return mEntry->sf.get();
+}
+
+const SF_INFO &PCMAliasFileCache::Lease::GetInfo() const
+{
+   return mEntry->info;
+}
+
+PCMAliasFileCache &PCMAliasFileCache::Get()
+{
+   static PCMAliasFileCache theCache;
+   return theCache;
+}
+
+PCMAliasFileCache::PCMAliasFileCache()
+: mMaxOpenFiles{ DefaultMaxOpenFiles }
+, mHits{ 0 }
+, mMisses{ 0 }
+, mEvictions{ 0 }
+{
+   // gPrefs may not exist yet in the unit tests
+   if (gPrefs) {
+      long maxOpenFiles = gPrefs->Read(wxT("/Directories/MaxOpenAliasedFiles"),
+                                       (long)DefaultMaxOpenFiles);
+      mMaxOpenFiles = std::max(0L, maxOpenFiles);
+   }
+}
+
+PCMAliasFileCache::~PCMAliasFileCache()
+{
+}
+
+auto PCMAliasFileCache::Open(const wxString &fullPath) -> EntryPtr
+{
+   auto entry = std::make_shared<Entry>(fullPath);
+
+   // Don't use Open if file does not exist
+   if (!wxFile::Exists(fullPath) || !entry->file.Open(fullPath))
+      return {};
+
+   // Even though there is an sf_open() that takes a filename, use the one that
+   // takes a file descriptor since wxWidgets can open a file with a Unicode name and
+   // libsndfile can't (under Windows).
+   entry->sf.reset(SFCall<SNDFILE*>(sf_open_fd, entry->file.fd(), SFM_READ,
+                                    &entry->info, FALSE));
+   if (!entry->sf)
+      return {};
+
+   entry->lastChecked = wxGetLocalTimeMillis();
+   return entry;
+}
+
+void PCMAliasFileCache::Close(Entry &entry)
+{
+   entry.stale = true;
+   entry.sf.reset();
+   entry.file.Close();
+}
+
+auto PCMAliasFileCache::Acquire(const wxString &fullPath) -> Lease
+{
+   while (true) {
+      EntryPtr entry;
+      {
+         ODLocker locker{ &mCacheMutex };
+         auto iter = mIndex.find(fullPath);
+         if (iter != mIndex.end()) {
+            // Move to the front of the LRU list
+            mEntries.splice(mEntries.begin(), mEntries, iter->second);
+            entry = *iter->second;
+            ++mHits;
+         }
+         else
+            ++mMisses;
+      }
+
+      if (!entry)
+         break;
+
+      // Wait for any other reader of the same file
+      ODLocker entryLocker{ &entry->mutex };
+      if (entry->stale)
+         // Invalidated while we waited; look again
+         continue;
+
+      auto now = wxGetLocalTimeMillis();
+      if (now - entry->lastChecked > kRecheckInterval) {
+         if (!wxFile::Exists(fullPath)) {
+            entryLocker.reset();
+            Invalidate(fullPath);
+            return {};
+         }
+         entry->lastChecked = now;
+      }
+
+      return { std::move(entry), std::move(entryLocker) };
+   }
+
+   // Open outside of the cache lock, so that readers of other files
+   // are not held up by the header parsing
+   auto entry = Open(fullPath);
+   if (!entry)
+      return {};
+
+   ODLocker entryLocker{ &entry->mutex };
+
+   std::vector<EntryPtr> removed;
+   {
+      ODLocker locker{ &mCacheMutex };
+      // If another thread opened the same file meanwhile, keep its entry
+      // in the cache, and let ours close when the lease is released.
+      if (mMaxOpenFiles > 0 && mIndex.find(fullPath) == mIndex.end()) {
+         mEntries.push_front(entry);
+         mIndex[fullPath] = mEntries.begin();
+         Trim(removed);
+      }
+   }
+   // Evicted entries are destroyed here, outside the cache lock, or later
+   // by the last lease holder
+
+   return { std::move(entry), std::move(entryLocker) };
+}
+
+void PCMAliasFileCache::Remove(const wxString &fullPath,
+                               std::vector<EntryPtr> &removed)
+{
+   auto iter = mIndex.find(fullPath);
+   if (iter == mIndex.end())
+      return;
+   removed.push_back(std::move(*iter->second));
+   mEntries.erase(iter->second);
+   mIndex.erase(iter);
+}
+
+void PCMAliasFileCache::Trim(std::vector<EntryPtr> &removed)
+{
+   while (mEntries.size() > mMaxOpenFiles) {
+      const wxString path = mEntries.back()->path;
+      Remove(path, removed);
+      ++mEvictions;
+   }
+}
+
+void PCMAliasFileCache::Invalidate(const wxString &fullPath)
+{
+   std::vector<EntryPtr> removed;
+   {
+      ODLocker locker{ &mCacheMutex };
+      Remove(fullPath, removed);
+   }
+
+   for (auto &entry : removed) {
+      ODLocker entryLocker{ &entry->mutex };
+      Close(*entry);
+   }
+}
+
+void PCMAliasFileCache::Clear()
+{
+   std::vector<EntryPtr> removed;
+   {
+      ODLocker locker{ &mCacheMutex };
+      for (auto &entry : mEntries)
+         removed.push_back(std::move(entry));
+      mEntries.clear();
+      mIndex.clear();
+   }
+
+   for (auto &entry : removed) {
+      ODLocker entryLocker{ &entry->mutex };
+      Close(*entry);
+   }
+}
+
+void PCMAliasFileCache::SetMaxOpenFiles(size_t maxOpenFiles)
+{
+   std::vector<EntryPtr> removed;
+   {
+      ODLocker locker{ &mCacheMutex };
+      mMaxOpenFiles = maxOpenFiles;
+      Trim(removed);
+   }
+}
+
+size_t PCMAliasFileCache::GetMaxOpenFiles() const
+{
+   ODLocker locker{ &mCacheMutex };
+   return mMaxOpenFiles;
+}
+
+auto PCMAliasFileCache::GetStatistics() const -> Statistics
+{
+   ODLocker locker{ &mCacheMutex };
+   return { mHits, mMisses, mEvictions, mEntries.size() };
+}
+
+void PCMAliasFileCache::ResetStatistics()
+{
+   ODLocker locker{ &mCacheMutex };
+   mHits = mMisses = mEvictions = 0;
+}
@@ -0,0 +1,125 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  PCMAliasFileCache.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_PCMALIASFILECACHE__
+#define __AUDACITY_PCMALIASFILECACHE__
+
+#include "../MemoryX.h"
+#include <list>
+#include <map>
+#include <vector>
+
+#include <wx/file.h>
+#include <wx/longlong.h>
+#include <wx/string.h>
+
+#include <sndfile.h>
+
+#include "../FileFormats.h"
+#include "../ondemand/ODTaskThread.h"
+
+/// A process-wide, least-recently-used cache of open libsndfile handles
+/// for the files referenced by PCMAliasBlockFile and ODPCMAliasBlockFile,
+/// so that repeated reads of the same aliased file do not reopen it.
+class PCMAliasFileCache final
+{
+   struct Entry;
+   using EntryPtr = std::shared_ptr<Entry>;
+
+ public:
+   enum { DefaultMaxOpenFiles = 16 };
+
+   struct Statistics {
+      unsigned long long hits;
+      unsigned long long misses;
+      unsigned long long evictions;
+      size_t openFiles;
+   };
+
+   /// Exclusive use of one open aliased file.  While a Lease is held, no
+   /// other thread seeks or reads through the same handle.
+   class Lease
+   {
+    public:
+      Lease() {}
+      Lease(Lease &&that)
+      : mEntry{ std::move(that.mEntry) }, mLocker{ std::move(that.mLocker) } {}
+      Lease &operator= (Lease &&that)
+      {
+         if (this != &that) {
+            mLocker = std::move(that.mLocker);
+            mEntry = std::move(that.mEntry);
+         }
+         return *this;
+      }
+
+      Lease(const Lease&) PROHIBITED;
+      Lease &operator= (const Lease&) PROHIBITED;
+
+      explicit operator bool () const { return mEntry.get() != nullptr; }
+      SNDFILE *GetSndFile() const;
+      const SF_INFO &GetInfo() const;
+
+    private:
+      friend class PCMAliasFileCache;
+      Lease(EntryPtr &&entry, ODLocker &&locker)
+      : mEntry{ std::move(entry) }, mLocker{ std::move(locker) } {}
+
+      // Declared in this order so that the lock is released first
+      EntryPtr mEntry;
+      ODLocker mLocker;
+   };
+
+   static PCMAliasFileCache &Get();
+
+   /// Returns a lease on an open handle for the file, opening it if needed.
+   /// The lease is empty if the file does not exist or libsndfile can't
+   /// open it; such failures are not cached.
+   Lease Acquire(const wxString &fullPath);
+
+   /// Close any cached handle for this file, waiting for a current reader
+   /// to finish.  Call before renaming or deleting an aliased file.
+   void Invalidate(const wxString &fullPath);
+   /// Close all cached handles.
+   void Clear();
+
+   /// Zero disables caching; each Acquire then opens a fresh handle.
+   void SetMaxOpenFiles(size_t maxOpenFiles);
+   size_t GetMaxOpenFiles() const;
+
+   Statistics GetStatistics() const;
+   void ResetStatistics();
+
+ private:
+   PCMAliasFileCache();
+   ~PCMAliasFileCache();
+
+   PCMAliasFileCache(const PCMAliasFileCache&) PROHIBITED;
+   PCMAliasFileCache &operator= (const PCMAliasFileCache&) PROHIBITED;
+
+   static EntryPtr Open(const wxString &fullPath);
+   static void Close(Entry &entry);
+
+   // Must be called with mCacheMutex held
+   void Remove(const wxString &fullPath, std::vector<EntryPtr> &removed);
+   void Trim(std::vector<EntryPtr> &removed);
+
+   mutable ODLock mCacheMutex;
+
+   // Front is most recently used
+   using EntryList = std::list<EntryPtr>;
+   EntryList mEntries;
+   std::map<wxString, EntryList::iterator> mIndex;
+
+   size_t mMaxOpenFiles;
+   unsigned long long mHits;
+   unsigned long long mMisses;
+   unsigned long long mEvictions;
+};
+
+#endif
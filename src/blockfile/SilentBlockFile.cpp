@@ -18,6 +18,7 @@ BlockFile{ wxFileNameWrapper{}, sampleLen }
    mMin = 0.;
    mMax = 0.;
    mRMS = 0.;
+   SetStatistics(0.0, 0.0, 0);
 }
 
 SilentBlockFile::~SilentBlockFile()
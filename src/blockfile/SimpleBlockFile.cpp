@@ -48,6 +48,17 @@ default is to disable caching.
   manual auto recovery, because the files are never written physically to
   disk).
 
+* Write-behind: If DirManager has a WriteBehindQueue, and no write cache
+  takes the block, NEW block files are held in memory only until one of
+  the queue's threads has written them, by WriteBehind(), and are read
+  from disk after that.
+
+Without a cache, files in native byte order are read through mappings
+kept by MappedFileCache, instead of through libsndfile; blocks of floats
+can then be used in place with GetFloatData().  Files from a machine of
+the other byte order, or when mapping is disabled or fails, are read
+with libsndfile as before.
+
 *//****************************************************************//**
 
 \class auHeader
@@ -66,6 +77,7 @@ to get its definition, rather than rolling our own.
 #include "../Prefs.h"
 
 #include "SimpleBlockFile.h"
+#include "MappedFileCache.h"
 #include "../FileFormats.h"
 
 #include "sndfile.h"
@@ -95,11 +107,14 @@ static wxUint32 SwapUintEndianess(wxUint32 in)
 /// @param sampleLen    The number of samples to be written to this block.
 /// @param format       The format of the given samples.
 /// @param allowDeferredWrite    Allow deferred write-caching
+/// @param writeBehind  Keep the data in memory, to be written by
+///                     WriteBehind() on another thread
 SimpleBlockFile::SimpleBlockFile(wxFileNameWrapper &&baseFileName,
                                  samplePtr sampleData, size_t sampleLen,
                                  sampleFormat format,
                                  bool allowDeferredWrite /* = false */,
-                                 bool bypassCache /* = false */):
+                                 bool bypassCache /* = false */,
+                                 bool writeBehind /* = false */):
    BlockFile {
       (baseFileName.SetExt(wxT("au")), std::move(baseFileName)),
       sampleLen
@@ -108,20 +123,24 @@ SimpleBlockFile::SimpleBlockFile(wxFileNameWrapper &&baseFileName,
    mFormat = format;
 
    mCache.active = false;
+   mWritePending = false;
 
    bool useCache = GetCache() && (!bypassCache);
+   // The write cache, when enabled, already defers the writing
+   writeBehind = writeBehind && !useCache && !bypassCache;
 
-   if (!(allowDeferredWrite && useCache) && !bypassCache)
+   if (!(allowDeferredWrite && useCache) && !bypassCache && !writeBehind)
    {
       bool bSuccess = WriteSimpleBlockFile(sampleData, sampleLen, format, NULL);
       wxASSERT(bSuccess); // TODO: Handle failure here by alert to user and undo partial op.
       wxUnusedVar(bSuccess);
    }
 
-   if (useCache) {
+   if (useCache || writeBehind) {
       //wxLogDebug("SimpleBlockFile::SimpleBlockFile(): Caching block file data.");
       mCache.active = true;
       mCache.needWrite = true;
+      mWritePending = writeBehind;
       mCache.format = format;
       const auto sampleDataSize = sampleLen * SAMPLE_SIZE(format);
       mCache.sampleData = new char[sampleDataSize];
@@ -151,10 +170,15 @@ SimpleBlockFile::SimpleBlockFile(wxFileNameWrapper &&existingFile, size_t len,
    mRMS = rms;
 
    mCache.active = false;
+   mWritePending = false;
 }
 
 SimpleBlockFile::~SimpleBlockFile()
 {
+   // BlockFile's destructor may delete the file, which a mapping would
+   // prevent on Windows
+   MappedFileCache::Get().Invalidate(mFileName.GetFullPath());
+
    if (mCache.active)
    {
       delete[] mCache.sampleData;
@@ -168,6 +192,8 @@ bool SimpleBlockFile::WriteSimpleBlockFile(
     sampleFormat format,
     void* summaryData)
 {
+   MappedFileCache::Get().Invalidate(mFileName.GetFullPath());
+
    wxFFile file(mFileName.GetFullPath(), wxT("wb"));
    if( !file.IsOpened() ){
       // Can't do anything else.
@@ -343,6 +369,7 @@ void SimpleBlockFile::FillCache()
 /// mSummaryinfo.totalSummaryBytes long.
 bool SimpleBlockFile::ReadSummary(void *data)
 {
+   ODLocker locker{ &mCacheMutex };
    if (mCache.active)
    {
       //wxLogDebug("SimpleBlockFile::ReadSummary(): Summary is already in cache.");
@@ -350,6 +377,20 @@ bool SimpleBlockFile::ReadSummary(void *data)
       return true;
    } else
    {
+      // Data freed by WriteBehind are on disk
+      locker.reset();
+
+      sampleFormat fileFormat;
+      size_t dataOffset;
+      if (auto file = MapFile(fileFormat, dataOffset)) {
+         // MapFile checked that the summary fits before the data
+         memcpy(data, file->GetData() + sizeof(auHeader),
+                (size_t)mSummaryInfo.totalSummaryBytes);
+         FixSummary(data);
+         mSilentLog=FALSE;
+         return true;
+      }
+
       //wxLogDebug("SimpleBlockFile::ReadSummary(): Reading summary from disk.");
 
       wxFFile file(mFileName.GetFullPath(), wxT("rb"));
@@ -391,6 +432,7 @@ bool SimpleBlockFile::ReadSummary(void *data)
 size_t SimpleBlockFile::ReadData(samplePtr data, sampleFormat format,
                         size_t start, size_t len) const
 {
+   ODLocker locker{ &mCacheMutex };
    if (mCache.active)
    {
       //wxLogDebug("SimpleBlockFile::ReadData(): Data are already in cache.");
@@ -404,6 +446,15 @@ size_t SimpleBlockFile::ReadData(samplePtr data, sampleFormat format,
    }
    else {
       //wxLogDebug("SimpleBlockFile::ReadData(): Reading data from disk.");
+      locker.reset();
+
+      sampleFormat fileFormat;
+      size_t dataOffset;
+      if (auto file = MapFile(fileFormat, dataOffset)) {
+         mSilentLog=FALSE;
+         return ReadMappedData(*file, fileFormat, dataOffset,
+                               data, format, start, len);
+      }
 
       SF_INFO info;
       wxFile f;   // will be closed when it goes out of scope
@@ -474,6 +525,110 @@ size_t SimpleBlockFile::ReadData(samplePtr data, sampleFormat format,
    }
 }
 
+const float *SimpleBlockFile::GetFloatData(MappedFilePtr &holder) const
+{
+   {
+      ODLocker locker{ &mCacheMutex };
+      if (mCache.active)
+         return nullptr;
+   }
+
+   sampleFormat fileFormat;
+   size_t dataOffset;
+   auto file = MapFile(fileFormat, dataOffset);
+   if (!file || fileFormat != floatSample || dataOffset % sizeof(float))
+      return nullptr;
+
+   holder = std::move(file);
+   return (const float *)(holder->GetData() + dataOffset);
+}
+
+/// Map the disk file, and check that its header is one we can read
+/// without libsndfile and that it holds all the summary and samples.
+///
+/// @param format     Receives the format of the samples on disk
+/// @param dataOffset Receives the offset of the first sample in the file
+MappedFilePtr SimpleBlockFile::MapFile(sampleFormat &format,
+                                       size_t &dataOffset) const
+{
+   const auto fullPath = mFileName.GetFullPath();
+   auto file = MappedFileCache::Get().Acquire(fullPath);
+   if (!file)
+      return {};
+
+   const auto size = file->GetSize();
+   auHeader header;
+   if (size < sizeof(header))
+      return {};
+   memcpy(&header, file->GetData(), sizeof(header));
+
+   // Files written on a machine of the other byte order are left to
+   // libsndfile
+   if (header.magic != 0x2e736e64)
+      return {};
+
+   switch (header.encoding) {
+   case AU_SAMPLE_FORMAT_16:
+      format = int16Sample;
+      break;
+   case AU_SAMPLE_FORMAT_24:
+      format = int24Sample;
+      break;
+   case AU_SAMPLE_FORMAT_FLOAT:
+      format = floatSample;
+      break;
+   default:
+      return {};
+   }
+
+   dataOffset = header.dataOffset;
+   if (dataOffset < sizeof(header) + mSummaryInfo.totalSummaryBytes ||
+       dataOffset > size ||
+       (size - dataOffset) / SAMPLE_SIZE_DISK(format) < mLen) {
+      // Perhaps mapped while it was being written; map it afresh next time
+      MappedFileCache::Get().Invalidate(fullPath);
+      return {};
+   }
+
+   return file;
+}
+
+/// Convert samples from a mapping of the disk file, as ReadData does.
+size_t SimpleBlockFile::ReadMappedData(const MappedFile &file,
+                                       sampleFormat fileFormat,
+                                       size_t dataOffset,
+                                       samplePtr data, sampleFormat format,
+                                       size_t start, size_t len) const
+{
+   len = std::min(len, std::max(start, mLen) - start);
+   const auto src = (const unsigned char *)file.GetData() + dataOffset +
+      start * SAMPLE_SIZE_DISK(fileFormat);
+
+   if (fileFormat != int24Sample) {
+      CopySamples((samplePtr)src, fileFormat, data, format, len);
+      return len;
+   }
+
+   // 24 bit samples on disk are packed in three bytes, as
+   // WriteSimpleBlockFile wrote them
+   SampleBuffer buffer;
+   int *ints = (int *)data;
+   if (format != int24Sample)
+      ints = (int *)buffer.Allocate(len, int24Sample).ptr();
+   for (size_t i = 0; i < len; i++) {
+      const unsigned char *p = src + 3 * i;
+      #if wxBYTE_ORDER == wxBIG_ENDIAN
+         ints[i] = ((signed char)p[0] << 16) | (p[1] << 8) | p[2];
+      #else
+         ints[i] = ((signed char)p[2] << 16) | (p[1] << 8) | p[0];
+      #endif
+   }
+   if (format != int24Sample)
+      CopySamples((samplePtr)ints, int24Sample, data, format, len);
+
+   return len;
+}
+
 void SimpleBlockFile::SaveXML(XMLWriter &xmlFile)
 {
    xmlFile.StartTag(wxT("simpleblockfile"));
@@ -484,6 +639,14 @@ void SimpleBlockFile::SaveXML(XMLWriter &xmlFile)
    xmlFile.WriteAttr(wxT("max"), mMax);
    xmlFile.WriteAttr(wxT("rms"), mRMS);
 
+   double sum, sumSquares;
+   size_t clipCount;
+   if (GetKnownStatistics(&sum, &sumSquares, &clipCount)) {
+      xmlFile.WriteAttr(wxT("sum"), sum, 9);
+      xmlFile.WriteAttr(wxT("sumsquares"), sumSquares, 9);
+      xmlFile.WriteAttr(wxT("clips"), clipCount);
+   }
+
    xmlFile.EndTag(wxT("simpleblockfile"));
 }
 
@@ -498,6 +661,10 @@ BlockFilePtr SimpleBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
    size_t len = 0;
    double dblValue;
    long nValue;
+   // The exact statistics, which older projects lack
+   bool haveSum = false, haveSumSquares = false, haveClipCount = false;
+   double sum = 0.0, sumSquares = 0.0;
+   size_t clipCount = 0;
 
    while(*attrs)
    {
@@ -520,6 +687,13 @@ BlockFilePtr SimpleBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
                XMLValueChecker::IsGoodInt(strValue) && strValue.ToLong(&nValue) &&
                nValue > 0)
          len = nValue;
+      else if (!wxStrcmp(attr, wxT("clips")) &&
+               XMLValueChecker::IsGoodInt(strValue) && strValue.ToLong(&nValue) &&
+               nValue >= 0)
+      {
+         clipCount = nValue;
+         haveClipCount = true;
+      }
       else if (XMLValueChecker::IsGoodString(strValue) && Internat::CompatibleToDouble(strValue, &dblValue))
       {  // double parameters
          if (!wxStricmp(attr, wxT("min")))
@@ -528,11 +702,23 @@ BlockFilePtr SimpleBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
             max = dblValue;
          else if (!wxStricmp(attr, wxT("rms")) && (dblValue >= 0.0))
             rms = dblValue;
+         else if (!wxStricmp(attr, wxT("sum"))) {
+            sum = dblValue;
+            haveSum = true;
+         }
+         else if (!wxStricmp(attr, wxT("sumsquares")) && (dblValue >= 0.0)) {
+            sumSquares = dblValue;
+            haveSumSquares = true;
+         }
       }
    }
 
-   return make_blockfile<SimpleBlockFile>
+   auto result = make_blockfile<SimpleBlockFile>
       (std::move(fileName), len, min, max, rms);
+   if (haveSum && haveSumSquares && haveClipCount && clipCount <= len)
+      result->SetStatistics(sum, sumSquares, clipCount);
+
+   return result;
 }
 
 /// Create a copy of this BlockFile, but using a different disk file.
@@ -542,16 +728,20 @@ BlockFilePtr SimpleBlockFile::Copy(wxFileNameWrapper &&newFileName)
 {
    auto newBlockFile = make_blockfile<SimpleBlockFile>
       (std::move(newFileName), mLen, mMin, mMax, mRMS);
+   CopyStatisticsTo(*newBlockFile);
 
    return newBlockFile;
 }
 
 auto SimpleBlockFile::GetSpaceUsage() const -> DiskByteCount
 {
-   if (mCache.active && mCache.needWrite)
    {
-      // We don't know space usage yet
-      return 0;
+      ODLocker locker{ &mCacheMutex };
+      if (mCache.active && mCache.needWrite && !mWritePending)
+      {
+         // We don't know space usage yet
+         return 0;
+      }
    }
 
    // Don't know the format, so it must be read from the file
@@ -605,6 +795,8 @@ auto SimpleBlockFile::GetSpaceUsage() const -> DiskByteCount
 }
 
 void SimpleBlockFile::Recover(){
+   MappedFileCache::Get().Invalidate(mFileName.GetFullPath());
+
    wxFFile file(mFileName.GetFullPath(), wxT("wb"));
    //int i;
 
@@ -645,7 +837,36 @@ void SimpleBlockFile::WriteCacheToDisk()
 
 bool SimpleBlockFile::GetNeedWriteCacheToDisk()
 {
-   return mCache.active && mCache.needWrite;
+   // Blocks still queued for WriteBehind are not for this thread to write
+   ODLocker locker{ &mCacheMutex };
+   return mCache.active && mCache.needWrite && !mWritePending;
+}
+
+bool SimpleBlockFile::WriteBehind()
+{
+   {
+      // Not made with writeBehind, or the write cache took it instead
+      ODLocker locker{ &mCacheMutex };
+      if (!mWritePending)
+         return false;
+   }
+
+   // The data don't change while the write is pending, so they are
+   // written without the lock, and reads meanwhile are not held up
+   const bool success = WriteSimpleBlockFile(
+      mCache.sampleData, mLen, mCache.format, mCache.summaryData);
+
+   ODLocker locker{ &mCacheMutex };
+   mWritePending = false;
+   if (success) {
+      mCache.active = false;
+      mCache.needWrite = false;
+      delete[] mCache.sampleData;
+      delete[] (char *)mCache.summaryData;
+      mCache.sampleData = nullptr;
+      mCache.summaryData = nullptr;
+   }
+   return success;
 }
 
 bool SimpleBlockFile::GetCache()
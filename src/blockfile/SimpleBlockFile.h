@@ -47,12 +47,14 @@ class PROFILE_DLL_API SimpleBlockFile /* not final */ : public BlockFile {
 
    // Constructor / Destructor
 
-   /// Create a disk file and write summary and sample data to it
+   /// Create a disk file and write summary and sample data to it, or
+   /// with writeBehind, keep them in memory until WriteBehind()
    SimpleBlockFile(wxFileNameWrapper &&baseFileName,
                    samplePtr sampleData, size_t sampleLen,
                    sampleFormat format,
                    bool allowDeferredWrite = false,
-                   bool bypassCache = false );
+                   bool bypassCache = false,
+                   bool writeBehind = false );
    /// Create the memory structure to refer to the given block file
    SimpleBlockFile(wxFileNameWrapper &&existingFile, size_t len,
                    float min, float max, float rms);
@@ -66,6 +68,8 @@ class PROFILE_DLL_API SimpleBlockFile /* not final */ : public BlockFile {
    /// Read the data section of the disk file
    size_t ReadData(samplePtr data, sampleFormat format,
                         size_t start, size_t len) const override;
+   /// Map the disk file, if it holds native-endian floats
+   const float *GetFloatData(MappedFilePtr &holder) const override;
 
    /// Create a NEW block file identical to this one
    BlockFilePtr Copy(wxFileNameWrapper &&newFileName) override;
@@ -83,6 +87,11 @@ class PROFILE_DLL_API SimpleBlockFile /* not final */ : public BlockFile {
    bool GetNeedFillCache() override { return !mCache.active; }
    void FillCache() override;
 
+   /// Write the data of a block made with writeBehind, then free them.
+   /// Called once, by WriteBehindQueue on one of its threads.  On failure
+   /// the data stay in memory, for WriteCacheToDisk to try again.
+   bool WriteBehind();
+
  protected:
 
    bool WriteSimpleBlockFile(samplePtr sampleData, size_t sampleLen,
@@ -90,7 +99,16 @@ class PROFILE_DLL_API SimpleBlockFile /* not final */ : public BlockFile {
    static bool GetCache();
    void ReadIntoCache();
 
+   MappedFilePtr MapFile(sampleFormat &format, size_t &dataOffset) const;
+   size_t ReadMappedData(const MappedFile &file, sampleFormat fileFormat,
+                         size_t dataOffset, samplePtr data,
+                         sampleFormat format, size_t start, size_t len) const;
+
    SimpleBlockFileCache mCache;
+   // Guards mCache against WriteBehind freeing it during a read
+   mutable ODLock mCacheMutex;
+   // Made with writeBehind, and WriteBehind() not yet done
+   bool mWritePending;
 
  private:
    mutable sampleFormat mFormat; // may be found lazily
@@ -0,0 +1,211 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WriteBehindQueue.cpp
+
+*******************************************************************//**
+
+\class WriteBehindQueue
+\brief Writes NEW SimpleBlockFiles to disk on background threads.
+
+DirManager owns one for each project.  SimpleBlockFiles made with
+writeBehind compute their summary at once, but keep their samples and
+summary in memory instead of writing them; DirManager then queues them
+here.  Reads of a block are served from memory until a writer thread
+has written its file, and from the file afterwards.
+
+The memory held is bounded: Enqueue waits while the blocks not yet
+written exceed the limit, so that a disk slower than the data arrive
+slows the producer down instead of using up memory.  Short stalls of
+the disk, which would make the audio thread miss its deadline while
+recording, are absorbed.
+
+Nothing here is forced to the disk until Flush, which DirManager calls
+when the project is saved.  A block that fails to be written, as when the
+disk is full, keeps its data in memory; Flush tries it again, and fails
+if it still can't be written, so that the project is not saved referring
+to a file that is not there.  Operations that need the files on disk, such
+as copying or moving them, Wait first.
+
+The queue holds weak pointers, so that a block that is deleted before
+its turn, as when an effect's intermediate results are discarded, is
+never written at all.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include "WriteBehindQueue.h"
+
+#include <wx/file.h>
+
+#ifdef __WXMSW__
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "SimpleBlockFile.h"
+#include "../WorkerPool.h"
+
+namespace {
+
+// Commit a written file to the disk
+bool SyncFile(const wxString &path)
+{
+   wxFile file;
+   if (!file.Open(path, wxFile::read_write))
+      return false;
+
+#if defined(__WXMSW__)
+   return _commit(file.fd()) == 0;
+#elif defined(__WXMAC__)
+   // fsync only reaches the drive's cache on Mac OS X
+   return fcntl(file.fd(), F_FULLFSYNC) != -1 || fsync(file.fd()) == 0;
+#else
+   return fsync(file.fd()) == 0;
+#endif
+}
+
+}
+
+WriteBehindQueue::WriteBehindQueue(size_t nThreads, size_t memoryLimit)
+: mWorkCondition(&mLock)
+, mDoneCondition(&mLock)
+, mPendingBytes(0)
+, mBusy(0)
+, mQuit(false)
+, mMemoryLimit(memoryLimit)
+{
+   for (size_t i = 0; i < nThreads; i++) {
+      auto writer = std::make_unique<WorkerThread>([this]{ WriterLoop(); });
+      if (!writer->Start())
+         break;
+      mWriters.push_back(std::move(writer));
+   }
+}
+
+WriteBehindQueue::~WriteBehindQueue()
+{
+   {
+      ODLocker locker{ &mLock };
+      mQuit = true;
+      mWorkCondition.Broadcast();
+   }
+
+   // The writers empty the queue before they return
+   for (auto &writer : mWriters)
+      writer->Join();
+}
+
+void WriteBehindQueue::Enqueue(
+   const std::shared_ptr<SimpleBlockFile> &block, size_t bytes)
+{
+   if (mWriters.empty()) {
+      const bool written = block->WriteBehind();
+      ODLocker locker{ &mLock };
+      if (written)
+         mUnsynced.push_back(block);
+      else
+         mFailed.push_back(block);
+      return;
+   }
+
+   ODLocker locker{ &mLock };
+
+   // A block bigger than the limit is let in when nothing else is pending
+   while (mPendingBytes > 0 && mPendingBytes + bytes > mMemoryLimit)
+      mDoneCondition.Wait();
+
+   mQueue.push_back(Entry{ block, bytes });
+   mPendingBytes += bytes;
+   mWorkCondition.Signal();
+}
+
+void WriteBehindQueue::Wait()
+{
+   ODLocker locker{ &mLock };
+   while (!mQueue.empty() || mBusy > 0)
+      mDoneCondition.Wait();
+}
+
+bool WriteBehindQueue::Flush()
+{
+   std::vector<std::weak_ptr<SimpleBlockFile>> unsynced, failed;
+   {
+      ODLocker locker{ &mLock };
+      while (!mQueue.empty() || mBusy > 0)
+         mDoneCondition.Wait();
+      unsynced.swap(mUnsynced);
+      failed.swap(mFailed);
+   }
+
+   bool success = true;
+
+   // Blocks that failed kept their data, and write it as a write cache
+   // would.  Those that fail again are kept for the next Flush.
+   std::vector<std::weak_ptr<SimpleBlockFile>> stillFailed;
+   for (const auto &weak : failed) {
+      if (auto block = weak.lock()) {
+         block->WriteCacheToDisk();
+         if (block->GetNeedWriteCacheToDisk()) {
+            success = false;
+            stillFailed.push_back(block);
+         }
+         else
+            unsynced.push_back(block);
+      }
+   }
+
+   // The files may have been moved since they were written, as into the
+   // project's directory when it is first saved, so ask the blocks
+   for (const auto &weak : unsynced) {
+      if (auto block = weak.lock())
+         if (!SyncFile(block->GetFileName().name.GetFullPath()))
+            success = false;
+   }
+
+   if (!stillFailed.empty()) {
+      ODLocker locker{ &mLock };
+      mFailed.insert(mFailed.end(), stillFailed.begin(), stillFailed.end());
+   }
+
+   return success;
+}
+
+void WriteBehindQueue::WriterLoop()
+{
+   ODLocker locker{ &mLock };
+   while (true) {
+      while (!mQuit && mQueue.empty())
+         mWorkCondition.Wait();
+      if (mQueue.empty())
+         break;
+
+      auto entry = std::move(mQueue.front());
+      mQueue.pop_front();
+      ++mBusy;
+
+      locker.reset();
+      auto block = entry.block.lock();
+      const bool written = block && block->WriteBehind();
+      // WriteBehind also declines blocks that the write cache took over
+      const bool failed =
+         block && !written && block->GetNeedWriteCacheToDisk();
+      locker.reset(&mLock);
+
+      if (written)
+         mUnsynced.push_back(block);
+      else if (failed)
+         mFailed.push_back(block);
+      mPendingBytes -= entry.bytes;
+      --mBusy;
+      mDoneCondition.Broadcast();
+
+      // If this was the last owner, let the block go without the lock
+      locker.reset();
+      block.reset();
+      locker.reset(&mLock);
+   }
+}
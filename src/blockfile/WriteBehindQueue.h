@@ -0,0 +1,81 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WriteBehindQueue.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_WRITE_BEHIND_QUEUE__
+#define __AUDACITY_WRITE_BEHIND_QUEUE__
+
+#include "../MemoryX.h"
+#include <deque>
+#include <vector>
+
+#include "../ondemand/ODTaskThread.h"
+
+class SimpleBlockFile;
+class WorkerThread;
+
+/// Writes NEW SimpleBlockFiles to disk on background threads, so that
+/// recording, importing and effects don't wait for the disk.  Until its
+/// turn comes a block keeps its samples and summary in memory and is read
+/// from there.  The memory held by blocks not yet written is bounded:
+/// Enqueue waits while it is over the limit.
+class WriteBehindQueue final
+{
+ public:
+   /// nThreads writers; memoryLimit bytes of samples may wait to be
+   /// written.  With no writers, Enqueue writes the block at once.
+   WriteBehindQueue(size_t nThreads, size_t memoryLimit);
+   /// Writes whatever is still queued before stopping the writers
+   ~WriteBehindQueue();
+
+   WriteBehindQueue(const WriteBehindQueue&) PROHIBITED;
+   WriteBehindQueue &operator= (const WriteBehindQueue&) PROHIBITED;
+
+   /// Queues a block made with writeBehind, to be written by one of the
+   /// threads.  bytes is the size of its samples in memory.  Waits first
+   /// while the backlog is over the limit.
+   void Enqueue(const std::shared_ptr<SimpleBlockFile> &block, size_t bytes);
+
+   /// Waits until every block queued so far is on disk, or has failed to
+   /// be written and keeps its data in memory
+   void Wait();
+   /// Waits, tries again to write the blocks that failed, then makes the
+   /// operating system commit to the disk all the files written since the
+   /// last Flush.  For save points.  Returns false if some block is still
+   /// not written or some file could not be committed; the blocks that
+   /// failed are tried again at the next Flush.
+   bool Flush();
+
+ private:
+   struct Entry {
+      std::weak_ptr<SimpleBlockFile> block;
+      size_t bytes;
+   };
+
+   void WriterLoop();
+
+   ODLock mLock;
+   ODCondition mWorkCondition;
+   ODCondition mDoneCondition;
+
+   std::deque<Entry> mQueue;
+   // Bytes of the blocks queued or being written
+   size_t mPendingBytes;
+   // Blocks being written
+   size_t mBusy;
+   // Blocks written since the last Flush
+   std::vector<std::weak_ptr<SimpleBlockFile>> mUnsynced;
+   // Blocks that WriteBehind failed to write
+   std::vector<std::weak_ptr<SimpleBlockFile>> mFailed;
+   bool mQuit;
+
+   const size_t mMemoryLimit;
+
+   std::vector<std::unique_ptr<WorkerThread>> mWriters;
+};
+
+#endif
@@ -15,12 +15,17 @@
 \brief Returns information about the amount of audio that is about a certain
 threshold of difference in two selected tracks
 
+With a SpectrumWindowSize, also compares the spectra of the tracks,
+averaged over the whole selection, and reports the largest difference.
+
 *//*******************************************************************/
 
 #include "CompareAudioCommand.h"
 #include "../Project.h"
 #include "Command.h"
 #include "../WaveTrack.h"
+#include "../FFT.h"
+#include "../SpectrumAnalyst.h"
 
 wxString CompareAudioCommandType::BuildName()
 {
@@ -31,6 +36,9 @@ void CompareAudioCommandType::BuildSignature(CommandSignature &signature)
 {
    auto thresholdValidator = make_movable<DoubleValidator>();
    signature.AddParameter(wxT("Threshold"), 0.0, std::move(thresholdValidator));
+   // Zero for no spectral comparison
+   auto windowSizeValidator = make_movable<IntValidator>();
+   signature.AddParameter(wxT("SpectrumWindowSize"), 0, std::move(windowSizeValidator));
 }
 
 CommandHolder CompareAudioCommandType::Create(std::unique_ptr<CommandOutputTarget> &&target)
@@ -77,6 +85,64 @@ double CompareAudioCommand::CompareSample(double value1, double value2)
    return fabs(value1 - value2);
 }
 
+bool CompareAudioCommand::CompareSpectra(size_t windowSize)
+{
+   if (windowSize < 32 || windowSize > 65536 ||
+       (windowSize & (windowSize - 1)) != 0)
+   {
+      Error(wxT("The spectrum window size must be a power of two from 32 to 65536."));
+      return false;
+   }
+   if (mTrack0->GetRate() != mTrack1->GetRate())
+   {
+      Error(wxT("To compare spectra, the tracks must have the same sample rate."));
+      return false;
+   }
+
+   Status(wxT("Comparing spectra."));
+
+   // The tracks are analyzed in turn, each taking half of the progress
+   SpectrumAnalyst analysts[2];
+   const WaveTrack *tracks[2] = { mTrack0, mTrack1 };
+   for (int ii = 0; ii < 2; ii++)
+   {
+      auto progress = [&](double fraction) {
+         Progress((ii + fraction) / 2);
+         return true;
+      };
+      if (!analysts[ii].Calculate(SpectrumAnalyst::Spectrum,
+            eWinFuncHanning, windowSize,
+            std::vector<const WaveTrack*>{ tracks[ii] }, mT0, mT1,
+            NULL, NULL, progress))
+      {
+         Error(wxT("The selection is too short for the spectrum window size."));
+         return false;
+      }
+   }
+
+   // Find the greatest difference, in dB, skipping the DC bin
+   const float *spectrum0 = analysts[0].GetProcessed();
+   const float *spectrum1 = analysts[1].GetProcessed();
+   const int size = analysts[0].GetProcessedSize();
+   double maxDifference = 0.0;
+   int maxBin = 0;
+   for (int bin = 1; bin < size; bin++)
+   {
+      double difference = fabs(spectrum0[bin] - spectrum1[bin]);
+      if (difference > maxDifference)
+      {
+         maxDifference = difference;
+         maxBin = bin;
+      }
+   }
+   double frequency = maxBin * mTrack0->GetRate() / windowSize;
+
+   Status(wxString::Format(wxT("%.4f"), maxDifference));
+   Status(wxString::Format(wxT("%.4f"), frequency));
+   Status(wxString::Format(wxT("Finished spectral comparison: the spectra differ by at most %.3f dB, at %.1f Hz."), maxDifference, frequency));
+   return true;
+}
+
 inline int min(int a, int b)
 {
    return (a < b) ? a : b;
@@ -139,5 +205,9 @@ bool CompareAudioCommand::Apply(CommandExecutionContext context)
    Status(wxString::Format(wxT("%li"), errorCount));
    Status(wxString::Format(wxT("%.4f"), errorSeconds));
    Status(wxString::Format(wxT("Finished comparison: %li samples (%.3f seconds) exceeded the error threshold of %f."), errorCount, errorSeconds, errorThreshold));
+
+   long windowSize = GetLong(wxT("SpectrumWindowSize"));
+   if (windowSize != 0)
+      return CompareSpectra(windowSize);
    return true;
 }
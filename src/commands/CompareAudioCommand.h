@@ -40,6 +40,9 @@ private:
    // Update member variables with project selection data (and validate)
    bool GetSelection(AudacityProject &proj);
 
+   // Compare the averaged power spectra of the two tracks
+   bool CompareSpectra(size_t windowSize);
+
 protected:
    double CompareSample(double value1, double value2) /* not override */;
 
@@ -109,6 +109,11 @@ unsigned EffectAmplify::GetAudioOutCount()
    return 1;
 }
 
+bool EffectAmplify::SupportsIndependentBlocks()
+{
+   return true;
+}
+
 size_t EffectAmplify::ProcessBlock(float **inBlock, float **outBlock, size_t blockLen)
 {
    for (decltype(blockLen) i = 0; i < blockLen; i++)
@@ -46,6 +46,7 @@ public:
 
    unsigned GetAudioInCount() override;
    unsigned GetAudioOutCount() override;
+   bool SupportsIndependentBlocks() override;
    size_t ProcessBlock(float **inBlock, float **outBlock, size_t blockLen) override;
    bool GetAutomationParameters(EffectAutomationParameters & parms) override;
    bool SetAutomationParameters(EffectAutomationParameters & parms) override;
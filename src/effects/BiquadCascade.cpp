@@ -0,0 +1,414 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BiquadCascade.cpp
+
+*******************************************************************//**
+
+\class BiquadCascade
+\brief Applies a cascade of biquads to several channels at once, with
+the sections of each channel in the lanes of SSE2 or AVX2 vectors.
+
+  The sections of a cascade depend on each other sample by sample, so
+they are not run side by side on the same sample.  Instead the lanes of
+a vector hold a chain of consecutive sections, and at each step every
+lane takes the output of the lane below from the step before: lane k
+filters sample n - k while lane 0 filters sample n.  The samples go in
+at the bottom of the chain and come out of the top a few steps later.
+At the start and end of each run of samples, the lanes that have no
+sample yet, or none left, keep their state.
+
+  A vector that is wider than the cascade holds the chains of several
+channels; a cascade that is longer than the vector is done in passes
+of as many sections as fit.  Lanes left over pass their input through.
+
+  As in SampleFormatSIMD.cpp, the kernel is written once, in
+BiquadCascadeKernels.h, against a struct Ops of vector primitives, and
+each function is marked with the instruction set that it may use rather
+than the file being built with special compiler flags.  The level is
+chosen at run time.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include "BiquadCascade.h"
+
+#include <algorithm>
+#include <string.h>
+#include <wx/debug.h>
+
+#include "../CPUCaps.h"
+
+namespace {
+
+enum { MaxWidth = 8 };
+
+// Samples of each channel interleaved into the lanes at a time
+enum { ChunkLength = 1024 };
+
+// The position of an unused lane, which is never active
+enum { NoPosition = 1 << 30 };
+
+// The coefficients and state of the lanes of one vector
+struct CascadeLanes
+{
+   float b0[MaxWidth], b1[MaxWidth], b2[MaxWidth];
+   float a1[MaxWidth], a2[MaxWidth];
+   float s1[MaxWidth], s2[MaxWidth];
+   // The position of each lane in its chain
+   int position[MaxWidth];
+   // All ones for the lanes that take the output of the lane below, zero
+   // for the bottom lane of each chain, which takes the input
+   int fromBelow[MaxWidth];
+};
+
+using RunLanesFunction = void (*)(CascadeLanes &lanes, const float *x,
+                                  float *y, size_t len, unsigned chainLength);
+
+}
+
+#ifdef CPUCAPS_X86
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#define SIMD_TARGET_FUNCTION(isa) static __forceinline
+#define SIMD_TARGET_ENTRY(isa) static
+#else
+#define SIMD_TARGET_FUNCTION(isa) \
+   static inline __attribute__((always_inline, target(isa)))
+#define SIMD_TARGET_ENTRY(isa) static __attribute__((target(isa)))
+#endif
+
+namespace SSE2 {
+
+#define SIMD_FUNCTION SIMD_TARGET_FUNCTION("sse2")
+#define SIMD_ENTRY SIMD_TARGET_ENTRY("sse2")
+
+struct Ops
+{
+   enum { Width = 4 };
+   using F = __m128;
+   using I = __m128i;
+
+   SIMD_FUNCTION F Zero() { return _mm_setzero_ps(); }
+   SIMD_FUNCTION I Set1Int(int x) { return _mm_set1_epi32(x); }
+   SIMD_FUNCTION F Load(const float *p) { return _mm_loadu_ps(p); }
+   SIMD_FUNCTION void Store(float *p, F x) { _mm_storeu_ps(p, x); }
+   SIMD_FUNCTION I LoadInts(const int *p)
+      { return _mm_loadu_si128((const __m128i *)p); }
+
+   SIMD_FUNCTION F Add(F a, F b) { return _mm_add_ps(a, b); }
+   SIMD_FUNCTION F Sub(F a, F b) { return _mm_sub_ps(a, b); }
+   SIMD_FUNCTION F Mul(F a, F b) { return _mm_mul_ps(a, b); }
+   SIMD_FUNCTION F AndFloat(F a, F b) { return _mm_and_ps(a, b); }
+   SIMD_FUNCTION F OrFloat(F a, F b) { return _mm_or_ps(a, b); }
+   SIMD_FUNCTION F AsFloat(I x) { return _mm_castsi128_ps(x); }
+
+   SIMD_FUNCTION I And(I a, I b) { return _mm_and_si128(a, b); }
+   SIMD_FUNCTION I Greater(I a, I b) { return _mm_cmpgt_epi32(a, b); }
+   // a where mask is set, else b
+   SIMD_FUNCTION F Select(I mask, F a, F b)
+   {
+      const F m = _mm_castsi128_ps(mask);
+      return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+   }
+
+   // Each lane moved up one, with zero in the bottom
+   SIMD_FUNCTION F ShiftUp(F x)
+      { return _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 4)); }
+};
+
+#include "BiquadCascadeKernels.h"
+
+#undef SIMD_FUNCTION
+#undef SIMD_ENTRY
+
+}
+
+namespace AVX2 {
+
+#define SIMD_FUNCTION SIMD_TARGET_FUNCTION("avx2")
+#define SIMD_ENTRY SIMD_TARGET_ENTRY("avx2")
+
+struct Ops
+{
+   enum { Width = 8 };
+   using F = __m256;
+   using I = __m256i;
+
+   SIMD_FUNCTION F Zero() { return _mm256_setzero_ps(); }
+   SIMD_FUNCTION I Set1Int(int x) { return _mm256_set1_epi32(x); }
+   SIMD_FUNCTION F Load(const float *p) { return _mm256_loadu_ps(p); }
+   SIMD_FUNCTION void Store(float *p, F x) { _mm256_storeu_ps(p, x); }
+   SIMD_FUNCTION I LoadInts(const int *p)
+      { return _mm256_loadu_si256((const __m256i *)p); }
+
+   SIMD_FUNCTION F Add(F a, F b) { return _mm256_add_ps(a, b); }
+   SIMD_FUNCTION F Sub(F a, F b) { return _mm256_sub_ps(a, b); }
+   SIMD_FUNCTION F Mul(F a, F b) { return _mm256_mul_ps(a, b); }
+   SIMD_FUNCTION F AndFloat(F a, F b) { return _mm256_and_ps(a, b); }
+   SIMD_FUNCTION F OrFloat(F a, F b) { return _mm256_or_ps(a, b); }
+   SIMD_FUNCTION F AsFloat(I x) { return _mm256_castsi256_ps(x); }
+
+   SIMD_FUNCTION I And(I a, I b) { return _mm256_and_si256(a, b); }
+   SIMD_FUNCTION I Greater(I a, I b) { return _mm256_cmpgt_epi32(a, b); }
+   SIMD_FUNCTION F Select(I mask, F a, F b)
+      { return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(mask)); }
+
+   // The bottom lane is left as it was; it is always masked off
+   SIMD_FUNCTION F ShiftUp(F x)
+   {
+      return _mm256_permutevar8x32_ps(
+         x, _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6));
+   }
+};
+
+#include "BiquadCascadeKernels.h"
+
+#undef SIMD_FUNCTION
+#undef SIMD_ENTRY
+
+}
+
+#endif // CPUCAPS_X86
+
+static RunLanesFunction GetKernel(BiquadCascade::VectorLevel level)
+{
+#ifdef CPUCAPS_X86
+   switch (level) {
+   case BiquadCascade::SSE2:
+      return ::SSE2::RunLanes;
+   case BiquadCascade::AVX2:
+      return ::AVX2::RunLanes;
+   default:
+      break;
+   }
+#endif
+   return nullptr;
+}
+
+static unsigned GetWidth(BiquadCascade::VectorLevel level)
+{
+   return level == BiquadCascade::AVX2 ? 8 : 4;
+}
+
+// Passes the samples through unchanged
+static const BiquadCoeffs identity = { 1, 0, 0, 0, 0 };
+
+auto BiquadCascade::GetBestLevel() -> VectorLevel
+{
+   const auto &caps = GetCPUCaps();
+   if (caps.AVX2)
+      return AVX2;
+   if (caps.SSE2)
+      return SSE2;
+   return Scalar;
+}
+
+bool BiquadCascade::IsSupported(VectorLevel level)
+{
+   const auto &caps = GetCPUCaps();
+   switch (level) {
+   case Scalar:
+      return true;
+   case SSE2:
+      return caps.SSE2 && GetKernel(level);
+   case AVX2:
+      return caps.AVX2 && GetKernel(level);
+   default:
+      return false;
+   }
+}
+
+BiquadCascade::BiquadCascade(unsigned nChannels, unsigned nSections)
+: mLevel(GetBestLevel())
+{
+   Configure(nChannels, nSections);
+}
+
+void BiquadCascade::Configure(unsigned nChannels, unsigned nSections)
+{
+   mChannels = nChannels;
+   mSections = nSections;
+   mCoeffs.assign(nChannels * nSections, identity);
+   Reset();
+}
+
+void BiquadCascade::SetSection(unsigned section, const BiquadCoeffs &coeffs)
+{
+   for (unsigned channel = 0; channel < mChannels; channel++)
+      SetSection(channel, section, coeffs);
+}
+
+void BiquadCascade::SetSection(unsigned section, const BiquadStruct &biquad)
+{
+   SetSection(section, BiquadCoeffs{
+      biquad.fNumerCoeffs[0], biquad.fNumerCoeffs[1], biquad.fNumerCoeffs[2],
+      biquad.fDenomCoeffs[0], biquad.fDenomCoeffs[1] });
+}
+
+void BiquadCascade::SetSection(unsigned channel, unsigned section,
+                               const BiquadCoeffs &coeffs)
+{
+   wxASSERT(channel < mChannels && section < mSections);
+   mCoeffs[channel * mSections + section] = coeffs;
+}
+
+void BiquadCascade::Reset()
+{
+   mState1.assign(mChannels * mSections, 0.0f);
+   mState2.assign(mChannels * mSections, 0.0f);
+}
+
+void BiquadCascade::SetVectorLevel(VectorLevel level)
+{
+   mLevel = IsSupported(level) ? level : Scalar;
+}
+
+void BiquadCascade::Process(const float *const *in, float *const *out,
+                            size_t len)
+{
+   if (mSections == 0) {
+      for (unsigned channel = 0; channel < mChannels; channel++)
+         if (in[channel] != out[channel])
+            memmove(out[channel], in[channel], len * sizeof(float));
+      return;
+   }
+
+   // A cascade that fills no more than half the lanes is quicker in
+   // narrower vectors, and one of a single lane in none
+   auto level = mLevel;
+   const auto lanes = mChannels * mSections;
+   if (lanes < 2)
+      level = Scalar;
+   else if (level == AVX2 && lanes <= GetWidth(SSE2))
+      level = SSE2;
+
+   if (level == Scalar)
+      ProcessScalar(in, out, len);
+   else
+      ProcessVector(level, in, out, len);
+}
+
+void BiquadCascade::ProcessScalar(const float *const *in, float *const *out,
+                                  size_t len)
+{
+   for (unsigned channel = 0; channel < mChannels; channel++) {
+      const float *src = in[channel];
+      float *dst = out[channel];
+      for (unsigned section = 0; section < mSections; section++) {
+         const auto index = channel * mSections + section;
+         const BiquadCoeffs c = mCoeffs[index];
+         float s1 = mState1[index], s2 = mState2[index];
+         for (size_t i = 0; i < len; i++) {
+            // The same operations in the same order as the vector
+            // kernels, with y as late as can be in the recursion
+            const float x = src[i];
+            const float y = c.b0 * x + s1;
+            s1 = (c.b1 * x + s2) - c.a1 * y;
+            s2 = c.b2 * x - c.a2 * y;
+            dst[i] = y;
+         }
+         mState1[index] = s1;
+         mState2[index] = s2;
+         src = dst;
+      }
+   }
+}
+
+void BiquadCascade::ProcessVector(VectorLevel level, const float *const *in,
+                                  float *const *out, size_t len)
+{
+   const auto run = GetKernel(level);
+   const unsigned width = GetWidth(level);
+   const unsigned chainLength = std::min(mSections, width);
+   const unsigned chains = width / chainLength;
+   const unsigned nPasses = (mSections + chainLength - 1) / chainLength;
+
+   // Only the bottom lanes of the chains are written below; the others
+   // stay zero
+   mLaneIn.assign((ChunkLength + chainLength - 1) * width, 0.0f);
+   mLaneOut.resize(mLaneIn.size());
+
+   for (unsigned pass = 0; pass < nPasses; pass++) {
+      for (unsigned first = 0; first < mChannels; first += chains) {
+         CascadeLanes lanes;
+         memset(&lanes, 0, sizeof(lanes));
+         for (unsigned lane = 0; lane < width; lane++)
+            lanes.position[lane] = NoPosition;
+
+         for (unsigned chain = 0; chain < chains; chain++) {
+            const auto channel = first + chain;
+            if (channel >= mChannels)
+               break;
+            for (unsigned k = 0; k < chainLength; k++) {
+               const auto lane = chain * chainLength + k;
+               const auto section = pass * chainLength + k;
+               lanes.position[lane] = k;
+               lanes.fromBelow[lane] = k > 0 ? ~0 : 0;
+
+               BiquadCoeffs c = identity;
+               if (section < mSections) {
+                  const auto index = channel * mSections + section;
+                  c = mCoeffs[index];
+                  lanes.s1[lane] = mState1[index];
+                  lanes.s2[lane] = mState2[index];
+               }
+               lanes.b0[lane] = c.b0;
+               lanes.b1[lane] = c.b1;
+               lanes.b2[lane] = c.b2;
+               lanes.a1[lane] = c.a1;
+               lanes.a2[lane] = c.a2;
+            }
+         }
+
+         for (size_t start = 0; start < len; start += ChunkLength) {
+            const auto count = std::min<size_t>(ChunkLength, len - start);
+            const auto steps = count + chainLength - 1;
+
+            for (unsigned chain = 0; chain < chains; chain++) {
+               const auto channel = first + chain;
+               if (channel >= mChannels)
+                  break;
+               // Later passes continue from the output of the one before
+               const float *src = (pass == 0 ? in[channel] : out[channel]) + start;
+               float *dst = &mLaneIn[chain * chainLength];
+               for (size_t i = 0; i < count; i++)
+                  dst[i * width] = src[i];
+               // Nothing more goes in while the last samples come out
+               for (size_t i = count; i < steps; i++)
+                  dst[i * width] = 0.0f;
+            }
+
+            run(lanes, mLaneIn.data(), mLaneOut.data(), count, chainLength);
+
+            for (unsigned chain = 0; chain < chains; chain++) {
+               const auto channel = first + chain;
+               if (channel >= mChannels)
+                  break;
+               const float *src = &mLaneOut[
+                  (chainLength - 1) * width + chain * chainLength + chainLength - 1];
+               float *dst = out[channel] + start;
+               for (size_t i = 0; i < count; i++)
+                  dst[i] = src[i * width];
+            }
+         }
+
+         for (unsigned chain = 0; chain < chains; chain++) {
+            const auto channel = first + chain;
+            if (channel >= mChannels)
+               break;
+            for (unsigned k = 0; k < chainLength; k++) {
+               const auto section = pass * chainLength + k;
+               if (section < mSections) {
+                  const auto lane = chain * chainLength + k;
+                  const auto index = channel * mSections + section;
+                  mState1[index] = lanes.s1[lane];
+                  mState2[index] = lanes.s2[lane];
+               }
+            }
+         }
+      }
+   }
+}
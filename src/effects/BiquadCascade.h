@@ -0,0 +1,90 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BiquadCascade.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_BIQUAD_CASCADE__
+#define __AUDACITY_BIQUAD_CASCADE__
+
+#include <stddef.h>
+#include <vector>
+
+#include "Biquad.h"
+
+/// The coefficients of one second order section, with a0 taken as 1:
+/// y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+struct BiquadCoeffs
+{
+   float b0, b1, b2;
+   float a1, a2;
+};
+
+/// A cascade of second order sections, applied to one or more channels,
+/// in transposed direct form II.
+///
+/// The sections of a channel, and the channels, are spread over the lanes
+/// of SSE2 or AVX2 vectors.  A sample goes through the sections of a
+/// channel one lane a step, so all of them work at once on consecutive
+/// samples.  The coefficients may be changed between calls of Process,
+/// as for realtime parameter changes, keeping the state of the filter.
+class BiquadCascade
+{
+ public:
+   enum VectorLevel {
+      Scalar,
+      SSE2,
+      AVX2,
+      nVectorLevels
+   };
+
+   /// The best level that the processor supports
+   static VectorLevel GetBestLevel();
+   /// Whether the processor supports a level
+   static bool IsSupported(VectorLevel level);
+
+   BiquadCascade(unsigned nChannels = 1, unsigned nSections = 1);
+
+   /// Sets every section of every channel to pass the samples unchanged,
+   /// and clears the state
+   void Configure(unsigned nChannels, unsigned nSections);
+   unsigned GetChannelCount() const { return mChannels; }
+   unsigned GetSectionCount() const { return mSections; }
+
+   /// For every channel
+   void SetSection(unsigned section, const BiquadCoeffs &coeffs);
+   void SetSection(unsigned section, const BiquadStruct &biquad);
+   void SetSection(unsigned channel, unsigned section,
+                   const BiquadCoeffs &coeffs);
+
+   /// Clears the state, as at the start of a track
+   void Reset();
+
+   /// The widest vectors to use, for benchmarks and tests; by default the
+   /// best level.  Cascades too small to fill the vectors use narrower ones.
+   void SetVectorLevel(VectorLevel level);
+   VectorLevel GetVectorLevel() const { return mLevel; }
+
+   /// Filters len samples of each channel.  in and out may be the same.
+   void Process(const float *const *in, float *const *out, size_t len);
+
+ private:
+   void ProcessScalar(const float *const *in, float *const *out, size_t len);
+   void ProcessVector(VectorLevel level,
+                      const float *const *in, float *const *out, size_t len);
+
+   unsigned mChannels;
+   unsigned mSections;
+   VectorLevel mLevel;
+
+   // For each channel, the coefficients and state of each section
+   std::vector<BiquadCoeffs> mCoeffs;
+   std::vector<float> mState1, mState2;
+
+   // Interleaved samples of the lanes, for the vector kernels
+   std::vector<float> mLaneIn, mLaneOut;
+};
+
+#endif
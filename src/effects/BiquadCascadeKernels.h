@@ -0,0 +1,82 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BiquadCascadeKernels.h
+
+  Not an ordinary header.  BiquadCascade.cpp includes it once per
+  instruction set, inside a namespace that already defines a struct
+  Ops of vector primitives and the macros SIMD_FUNCTION and SIMD_ENTRY,
+  as SampleFormatSIMD.cpp does for SampleFormatKernels.h.
+
+**********************************************************************/
+
+using F = Ops::F;
+using I = Ops::I;
+
+// The lanes that have a sample at step t: those whose position in the
+// chain is at most t, and that have not yet had all len samples
+SIMD_FUNCTION I ActiveLanes(I position, ptrdiff_t t, ptrdiff_t len)
+{
+   return Ops::And(Ops::Greater(Ops::Set1Int((int)(t + 1)), position),
+                   Ops::Greater(position, Ops::Set1Int((int)(t - len))));
+}
+
+// One step of every lane.  Lanes not active keep their state, unless all
+// are known to be active.
+template<bool AllActive>
+SIMD_FUNCTION void Step(const F *coeffs, F fromBelow, I position,
+                        const float *x, float *y, ptrdiff_t t, ptrdiff_t len,
+                        F &prev, F &s1, F &s2)
+{
+   // Each lane has either a sample from below or one from x, and zero from
+   // the other, so a bitwise or adds them more quickly
+   const F in = Ops::OrFloat(Ops::AndFloat(Ops::ShiftUp(prev), fromBelow),
+                             Ops::Load(x + t * Ops::Width));
+   const F out = Ops::Add(Ops::Mul(coeffs[0], in), s1);
+   const F n1 = Ops::Sub(
+      Ops::Add(Ops::Mul(coeffs[1], in), s2), Ops::Mul(coeffs[3], out));
+   const F n2 = Ops::Sub(Ops::Mul(coeffs[2], in), Ops::Mul(coeffs[4], out));
+   if (AllActive)
+      s1 = n1, s2 = n2;
+   else {
+      const I active = ActiveLanes(position, t, len);
+      s1 = Ops::Select(active, n1, s1);
+      s2 = Ops::Select(active, n2, s2);
+   }
+   Ops::Store(y + t * Ops::Width, out);
+   prev = out;
+}
+
+// x holds len + chainLength - 1 vectors of input, with the samples in the
+// bottom lanes of the chains and zero elsewhere.  Vector t of y receives
+// the outputs of step t, so the top lane of a chain gives sample n at
+// step n + chainLength - 1.
+SIMD_ENTRY void RunLanes(CascadeLanes &lanes, const float *x, float *y,
+                         size_t len, unsigned chainLength)
+{
+   const F coeffs[] = {
+      Ops::Load(lanes.b0), Ops::Load(lanes.b1), Ops::Load(lanes.b2),
+      Ops::Load(lanes.a1), Ops::Load(lanes.a2),
+   };
+   const F fromBelow = Ops::AsFloat(Ops::LoadInts(lanes.fromBelow));
+   const I position = Ops::LoadInts(lanes.position);
+   F s1 = Ops::Load(lanes.s1), s2 = Ops::Load(lanes.s2);
+   F prev = Ops::Zero();
+
+   const ptrdiff_t steps = len + chainLength - 1;
+   // Between these, every lane of every chain has a sample
+   const ptrdiff_t steadyBegin = chainLength - 1;
+   const ptrdiff_t steadyEnd = std::max<ptrdiff_t>(len, steadyBegin);
+
+   ptrdiff_t t = 0;
+   for (; t < steadyBegin; t++)
+      Step<false>(coeffs, fromBelow, position, x, y, t, len, prev, s1, s2);
+   for (; t < steadyEnd; t++)
+      Step<true>(coeffs, fromBelow, position, x, y, t, len, prev, s1, s2);
+   for (; t < steps; t++)
+      Step<false>(coeffs, fromBelow, position, x, y, t, len, prev, s1, s2);
+
+   Ops::Store(lanes.s1, s1);
+   Ops::Store(lanes.s2, s2);
+}
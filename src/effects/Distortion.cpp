@@ -220,6 +220,12 @@ unsigned EffectDistortion::GetAudioOutCount()
    return 1;
 }
 
+bool EffectDistortion::SupportsIndependentBlocks()
+{
+   // Only the table lookup; the DC blocking filter has memory
+   return !mParams.mDCBlock;
+}
+
 bool EffectDistortion::ProcessInitialize(sampleCount WXUNUSED(totalLen), ChannelNames WXUNUSED(chanMap))
 {
    InstanceInit(mMaster, mSampleRate);
@@ -520,11 +526,15 @@ size_t EffectDistortion::InstanceProcess(EffectDistortionState& data, float** in
    double p1 = mParams.mParam1 / 100.0;
    double p2 = mParams.mParam2 / 100.0;
 
-   data.tablechoiceindx = mParams.mTableChoiceIndx;
-   data.threshold = mParams.mThreshold_dB;
-   data.noisefloor = mParams.mNoiseFloor;
-   data.param1 = mParams.mParam1;
-   data.repeats = mParams.mRepeats;
+   // Leave the state alone when nothing changed, so that blocks may be
+   // processed at once on several threads
+   if (update) {
+      data.tablechoiceindx = mParams.mTableChoiceIndx;
+      data.threshold = mParams.mThreshold_dB;
+      data.noisefloor = mParams.mNoiseFloor;
+      data.param1 = mParams.mParam1;
+      data.repeats = mParams.mRepeats;
+   }
 
    for (decltype(blockLen) i = 0; i < blockLen; i++) {
       if (update && ((data.skipcount++) % skipsamples == 0)) {
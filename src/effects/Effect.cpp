@@ -25,6 +25,8 @@ greater use in future.
 #include "Effect.h"
 
 #include <algorithm>
+#include <atomic>
+#include <vector>
 
 #include <wx/defs.h>
 #include <wx/hashmap.h>
@@ -46,6 +48,7 @@ greater use in future.
 #include "../Project.h"
 #include "../ShuttleGui.h"
 #include "../WaveTrack.h"
+#include "../WorkerPool.h"
 #include "../toolbars/ControlToolBar.h"
 #include "../widgets/AButton.h"
 #include "../widgets/ProgressDialog.h"
@@ -367,6 +370,16 @@ size_t Effect::GetTailSize()
    return 0;
 }
 
+bool Effect::SupportsIndependentBlocks()
+{
+   if (mClient)
+   {
+      return mClient->SupportsIndependentBlocks();
+   }
+
+   return false;
+}
+
 bool Effect::IsReady()
 {
    if (mClient)
@@ -1523,6 +1536,23 @@ bool Effect::ProcessTrack(int count,
       return false;
    }
 
+   // Effects whose blocks don't depend on each other can process
+   // several parts of a long selection at once
+   if (GetType() == EffectTypeProcess &&
+       len > mBufferSize &&
+       WorkerPool::GetProcessorCount() > 1 &&
+       SupportsIndependentBlocks())
+   {
+      rc = ProcessTrackParallel(count, left, right, leftStart, rightStart, len);
+
+      if (!ProcessFinalize())
+      {
+         return false;
+      }
+
+      return rc;
+   }
+
    // For each input block of samples, we pass it to the effect along with a
    // variable output location.  This output location is simply a pointer into a
    // much larger buffer.  This reduces the number of calls required to add the
@@ -1865,6 +1895,132 @@ bool Effect::ProcessTrack(int count,
    return rc;
 }
 
+// The selection is cut into ranges of mBufferSize samples.  Each worker
+// reads a range, and passes it through ProcessBlock a block at a time,
+// into buffers of its own.  The ranges are written back to the tracks in
+// order on this thread, a round at a time, which bounds the memory used
+// and lets progress and cancellation work as in ProcessTrack.
+bool Effect::ProcessTrackParallel(int count,
+                                  WaveTrack *left,
+                                  WaveTrack *right,
+                                  sampleCount leftStart,
+                                  sampleCount rightStart,
+                                  sampleCount len)
+{
+   // A pool for this track only; its start-up is small beside the work
+   WorkerPool pool{ WorkerPool::GetProcessorCount() };
+
+   struct Range
+   {
+      sampleCount start;
+      size_t len;
+      std::vector< std::vector<float> > in;
+      std::vector< std::vector<float> > out;
+   };
+
+   // Always give the client the number of buffers it expects, even if we
+   // don't have the same number of channels; unused inputs stay zero
+   std::vector<Range> ranges(2 * pool.GetThreadCount());
+   for (auto &range : ranges)
+   {
+      range.in.resize(mNumAudioIn, std::vector<float>(mBufferSize, 0.0f));
+      range.out.resize(mNumAudioOut, std::vector<float>(mBufferSize));
+   }
+
+   const auto chans = std::min(mNumAudioOut, mNumChannels);
+   std::atomic<bool> failed{ false };
+
+   auto process = [&](size_t ii)
+   {
+      auto &range = ranges[ii];
+      if (range.len == 0)
+      {
+         return;
+      }
+
+      bool ok = left->Get((samplePtr) range.in[0].data(), floatSample,
+                          leftStart + range.start, range.len);
+      if (right && ok)
+      {
+         ok = right->Get((samplePtr) range.in[1].data(), floatSample,
+                         rightStart + range.start, range.len);
+      }
+      if (!ok)
+      {
+         failed = true;
+         return;
+      }
+
+      std::vector<float *> inPos(mNumAudioIn), outPos(mNumAudioOut);
+      for (size_t pos = 0; pos < range.len; pos += mBlockSize)
+      {
+         const auto blockLen = std::min(mBlockSize, range.len - pos);
+         for (unsigned i = 0; i < mNumAudioIn; i++)
+         {
+            inPos[i] = range.in[i].data() + pos;
+         }
+         for (unsigned i = 0; i < mNumAudioOut; i++)
+         {
+            outPos[i] = range.out[i].data() + pos;
+         }
+
+         try
+         {
+            ProcessBlock(inPos.data(), outPos.data(), blockLen);
+         }
+         catch(...)
+         {
+            failed = true;
+            return;
+         }
+      }
+   };
+
+   sampleCount done = 0;
+   while (done < len)
+   {
+      // Hand out the next round of ranges
+      for (auto &range : ranges)
+      {
+         range.start = done;
+         range.len = limitSampleBufferSize(mBufferSize, len - done);
+         done += range.len;
+      }
+
+      pool.ForEach(ranges.size(), process);
+      if (failed)
+      {
+         return false;
+      }
+
+      for (const auto &range : ranges)
+      {
+         if (range.len == 0)
+         {
+            continue;
+         }
+
+         left->Set((samplePtr) range.out[0].data(), floatSample,
+                   leftStart + range.start, range.len);
+         if (right)
+         {
+            const auto &out = range.out[chans >= 2 ? 1 : 0];
+            right->Set((samplePtr) out.data(), floatSample,
+                       rightStart + range.start, range.len);
+         }
+      }
+
+      const double frac = done.as_double() / len.as_double();
+      if (mNumChannels > 1 ? TrackGroupProgress(count, frac)
+                           : TrackProgress(count, frac))
+      {
+         return false;
+      }
+   }
+
+   return true;
+}
+
 void Effect::End()
 {
 }
@@ -105,6 +105,7 @@ class AUDACITY_DLL_API Effect /* not final */ : public wxEvtHandler,
 
    sampleCount GetLatency() override;
    size_t GetTailSize() override;
+   bool SupportsIndependentBlocks() override;
 
    void SetSampleRate(double rate) override;
    size_t SetBlockSize(size_t maxBlockSize) override;
@@ -471,6 +472,12 @@ protected:
                      sampleCount leftStart,
                      sampleCount rightStart,
                      sampleCount len);
+   bool ProcessTrackParallel(int count,
+                             WaveTrack *left,
+                             WaveTrack *right,
+                             sampleCount leftStart,
+                             sampleCount rightStart,
+                             sampleCount len);
  
  //
  // private data
@@ -619,11 +619,13 @@ size_t EffectManager::RealtimeProcess(int group, unsigned chans, float **buffers
    // Now call each effect in the chain while swapping buffer pointers to feed the
    // output of one effect as the input to the next effect
    size_t called = 0;
+   sampleCount delay = 0;
    for (size_t i = 0, cnt = mRealtimeEffects.GetCount(); i < cnt; i++)
    {
       if (mRealtimeEffects[i]->IsRealtimeActive())
       {
          mRealtimeEffects[i]->RealtimeProcess(group, chans, ibuf, obuf, numSamples);
+         delay += mRealtimeEffects[i]->GetLatency();
          called++;
       }
 
@@ -648,8 +650,13 @@ size_t EffectManager::RealtimeProcess(int group, unsigned chans, float **buffers
       }
    }
 
-   // Remember the latency
+   // Remember the latency, both the time taken and the delay that the
+   // effects add to the samples
    mRealtimeLatency = (int) (wxGetLocalTimeMillis() - start).GetValue();
+   if (group < (int) mRealtimeRates.GetCount() && mRealtimeRates[group] > 0)
+   {
+      mRealtimeLatency += (int) (delay.as_double() * 1000.0 / mRealtimeRates[group]);
+   }
 
    mRealtimeLock.Leave();
 
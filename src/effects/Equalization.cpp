@@ -55,6 +55,7 @@
 #include "../Audacity.h"
 #include "Equalization.h"
 
+#include <algorithm>
 #include <math.h>
 #include <vector>
 
@@ -218,7 +219,6 @@ EffectEqualization::EffectEqualization()
    mPanel = NULL;
 
    hFFT = InitializeFFT(windowSize);
-   mFFTBuffer = new float[windowSize];
    mFilterFuncR = new float[windowSize];
    mFilterFuncI = new float[windowSize];
 
@@ -253,6 +253,9 @@ EffectEqualization::EffectEqualization()
 
    mWindowSize = windowSize;
 
+   mImpulseGeneration = 0;
+   mRealtimeLatency = 0;
+
    mDirty = false;
    mDisallowCustom = false;
 
@@ -287,9 +290,6 @@ EffectEqualization::~EffectEqualization()
    if(hFFT)
       EndFFT(hFFT);
    hFFT = NULL;
-   if(mFFTBuffer)
-      delete[] mFFTBuffer;
-   mFFTBuffer = NULL;
    if(mFilterFuncR)
       delete[] mFilterFuncR;
    if(mFilterFuncI)
@@ -317,8 +317,84 @@ EffectType EffectEqualization::GetType()
    return EffectTypeProcess;
 }
 
+bool EffectEqualization::SupportsRealtime()
+{
+#if defined(EXPERIMENTAL_REALTIME_AUDACITY_EFFECTS)
+   return true;
+#else
+   return false;
+#endif
+}
+
 // EffectClientInterface implementation
 
+unsigned EffectEqualization::GetAudioInCount()
+{
+   return 1;
+}
+
+unsigned EffectEqualization::GetAudioOutCount()
+{
+   return 1;
+}
+
+bool EffectEqualization::RealtimeInitialize()
+{
+   SetBlockSize(realtimePartitionSize);
+
+   mSlaves.clear();
+   mRealtimeLatency = realtimePartitionSize;
+
+   return true;
+}
+
+bool EffectEqualization::RealtimeAddProcessor(unsigned WXUNUSED(numChannels), float WXUNUSED(sampleRate))
+{
+   auto slave = std::make_unique<RealtimeSlave>();
+   // So that taking up a NEW curve does not allocate, at the longest filter
+   slave->convolver.Reserve(windowSize - 1);
+
+   mSlaves.push_back(std::move(slave));
+
+   return true;
+}
+
+bool EffectEqualization::RealtimeFinalize()
+{
+   mSlaves.clear();
+   mRealtimeLatency = 0;
+
+   return true;
+}
+
+size_t EffectEqualization::RealtimeProcess(int group,
+                                           float **inbuf,
+                                           float **outbuf,
+                                           size_t numSamples)
+{
+   RealtimeSlave &slave = *mSlaves[group];
+
+   // Take up the spectra that CalcFilter made last, which costs only a
+   // reference.  If it is making them now, keep the old ones for this
+   // block rather than wait.
+   {
+      ODLocker locker(&mImpulseLock, true);
+      if (locker && mRealtimeImpulse &&
+          slave.generation != mImpulseGeneration)
+      {
+         slave.convolver.SetImpulse(mRealtimeImpulse);
+         slave.generation = mImpulseGeneration;
+         // The filter is symmetric about its middle, which lags the input
+         mRealtimeLatency = slave.convolver.GetLatency() +
+            (mRealtimeImpulse->GetLength() - 1) / 2;
+      }
+   }
+
+   slave.convolver.Process(inbuf, outbuf, numSamples);
+
+   return numSamples;
+}
+
 bool EffectEqualization::GetAutomationParameters(EffectAutomationParameters & parms)
 {
    parms.Write(KEY_FilterLength, mM);
@@ -569,6 +645,11 @@ bool EffectEqualization::Process()
    return bGoodResult;
 }
 
+sampleCount EffectEqualization::GetLatency()
+{
+   return mRealtimeLatency;
+}
+
 bool EffectEqualization::PopulateUI(wxWindow *parent)
 {
    mUIParent = parent;
@@ -1064,28 +1145,33 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
    AudacityProject *p = GetActiveProject();
    auto output = p->GetTrackFactory()->NewWaveTrack(floatSample, t->GetRate());
 
+   wxASSERT(mM == mImpulse.size());
    wxASSERT(mM - 1 < windowSize);
-   size_t L = windowSize - (mM - 1);   //Process L samples at a go
+
+   // The filter is one partition; each transform of windowSize points
+   // takes in as many samples as leave room for it
+   PartitionedConvolver convolver(1, windowSize - (mM - 1), windowSize);
+   convolver.SetImpulse(&mImpulse[0], mImpulse.size());
+
    auto s = start;
    auto idealBlockLen = t->GetMaxBlockSize() * 4;
-   if (idealBlockLen % L != 0)
-      idealBlockLen += (L - (idealBlockLen % L));
 
    float *buffer = new float[idealBlockLen];
 
-   float *window1 = new float[windowSize];
-   float *window2 = new float[windowSize];
-   float *thisWindow = window1;
-   float *lastWindow = window2;
-
    auto originalLen = len;
 
-   for(size_t i = 0; i < windowSize; i++)
-      lastWindow[i] = 0;
+   // The convolver delays its output; drop that many samples from the
+   // start of the output, so that it is the whole convolution
+   size_t skip = convolver.GetLatency();
+   auto append = [&](size_t block) {
+      auto dropped = std::min(skip, block);
+      skip -= dropped;
+      if (block > dropped)
+         output->Append((samplePtr)(buffer + dropped), floatSample, block - dropped);
+   };
 
    TrackProgress(count, 0.);
    bool bLoopSuccess = true;
-   size_t wcopy = 0;
    int offset = (mM - 1) / 2;
 
    while (len != 0)
@@ -1094,28 +1180,9 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
 
       t->Get((samplePtr)buffer, floatSample, s, block);
 
-      for(size_t i = 0; i < block; i += L)   //go through block in lumps of length L
-      {
-         wcopy = std::min <size_t> (L, block - i);
-         for(size_t j = 0; j < wcopy; j++)
-            thisWindow[j] = buffer[i+j];   //copy the L (or remaining) samples
-         for(auto j = wcopy; j < windowSize; j++)
-            thisWindow[j] = 0;   //this includes the padding
-
-         Filter(windowSize, thisWindow);
-
-         // Overlap - Add
-         for(size_t j = 0; (j < mM - 1) && (j < wcopy); j++)
-            buffer[i+j] = thisWindow[j] + lastWindow[L + j];
-         for(size_t j = mM - 1; j < wcopy; j++)
-            buffer[i+j] = thisWindow[j];
-
-         float *tempP = thisWindow;
-         thisWindow = lastWindow;
-         lastWindow = tempP;
-      }  //next i, lump of this block
-
-      output->Append((samplePtr)buffer, floatSample, block);
+      convolver.Process(&buffer, &buffer, block);
+      append(block);
+
       len -= block;
       s += block;
 
@@ -1129,22 +1196,18 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
 
    if(bLoopSuccess)
    {
-      // mM-1 samples of 'tail' left in lastWindow, get them now
-      if(wcopy < (mM - 1)) {
-         // Still have some overlap left to process
-         // (note that lastWindow and thisWindow have been exchanged at this point
-         //  so that 'thisWindow' is really the window prior to 'lastWindow')
-         size_t j = 0;
-         for(; j < mM - 1 - wcopy; j++)
-            buffer[j] = lastWindow[wcopy + j] + thisWindow[L + wcopy + j];
-         // And fill in the remainder after the overlap
-         for( ; j < mM - 1; j++)
-            buffer[j] = lastWindow[wcopy + j];
-      } else {
-         for(size_t j = 0; j < mM - 1; j++)
-            buffer[j] = lastWindow[wcopy + j];
-      }
-      output->Append((samplePtr)buffer, floatSample, mM - 1);
+      // Feed in silence for the mM-1 samples of 'tail', and the samples
+      // the convolver still holds
+      size_t tail = mM - 1 + convolver.GetLatency();
+      while (tail != 0)
+      {
+         auto block = std::min<size_t>(idealBlockLen, tail);
+         for(size_t j = 0; j < block; j++)
+            buffer[j] = 0;
+         convolver.Process(&buffer, &buffer, block);
+         append(block);
+         tail -= block;
+      }
       output->Flush();
 
       // now move the appropriate bit of the output back to the track
@@ -1211,8 +1274,6 @@ bool EffectEqualization::ProcessOne(int count, WaveTrack * t,
    }
 
    delete[] buffer;
-   delete[] window1;
-   delete[] window2;
 
    return bLoopSuccess;
 }
@@ -1319,6 +1380,25 @@ bool EffectEqualization::CalcFilter()
    {   //and copy useful values back
       outr[i] = tempr[i];
    }
+   //keep the impulse response for the convolver
+   mImpulse.assign(outr, outr + mM);
+   {
+      // and its spectra for the realtime processors, made here so that
+      // the audio thread need only swap them in
+      auto impulse = std::make_shared<const PartitionedConvolver::Impulse>(
+         outr, mM, realtimePartitionSize);
+      ODLocker locker(&mImpulseLock);
+      if (mRealtimeImpulse)
+         mRetiredImpulses.push_back(std::move(mRealtimeImpulse));
+      mRealtimeImpulse = std::move(impulse);
+      mImpulseGeneration++;
+   }
+   // Let go of the spectra that no processor still uses
+   mRetiredImpulses.erase(
+      std::remove_if(mRetiredImpulses.begin(), mRetiredImpulses.end(),
+         [](const std::shared_ptr<const PartitionedConvolver::Impulse> &p)
+            { return p.use_count() == 1; }),
+      mRetiredImpulses.end());
    for(size_t i = mM; i < mWindowSize; i++)
    {   //rest is padding
       outr[i]=0.;
@@ -1334,31 +1414,6 @@ bool EffectEqualization::CalcFilter()
    return TRUE;
 }
 
-void EffectEqualization::Filter(size_t len, float *buffer)
-{
-   float re,im;
-   // Apply FFT
-   RealFFTf(buffer, hFFT);
-   //FFT(len, false, inr, NULL, outr, outi);
-
-   // Apply filter
-   // DC component is purely real
-   mFFTBuffer[0] = buffer[0] * mFilterFuncR[0];
-   for(size_t i = 1; i < (len / 2); i++)
-   {
-      re=buffer[hFFT->BitReversed[i]  ];
-      im=buffer[hFFT->BitReversed[i]+1];
-      mFFTBuffer[2*i  ] = re*mFilterFuncR[i] - im*mFilterFuncI[i];
-      mFFTBuffer[2*i+1] = re*mFilterFuncI[i] + im*mFilterFuncR[i];
-   }
-   // Fs/2 component is purely real
-   mFFTBuffer[1] = buffer[1] * mFilterFuncR[len/2];
-
-   // Inverse FFT and normalization
-   InverseRealFFTf(mFFTBuffer, hFFT);
-   ReorderToTime(hFFT, mFFTBuffer, buffer);
-}
-
 //
 // Load external curves with fallback to default, then message
 //
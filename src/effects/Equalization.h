@@ -36,11 +36,15 @@
 #include <wx/access.h>
 #endif
 
+#include <vector>
+
 #include "Effect.h"
+#include "PartitionedConvolver.h"
 #include "../xml/XMLTagHandler.h"
 #include "../widgets/Grid.h"
 #include "../widgets/Ruler.h"
 #include "../RealFFTf.h"
+#include "../ondemand/ODTaskThread.h"
 
 #define EQUALIZATION_PLUGIN_SYMBOL XO("Equalization")
 
@@ -97,9 +101,19 @@ public:
    // EffectIdentInterface implementation
 
    EffectType GetType() override;
+   bool SupportsRealtime() override;
 
    // EffectClientInterface implementation
 
+   unsigned GetAudioInCount() override;
+   unsigned GetAudioOutCount() override;
+   bool RealtimeInitialize() override;
+   bool RealtimeAddProcessor(unsigned numChannels, float sampleRate) override;
+   bool RealtimeFinalize() override;
+   size_t RealtimeProcess(int group,
+                               float **inbuf,
+                               float **outbuf,
+                               size_t numSamples) override;
    bool GetAutomationParameters(EffectAutomationParameters & parms) override;
    bool SetAutomationParameters(EffectAutomationParameters & parms) override;
    bool LoadFactoryDefaults() override;
@@ -113,6 +127,7 @@ public:
    bool Startup() override;
    bool Init() override;
    bool Process() override;
+   sampleCount GetLatency() override;
 
    bool PopulateUI(wxWindow *parent) override;
    bool CloseUI() override;
@@ -126,6 +141,10 @@ private:
    // Number of samples in an FFT window
    enum : size_t {windowSize=16384};   //MJS - work out the optimum for this at run time?  Have a dialog box for it?
 
+   // Samples in a partition of the convolution when playing in realtime,
+   // which is also the delay it adds
+   enum : size_t {realtimePartitionSize=512};
+
    // Low frequency of the FFT.  20Hz is the
    // low range of human hearing
    enum {loFreqI=20};
@@ -133,7 +152,6 @@ private:
    bool ProcessOne(int count, WaveTrack * t,
                    sampleCount start, sampleCount len);
    bool CalcFilter();
-   void Filter(size_t len, float *buffer);
    
    void Flatten();
    void ForceRecalc();
@@ -190,7 +208,6 @@ private:
 
 private:
    HFFT hFFT;
-   float *mFFTBuffer;
    float *mFilterFuncR;
    float *mFilterFuncI;
    size_t mM;
@@ -222,6 +239,29 @@ private:
    std::unique_ptr<Envelope> mLogEnvelope, mLinEnvelope;
    Envelope *mEnvelope;
 
+   // The impulse response that CalcFilter made
+   std::vector<float> mImpulse;
+
+   // Its spectra for the realtime processors, made here and taken up on
+   // the audio thread, and a count of the times CalcFilter made them
+   ODLock mImpulseLock;
+   std::shared_ptr<const PartitionedConvolver::Impulse> mRealtimeImpulse;
+   int mImpulseGeneration;
+   // Spectra replaced since, kept until no processor uses them, so that
+   // the audio thread never frees them
+   std::vector<std::shared_ptr<const PartitionedConvolver::Impulse>>
+      mRetiredImpulses;
+
+   // One for each channel played in realtime
+   struct RealtimeSlave
+   {
+      RealtimeSlave() : convolver(1, realtimePartitionSize), generation(-1) {}
+      PartitionedConvolver convolver;
+      int generation;
+   };
+   std::vector<std::unique_ptr<RealtimeSlave>> mSlaves;
+   size_t mRealtimeLatency;
+
 #ifdef EXPERIMENTAL_EQ_SSE_THREADED
    bool mBench;
    std::unique_ptr<EffectEqualization48x> mEffectEqualization48x;
@@ -39,6 +39,7 @@ public:
 
    unsigned GetAudioInCount() override;
    unsigned GetAudioOutCount() override;
+   bool SupportsIndependentBlocks() override;
    size_t ProcessBlock(float **inBlock, float **outBlock, size_t blockLen) override;
 };
 
@@ -45,10 +45,13 @@
 #include "../Prefs.h"
 
 #include "../WaveTrack.h"
+#include "../WorkerPool.h"
 
 #include <algorithm>
+#include <atomic>
 #include <vector>
 #include <math.h>
+#include <string.h>
 
 #if defined(__WXMSW__) && !defined(__CYGWIN__)
 #include <float.h>
@@ -106,6 +109,9 @@ const struct DiscriminationMethodInfo {
 // and the old discrimination
 const float minSignalTime = 0.05f;
 
+// Samples in each piece of a track reduced by one thread
+const size_t parallelSegmentSamples = 1 << 18;
+
 enum WindowTypes {
    WT_RECTANGULAR_HANN = 0, // 2.0.6 behavior, requires 1/2 step
    WT_HANN_RECTANGULAR, // requires 1/2 step
@@ -261,27 +267,61 @@ public:
                 Statistics &statistics, TrackFactory &factory,
                 SelectedTrackListOfKindIterator &iter, double mT0, double mT1);
 
+   static bool CheckParallel(TrackFactory &factory);
+
 private:
+   // The part of one track to process
+   struct TrackRange
+   {
+      int count;
+      WaveTrack *track;
+      sampleCount start;
+      sampleCount len;
+   };
+
+   // A piece of a TrackRange, reduced by one worker of the pool
+   struct Segment
+   {
+      size_t range;
+      sampleCount start;
+      size_t len;
+      FloatVector input;
+      FloatVector output;
+   };
+
    bool ProcessOne(EffectNoiseReduction &effect,
                    Statistics &statistics,
                    TrackFactory &factory,
                    int count, WaveTrack *track,
                    sampleCount start, sampleCount len);
+   bool ProcessParallel(EffectNoiseReduction &effect,
+                        Statistics &statistics,
+                        TrackFactory &factory,
+                        const std::vector<TrackRange> &ranges);
+   bool ProcessSegment(Statistics &statistics,
+                       const TrackRange &range, Segment &segment);
 
    void StartNewTrack();
-   void ProcessSamples(Statistics &statistics,
-      WaveTrack *outputTrack, size_t len, float *buffer);
+   void ProcessSamples(Statistics &statistics, size_t len, float *buffer);
    void FillFirstHistoryWindow();
    void ApplyFreqSmoothing(FloatVector &gains);
    void GatherStatistics(Statistics &statistics);
    inline bool Classify(const Statistics &statistics, int band);
-   void ReduceNoise(const Statistics &statistics, WaveTrack *outputTrack);
+   void ReduceNoise(const Statistics &statistics);
    void RotateHistoryWindows();
    void FinishTrackStatistics(Statistics &statistics);
-   void FinishTrack(Statistics &statistics, WaveTrack *outputTrack);
+   void FinishTrack(Statistics &statistics);
+   void TakeOutput(WaveTrack *outputTrack);
 
 private:
 
+   // Kept to make more workers like this one, for the thread pool
+   const Settings &mSettings;
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+   const double mF0;
+   const double mF1;
+#endif
+
    const bool mDoProfile;
 
    const double mSampleRate;
@@ -323,6 +363,14 @@ private:
    unsigned  mCenter;
    unsigned  mHistoryLen;
 
+   // Samples to process before a segment, and after it, so that its
+   // output is the same as when the whole track is processed at once
+   size_t    mLeadIn;
+   size_t    mLeadOut;
+
+   // Output of ReduceNoise not yet taken
+   FloatVector mOutBuffer;
+
    struct Record
    {
       Record(size_t spectrumSize)
@@ -647,6 +695,7 @@ bool EffectNoiseReduction::Worker::Process
 (EffectNoiseReduction &effect, Statistics &statistics, TrackFactory &factory,
  SelectedTrackListOfKindIterator &iter, double mT0, double mT1)
 {
+   std::vector<TrackRange> ranges;
    int count = 0;
    WaveTrack *track = (WaveTrack *) iter.First();
    while (track) {
@@ -666,16 +715,25 @@ bool EffectNoiseReduction::Worker::Process
       if (t1 > t0) {
          auto start = track->TimeToLongSamples(t0);
          auto end = track->TimeToLongSamples(t1);
-         auto len = end - start;
-
-         if (!ProcessOne(effect, statistics, factory,
-                         count, track, start, len))
-            return false;
+         ranges.push_back({ count, track, start, end - start });
       }
       track = (WaveTrack *) iter.Next();
       ++count;
    }
 
+   // Profiling accumulates into the statistics, so it goes one track at
+   // a time; reduction only reads them, and may use all processors
+   if (!mDoProfile && WorkerPool::GetProcessorCount() > 1) {
+      if (!ProcessParallel(effect, statistics, factory, ranges))
+         return false;
+   }
+   else {
+      for (const auto &range : ranges)
+         if (!ProcessOne(effect, statistics, factory,
+                         range.count, range.track, range.start, range.len))
+            return false;
+   }
+
    if (mDoProfile) {
       if (statistics.mTotalWindows == 0) {
          ::wxMessageBox(_("Selected noise profile is too short."));
@@ -722,7 +780,13 @@ EffectNoiseReduction::Worker::Worker
 , double f0, double f1
 #endif
 )
-: mDoProfile(settings.mDoProfile)
+: mSettings(settings)
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+, mF0(f0)
+, mF1(f1)
+#endif
+
+, mDoProfile(settings.mDoProfile)
 
 , mSampleRate(sampleRate)
 
@@ -793,6 +857,15 @@ EffectNoiseReduction::Worker::Worker
       mHistoryLen = std::max(mNWindowsToExamine, mCenter + nAttackBlocks);
    }
 
+   // A segment's first windows are zero-padded in front, as at the start
+   // of a track.  Their gains differ, and reach later windows through
+   // classification and release, and later samples through overlap-add.
+   // One more release block lets the decay fall below the floor.
+   mLeadIn = mStepSize *
+      (2 * mStepsPerWindow + mNWindowsToExamine + nReleaseBlocks + 1);
+   // Output lags input while the history fills
+   mLeadOut = mStepSize * (mHistoryLen + mStepsPerWindow);
+
    mQueue.resize(mHistoryLen);
    for (unsigned ii = 0; ii < mHistoryLen; ++ii)
       mQueue[ii] = make_movable<Record>(mSpectrumSize);
@@ -907,11 +980,11 @@ void EffectNoiseReduction::Worker::StartNewTrack()
    }
 
    mInSampleCount = 0;
+   mOutBuffer.clear();
 }
 
 void EffectNoiseReduction::Worker::ProcessSamples
-(Statistics &statistics, WaveTrack *outputTrack,
- size_t len, float *buffer)
+(Statistics &statistics, size_t len, float *buffer)
 {
    while (len && mOutStepCount * mStepSize < mInSampleCount) {
       auto avail = std::min(len, mWindowSize - mInWavePos);
@@ -925,7 +998,7 @@ void EffectNoiseReduction::Worker::ProcessSamples
          if (mDoProfile)
             GatherStatistics(statistics);
          else
-            ReduceNoise(statistics, outputTrack);
+            ReduceNoise(statistics);
          ++mOutStepCount;
          RotateHistoryWindows();
 
@@ -1008,8 +1081,7 @@ void EffectNoiseReduction::Worker::FinishTrackStatistics(Statistics &statistics)
    statistics.mTotalWindows = denom;
 }
 
-void EffectNoiseReduction::Worker::FinishTrack
-(Statistics &statistics, WaveTrack *outputTrack)
+void EffectNoiseReduction::Worker::FinishTrack(Statistics &statistics)
 {
    // Keep flushing empty input buffers through the history
    // windows until we've output exactly as many samples as
@@ -1021,7 +1093,16 @@ void EffectNoiseReduction::Worker::FinishTrack
    FloatVector empty(mStepSize);
 
    while (mOutStepCount * mStepSize < mInSampleCount) {
-      ProcessSamples(statistics, outputTrack, mStepSize, &empty[0]);
+      ProcessSamples(statistics, mStepSize, &empty[0]);
+   }
+}
+
+void EffectNoiseReduction::Worker::TakeOutput(WaveTrack *outputTrack)
+{
+   if (!mOutBuffer.empty()) {
+      outputTrack->Append((samplePtr)&mOutBuffer[0], floatSample,
+                          mOutBuffer.size());
+      mOutBuffer.clear();
    }
 }
 
@@ -1131,8 +1212,7 @@ bool EffectNoiseReduction::Worker::Classify(const Statistics &statistics, int ba
    }
 }
 
-void EffectNoiseReduction::Worker::ReduceNoise
-(const Statistics &statistics, WaveTrack *outputTrack)
+void EffectNoiseReduction::Worker::ReduceNoise(const Statistics &statistics)
 {
    // Raise the gain for elements in the center of the sliding history
    // or, if isolating noise, zero out the non-noise
@@ -1269,7 +1349,7 @@ void EffectNoiseReduction::Worker::ReduceNoise
       float *buffer = &mOutOverlapBuffer[0];
       if (mOutStepCount >= 0) {
          // Output the first portion of the overlap buffer, they're done
-         outputTrack->Append((samplePtr)buffer, floatSample, mStepSize);
+         mOutBuffer.insert(mOutBuffer.end(), buffer, buffer + mStepSize);
       }
 
       // Shift the remainder over.
@@ -1308,7 +1388,9 @@ bool EffectNoiseReduction::Worker::ProcessOne
       samplePos += blockSize;
 
       mInSampleCount += blockSize;
-      ProcessSamples(statistics, outputTrack.get(), blockSize, &buffer[0]);
+      ProcessSamples(statistics, blockSize, &buffer[0]);
+      if (outputTrack)
+         TakeOutput(outputTrack.get());
 
       // Update the Progress meter, let user cancel
       bLoopSuccess = 
@@ -1320,8 +1402,10 @@ bool EffectNoiseReduction::Worker::ProcessOne
    if (bLoopSuccess) {
       if (mDoProfile)
          FinishTrackStatistics(statistics);
-      else
-         FinishTrack(statistics, &*outputTrack);
+      else {
+         FinishTrack(statistics);
+         TakeOutput(outputTrack.get());
+      }
    }
 
    if (bLoopSuccess && !mDoProfile) {
@@ -1342,6 +1426,230 @@ bool EffectNoiseReduction::Worker::ProcessOne
    return bLoopSuccess;
 }
 
+// The tracks are cut into segments of about parallelSegmentSamples, and
+// each worker of the pool reduces a segment with its own FFT tables and
+// history, starting mLeadIn samples early and stopping mLeadOut samples
+// late, so that the result matches that of ProcessOne.  The segments are
+// appended to the output tracks in order on this thread, a round at a
+// time, because making block files is not thread-safe.  The workers share
+// the statistics, which reducing noise only reads.
+bool EffectNoiseReduction::Worker::ProcessParallel
+(EffectNoiseReduction &effect, Statistics &statistics,
+ TrackFactory &factory, const std::vector<TrackRange> &ranges)
+{
+   WorkerPool pool{ WorkerPool::GetProcessorCount() };
+
+   std::vector<Segment> segments(2 * pool.GetThreadCount());
+   std::vector<std::unique_ptr<Worker>> workers;
+   for (size_t ii = 0; ii < segments.size(); ++ii)
+      workers.push_back(std::make_unique<Worker>(mSettings, mSampleRate
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+                                                 , mF0, mF1
+#endif
+                                                 ));
+
+   // Segments start on the same step boundaries as the windows of
+   // ProcessOne
+   const size_t segmentLen =
+      std::max<size_t>(1, parallelSegmentSamples / mStepSize) * mStepSize;
+
+   std::atomic<bool> failed{ false };
+   auto process = [&](size_t ii) {
+      auto &segment = segments[ii];
+      if (segment.len == 0)
+         return;
+      try {
+         if (!workers[ii]->ProcessSegment(
+               statistics, ranges[segment.range], segment))
+            failed = true;
+      }
+      catch(...) {
+         failed = true;
+      }
+   };
+
+   WaveTrack::Holder outputTrack;
+   size_t nextRange = 0;
+   sampleCount done = 0;
+   while (true) {
+      // Hand out the next round of segments
+      bool any = false;
+      for (auto &segment : segments) {
+         while (nextRange < ranges.size() && done >= ranges[nextRange].len)
+            ++nextRange, done = 0;
+         if (nextRange == ranges.size()) {
+            segment.len = 0;
+            continue;
+         }
+
+         const auto &range = ranges[nextRange];
+         segment.range = nextRange;
+         segment.start = range.start + done;
+         segment.len = limitSampleBufferSize(segmentLen, range.len - done);
+         done += segment.len;
+         any = true;
+      }
+      if (!any)
+         break;
+
+      pool.ForEach(segments.size(), process);
+      if (failed)
+         return false;
+
+      for (const auto &segment : segments) {
+         if (segment.len == 0)
+            continue;
+
+         const auto &range = ranges[segment.range];
+         if (!outputTrack)
+            outputTrack = factory.NewWaveTrack(
+               range.track->GetSampleFormat(), range.track->GetRate());
+         outputTrack->Append((samplePtr)&segment.output[0], floatSample,
+                             segment.len);
+
+         const auto end = segment.start + segment.len;
+         if (end == range.start + range.len) {
+            // Take the output track and insert it in place of the original
+            // sample data, as in ProcessOne; there is no tail to delete
+            outputTrack->Flush();
+            double t0 = outputTrack->LongSamplesToTime(range.start);
+            double tLen = outputTrack->LongSamplesToTime(range.len);
+            bool bResult = range.track->ClearAndPaste(
+               t0, t0 + tLen, &*outputTrack, true, false);
+            wxASSERT(bResult); // TO DO: Actually handle this.
+            wxUnusedVar(bResult);
+            outputTrack.reset();
+         }
+
+         // Update the Progress meter, let user cancel
+         if (effect.TrackProgress(range.count,
+                                  (end - range.start).as_double() /
+                                  range.len.as_double()))
+            return false;
+      }
+   }
+
+   return true;
+}
+
+bool EffectNoiseReduction::Worker::ProcessSegment
+(Statistics &statistics, const TrackRange &range, Segment &segment)
+{
+   StartNewTrack();
+
+   // Start no earlier than the range, in which case the windows are just
+   // those of ProcessOne, and stop no later
+   const auto segmentEnd = segment.start + segment.len;
+   const auto rangeEnd = range.start + range.len;
+   const auto leadIn =
+      limitSampleBufferSize(mLeadIn, segment.start - range.start);
+   const auto leadOut =
+      limitSampleBufferSize(mLeadOut, rangeEnd - segmentEnd);
+   const auto readStart = segment.start - leadIn;
+   const auto readLen = leadIn + segment.len + leadOut;
+
+   segment.input.resize(readLen);
+   if (!range.track->Get((samplePtr)&segment.input[0], floatSample,
+                         readStart, readLen))
+      return false;
+
+   mInSampleCount = readLen;
+   ProcessSamples(statistics, readLen, &segment.input[0]);
+   if (readStart + readLen == rangeEnd)
+      FinishTrack(statistics);
+
+   if (mOutBuffer.size() < leadIn + segment.len)
+      return false;
+   segment.output.assign(mOutBuffer.begin() + leadIn,
+                         mOutBuffer.begin() + leadIn + segment.len);
+   mOutBuffer.clear();
+   return true;
+}
+
+bool EffectNoiseReduction::CheckParallel(TrackFactory &factory)
+{
+   return Worker::CheckParallel(factory);
+}
+
+// Profiles a quiet noise, then reduces it, under a louder tone, in two
+// copies of one track, one on this thread and one in segments on a pool,
+// and requires the same samples of both.  The track is long enough for
+// several segments and a piece of one.
+bool EffectNoiseReduction::Worker::CheckParallel(TrackFactory &factory)
+{
+   const double rate = 44100.0;
+   const size_t profileLen = 44100;
+   const size_t len = 3 * parallelSegmentSamples + 12345;
+
+   const auto track = factory.NewWaveTrack(floatSample, rate);
+   {
+      FloatVector buffer(len);
+      unsigned seed = 1;
+      for (size_t ii = 0; ii < len; ++ii) {
+         seed = seed * 1664525u + 1013904223u;
+         buffer[ii] = 0.02f * ((seed >> 8) / float(1 << 24) - 0.5f);
+         if (ii >= profileLen)
+            buffer[ii] += 0.5f * sin(2 * M_PI * 440.0 * ii / rate);
+      }
+      track->Append((samplePtr)&buffer[0], floatSample, len);
+      track->Flush();
+   }
+
+   // With the user's settings, as the effect would run
+   Settings settings;
+   Statistics statistics(1 + settings.WindowSize() / 2, rate,
+                         settings.mWindowTypes);
+   EffectNoiseReduction effect;
+
+   settings.mDoProfile = true;
+   if (!Worker(settings, rate
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+               , SelectedRegion::UndefinedFrequency,
+               SelectedRegion::UndefinedFrequency
+#endif
+              ).ProcessOne(effect, statistics, factory, 0, track.get(),
+                           0, profileLen) ||
+       statistics.mTotalWindows == 0)
+      return false;
+
+   settings.mDoProfile = false;
+   const auto serial = track->Duplicate();
+   const auto parallel = track->Duplicate();
+   const auto serialTrack = static_cast<WaveTrack*>(serial.get());
+   const auto parallelTrack = static_cast<WaveTrack*>(parallel.get());
+
+   if (!Worker(settings, rate
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+               , SelectedRegion::UndefinedFrequency,
+               SelectedRegion::UndefinedFrequency
+#endif
+              ).ProcessOne(effect, statistics, factory, 0, serialTrack,
+                           0, len))
+      return false;
+
+   const std::vector<TrackRange> ranges{ { 0, parallelTrack, 0, len } };
+   if (!Worker(settings, rate
+#ifdef EXPERIMENTAL_SPECTRAL_EDITING
+               , SelectedRegion::UndefinedFrequency,
+               SelectedRegion::UndefinedFrequency
+#endif
+              ).ProcessParallel(effect, statistics, factory, ranges))
+      return false;
+
+   if (serialTrack->GetEndTime() != parallelTrack->GetEndTime())
+      return false;
+
+   FloatVector serialSamples(len), parallelSamples(len);
+   if (!serialTrack->Get((samplePtr)&serialSamples[0], floatSample, 0, len) ||
+       !parallelTrack->Get((samplePtr)&parallelSamples[0], floatSample,
+                           0, len))
+      return false;
+
+   // Not only close, but bit for bit the same
+   return memcmp(&serialSamples[0], &parallelSamples[0],
+                 len * sizeof(float)) == 0;
+}
+
 //----------------------------------------------------------------------------
 // EffectNoiseReduction::Dialog
 //----------------------------------------------------------------------------
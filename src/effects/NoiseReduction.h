@@ -46,6 +46,10 @@ public:
    bool CheckWhetherSkipEffect() override;
    bool Process() override;
 
+   /// For tests/NoiseReductionTest: whether reducing noise on a pool of
+   /// threads gives exactly the samples of reducing it on one
+   static bool CheckParallel(TrackFactory &factory);
+
    class Settings;
    class Statistics;
    class Dialog;
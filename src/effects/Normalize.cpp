@@ -18,7 +18,9 @@
 #include "../Audacity.h" // for rint from configwin.h
 #include "Normalize.h"
 
+#include <algorithm>
 #include <math.h>
+#include <vector>
 
 #include <wx/intl.h>
 #include <wx/valgen.h>
@@ -159,6 +161,9 @@ bool EffectNormalize::Process()
    //Iterate over each track
    this->CopyInputTracks(); // Set up mOutputTracks.
    bool bGoodResult = true;
+
+   AnalyseTracks();
+
    SelectedTrackListOfKindIterator iter(Track::Wave, mOutputTracks.get());
    WaveTrack *track = (WaveTrack *) iter.First();
    WaveTrack *prevTrack;
@@ -259,6 +264,9 @@ bool EffectNormalize::Process()
       mCurTrackNum++;
    }
 
+   mStatistics.reset();
+   mStatisticsIndices.clear();
+
    this->ReplaceProcessedTracks(bGoodResult);
    return bGoodResult;
 }
@@ -333,16 +341,72 @@ bool EffectNormalize::TransferDataFromWindow()
 
 // EffectNormalize implementation
 
+// With several tracks, find the peaks and offsets of all of them at once,
+// on several threads.  AnalyseTrack then uses these results.
+void EffectNormalize::AnalyseTracks()
+{
+   mStatistics.reset();
+   mStatisticsIndices.clear();
+
+   SelectedTrackListOfKindIterator iter(Track::Wave, mOutputTracks.get());
+   std::vector<WaveTrack*> tracks;
+   for (Track *t = iter.First(); t; t = iter.Next())
+      tracks.push_back(static_cast<WaveTrack*>(t));
+   if (tracks.size() < 2)
+      return;
+
+   mStatistics = std::make_unique<WaveTrackStatistics>();
+   for (auto track : tracks) {
+      // The same bounds as Process uses
+      double t0 = std::max(mT0, track->GetStartTime());
+      double t1 = std::min(mT1, track->GetEndTime());
+      if (t1 > t0) {
+         if (mGain)
+            WaitForOD(track);
+         mStatisticsIndices[track] = mStatistics->Add(track, t0, t1);
+      }
+   }
+   mStatistics->Compute();
+}
+
+void EffectNormalize::WaitForOD(WaveTrack * track)
+{
+   // Since we need complete summary data, we need to block until the OD tasks are done for this track
+   // TODO: should we restrict the flags to just the relevant block files (for selections)
+   while (track->GetODFlags()) {
+      // update the gui
+      mProgress->Update(0, wxT("Waiting for waveform to finish computing..."));
+      wxMilliSleep(100);
+   }
+}
+
 void EffectNormalize::AnalyseTrack(WaveTrack * track, const wxString &msg)
 {
-   if(mGain) {
-      // Since we need complete summary data, we need to block until the OD tasks are done for this track
-      // TODO: should we restrict the flags to just the relevant block files (for selections)
-      while (track->GetODFlags()) {
-         // update the gui
-         mProgress->Update(0, wxT("Waiting for waveform to finish computing..."));
-         wxMilliSleep(100);
+   if (mStatistics) {
+      auto found = mStatisticsIndices.find(track);
+      if (found != mStatisticsIndices.end() &&
+          (*mStatistics)[found->second].ok) {
+         const auto &range = (*mStatistics)[found->second];
+         if(mGain) {
+            mMin = range.min;
+            mMax = range.max;
+         } else {
+            mMin = -1.0, mMax = 1.0;   // sensible defaults?
+         }
+
+         if(mDC) {
+            mOffset = -range.mean;
+            mMin += mOffset;
+            mMax += mOffset;
+         } else {
+            mOffset = 0.0;
+         }
+         return;
       }
+   }
+
+   if(mGain) {
+      WaitForOD(track);
 
       track->GetMinMax(&mMin, &mMax, mCurT0, mCurT1); // set mMin, mMax.  No progress bar here as it's fast.
    } else {
@@ -370,54 +434,73 @@ bool EffectNormalize::AnalyseDC(WaveTrack * track, const wxString &msg)
    if(!mDC)  // don't do analysis if not doing dc removal
       return(rc);
 
-   //Transform the marker timepoints to samples
-   auto start = track->TimeToLongSamples(mCurT0);
-   auto end = track->TimeToLongSamples(mCurT1);
+   // The blocks keep exact sums of their samples, so the mean needs to read
+   // only the partial blocks at the ends of the selection -- unless some
+   // data are still being loaded on demand.  Gaps between clips don't count,
+   // as the offset is not applied to them.
+   double mean;
+   if (track->GetMean(&mean, mCurT0, mCurT1)) {
+      mOffset = -mean;
+      return rc;
+   }
 
-   //Get the length of the buffer (as double). len is
-   //used simply to calculate a progress meter, so it is easier
-   //to make it a double now than it is to do it later
-   auto len = (end - start).as_double();
+   //Transform the marker timepoints to samples in each clip, leaving out
+   //the gaps between clips as GetMean does
+   struct ClipRange { WaveClip *clip; sampleCount start, end; };
+   std::vector<ClipRange> ranges;
+   double len = 0.0;
+   for (const auto &clip : track->GetClips()) {
+      if (mCurT1 >= clip->GetStartTime() && mCurT0 <= clip->GetEndTime()) {
+         sampleCount clipStart, clipEnd;
+         clip->TimeToSamplesClip(wxMax(mCurT0, clip->GetStartTime()), &clipStart);
+         clip->TimeToSamplesClip(wxMin(mCurT1, clip->GetEndTime()), &clipEnd);
+         if (clipEnd > clipStart) {
+            ranges.push_back(ClipRange{ clip.get(), clipStart, clipEnd });
+            len += (clipEnd - clipStart).as_double();
+         }
+      }
+   }
 
    //Initiate a processing buffer.  This buffer will (most likely)
    //be shorter than the length of the track being processed.
-   float *buffer = new float[track->GetMaxBlockSize()];
+   const auto bufferSize = track->GetMaxBlockSize();
+   float *buffer = new float[bufferSize];
 
    mSum = 0.0; // dc offset inits
    mCount = 0;
 
-   //Go through the track one buffer at a time. s counts which
-   //sample the current buffer starts at.
-   auto s = start;
-   while (s < end) {
-      //Get a block of samples (smaller than the size of the buffer)
-      //Adjust the block size if it is the final block in the track
-      const auto block = limitSampleBufferSize(
-         track->GetBestBlockSize(s),
-         end - s
-      );
-
-      //Get the samples from the track and put them in the buffer
-      track->Get((samplePtr) buffer, floatSample, s, block);
-
-      //Process the buffer.
-      AnalyzeData(buffer, block);
-
-      //Increment s one blockfull of samples
-      s += block;
-
-      //Update the Progress meter
-      if (TrackProgress(mCurTrackNum,
-                        ((s - start).as_double() / len)/2.0, msg)) {
-         rc = false; //lda .. break, not return, so that buffer is deleted
-         break;
+   //Go through each clip one buffer at a time. s counts which
+   //sample of the clip the current buffer starts at.
+   double done = 0.0;
+   for (const auto &range : ranges) {
+      auto s = range.start;
+      while (rc && s < range.end) {
+         //Get a block of samples (smaller than the size of the buffer)
+         //Adjust the block size if it is the final block in the clip
+         const auto block = limitSampleBufferSize(bufferSize, range.end - s);
+
+         //Get the samples from the clip and put them in the buffer
+         range.clip->GetSamples((samplePtr) buffer, floatSample, s, block);
+
+         //Process the buffer.
+         AnalyzeData(buffer, block);
+
+         //Increment s one blockfull of samples
+         s += block;
+         done += block;
+
+         //Update the Progress meter
+         if (TrackProgress(mCurTrackNum, (done / len)/2.0, msg))
+            rc = false; //lda .. break, not return, so that buffer is deleted
       }
    }
 
    //Clean up the buffer
    delete[] buffer;
 
-   mOffset = -mSum / mCount.as_double();  // calculate actual offset (amount that needs to be added on)
+   // calculate actual offset (amount that needs to be added on); none if
+   // the selection is all gaps
+   mOffset = mCount > 0 ? -mSum / mCount.as_double() : 0.0;
 
    //Return true because the effect processing succeeded ... unless cancelled
    return rc;
@@ -18,7 +18,10 @@
 #include <wx/string.h>
 #include <wx/textctrl.h>
 
+#include <map>
+
 #include "Effect.h"
+#include "../WaveTrackStatistics.h"
 
 class ShuttleGui;
 
@@ -57,7 +60,9 @@ private:
    // EffectNormalize implementation
 
    bool ProcessOne(WaveTrack * t, const wxString &msg);
+   void AnalyseTracks();
    void AnalyseTrack(WaveTrack * track, const wxString &msg);
+   void WaitForOD(WaveTrack * track);
    void AnalyzeData(float *buffer, size_t len);
    bool AnalyseDC(WaveTrack * track, const wxString &msg);
    void ProcessData(float *buffer, size_t len);
@@ -81,6 +86,10 @@ private:
    double mSum;
    sampleCount    mCount;
 
+   // Results of AnalyseTracks, and where to find them for each track
+   std::unique_ptr<WaveTrackStatistics> mStatistics;
+   std::map<const WaveTrack*, size_t> mStatisticsIndices;
+
    wxCheckBox *mGainCheckBox;
    wxCheckBox *mDCCheckBox;
    wxTextCtrl *mLevelTextCtrl;
@@ -0,0 +1,244 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  PartitionedConvolver.cpp
+
+*******************************************************************//**
+
+\class PartitionedConvolver
+\brief Convolves channels with a long impulse response in short
+partitions, so that the delay does not grow with the impulse.
+
+  The impulse is cut into P partitions of B samples, and the spectrum of
+each, zero padded to 2B, is computed once.  Each time B samples of input
+have come in, the last 2B samples of input are transformed, and the
+spectra of the last P such transforms, each multiplied by the spectrum
+of the partition as old as it, are summed.  The second half of the
+inverse transform of the sum is the convolution of the last B samples
+with the whole impulse (uniformly partitioned overlap-save).
+
+  So the cost per sample is two transforms of 2B points for each B
+samples, and P complex products per bin, while the delay is B samples.
+
+  With a transform of N points, longer than 2B, an impulse of up to
+N - B + 1 samples is one partition, and the last B samples of each
+inverse transform are the output.  That is plain overlap-save, as for
+processing whole tracks, where the delay does not matter.
+
+  The spectra are kept in the order that InverseRealFFTf takes, with the
+real values at 0 and at half the sample rate in the first two places.
+The spectra of an impulse are an object of their own, which the
+convolver only refers to, so that they can be made on one thread and
+taken up on another, as by the audio thread.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include "PartitionedConvolver.h"
+
+#include <algorithm>
+#include <string.h>
+#include <wx/debug.h>
+
+namespace {
+
+// Transforms buffer, and reorders it into spectrum
+void ToSpectrum(HFFT hFFT, float *buffer, float *spectrum)
+{
+   RealFFTf(buffer, hFFT);
+   spectrum[0] = buffer[0];
+   spectrum[1] = buffer[1];
+   for (size_t i = 1; i < hFFT->Points; i++) {
+      spectrum[2 * i    ] = buffer[hFFT->BitReversed[i]    ];
+      spectrum[2 * i + 1] = buffer[hFFT->BitReversed[i] + 1];
+   }
+}
+
+// Partitions for an impulse of len samples; one if it fits whole
+size_t PartitionsFor(size_t len, size_t partitionSize, size_t fftSize)
+{
+   if (len <= fftSize - partitionSize + 1)
+      return 1;
+   // Partitions after the first must line up with the transforms of input
+   wxASSERT(fftSize >= 2 * partitionSize - 1);
+   return (len + partitionSize - 1) / partitionSize;
+}
+
+}
+
+PartitionedConvolver::Impulse::Impulse(const float *impulse, size_t len,
+                                       size_t partitionSize, size_t fftSize)
+: mLength(len)
+, mPartitionSize(partitionSize)
+, mFFTSize(fftSize ? fftSize : 2 * partitionSize)
+{
+   const auto B = mPartitionSize;
+   const auto N = mFFTSize;
+   mPartitions = PartitionsFor(len, B, N);
+   const auto partitionLength = (mPartitions == 1) ? len : B;
+
+   mSpectra.resize(mPartitions * N);
+   std::vector<float> buffer(N);
+   HFFT hFFT = GetFFT(N);
+
+   for (size_t p = 0; p < mPartitions; p++) {
+      const auto begin = std::min(len, p * partitionLength);
+      const auto count = std::min(len, begin + partitionLength) - begin;
+      std::fill(buffer.begin(), buffer.end(), 0.0f);
+      std::copy(impulse + begin, impulse + begin + count, buffer.begin());
+      ToSpectrum(hFFT, &buffer[0], &mSpectra[p * N]);
+   }
+
+   ReleaseFFT(hFFT);
+}
+
+PartitionedConvolver::PartitionedConvolver(unsigned nChannels,
+                                           size_t partitionSize,
+                                           size_t fftSize)
+: mChannels(0)
+, mPartitionSize(0)
+, mFFTSize(0)
+, hFFT(NULL)
+, mCapacity(0)
+, mCurrent(0)
+, mFill(0)
+{
+   Configure(nChannels, partitionSize, fftSize);
+}
+
+PartitionedConvolver::~PartitionedConvolver()
+{
+   if (hFFT)
+      ReleaseFFT(hFFT);
+}
+
+void PartitionedConvolver::Configure(unsigned nChannels, size_t partitionSize,
+                                     size_t fftSize)
+{
+   if (!fftSize)
+      fftSize = 2 * partitionSize;
+   wxASSERT(partitionSize >= 1 && partitionSize <= fftSize &&
+            (fftSize & (fftSize - 1)) == 0);
+
+   if (fftSize != mFFTSize) {
+      if (hFFT)
+         ReleaseFFT(hFFT);
+      hFFT = GetFFT(fftSize);
+   }
+
+   mChannels = nChannels;
+   mPartitionSize = partitionSize;
+   mFFTSize = fftSize;
+   mFFTBuffer.resize(fftSize);
+   mAccumulator.resize(fftSize);
+   mInput.resize(mChannels * fftSize);
+   mOutput.resize(mChannels * partitionSize);
+
+   // Forget the room for the impulse, so that the state is sized afresh
+   mCapacity = 0;
+   const float identity = 1.0f;
+   SetImpulse(&identity, 1);
+}
+
+void PartitionedConvolver::Reserve(size_t len)
+{
+   const auto partitions = PartitionsFor(len, mPartitionSize, mFFTSize);
+   if (partitions > mCapacity) {
+      mCapacity = partitions;
+      mInputSpectra.resize(mChannels * mCapacity * mFFTSize);
+      Reset();
+   }
+}
+
+void PartitionedConvolver::SetImpulse(const float *impulse, size_t len)
+{
+   SetImpulse(std::make_shared<const Impulse>(
+      impulse, len, mPartitionSize, mFFTSize));
+}
+
+void PartitionedConvolver::SetImpulse(
+   const std::shared_ptr<const Impulse> &impulse)
+{
+   wxASSERT(impulse->mPartitionSize == mPartitionSize &&
+            impulse->mFFTSize == mFFTSize);
+
+   // The spectra of the input are kept for the longest impulse reserved,
+   // so a shorter one leaves them in place, as the input goes on
+   mImpulse = impulse;
+   Reserve(impulse->GetLength());
+}
+
+void PartitionedConvolver::Reset()
+{
+   std::fill(mInput.begin(), mInput.end(), 0.0f);
+   std::fill(mOutput.begin(), mOutput.end(), 0.0f);
+   std::fill(mInputSpectra.begin(), mInputSpectra.end(), 0.0f);
+   mCurrent = 0;
+   mFill = 0;
+}
+
+void PartitionedConvolver::Process(const float *const *in, float *const *out,
+                                   size_t len)
+{
+   const auto B = mPartitionSize;
+   const auto N = mFFTSize;
+
+   for (size_t pos = 0; pos < len;) {
+      const auto count = std::min(B - mFill, len - pos);
+      for (unsigned channel = 0; channel < mChannels; channel++) {
+         // Take the input before giving the output, which may overwrite it
+         memcpy(&mInput[channel * N + N - B + mFill], in[channel] + pos,
+                count * sizeof(float));
+         memcpy(out[channel] + pos, &mOutput[channel * B + mFill],
+                count * sizeof(float));
+      }
+      mFill += count;
+      pos += count;
+
+      if (mFill == B) {
+         for (unsigned channel = 0; channel < mChannels; channel++)
+            ProcessPartition(channel);
+         mCurrent = (mCurrent + 1) % mCapacity;
+         mFill = 0;
+      }
+   }
+}
+
+void PartitionedConvolver::ProcessPartition(unsigned channel)
+{
+   const auto B = mPartitionSize;
+   const auto N = mFFTSize;
+   const auto partitions = mImpulse->mPartitions;
+   float *input = &mInput[channel * N];
+   float *spectra = &mInputSpectra[channel * mCapacity * N];
+
+   std::copy(input, input + N, mFFTBuffer.begin());
+   ToSpectrum(hFFT, &mFFTBuffer[0], spectra + mCurrent * N);
+
+   // Partition p of the impulse meets the input of p partitions ago
+   float *acc = &mAccumulator[0];
+   std::fill(mAccumulator.begin(), mAccumulator.end(), 0.0f);
+   for (size_t p = 0; p < partitions; p++) {
+      const float *x =
+         spectra + ((mCurrent + mCapacity - p) % mCapacity) * N;
+      const float *h = &mImpulse->mSpectra[p * N];
+      // Purely real at 0 and at half the sample rate
+      acc[0] += x[0] * h[0];
+      acc[1] += x[1] * h[1];
+      for (size_t i = 2; i < N; i += 2) {
+         acc[i    ] += x[i] * h[i    ] - x[i + 1] * h[i + 1];
+         acc[i + 1] += x[i] * h[i + 1] + x[i + 1] * h[i    ];
+      }
+   }
+
+   InverseRealFFTf(acc, hFFT);
+   ReorderToTime(hFFT, acc, &mFFTBuffer[0]);
+
+   // The rest wraps around and is discarded
+   std::copy(mFFTBuffer.begin() + N - B, mFFTBuffer.end(),
+             mOutput.begin() + channel * B);
+
+   // Slide the input along by a partition
+   std::copy(input + B, input + N, input);
+}
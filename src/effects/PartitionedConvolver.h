@@ -0,0 +1,117 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  PartitionedConvolver.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_PARTITIONED_CONVOLVER__
+#define __AUDACITY_PARTITIONED_CONVOLVER__
+
+#include <stddef.h>
+#include <vector>
+
+#include "../Audacity.h"
+#include "../MemoryX.h"
+#include "../RealFFTf.h"
+
+/// Convolves one or more channels with a finite impulse response, cut
+/// into partitions of equal length, by overlap-save with FFTs of twice
+/// the partition length.
+///
+/// The output is delayed by one partition, whatever the length of the
+/// impulse, so that long filters can run in realtime with short
+/// partitions.  Process accepts blocks of any length.  The impulse may be
+/// changed between calls of Process, keeping the samples already taken.
+///
+/// A longer FFT may be given instead, for an impulse that fits in one
+/// partition, so that each transform takes in more samples.
+class PartitionedConvolver
+{
+ public:
+   /// The spectra of the partitions of an impulse, made apart from the
+   /// convolvers that use it, so that they can take it up on another
+   /// thread without allocating
+   class Impulse
+   {
+    public:
+      /// partitionSize and fftSize as for the convolvers that will use it
+      Impulse(const float *impulse, size_t len,
+              size_t partitionSize, size_t fftSize = 0);
+
+      size_t GetLength() const { return mLength; }
+      size_t GetPartitionCount() const { return mPartitions; }
+
+    private:
+      friend class PartitionedConvolver;
+
+      size_t mLength;
+      size_t mPartitionSize;
+      size_t mFFTSize;
+      size_t mPartitions;
+      // Each of mFFTSize values in the order that InverseRealFFTf takes
+      std::vector<float> mSpectra;
+   };
+
+   /// Takes in partitionSize samples for each transform of fftSize
+   /// points, which must be a power of two; twice partitionSize if 0
+   PartitionedConvolver(unsigned nChannels = 1, size_t partitionSize = 512,
+                        size_t fftSize = 0);
+   ~PartitionedConvolver();
+
+   PartitionedConvolver(const PartitionedConvolver &) PROHIBITED;
+   PartitionedConvolver &operator= (const PartitionedConvolver &) PROHIBITED;
+
+   /// Sets the impulse to pass the samples unchanged, and clears the state
+   void Configure(unsigned nChannels, size_t partitionSize,
+                  size_t fftSize = 0);
+   unsigned GetChannelCount() const { return mChannels; }
+   size_t GetPartitionSize() const { return mPartitionSize; }
+   size_t GetFFTSize() const { return mFFTSize; }
+
+   /// Makes room in the state for impulses of up to len samples, so that
+   /// taking one up later neither allocates nor clears the state
+   void Reserve(size_t len);
+
+   /// The same impulse applies to every channel.  The state is cleared
+   /// only if the impulse needs more partitions than there is room for.
+   void SetImpulse(const float *impulse, size_t len);
+   /// The same, with spectra made for this partition and FFT size.  Only
+   /// a reference is taken, so within the room reserved this allocates
+   /// nothing, but the last reference to the old impulse may be let go.
+   void SetImpulse(const std::shared_ptr<const Impulse> &impulse);
+   size_t GetImpulseLength() const { return mImpulse->GetLength(); }
+
+   /// The samples by which the output lags the input
+   size_t GetLatency() const { return mPartitionSize; }
+
+   /// Clears the state, as at the start of a track
+   void Reset();
+
+   /// Convolves len samples of each channel.  in and out may be the same.
+   void Process(const float *const *in, float *const *out, size_t len);
+
+ private:
+   void ProcessPartition(unsigned channel);
+
+   unsigned mChannels;
+   size_t mPartitionSize;
+   size_t mFFTSize;
+   HFFT hFFT;
+
+   std::shared_ptr<const Impulse> mImpulse;
+
+   // For each channel, the last mFFTSize samples of input, the output of
+   // the last partition, and the spectra of the last mCapacity transforms
+   // of input, the latest at mCurrent
+   std::vector<float> mInput, mOutput, mInputSpectra;
+   size_t mCapacity;
+   size_t mCurrent;
+   // Samples of the partition in progress, the same for every channel
+   size_t mFill;
+
+   std::vector<float> mFFTBuffer, mAccumulator;
+};
+
+#endif
@@ -22,7 +22,7 @@
   Butterworth, Chebyshev Type I and Type II. Highpass and lowpass filters
   are supported, as are filter orders from 1 to 10.
 
-  The filter is applied using biquads
+  The filter is applied using biquads, by a BiquadCascade
 
 *//****************************************************************//**
 
@@ -217,27 +217,16 @@ unsigned EffectScienFilter::GetAudioOutCount()
 
 bool EffectScienFilter::ProcessInitialize(sampleCount WXUNUSED(totalLen), ChannelNames WXUNUSED(chanMap))
 {
+   mCascade.Configure(1, (mOrder + 1) / 2);
    for (int iPair = 0; iPair < (mOrder + 1) / 2; iPair++)
-   {
-      mpBiquad[iPair].fPrevIn = 0;
-      mpBiquad[iPair].fPrevPrevIn = 0;
-      mpBiquad[iPair].fPrevOut = 0;
-      mpBiquad[iPair].fPrevPrevOut = 0;
-   }
+      mCascade.SetSection(iPair, mpBiquad[iPair]);
 
    return true;
 }
 
 size_t EffectScienFilter::ProcessBlock(float **inBlock, float **outBlock, size_t blockLen)
 {
-   float *ibuf = inBlock[0];
-   for (int iPair = 0; iPair < (mOrder + 1) / 2; iPair++)
-   {
-      mpBiquad[iPair].pfIn = ibuf;
-      mpBiquad[iPair].pfOut = outBlock[0];
-      Biquad_Process(&mpBiquad[iPair], blockLen);
-      ibuf = outBlock[0];
-   }
+   mCascade.Process(inBlock, outBlock, blockLen);
 
    return blockLen;
 }
@@ -25,6 +25,7 @@ Vaughan Johnson (Preview)
 
 #include "../widgets/Ruler.h"
 #include "Biquad.h"
+#include "BiquadCascade.h"
 
 #include "Effect.h"
 
@@ -101,6 +102,8 @@ private:
    int mOrder;
    int mOrderIndex;
    BiquadStruct *mpBiquad;
+   // Applies the biquads when processing
+   BiquadCascade mCascade;
 
    double mdBMax;
    double mdBMin;
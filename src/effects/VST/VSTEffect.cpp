@@ -1357,6 +1357,12 @@ size_t VSTEffect::GetTailSize()
    return 0;
 }
 
+bool VSTEffect::SupportsIndependentBlocks()
+{
+   // Plug-ins may keep state between blocks, and may not be reentrant
+   return false;
+}
+
 bool VSTEffect::IsReady()
 {
    return mReady;
@@ -107,6 +107,7 @@ class VSTEffect final : public wxEvtHandler,
 
    sampleCount GetLatency() override;
    size_t GetTailSize() override;
+   bool SupportsIndependentBlocks() override;
 
    void SetSampleRate(double rate) override;
    size_t SetBlockSize(size_t maxBlockSize) override;
@@ -1237,6 +1237,12 @@ size_t AudioUnitEffect::GetTailSize()
    return tailTime * mSampleRate;
 }
 
+bool AudioUnitEffect::SupportsIndependentBlocks()
+{
+   // Plug-ins may keep state between blocks, and may not be reentrant
+   return false;
+}
+
 bool AudioUnitEffect::IsReady()
 {
    return mReady;
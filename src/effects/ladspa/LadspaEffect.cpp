@@ -916,6 +916,12 @@ size_t LadspaEffect::GetTailSize()
    return 0;
 }
 
+bool LadspaEffect::SupportsIndependentBlocks()
+{
+   // Plug-ins may keep state between blocks, and may not be reentrant
+   return false;
+}
+
 bool LadspaEffect::IsReady()
 {
    return mReady;
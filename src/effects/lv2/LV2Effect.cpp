@@ -785,6 +785,12 @@ size_t LV2Effect::GetTailSize()
    return 0;
 }
 
+bool LV2Effect::SupportsIndependentBlocks()
+{
+   // Plug-ins may keep state between blocks, and may not be reentrant
+   return false;
+}
+
 bool LV2Effect::IsReady()
 {
    return mMaster != NULL;
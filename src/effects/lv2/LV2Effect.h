@@ -133,6 +133,7 @@ public:
 
    sampleCount GetLatency() override;
    size_t GetTailSize() override;
+   bool SupportsIndependentBlocks() override;
 
    bool IsReady() override;
    bool ProcessInitialize(sampleCount totalLen, ChannelNames chanMap = NULL) override;
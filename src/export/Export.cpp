@@ -26,6 +26,32 @@
 \class ExportMixerPanel
 \brief Panel that displays mixing for advanced mixing option.
 
+*//****************************************************************//**
+
+\class ExportJobs
+\brief Runs several exports at once, as ExportMultiple does.
+
+ExportMultiple used to export its files strictly one after another.
+Exporters that can run on several threads at once are now given a few
+files at a time, one per processor.  Each export has its own Mixer and
+encoder, and only reads the tracks.  One ProgressDialog, on the main
+thread, shows the progress of them all.
+
+*//****************************************************************//**
+
+\class ExportProgress
+\brief Reports the progress of an exporter to a dialog, or to its job.
+
+*//****************************************************************//**
+
+\class ExportPipeline
+\brief Mixes for an exporter on another thread.
+
+The exporters used to alternate between mixing a buffer and encoding
+it, so that reading the blocks, resampling and mixing never overlapped
+the compression.  Now a thread runs the Mixer into a small ring of
+buffers, and the exporter encodes each as it is ready.
+
 *//********************************************************************/
 
 #include "../Audacity.h"
@@ -46,6 +72,11 @@
 #include <wx/dcmemory.h>
 #include <wx/window.h>
 
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string.h>
+
 #include "ExportPCM.h"
 #include "ExportMP3.h"
 #include "ExportOGG.h"
@@ -66,9 +97,11 @@
 #include "../Project.h"
 #include "../ShuttleGui.h"
 #include "../WaveTrack.h"
+#include "../WorkerPool.h"
 #include "../widgets/Warning.h"
 #include "../AColor.h"
 #include "../Dependencies.h"
+#include "../widgets/ProgressDialog.h"
 
 //----------------------------------------------------------------------------
 // ExportPlugin
@@ -253,6 +286,386 @@ std::unique_ptr<Mixer> ExportPlugin::CreateMixer(const WaveTrackConstArray &inpu
                   highQuality, mixerSpec);
 }
 
+std::unique_ptr<ExportPipeline> ExportPlugin::CreatePipeline(
+         const WaveTrackConstArray &inputTracks,
+         const TimeTrack *timeTrack,
+         double startTime, double stopTime,
+         unsigned numOutChannels, int outBufferSize, bool outInterleaved,
+         double outRate, sampleFormat outFormat,
+         bool highQuality, MixerSpec *mixerSpec)
+{
+   auto mixer = CreateMixer(inputTracks, timeTrack, startTime, stopTime,
+                            numOutChannels, outBufferSize, outInterleaved,
+                            outRate, outFormat, highQuality, mixerSpec);
+   return std::make_unique<ExportPipeline>(std::move(mixer),
+      numOutChannels, outBufferSize, outInterleaved, outFormat);
+}
+
+//----------------------------------------------------------------------------
+// ExportPipeline
+//----------------------------------------------------------------------------
+
+// Buffers the mixer may get ahead of the encoder
+static const size_t PipelineDepth = 4;
+
+ExportPipeline::ExportPipeline(std::unique_ptr<Mixer> &&mixer,
+                               unsigned numChannels, size_t bufferSize,
+                               bool interleaved, sampleFormat format)
+: mMixer(std::move(mixer))
+, mNumChannels(numChannels)
+, mBufferSize(bufferSize)
+, mInterleaved(interleaved)
+, mFormat(format)
+, mCondition(&mLock)
+, mFilled(0)
+, mStop(false)
+, mCurrent(nullptr)
+, mRead(0)
+, mFinished(false)
+{
+   mStartTime = mMixer->MixGetCurrentTime();
+
+   // Each slot holds all the channels, one after another if not interleaved
+   for (size_t i = 0; i < PipelineDepth; i++) {
+      auto slot = std::make_unique<Slot>();
+      slot->buffer.Allocate(mBufferSize * mNumChannels, mFormat);
+      slot->length = 0;
+      slot->time = mStartTime;
+      mSlots.push_back(std::move(slot));
+   }
+
+   // If the thread can't be started, Process() mixes as it's called
+   mThread = std::make_unique<WorkerThread>([this]{ Produce(); });
+   if (!mThread->Start())
+      mThread.reset();
+}
+
+ExportPipeline::~ExportPipeline()
+{
+   if (mThread) {
+      {
+         ODLocker locker{ &mLock };
+         mStop = true;
+         mCondition.Broadcast();
+      }
+      mThread->Join();
+   }
+}
+
+void ExportPipeline::Fill(Slot &slot)
+{
+   auto len = mMixer->Process(mBufferSize);
+   if (mInterleaved)
+      memcpy(slot.buffer.ptr(), mMixer->GetBuffer(),
+             len * mNumChannels * SAMPLE_SIZE(mFormat));
+   else
+      for (unsigned c = 0; c < mNumChannels; c++)
+         memcpy(slot.buffer.ptr() + c * mBufferSize * SAMPLE_SIZE(mFormat),
+                mMixer->GetBuffer(c), len * SAMPLE_SIZE(mFormat));
+   slot.length = len;
+   slot.time = mMixer->MixGetCurrentTime();
+}
+
+void ExportPipeline::Produce()
+{
+   for (size_t write = 0;; write = (write + 1) % mSlots.size()) {
+      {
+         ODLocker locker{ &mLock };
+         while (!mStop && mFilled == mSlots.size())
+            mCondition.Wait();
+         if (mStop)
+            return;
+      }
+
+      // The consumer doesn't touch a slot until it is counted as filled
+      auto &slot = *mSlots[write];
+      Fill(slot);
+
+      {
+         ODLocker locker{ &mLock };
+         ++mFilled;
+         mCondition.Broadcast();
+      }
+
+      if (slot.length == 0)
+         return;
+   }
+}
+
+size_t ExportPipeline::Process(size_t maxSamples)
+{
+   // The buffers are mixed ahead, all of the size given to the constructor
+   wxASSERT(maxSamples == mBufferSize);
+   wxUnusedVar(maxSamples);
+
+   if (mFinished)
+      return 0;
+
+   if (!mThread) {
+      mCurrent = mSlots[0].get();
+      Fill(*mCurrent);
+   }
+   else {
+      ODLocker locker{ &mLock };
+      // Give back the slot of the last call
+      if (mCurrent) {
+         mCurrent = nullptr;
+         --mFilled;
+         mRead = (mRead + 1) % mSlots.size();
+         mCondition.Broadcast();
+      }
+      while (mFilled == 0)
+         mCondition.Wait();
+      mCurrent = mSlots[mRead].get();
+   }
+
+   if (mCurrent->length == 0)
+      mFinished = true;
+   return mCurrent->length;
+}
+
+samplePtr ExportPipeline::GetBuffer()
+{
+   return mCurrent ? mCurrent->buffer.ptr() : nullptr;
+}
+
+samplePtr ExportPipeline::GetBuffer(int channel)
+{
+   if (!mCurrent)
+      return nullptr;
+   if (mInterleaved)
+      return mCurrent->buffer.ptr();
+   return mCurrent->buffer.ptr() + channel * mBufferSize * SAMPLE_SIZE(mFormat);
+}
+
+double ExportPipeline::MixGetCurrentTime()
+{
+   return mCurrent ? mCurrent->time : mStartTime;
+}
+
+//----------------------------------------------------------------------------
+// ExportJobs
+//----------------------------------------------------------------------------
+
+// The resolution of the progress of a job
+static const int JobProgressScale = 1000;
+
+// How often the main thread shows the progress of the jobs, in milliseconds
+static const unsigned long JobProgressInterval = 50;
+
+struct ExportJobs::Job
+{
+   Job()
+   : progress{ 0 }, request{ eProgressSuccess }, done{ false }
+   , result(eProgressSuccess), holdsSetup(false)
+   {}
+
+   // Lets the next export start setting up
+   void ReleaseSetup()
+   {
+      if (holdsSetup) {
+         holdsSetup = false;
+         owner->mSetupLock.Unlock();
+      }
+   }
+
+   ExportJobs *owner;
+   ExportPlugin *plugin;
+   AudacityProject *project;
+   unsigned channels;
+   wxString fName;
+   bool selectedOnly;
+   double t0;
+   double t1;
+   Tags tags;
+   int subformat;
+
+   // Set by the export, in parts of JobProgressScale
+   std::atomic<int> progress;
+   // Set by the main thread:  eProgressSuccess to go on, or else how to end
+   std::atomic<int> request;
+   std::atomic<bool> done;
+
+   // Read by the main thread when done
+   int result;
+   bool holdsSetup;
+   wxArrayString errors;
+};
+
+// The jobs being exported, by the thread doing each
+static ODLock sCurrentJobsLock;
+static std::map<wxThreadIdType, ExportJobs::Job*> sCurrentJobs;
+
+ExportJobs::ExportJobs()
+{
+}
+
+ExportJobs::~ExportJobs()
+{
+}
+
+void ExportJobs::Add(ExportPlugin *plugin, AudacityProject *project,
+                     unsigned channels, const wxString &fName,
+                     bool selectedOnly, double t0, double t1,
+                     const Tags &tags, int subformat)
+{
+   auto job = std::make_unique<Job>();
+   job->owner = this;
+   job->plugin = plugin;
+   job->project = project;
+   job->channels = channels;
+   job->fName = fName;
+   job->selectedOnly = selectedOnly;
+   job->t0 = t0;
+   job->t1 = t1;
+   job->tags = tags;
+   job->subformat = subformat;
+   mJobs.push_back(std::move(job));
+}
+
+ExportJobs::Job *ExportJobs::Current()
+{
+   ODLocker locker{ &sCurrentJobsLock };
+   auto iter = sCurrentJobs.find(wxThread::GetCurrentId());
+   return iter == sCurrentJobs.end() ? nullptr : iter->second;
+}
+
+void ExportJobs::RunJob(Job &job)
+{
+   // Nothing is written for a job the user stopped before it began
+   if (job.request != eProgressSuccess) {
+      job.result = eProgressCancelled;
+      job.done = true;
+      return;
+   }
+
+   const auto id = wxThread::GetCurrentId();
+   {
+      ODLocker locker{ &sCurrentJobsLock };
+      sCurrentJobs[id] = &job;
+   }
+
+   mSetupLock.Lock();
+   job.holdsSetup = true;
+
+   job.result = job.plugin->Export(job.project, job.channels, job.fName,
+                                   job.selectedOnly, job.t0, job.t1,
+                                   NULL, &job.tags, job.subformat);
+
+   // In case the export failed before it made its ExportProgress
+   job.ReleaseSetup();
+
+   {
+      ODLocker locker{ &sCurrentJobsLock };
+      sCurrentJobs.erase(id);
+   }
+   job.done = true;
+}
+
+std::vector<int> ExportJobs::Run(const wxString &title,
+                                 const wxString &message, size_t nThreads)
+{
+   const size_t count = mJobs.size();
+   std::atomic<size_t> next{ 0 };
+   auto work = [&] {
+      for (size_t ii = next++; ii < count; ii = next++)
+         RunJob(*mJobs[ii]);
+   };
+
+   std::vector< std::unique_ptr<WorkerThread> > threads;
+   nThreads = std::min(std::max<size_t>(1, nThreads), count);
+   for (size_t ii = 0; ii < nThreads; ii++) {
+      auto thread = std::make_unique<WorkerThread>(work);
+      if (thread->Start())
+         threads.push_back(std::move(thread));
+   }
+
+   if (threads.empty()) {
+      // Export one after another here, each with its own dialog
+      for (auto &job : mJobs) {
+         job->result = job->plugin->Export(job->project, job->channels,
+            job->fName, job->selectedOnly, job->t0, job->t1,
+            NULL, &job->tags, job->subformat);
+         if (job->result != eProgressSuccess &&
+             job->result != eProgressStopped)
+            break;
+      }
+   }
+   else {
+      ProgressDialog progress(title, message);
+      int request = eProgressSuccess;
+      while (true) {
+         size_t finished = 0;
+         double done = 0;
+         for (const auto &job : mJobs) {
+            if (job->done) {
+               ++finished;
+               done += JobProgressScale;
+            }
+            else
+               done += job->progress;
+         }
+         if (finished == count)
+            break;
+
+         if (request == eProgressSuccess) {
+            request = progress.Update(done, (double)count * JobProgressScale);
+            if (request != eProgressSuccess)
+               for (auto &job : mJobs)
+                  job->request = request;
+         }
+         wxMilliSleep(JobProgressInterval);
+      }
+
+      for (auto &thread : threads)
+         thread->Join();
+   }
+
+   std::vector<int> results;
+   for (const auto &job : mJobs) {
+      results.push_back(job->result);
+      WX_APPEND_ARRAY(mErrors, job->errors);
+   }
+   return results;
+}
+
+//----------------------------------------------------------------------------
+// ExportProgress
+//----------------------------------------------------------------------------
+
+ExportProgress::ExportProgress(const wxString &title, const wxString &message)
+: mJob(ExportJobs::Current())
+{
+   if (mJob)
+      // The export is set up
+      mJob->ReleaseSetup();
+   else
+      mDialog = std::make_unique<ProgressDialog>(title, message);
+}
+
+ExportProgress::~ExportProgress()
+{
+}
+
+int ExportProgress::Update(double current, double total)
+{
+   if (mDialog)
+      return mDialog->Update(current, total);
+
+   if (total > 0)
+      mJob->progress = std::max(0, std::min(JobProgressScale,
+         (int)(JobProgressScale * current / total)));
+   return mJob->request;
+}
+
+void ExportError(const wxString &message)
+{
+   if (auto job = ExportJobs::Current())
+      job->errors.Add(message);
+   else
+      wxMessageBox(message);
+}
+
 //----------------------------------------------------------------------------
 // Export
 //----------------------------------------------------------------------------
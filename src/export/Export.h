@@ -19,6 +19,7 @@
 #include <wx/simplebook.h>
 #include "../Tags.h"
 #include "../SampleFormat.h"
+#include "../ondemand/ODTaskThread.h"
 #include "../widgets/wxPanelWrapper.h"
 
 #include "FileDialog.h"
@@ -33,6 +34,8 @@ class MixerSpec;
 class TimeTrack;
 class Mixer;
 class WaveTrackConstArray;
+class ProgressDialog;
+class WorkerThread;
 
 class AUDACITY_DLL_API FormatInfo
 {
@@ -50,6 +53,63 @@ class AUDACITY_DLL_API FormatInfo
 
 WX_DECLARE_USER_EXPORTED_OBJARRAY(FormatInfo, FormatInfoArray, AUDACITY_DLL_API);
 
+//----------------------------------------------------------------------------
+// ExportPipeline
+//----------------------------------------------------------------------------
+/// Runs a Mixer on a thread of its own, a few buffers ahead of the encoder,
+/// so that reading and mixing the tracks overlap the encoding.  It is used
+/// in place of the Mixer, with the same calls.
+class AUDACITY_DLL_API ExportPipeline final
+{
+public:
+   ExportPipeline(std::unique_ptr<Mixer> &&mixer,
+                  unsigned numChannels, size_t bufferSize, bool interleaved,
+                  sampleFormat format);
+   ~ExportPipeline();
+
+   /// Waits for the next buffer of mixed samples, and returns its length,
+   /// zero at the end.  maxSamples must be the bufferSize given to the
+   /// constructor.  The buffer of the previous call may be reused.
+   size_t Process(size_t maxSamples);
+
+   samplePtr GetBuffer();
+   samplePtr GetBuffer(int channel);
+
+   /// The mixer's time at the end of the buffer last returned
+   double MixGetCurrentTime();
+
+private:
+   struct Slot
+   {
+      SampleBuffer buffer;
+      size_t length;
+      double time;
+   };
+
+   void Fill(Slot &slot);
+   void Produce();
+
+   const std::unique_ptr<Mixer> mMixer;
+   const unsigned mNumChannels;
+   const size_t mBufferSize;
+   const bool mInterleaved;
+   const sampleFormat mFormat;
+
+   std::vector< std::unique_ptr<Slot> > mSlots;
+   // Guards the next two
+   ODLock mLock;
+   ODCondition mCondition;
+   size_t mFilled;
+   bool mStop;
+   // The slot the consumer has, else null
+   Slot *mCurrent;
+   size_t mRead;
+   bool mFinished;
+   double mStartTime;
+
+   std::unique_ptr<WorkerThread> mThread;
+};
+
 //----------------------------------------------------------------------------
 // ExportPlugin
 //----------------------------------------------------------------------------
@@ -94,6 +154,16 @@ public:
     * of channels in exported file. -1 for unspecified */
    virtual int SetNumExportChannels() { return -1; }
 
+   /** @brief Whether Export can run on several threads at once, for
+    * ExportJobs.  It must then report through ExportProgress and
+    * ExportError, and not show any other dialog.  Called on the main
+    * thread first, so it may ask the user for what the exports will need.
+    * @param project The project to be exported
+    * @param subformat The sub-format that will be exported */
+   virtual bool CanExportConcurrently(AudacityProject *WXUNUSED(project),
+                                      int WXUNUSED(subformat))
+   { return false; }
+
    /** \brief called to export audio into a file.
     *
     * @param selectedOnly Set to true if all tracks should be mixed, to false
@@ -126,11 +196,84 @@ protected:
          double outRate, sampleFormat outFormat,
          bool highQuality = true, MixerSpec *mixerSpec = NULL);
 
+   /// Like CreateMixer, but the mixer runs on another thread
+   std::unique_ptr<ExportPipeline> CreatePipeline(
+         const WaveTrackConstArray &inputTracks,
+         const TimeTrack *timeTrack,
+         double startTime, double stopTime,
+         unsigned numOutChannels, int outBufferSize, bool outInterleaved,
+         double outRate, sampleFormat outFormat,
+         bool highQuality = true, MixerSpec *mixerSpec = NULL);
+
 private:
    FormatInfoArray mFormatInfos;
 };
 
 using ExportPluginArray = std::vector < movable_ptr< ExportPlugin > > ;
+
+//----------------------------------------------------------------------------
+// ExportJobs
+//----------------------------------------------------------------------------
+/// Runs several exports at once, each on a thread of its own, and shows one
+/// progress dialog for them all.
+class AUDACITY_DLL_API ExportJobs final
+{
+public:
+   struct Job;
+
+   ExportJobs();
+   ~ExportJobs();
+
+   /// Adds an export, to be done with the given arguments of
+   /// ExportPlugin::Export.  The plugin must be able to export concurrently.
+   void Add(ExportPlugin *plugin, AudacityProject *project,
+            unsigned channels, const wxString &fName, bool selectedOnly,
+            double t0, double t1, const Tags &tags, int subformat);
+
+   /// Runs the exports, no more than nThreads at once, and returns the
+   /// result of each, in the order they were added
+   std::vector<int> Run(const wxString &title, const wxString &message,
+                        size_t nThreads);
+
+   /// The error messages, from all the exports
+   const wxArrayString &GetErrors() const { return mErrors; }
+
+   /// The export being done on this thread, or null
+   static Job *Current();
+
+private:
+   void RunJob(Job &job);
+
+   std::vector< std::unique_ptr<Job> > mJobs;
+   wxArrayString mErrors;
+
+   // Held by each export until it starts its progress, so that only one
+   // at a time reads the preferences and opens its libraries
+   ODLock mSetupLock;
+};
+
+//----------------------------------------------------------------------------
+// ExportProgress
+//----------------------------------------------------------------------------
+/// Where an exporter reports its progress.  It shows a ProgressDialog,
+/// except in an export done by ExportJobs, which reports to the job.
+class AUDACITY_DLL_API ExportProgress final
+{
+public:
+   ExportProgress(const wxString &title, const wxString &message);
+   ~ExportProgress();
+
+   /// Returns a ProgressResult, like ProgressDialog::Update
+   int Update(double current, double total);
+
+private:
+   ExportJobs::Job *mJob;
+   std::unique_ptr<ProgressDialog> mDialog;
+};
+
+/// Shows an error message of an exporter, or, in an export done by
+/// ExportJobs, keeps it to show when all are done.
+AUDACITY_DLL_API void ExportError(const wxString &message);
 WX_DEFINE_USER_EXPORTED_ARRAY_PTR(wxWindow *, WindowPtrArray, class AUDACITY_DLL_API);
 
 //----------------------------------------------------------------------------
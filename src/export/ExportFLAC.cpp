@@ -182,6 +182,9 @@ public:
    // Required
 
    wxWindow *OptionsCreate(wxWindow *parent, int format);
+   bool CanExportConcurrently(AudacityProject *WXUNUSED(project),
+                              int WXUNUSED(subformat)) override
+   { return true; }
    int Export(AudacityProject *project,
                unsigned channels,
                const wxString &fName,
@@ -194,9 +197,9 @@ public:
 
 private:
 
-   bool GetMetadata(AudacityProject *project, const Tags *tags);
-
-   FLAC__StreamMetadata *mMetadata;
+   // A new object, or null; the caller deletes it.  Not a member, so that
+   // several files can be exported at once
+   FLAC__StreamMetadata *GetMetadata(AudacityProject *project, const Tags *tags);
 };
 
 //----------------------------------------------------------------------------
@@ -243,12 +246,10 @@ int ExportFLAC::Export(AudacityProject *project,
    encoder.set_sample_rate(lrint(rate));
 
    // See note in GetMetadata() about a bug in libflac++ 1.1.2
-   if (!GetMetadata(project, metadata)) {
-      return false;
-   }
+   FLAC__StreamMetadata *flacMetadata = GetMetadata(project, metadata);
 
-   if (mMetadata) {
-      encoder.set_metadata(&mMetadata, 1);
+   if (flacMetadata) {
+      encoder.set_metadata(&flacMetadata, 1);
    }
 
    sampleFormat format;
@@ -285,7 +286,7 @@ int ExportFLAC::Export(AudacityProject *project,
 #else
    wxFFile f;     // will be closed when it goes out of scope
    if (!f.Open(fName, wxT("w+b"))) {
-      wxMessageBox(wxString::Format(_("FLAC export couldn't open %s"), fName.c_str()));
+      ExportError(wxString::Format(_("FLAC export couldn't open %s"), fName.c_str()));
       return false;
    }
 
@@ -294,22 +295,22 @@ int ExportFLAC::Export(AudacityProject *project,
    // libflac can't (under Windows).
    int status = encoder.init(f.fp());
    if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK) {
-      wxMessageBox(wxString::Format(_("FLAC encoder failed to initialize\nStatus: %d"), status));
+      ExportError(wxString::Format(_("FLAC encoder failed to initialize\nStatus: %d"), status));
       return false;
    }
 #endif
 
-   if (mMetadata) {
-      ::FLAC__metadata_object_delete(mMetadata);
+   if (flacMetadata) {
+      ::FLAC__metadata_object_delete(flacMetadata);
    }
 
    const WaveTrackConstArray waveTracks =
       tracks->GetWaveTrackConstArray(selectionOnly, false);
-   auto mixer = CreateMixer(waveTracks,
-                            tracks->GetTimeTrack(),
-                            t0, t1,
-                            numChannels, SAMPLES_PER_RUN, false,
-                            rate, format, true, mixerSpec);
+   auto mixer = CreatePipeline(waveTracks,
+                               tracks->GetTimeTrack(),
+                               t0, t1,
+                               numChannels, SAMPLES_PER_RUN, false,
+                               rate, format, true, mixerSpec);
 
    int i;
    FLAC__int32 **tmpsmplbuf = new FLAC__int32*[numChannels];
@@ -318,7 +319,7 @@ int ExportFLAC::Export(AudacityProject *project,
    }
 
    {
-      ProgressDialog progress(wxFileName(fName).GetName(),
+      ExportProgress progress(wxFileName(fName).GetName(),
          selectionOnly ?
          _("Exporting the selected audio as FLAC") :
          _("Exporting the entire project as FLAC"));
@@ -371,13 +372,16 @@ wxWindow *ExportFLAC::OptionsCreate(wxWindow *parent, int format)
 //      expects that array to be valid until the stream is initialized.
 //
 //      This has been fixed in 1.1.4.
-bool ExportFLAC::GetMetadata(AudacityProject *project, const Tags *tags)
+FLAC__StreamMetadata *ExportFLAC::GetMetadata(AudacityProject *project, const Tags *tags)
 {
    // Retrieve tags if needed
    if (tags == NULL)
       tags = project->GetTags();
 
-   mMetadata = ::FLAC__metadata_object_new(FLAC__METADATA_TYPE_VORBIS_COMMENT);
+   FLAC__StreamMetadata *flacMetadata =
+      ::FLAC__metadata_object_new(FLAC__METADATA_TYPE_VORBIS_COMMENT);
+   if (!flacMetadata)
+      return NULL;
 
    wxString n;
    for (const auto &pair : tags->GetRange()) {
@@ -388,12 +392,12 @@ bool ExportFLAC::GetMetadata(AudacityProject *project, const Tags *tags)
       }
       FLAC::Metadata::VorbisComment::Entry entry(n.mb_str(wxConvUTF8),
                                                  v.mb_str(wxConvUTF8));
-      ::FLAC__metadata_object_vorbiscomment_append_comment(mMetadata,
+      ::FLAC__metadata_object_vorbiscomment_append_comment(flacMetadata,
                                                            entry.get_entry(),
                                                            true);
    }
 
-   return true;
+   return flacMetadata;
 }
 
 movable_ptr<ExportPlugin> New_ExportFLAC()
@@ -1583,6 +1583,7 @@ public:
 
    ExportMP3();
    bool CheckFileName(wxFileName & filename, int format);
+   bool CanExportConcurrently(AudacityProject *project, int subformat) override;
 
    // Required
 
@@ -1638,6 +1639,36 @@ bool ExportMP3::CheckFileName(wxFileName & WXUNUSED(filename), int WXUNUSED(form
    return true;
 }
 
+bool ExportMP3::CanExportConcurrently(AudacityProject *project, int subformat)
+{
+   // Find the library here, where the user can be asked for it
+   wxFileName unused;
+   if (!CheckFileName(unused, subformat))
+      return false;
+
+   // Likewise, each export would ask about a rate the encoder won't take
+   int brate;
+   int rmode;
+   gPrefs->Read(wxT("/FileFormats/MP3Bitrate"), &brate, 128);
+   gPrefs->Read(wxT("/FileFormats/MP3RateMode"), &rmode, MODE_CBR);
+
+   int highrate = 48000;
+   int lowrate = 8000;
+   if (rmode != MODE_SET && rmode != MODE_VBR) {
+      int bitrate = FindValue(fixRates, WXSIZEOF(fixRates), brate, 128);
+      if (bitrate > 160) {
+         lowrate = 32000;
+      }
+      else if (bitrate < 32 || bitrate == 144) {
+         highrate = 24000;
+      }
+   }
+
+   int rate = lrint(project->GetRate());
+   return !(FindName(sampRates, WXSIZEOF(sampRates), rate).IsEmpty() ||
+      (rate < lowrate) || (rate > highrate));
+}
+
 int ExportMP3::SetNumExportChannels()
 {
    bool mono;
@@ -1666,7 +1697,7 @@ int ExportMP3::Export(AudacityProject *project,
 
 #ifdef DISABLE_DYNAMIC_LOADING_LAME
    if (!exporter.InitLibrary(wxT(""))) {
-      wxMessageBox(_("Could not initialize MP3 encoding library!"));
+      ExportError(_("Could not initialize MP3 encoding library!"));
       gPrefs->Write(wxT("/MP3/MP3LibPath"), wxString(wxT("")));
       gPrefs->Flush();
 
@@ -1674,7 +1705,7 @@ int ExportMP3::Export(AudacityProject *project,
    }
 #else
    if (!exporter.LoadLibrary(parent, MP3Exporter::Maybe)) {
-      wxMessageBox(_("Could not open MP3 encoding library!"));
+      ExportError(_("Could not open MP3 encoding library!"));
       gPrefs->Write(wxT("/MP3/MP3LibPath"), wxString(wxT("")));
       gPrefs->Flush();
 
@@ -1682,7 +1713,7 @@ int ExportMP3::Export(AudacityProject *project,
    }
 
    if (!exporter.ValidLibraryLoaded()) {
-      wxMessageBox(_("Not a valid or supported MP3 encoding library!"));
+      ExportError(_("Not a valid or supported MP3 encoding library!"));
       gPrefs->Write(wxT("/MP3/MP3LibPath"), wxString(wxT("")));
       gPrefs->Flush();
 
@@ -1766,7 +1797,7 @@ int ExportMP3::Export(AudacityProject *project,
 
    auto inSamples = exporter.InitializeStream(channels, rate);
    if (((int)inSamples) < 0) {
-      wxMessageBox(_("Unable to initialize MP3 stream"));
+      ExportError(_("Unable to initialize MP3 stream"));
       return false;
    }
 
@@ -1777,7 +1808,7 @@ int ExportMP3::Export(AudacityProject *project,
    // Open file for writing
    wxFFile outFile(fName, wxT("w+b"));
    if (!outFile.IsOpened()) {
-      wxMessageBox(_("Unable to open target file for writing"));
+      ExportError(_("Unable to open target file for writing"));
       return false;
    }
 
@@ -1800,7 +1831,7 @@ int ExportMP3::Export(AudacityProject *project,
    const WaveTrackConstArray waveTracks =
       tracks->GetWaveTrackConstArray(selectionOnly, false);
    {
-      auto mixer = CreateMixer(waveTracks,
+      auto mixer = CreatePipeline(waveTracks,
          tracks->GetTimeTrack(),
          t0, t1,
          channels, inSamples, true,
@@ -1826,7 +1857,7 @@ int ExportMP3::Export(AudacityProject *project,
             brate);
       }
 
-      ProgressDialog progress(wxFileName(fName).GetName(), title);
+      ExportProgress progress(wxFileName(fName).GetName(), title);
 
       while (updateResult == eProgressSuccess) {
          auto blockLen = mixer->Process(inSamples);
@@ -1857,7 +1888,7 @@ int ExportMP3::Export(AudacityProject *project,
          if (bytes < 0) {
             wxString msg;
             msg.Printf(_("Error %ld returned from MP3 encoder"), bytes);
-            wxMessageBox(msg);
+            ExportError(msg);
             break;
          }
 
@@ -49,6 +49,7 @@
 #include "../ShuttleGui.h"
 #include "../Tags.h"
 #include "../WaveTrack.h"
+#include "../WorkerPool.h"
 #include "../widgets/HelpSystem.h"
 
 
@@ -744,6 +745,56 @@ int ExportMultiple::ExportMultipleByLabel(bool byName,
    int ok = eProgressSuccess;   // did it work?
    int count = 0; // count the number of sucessful runs
    ExportKit activeSetting;  // pointer to the settings in use for this export
+
+   /* If the format allows, export several files at once, each from the
+    * same tracks.  The names are all found first, so they are the same as
+    * they would be one file after another */
+   if (numFiles > 1 &&
+       mPlugins[mPluginIndex]->CanExportConcurrently(mProject, mSubFormatIndex)) {
+      ExportJobs jobs;
+      // No file exists yet when the names are found, so that a name like
+      // "a-2" might be given twice; GetExportName checks against names too
+      wxArrayString names;
+      for (count = 0; count < numFiles; count++) {
+         activeSetting = exportSettings[count];
+         if( activeSetting.destfile.GetName().IsEmpty() )
+            continue;
+
+         wxFileName name;
+         if (!GetExportName(activeSetting.destfile, name, &names)) {
+            ok = false;
+            break;
+         }
+         jobs.Add(mPlugins[mPluginIndex].get(), mProject, channels,
+                  names.Last(), false, activeSetting.t0, activeSetting.t1,
+                  activeSetting.filetags, mSubFormatIndex);
+      }
+
+      auto results = jobs.Run(_("Export Multiple"),
+         wxString::Format(_("Exporting %lld files"), (long long)names.GetCount()),
+         WorkerPool::GetProcessorCount());
+
+      for (size_t i = 0; i < results.size(); i++) {
+         if (results[i] == eProgressSuccess || results[i] == eProgressStopped)
+            mExported.Add(names[i]);
+         if (ok == eProgressSuccess)
+            ok = results[i];
+      }
+
+      const auto &errors = jobs.GetErrors();
+      if (!errors.IsEmpty()) {
+         wxString msg;
+         for (size_t i = 0; i < errors.GetCount(); i++)
+            msg += errors[i] + wxT("\n");
+         wxMessageBox(msg);
+      }
+
+      Refresh();
+      Update();
+
+      return ok;
+   }
+
    /* Go round again and do the exporting (so this run is slow but
     * non-interactive) */
    for (count = 0; count < numFiles; count++) {
@@ -958,20 +1009,8 @@ int ExportMultiple::DoExport(unsigned channels,
    if (selectedOnly) wxLogDebug(wxT("Selected Region Only"));
    else wxLogDebug(wxT("Whole Project"));
 
-   if (mOverwrite->GetValue()) {
-      // Make sure we don't overwrite (corrupt) alias files
-      if (!mProject->GetDirManager()->EnsureSafeFilename(inName)) {
-         return false;
-      }
-      name = inName;
-   }
-   else {
-      name = inName;
-      int i = 2;
-      wxString base(name.GetName());
-      while (name.FileExists()) {
-         name.SetName(wxString::Format(wxT("%s-%d"), base.c_str(), i++));
-      }
+   if (!GetExportName(inName, name)) {
+      return false;
    }
 
    // Call the format export routine
@@ -996,6 +1035,36 @@ int ExportMultiple::DoExport(unsigned channels,
    return success;
 }
 
+bool ExportMultiple::GetExportName(const wxFileName &inName, wxFileName &name,
+                                   wxArrayString *assigned)
+{
+   auto taken = [&] {
+      return name.FileExists() ||
+         (assigned && assigned->Index(name.GetFullPath(), false) != wxNOT_FOUND);
+   };
+
+   if (mOverwrite->GetValue()) {
+      // Make sure we don't overwrite (corrupt) alias files
+      if (!mProject->GetDirManager()->EnsureSafeFilename(inName)) {
+         return false;
+      }
+      name = inName;
+   }
+   else {
+      name = inName;
+      int i = 2;
+      wxString base(name.GetName());
+      while (taken()) {
+         name.SetName(wxString::Format(wxT("%s-%d"), base.c_str(), i++));
+      }
+   }
+
+   if (assigned)
+      assigned->Add(name.GetFullPath());
+
+   return true;
+}
+
 wxString ExportMultiple::MakeFileName(const wxString &input)
 {
    wxString newname = input; // name we are generating
@@ -80,6 +80,18 @@ private:
                  double t0,
                  double t1,
                  const Tags &tags);
+   /** Find the name of one file of an export multiple set
+    *
+    * @param inName The name wanted
+    * @param name Set to inName, or, if files are not to be overwritten, to
+    * the first of inName-2, inName-3... that doesn't exist
+    * @param assigned If not null, the full paths of the files of this set
+    * named already, but maybe not yet written, which name must not be
+    * either; name is added to them
+    * @return false if the file must not be written
+    */
+   bool GetExportName(const wxFileName &inName, wxFileName &name,
+                      wxArrayString *assigned = NULL);
    /** \brief Takes an arbitrary text string and converts it to a form that can
     * be used as a file name, if necessary prompting the user to edit the file
     * name produced */
@@ -131,6 +131,9 @@ public:
 
    // Required
    wxWindow *OptionsCreate(wxWindow *parent, int format) override;
+   bool CanExportConcurrently(AudacityProject *WXUNUSED(project),
+                              int WXUNUSED(subformat)) override
+   { return true; }
 
    int Export(AudacityProject *project,
                unsigned channels,
@@ -179,7 +182,7 @@ int ExportOGG::Export(AudacityProject *project,
    FileIO outFile(fName, FileIO::Output);
 
    if (!outFile.IsOpened()) {
-      wxMessageBox(_("Unable to open target file for writing"));
+      ExportError(_("Unable to open target file for writing"));
       return false;
    }
 
@@ -242,13 +245,13 @@ int ExportOGG::Export(AudacityProject *project,
    const WaveTrackConstArray waveTracks =
       tracks->GetWaveTrackConstArray(selectionOnly, false);
    {
-      auto mixer = CreateMixer(waveTracks,
+      auto mixer = CreatePipeline(waveTracks,
          tracks->GetTimeTrack(),
          t0, t1,
          numChannels, SAMPLES_PER_RUN, false,
          rate, floatSample, true, mixerSpec);
 
-      ProgressDialog progress(wxFileName(fName).GetName(),
+      ExportProgress progress(wxFileName(fName).GetName(),
          selectionOnly ?
          _("Exporting the selected audio as Ogg Vorbis") :
          _("Exporting the entire project as Ogg Vorbis"));
@@ -313,6 +313,9 @@ public:
    // Required
 
    wxWindow *OptionsCreate(wxWindow *parent, int format);
+   bool CanExportConcurrently(AudacityProject *WXUNUSED(project),
+                              int WXUNUSED(subformat)) override
+   { return true; }
    int Export(AudacityProject *project,
                unsigned channels,
                const wxString &fName,
@@ -435,7 +438,7 @@ int ExportPCM::Export(AudacityProject *project,
       if (!sf_format_check(&info))
          info.format = (info.format & SF_FORMAT_TYPEMASK);
       if (!sf_format_check(&info)) {
-         wxMessageBox(_("Cannot export audio in this format."));
+         ExportError(_("Cannot export audio in this format."));
          return false;
       }
 
@@ -449,8 +452,8 @@ int ExportPCM::Export(AudacityProject *project,
       }
 
       if (!sf) {
-         wxMessageBox(wxString::Format(_("Cannot export audio to %s"),
-                                       fName.c_str()));
+         ExportError(wxString::Format(_("Cannot export audio to %s"),
+                                      fName.c_str()));
          return false;
       }
       // Retrieve tags if not given a set
@@ -478,13 +481,13 @@ int ExportPCM::Export(AudacityProject *project,
       tracks->GetWaveTrackConstArray(selectionOnly, false);
       {
          wxASSERT(info.channels >= 0);
-         auto mixer = CreateMixer(waveTracks,
-                                  tracks->GetTimeTrack(),
-                                  t0, t1,
-                                  info.channels, maxBlockLen, true,
-                                  rate, format, true, mixerSpec);
+         auto mixer = CreatePipeline(waveTracks,
+                                     tracks->GetTimeTrack(),
+                                     t0, t1,
+                                     info.channels, maxBlockLen, true,
+                                     rate, format, true, mixerSpec);
 
-         ProgressDialog progress(wxFileName(fName).GetName(),
+         ExportProgress progress(wxFileName(fName).GetName(),
                                  selectionOnly ?
                                  wxString::Format(_("Exporting the selected audio as %s"),
                                                   formatStr.c_str()) :
@@ -508,13 +511,13 @@ int ExportPCM::Export(AudacityProject *project,
             if (samplesWritten != numSamples) {
                char buffer2[1000];
                sf_error_str(sf.get(), buffer2, 1000);
-               wxMessageBox(wxString::Format(
-                                             /* i18n-hint: %s will be the error message from libsndfile, which
-                                              * is usually something unhelpful (and untranslated) like "system
-                                              * error" */
-                                             _("Error while writing %s file (disk full?).\nLibsndfile says \"%s\""),
-                                             formatStr.c_str(),
-                                             wxString::FromAscii(buffer2).c_str()));
+               ExportError(wxString::Format(
+                                            /* i18n-hint: %s will be the error message from libsndfile, which
+                                             * is usually something unhelpful (and untranslated) like "system
+                                             * error" */
+                                            _("Error while writing %s file (disk full?).\nLibsndfile says \"%s\""),
+                                            formatStr.c_str(),
+                                            wxString::FromAscii(buffer2).c_str()));
                break;
             }
             
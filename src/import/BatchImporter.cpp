@@ -0,0 +1,178 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BatchImporter.cpp
+
+*******************************************************************//**
+
+\class BatchImporter
+\brief Imports several files at once, as when many are chosen in the
+Import dialog or dropped on a project.
+
+The files are taken in windows of a few dozen, so that not too many are
+open at once.  For each window, the main thread opens the files and
+lets their ImportFileHandles prepare: ask the user any questions and
+make the tracks.  The handles that can run their Import off the main
+thread (PCM and FLAC) are then run on the threads of a WorkerPool, while
+the main thread shows one progress dialog for them all.  Finally the
+main thread reads the metadata of each file and hands the results to
+the caller in the order of the files, with the files that could not be
+imported this way marked for the caller to import as usual.
+
+Cancelling stops the files still being decoded and those not yet begun,
+but the files that were already complete are kept, as they would have
+been if imported one after another.
+
+Within one file, the decoding already overlaps the writing of the block
+files, which the DirManager's WriteBehindQueue does on other threads.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include "BatchImporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <wx/intl.h>
+#include <wx/utils.h>
+
+#include "Import.h"
+#include "ImportPlugin.h"
+#include "../Project.h"
+#include "../Tags.h"
+#include "../WaveTrack.h"
+#include "../WorkerPool.h"
+#include "../widgets/ProgressDialog.h"
+
+namespace {
+
+// Files open at once
+enum { FilesAtOnce = 32 };
+
+// Milliseconds between updates of the progress dialog
+enum { ProgressInterval = 50 };
+
+struct Entry {
+   std::unique_ptr<ImportFileHandle> handle;
+   TrackHolders tracks;
+   int result;
+   std::atomic<float> fraction;
+};
+
+}
+
+BatchImporter::BatchImporter(TrackFactory *trackFactory)
+: mTrackFactory(trackFactory)
+{
+}
+
+BatchImporter::~BatchImporter()
+{
+}
+
+void BatchImporter::Import(const wxArrayString &fileNames, const Callback &done)
+{
+   auto &importer = Importer::Get();
+   AudacityProject *pProj = GetActiveProject();
+
+   WorkerPool pool{ std::min<size_t>(WorkerPool::GetProcessorCount(),
+                                     FilesAtOnce) };
+
+   std::atomic<bool> cancelled(false);
+
+   for (size_t first = 0; first < fileNames.size(); first += FilesAtOnce) {
+      const size_t count =
+         std::min<size_t>(FilesAtOnce, fileNames.size() - first);
+
+      std::vector<Entry> entries(count);
+      std::vector<size_t> concurrent;
+
+      pProj->mbBusyImporting = true;
+
+      // Open and prepare the files here, where dialogs may be shown
+      for (size_t ii = 0; ii < count; ++ii) {
+         auto &entry = entries[ii];
+         entry.result = eProgressFailed;
+         entry.fraction = 0.0f;
+         if (cancelled)
+            continue;
+
+         entry.handle = importer.Open(fileNames[first + ii]);
+         auto progress = [&entry, &cancelled](double fraction){
+            entry.fraction = fraction;
+            return !cancelled;
+         };
+         if (entry.handle &&
+             entry.handle->PrepareConcurrentImport(mTrackFactory, progress))
+            concurrent.push_back(ii);
+         else
+            entry.handle.reset();
+      }
+
+      if (!concurrent.empty()) {
+         std::atomic<bool> finished(false);
+         auto body = [&]{
+            pool.ForEach(concurrent.size(), [&](size_t jj){
+               auto &entry = entries[concurrent[jj]];
+               if (cancelled)
+                  entry.result = eProgressCancelled;
+               else
+                  entry.result =
+                     entry.handle->Import(mTrackFactory, entry.tracks, nullptr);
+            });
+            finished = true;
+         };
+
+         WorkerThread thread{ body };
+         if (thread.Start()) {
+            wxString title;
+            title.Printf(_("Importing %d files"), (int)concurrent.size());
+            ProgressDialog progress(title, wxEmptyString, pdlgHideStopButton);
+
+            while (!finished) {
+               wxMilliSleep(ProgressInterval);
+               double sum = 0.0;
+               for (auto ii : concurrent)
+                  sum += entries[ii].fraction;
+               if (!cancelled &&
+                   progress.Update(sum / concurrent.size()) == eProgressCancelled)
+                  cancelled = true;
+            }
+            thread.Join();
+         }
+         else
+            // Do it all here, without progress
+            body();
+      }
+
+      // Read the metadata here too, then let the files go before any are
+      // imported again by the caller
+      std::vector<std::unique_ptr<Tags>> tags(count);
+      for (auto ii : concurrent) {
+         auto &entry = entries[ii];
+         if ((entry.result == eProgressSuccess ||
+              entry.result == eProgressStopped) && !entry.tracks.empty()) {
+            tags[ii] = std::make_unique<Tags>();
+            entry.handle->ImportTags(tags[ii].get());
+         }
+         entry.handle.reset();
+      }
+
+      pProj->mbBusyImporting = false;
+
+      for (size_t ii = 0; ii < count; ++ii) {
+         auto &entry = entries[ii];
+         const auto &fileName = fileNames[first + ii];
+         if (tags[ii])
+            // Complete, even if the rest were cancelled meanwhile
+            done(fileName, Imported, entry.tracks, tags[ii].get());
+         else if (cancelled || entry.result == eProgressCancelled)
+            done(fileName, Cancelled, entry.tracks, nullptr);
+         else
+            // Not imported here, or failed; the usual way will try the
+            // other importers, and report any error
+            done(fileName, Deferred, entry.tracks, nullptr);
+      }
+   }
+}
@@ -0,0 +1,54 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BatchImporter.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_BATCH_IMPORTER__
+#define __AUDACITY_BATCH_IMPORTER__
+
+#include "../MemoryX.h"
+#include <functional>
+#include <wx/arrstr.h>
+#include <wx/string.h>
+
+#include "ImportRaw.h" // defines TrackHolders
+
+class Tags;
+class TrackFactory;
+
+/// Imports several files at once, decoding them on a pool of threads.
+/// Files whose importers can't be run off the main thread are left for
+/// the caller to import as usual, in their turn.
+class BatchImporter final
+{
+ public:
+   enum Outcome {
+      // The tracks and tags are given
+      Imported,
+      // The caller should import the file by Importer::Import
+      Deferred,
+      // The user cancelled before the file was complete
+      Cancelled,
+   };
+
+   /// Called on the main thread for each file, in the order given.  tracks
+   /// may be moved from; tags holds the file's metadata only.
+   using Callback = std::function< void(const wxString &fileName,
+      Outcome outcome, TrackHolders &tracks, const Tags *tags) >;
+
+   explicit BatchImporter(TrackFactory *trackFactory);
+   ~BatchImporter();
+
+   BatchImporter(const BatchImporter&) PROHIBITED;
+   BatchImporter &operator= (const BatchImporter&) PROHIBITED;
+
+   void Import(const wxArrayString &fileNames, const Callback &done);
+
+ private:
+   TrackFactory *mTrackFactory;
+};
+
+#endif
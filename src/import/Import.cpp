@@ -328,26 +328,13 @@ movable_ptr<ExtImportItem> Importer::CreateDefaultImportItem()
    return new_item;
 }
 
-// returns number of tracks imported
-bool Importer::Import(const wxString &fName,
-                     TrackFactory *trackFactory,
-                     TrackHolders &tracks,
-                     Tags *tags,
-                     wxString &errorMessage)
+Importer::ImportPluginPtrs Importer::GetImportPlugins(const wxString &fName)
 {
-   AudacityProject *pProj = GetActiveProject();
-   pProj->mbBusyImporting = true;
-
    wxString extension = fName.AfterLast(wxT('.'));
 
-   using ImportPluginPtrs = std::vector< ImportPlugin* >;
-
    // This list is used to call plugins in correct order
    ImportPluginPtrs importPlugins;
 
-   // This list is used to remember plugins that should have been compatible with the file.
-   ImportPluginPtrs compatiblePlugins;
-
    // If user explicitly selected a filter,
    // then we should try importing via corresponding plugin first
    wxString type = gPrefs->Read(wxT("/LastOpenType"),wxT(""));
@@ -493,6 +480,46 @@ bool Importer::Import(const wxString &fName,
       }
    }
 
+   return importPlugins;
+}
+
+std::unique_ptr<ImportFileHandle> Importer::Open(const wxString &fName)
+{
+   for (const auto plugin : GetImportPlugins(fName))
+   {
+      auto inFile = plugin->Open(fName);
+      if ( (inFile != NULL) && (inFile->GetStreamCount() > 0) )
+      {
+         // A choice of streams must be made by Import
+         if (inFile->GetStreamCount() > 1)
+            return {};
+
+         inFile->SetStreamUsage(0,TRUE);
+         return inFile;
+      }
+   }
+
+   return {};
+}
+
+// returns number of tracks imported
+bool Importer::Import(const wxString &fName,
+                     TrackFactory *trackFactory,
+                     TrackHolders &tracks,
+                     Tags *tags,
+                     wxString &errorMessage)
+{
+   AudacityProject *pProj = GetActiveProject();
+   pProj->mbBusyImporting = true;
+
+   wxString extension = fName.AfterLast(wxT('.'));
+
+   // This list is used to call plugins in correct order
+   ImportPluginPtrs importPlugins = GetImportPlugins(fName);
+
+   // This list is used to remember plugins that should have been compatible with the file.
+   ImportPluginPtrs compatiblePlugins;
+
    // Try the import plugins, in the permuted sequences just determined
    for (const auto plugin : importPlugins)
    {
@@ -144,7 +144,20 @@ public:
               Tags *tags,
               wxString &errorMessage);
 
+   /**
+    * Opens the file with the first plugin, in the order Import would try
+    * them, that recognizes it, for importing without asking which streams
+    * to import.  Returns null if none does, or if the file has more than
+    * one stream.
+    */
+   std::unique_ptr<ImportFileHandle> Open(const wxString &fName);
+
 private:
+   using ImportPluginPtrs = std::vector< ImportPlugin* >;
+
+   // The plugins to try for the file, in order
+   ImportPluginPtrs GetImportPlugins(const wxString &fName);
+
    static Importer mInstance;
 
    ExtImportItems mExtImportItems;
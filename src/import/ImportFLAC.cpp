@@ -157,6 +157,10 @@ public:
    int Import(TrackFactory *trackFactory, TrackHolders &outTracks,
               Tags *tags) override;
 
+   bool PrepareConcurrentImport(TrackFactory *trackFactory,
+                                const ProgressCallback &progress) override;
+   void ImportTags(Tags *tags) override;
+
    wxInt32 GetStreamCount(){ return 1; }
 
    const wxArrayString &GetStreamInfo() override
@@ -168,6 +172,8 @@ public:
    void SetStreamUsage(wxInt32 WXUNUSED(StreamID), bool WXUNUSED(Use)){}
 
 private:
+   TrackHolders MakeChannels(TrackFactory *trackFactory);
+
    sampleFormat          mFormat;
    std::unique_ptr<MyFLACFile> mFile;
    wxFFile               mHandle;
@@ -275,7 +281,7 @@ FLAC__StreamDecoderWriteStatus MyFLACFile::write_callback(const FLAC__Frame *fra
 
    mFile->mSamplesDone += frame->header.blocksize;
 
-   mFile->mUpdateResult = mFile->mProgress->Update((wxULongLong_t) mFile->mSamplesDone, mFile->mNumSamples != 0 ? (wxULongLong_t)mFile->mNumSamples : 1);
+   mFile->mUpdateResult = mFile->UpdateProgress((wxULongLong_t) mFile->mSamplesDone, mFile->mNumSamples != 0 ? (wxULongLong_t)mFile->mNumSamples : 1);
    if (mFile->mUpdateResult != eProgressSuccess)
    {
       return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
@@ -438,19 +444,11 @@ auto FLACImportFileHandle::GetFileUncompressedBytes() -> ByteCount
 }
 
 
-int FLACImportFileHandle::Import(TrackFactory *trackFactory,
-                                 TrackHolders &outTracks,
-                                 Tags *tags)
+TrackHolders FLACImportFileHandle::MakeChannels(TrackFactory *trackFactory)
 {
-   outTracks.clear();
-
-   wxASSERT(mStreamInfoDone);
-
-   CreateProgress();
+   TrackHolders channels(mNumChannels);
 
-   mChannels.resize(mNumChannels);
-
-   auto iter = mChannels.begin();
+   auto iter = channels.begin();
    for (int c = 0; c < mNumChannels; ++iter, ++c) {
       *iter = trackFactory->NewWaveTrack(mFormat, mSampleRate);
 
@@ -470,6 +468,38 @@ int FLACImportFileHandle::Import(TrackFactory *trackFactory,
       }
    }
 
+   return channels;
+}
+
+bool FLACImportFileHandle::PrepareConcurrentImport(TrackFactory *trackFactory,
+                                                   const ProgressCallback &progress)
+{
+#ifdef EXPERIMENTAL_OD_FLAC
+   // The on-demand tasks must be added on the main thread
+   return false;
+#else
+   wxASSERT(mStreamInfoDone);
+
+   // Tracks are made on the main thread; only decoding is left for Import
+   mChannels = MakeChannels(trackFactory);
+   mProgressCallback = progress;
+   return true;
+#endif
+}
+
+int FLACImportFileHandle::Import(TrackFactory *trackFactory,
+                                 TrackHolders &outTracks,
+                                 Tags *tags)
+{
+   outTracks.clear();
+
+   wxASSERT(mStreamInfoDone);
+
+   CreateProgress();
+
+   if (mChannels.empty())
+      mChannels = MakeChannels(trackFactory);
+
 
 //Start OD
    bool useOD = false;
@@ -502,7 +532,7 @@ int FLACImportFileHandle::Import(TrackFactory *trackFactory,
          for (int c = 0; c < mNumChannels; ++c, ++iter)
             iter->get()->AppendCoded(mFilename, i, blockLen, c, ODTask::eODFLAC);
 
-         mUpdateResult = mProgress->Update(
+         mUpdateResult = UpdateProgress(
             i.as_long_long(),
             fileTotalFrames.as_long_long()
          );
@@ -537,6 +567,14 @@ int FLACImportFileHandle::Import(TrackFactory *trackFactory,
    }
    outTracks.swap(mChannels);
 
+   if (tags)
+      ImportTags(tags);
+
+   return mUpdateResult;
+}
+
+void FLACImportFileHandle::ImportTags(Tags *tags)
+{
    tags->Clear();
    size_t cnt = mFile->mComments.GetCount();
    for (int c = 0; c < cnt; c++) {
@@ -550,8 +588,6 @@ int FLACImportFileHandle::Import(TrackFactory *trackFactory,
       }
       tags->SetTag(name, value);
    }
-
-   return mUpdateResult;
 }
 
 
@@ -97,6 +97,10 @@ public:
    int Import(TrackFactory *trackFactory, TrackHolders &outTracks,
               Tags *tags) override;
 
+   bool PrepareConcurrentImport(TrackFactory *trackFactory,
+                                const ProgressCallback &progress) override;
+   void ImportTags(Tags *tags) override;
+
    wxInt32 GetStreamCount(){ return 1; }
 
    const wxArrayString &GetStreamInfo() override
@@ -108,9 +112,21 @@ public:
    void SetStreamUsage(wxInt32 WXUNUSED(StreamID), bool WXUNUSED(Use)){}
 
 private:
+   TrackHolders MakeChannels(TrackFactory *trackFactory);
+   bool DoEdit() const;
+   int ImportAliases(const TrackHolders &channels);
+   int ImportSamples(const TrackHolders &channels);
+
    SFFile                mFile;
    const SF_INFO         mInfo;
    sampleFormat          mFormat;
+
+   // "copy", "edit" or "cancel", once asked
+   wxString              mCopyEdit;
+   // Made by PrepareConcurrentImport, which also makes any aliases
+   TrackHolders          mChannels;
+   bool                  mAliasesDone;
+   int                   mAliasResult;
 };
 
 void GetPCMImportPlugin(ImportPluginList & importPluginList,
@@ -192,7 +208,9 @@ PCMImportFileHandle::PCMImportFileHandle(wxString name,
                                          SFFile &&file, SF_INFO info)
 :  ImportFileHandle(name),
    mFile(std::move(file)),
-   mInfo(info)
+   mInfo(info),
+   mAliasesDone(false),
+   mAliasResult(eProgressSuccess)
 {
    wxASSERT(info.channels >= 0);
 
@@ -324,28 +342,8 @@ How do you want to import the current file(s)?"), oldCopyPref == wxT("copy") ? _
    return oldCopyPref;
 }
 
-int PCMImportFileHandle::Import(TrackFactory *trackFactory,
-                                TrackHolders &outTracks,
-                                Tags *tags)
+TrackHolders PCMImportFileHandle::MakeChannels(TrackFactory *trackFactory)
 {
-   outTracks.clear();
-
-   wxASSERT(mFile.get());
-
-   // Get the preference / warn the user about aliased files.
-   wxString copyEdit = AskCopyOrEdit();
-
-   if (copyEdit == wxT("cancel"))
-      return eProgressCancelled;
-
-   // Fall back to "copy" if it doesn't match anything else, since it is safer
-   bool doEdit = false;
-   if (copyEdit.IsSameAs(wxT("edit"), false))
-      doEdit = true;
-
-
-   CreateProgress();
-
    TrackHolders channels(mInfo.channels);
 
    auto iter = channels.begin();
@@ -369,149 +367,231 @@ int PCMImportFileHandle::Import(TrackFactory *trackFactory,
       channels.begin()->get()->SetLinked(true);
    }
 
+   return channels;
+}
+
+bool PCMImportFileHandle::DoEdit() const
+{
+   // Fall back to "copy" if it doesn't match anything else, since it is safer.
+   // If the format is not seekable, we must use 'copy' mode,
+   // because 'edit' mode depends on the ability to seek to an
+   // arbitrary location in the file.
+   return mCopyEdit.IsSameAs(wxT("edit"), false) && mInfo.seekable;
+}
+
+bool PCMImportFileHandle::PrepareConcurrentImport(TrackFactory *trackFactory,
+                                                  const ProgressCallback &progress)
+{
+   mCopyEdit = AskCopyOrEdit();
+   if (mCopyEdit == wxT("cancel"))
+      // Import will return at once
+      return true;
+
+   mChannels = MakeChannels(trackFactory);
+   mProgressCallback = progress;
+
+   // Aliases are made quickly, and the on-demand tasks must be added, on
+   // the main thread, so only copying in is left for the other thread
+   if (DoEdit()) {
+      mAliasResult = ImportAliases(mChannels);
+      mAliasesDone = true;
+   }
+
+   return true;
+}
+
+int PCMImportFileHandle::Import(TrackFactory *trackFactory,
+                                TrackHolders &outTracks,
+                                Tags *tags)
+{
+   outTracks.clear();
+
+   wxASSERT(mFile.get());
+
+   // Get the preference / warn the user about aliased files, unless
+   // PrepareConcurrentImport did already
+   if (mCopyEdit.IsEmpty())
+      mCopyEdit = AskCopyOrEdit();
+
+   if (mCopyEdit == wxT("cancel"))
+      return eProgressCancelled;
+
+   CreateProgress();
+
+   TrackHolders channels;
+   if (mChannels.empty())
+      channels = MakeChannels(trackFactory);
+   else
+      channels.swap(mChannels);
+
+   int updateResult;
+   if (mAliasesDone)
+      updateResult = mAliasResult;
+   else if (DoEdit())
+      updateResult = ImportAliases(channels);
+   else
+      updateResult = ImportSamples(channels);
+
+   if (updateResult == eProgressFailed || updateResult == eProgressCancelled) {
+      return updateResult;
+   }
+
+   for(const auto &channel : channels) {
+      channel->Flush();
+   }
+   outTracks.swap(channels);
+
+   if (tags)
+      ImportTags(tags);
+
+   return updateResult;
+}
+
+int PCMImportFileHandle::ImportAliases(const TrackHolders &channels)
+{
    auto fileTotalFrames =
       (sampleCount)mInfo.frames; // convert from sf_count_t
    auto maxBlockSize = channels.begin()->get()->GetMaxBlockSize();
    int updateResult = false;
 
-   // If the format is not seekable, we must use 'copy' mode,
-   // because 'edit' mode depends on the ability to seek to an
-   // arbitrary location in the file.
-   if (!mInfo.seekable)
-      doEdit = false;
+   // If this mode has been selected, we form the tracks as
+   // aliases to the files we're editing, i.e. ("foo.wav", 12000-18000)
+   // instead of actually making fresh copies of the samples.
 
-   if (doEdit) {
-      // If this mode has been selected, we form the tracks as
-      // aliases to the files we're editing, i.e. ("foo.wav", 12000-18000)
-      // instead of actually making fresh copies of the samples.
+   // lets use OD only if the file is longer than 30 seconds.  Otherwise, why wake up extra threads.
+   //todo: make this a user pref.
+   bool useOD =fileTotalFrames>kMinimumODFileSampleSize;
+   int updateCounter = 0;
 
-      // lets use OD only if the file is longer than 30 seconds.  Otherwise, why wake up extra threads.
-      //todo: make this a user pref.
-      bool useOD =fileTotalFrames>kMinimumODFileSampleSize;
-      int updateCounter = 0;
+   for (decltype(fileTotalFrames) i = 0; i < fileTotalFrames; i += maxBlockSize) {
 
-      for (decltype(fileTotalFrames) i = 0; i < fileTotalFrames; i += maxBlockSize) {
+      const auto blockLen =
+         limitSampleBufferSize( maxBlockSize, fileTotalFrames - i );
 
-         const auto blockLen =
-            limitSampleBufferSize( maxBlockSize, fileTotalFrames - i );
+      auto iter = channels.begin();
+      for (int c = 0; c < mInfo.channels; ++iter, ++c)
+         iter->get()->AppendAlias(mFilename, i, blockLen, c,useOD);
 
-         auto iter = channels.begin();
-         for (int c = 0; c < mInfo.channels; ++iter, ++c)
-            iter->get()->AppendAlias(mFilename, i, blockLen, c,useOD);
-
-         if (++updateCounter == 50) {
-            updateResult = mProgress->Update(
-               i.as_long_long(),
-               fileTotalFrames.as_long_long()
-            );
-            updateCounter = 0;
-            if (updateResult != eProgressSuccess)
-               break;
-         }
+      if (++updateCounter == 50) {
+         updateResult = UpdateProgress(
+            i.as_long_long(),
+            fileTotalFrames.as_long_long()
+         );
+         updateCounter = 0;
+         if (updateResult != eProgressSuccess)
+            break;
       }
+   }
 
-      // One last update for completion
-      updateResult = mProgress->Update(
-         fileTotalFrames.as_long_long(),
-         fileTotalFrames.as_long_long()
-      );
+   // One last update for completion
+   updateResult = UpdateProgress(
+      fileTotalFrames.as_long_long(),
+      fileTotalFrames.as_long_long()
+   );
 
-      if(useOD)
+   if(useOD)
+   {
+      auto computeTask = make_movable<ODComputeSummaryTask>();
+      bool moreThanStereo = mInfo.channels>2;
+      for (const auto &channel : channels)
       {
-         auto computeTask = make_movable<ODComputeSummaryTask>();
-         bool moreThanStereo = mInfo.channels>2;
-         for (const auto &channel : channels)
+         computeTask->AddWaveTrack(channel.get());
+         if(moreThanStereo)
          {
-            computeTask->AddWaveTrack(channel.get());
-            if(moreThanStereo)
-            {
-               //if we have 3 more channels, they get imported on seperate tracks, so we add individual tasks for each.
-               ODManager::Instance()->AddNewTask(std::move(computeTask));
-               computeTask = make_movable<ODComputeSummaryTask>();
-            }
-         }
-         //if we have a linked track, we add ONE task.
-         if(!moreThanStereo)
+            //if we have 3 more channels, they get imported on seperate tracks, so we add individual tasks for each.
             ODManager::Instance()->AddNewTask(std::move(computeTask));
+            computeTask = make_movable<ODComputeSummaryTask>();
+         }
       }
+      //if we have a linked track, we add ONE task.
+      if(!moreThanStereo)
+         ODManager::Instance()->AddNewTask(std::move(computeTask));
    }
-   else {
-      // Otherwise, we're in the "copy" mode, where we read in the actual
-      // samples from the file and store our own local copy of the
-      // samples in the tracks.
-
-      // PRL:  guard against excessive memory buffer allocation in case of many channels
-      using type = decltype(maxBlockSize);
-      if (mInfo.channels < 1)
-         return eProgressFailed;
-      auto maxBlock = std::min(maxBlockSize,
-         std::numeric_limits<type>::max() /
-            (mInfo.channels * SAMPLE_SIZE(mFormat))
-      );
-      if (maxBlock < 1)
-         return eProgressFailed;
 
-      SampleBuffer srcbuffer;
-      wxASSERT(mInfo.channels >= 0);
-      while (NULL == srcbuffer.Allocate(maxBlock * mInfo.channels, mFormat).ptr())
-      {
-         maxBlock /= 2;
-         if (maxBlock < 1)
-            return eProgressFailed;
-      }
+   return updateResult;
+}
 
-      SampleBuffer buffer(maxBlock, mFormat);
+int PCMImportFileHandle::ImportSamples(const TrackHolders &channels)
+{
+   auto fileTotalFrames =
+      (sampleCount)mInfo.frames; // convert from sf_count_t
+   auto maxBlockSize = channels.begin()->get()->GetMaxBlockSize();
+   int updateResult = false;
+
+   // Otherwise, we're in the "copy" mode, where we read in the actual
+   // samples from the file and store our own local copy of the
+   // samples in the tracks.
+
+   // PRL:  guard against excessive memory buffer allocation in case of many channels
+   using type = decltype(maxBlockSize);
+   if (mInfo.channels < 1)
+      return eProgressFailed;
+   auto maxBlock = std::min(maxBlockSize,
+      std::numeric_limits<type>::max() /
+         (mInfo.channels * SAMPLE_SIZE(mFormat))
+   );
+   if (maxBlock < 1)
+      return eProgressFailed;
+
+   SampleBuffer srcbuffer;
+   wxASSERT(mInfo.channels >= 0);
+   while (NULL == srcbuffer.Allocate(maxBlock * mInfo.channels, mFormat).ptr())
+   {
+      maxBlock /= 2;
+      if (maxBlock < 1)
+         return eProgressFailed;
+   }
 
-      decltype(fileTotalFrames) framescompleted = 0;
+   SampleBuffer buffer(maxBlock, mFormat);
 
-      long block;
-      do {
-         block = maxBlock;
+   decltype(fileTotalFrames) framescompleted = 0;
 
-         if (mFormat == int16Sample)
-            block = SFCall<sf_count_t>(sf_readf_short, mFile.get(), (short *)srcbuffer.ptr(), block);
-         //import 24 bit int as float and have the append function convert it.  This is how PCMAliasBlockFile works too.
-         else
-            block = SFCall<sf_count_t>(sf_readf_float, mFile.get(), (float *)srcbuffer.ptr(), block);
+   long block;
+   do {
+      block = maxBlock;
 
-         if (block) {
-            auto iter = channels.begin();
-            for(int c=0; c<mInfo.channels; ++iter, ++c) {
-               if (mFormat==int16Sample) {
-                  for(int j=0; j<block; j++)
-                     ((short *)buffer.ptr())[j] =
-                        ((short *)srcbuffer.ptr())[mInfo.channels*j+c];
-               }
-               else {
-                  for(int j=0; j<block; j++)
-                     ((float *)buffer.ptr())[j] =
-                        ((float *)srcbuffer.ptr())[mInfo.channels*j+c];
-               }
+      // libsndfile is safe to use on different handles at once; only
+      // sf_open and sf_close take libSndFileMutex, so that files being
+      // imported concurrently decode in parallel
+      if (mFormat == int16Sample)
+         block = sf_readf_short(mFile.get(), (short *)srcbuffer.ptr(), block);
+      //import 24 bit int as float and have the append function convert it.  This is how PCMAliasBlockFile works too.
+      else
+         block = sf_readf_float(mFile.get(), (float *)srcbuffer.ptr(), block);
 
-               iter->get()->Append(buffer.ptr(), (mFormat == int16Sample)?int16Sample:floatSample, block);
+      if (block) {
+         auto iter = channels.begin();
+         for(int c=0; c<mInfo.channels; ++iter, ++c) {
+            if (mFormat==int16Sample) {
+               for(int j=0; j<block; j++)
+                  ((short *)buffer.ptr())[j] =
+                     ((short *)srcbuffer.ptr())[mInfo.channels*j+c];
+            }
+            else {
+               for(int j=0; j<block; j++)
+                  ((float *)buffer.ptr())[j] =
+                     ((float *)srcbuffer.ptr())[mInfo.channels*j+c];
             }
-            framescompleted += block;
-         }
 
-         updateResult = mProgress->Update(
-            framescompleted.as_long_long(),
-            fileTotalFrames.as_long_long()
-         );
-         if (updateResult != eProgressSuccess)
-            break;
+            iter->get()->Append(buffer.ptr(), (mFormat == int16Sample)?int16Sample:floatSample, block);
+         }
+         framescompleted += block;
+      }
 
-      } while (block > 0);
-   }
+      updateResult = UpdateProgress(
+         framescompleted.as_long_long(),
+         fileTotalFrames.as_long_long()
+      );
+      if (updateResult != eProgressSuccess)
+         break;
 
-   if (updateResult == eProgressFailed || updateResult == eProgressCancelled) {
-      return updateResult;
-   }
+   } while (block > 0);
 
-   for(const auto &channel : channels) {
-      channel->Flush();
-   }
-   outTracks.swap(channels);
+   return updateResult;
+}
 
+void PCMImportFileHandle::ImportTags(Tags *tags)
+{
    const char *str;
 
    str = sf_get_string(mFile.get(), SF_STR_TITLE);
@@ -701,8 +781,6 @@ int PCMImportFileHandle::Import(TrackFactory *trackFactory,
       }
    }
 #endif
-
-   return updateResult;
 }
 
 PCMImportFileHandle::~PCMImportFileHandle()
@@ -59,6 +59,7 @@ but little else.
 #include <wx/arrstr.h>
 #include <wx/filename.h>
 #include <wx/string.h>
+#include <functional>
 #include "../MemoryX.h"
 
 #include "../widgets/ProgressDialog.h"
@@ -130,10 +131,17 @@ public:
    {
    }
 
+   // Called with the fraction of the file done; return false to cancel
+   using ProgressCallback = std::function< bool(double fraction) >;
+
    // The importer should call this to create the progress dialog and
    // identify the filename being imported.
    void CreateProgress()
    {
+      // A concurrent import reports progress only through the callback
+      if (mProgressCallback)
+         return;
+
       wxFileName ff(mFilename);
       wxString title;
 
@@ -167,9 +175,33 @@ public:
    // Set stream "import/don't import" flag
    virtual void SetStreamUsage(wxInt32 StreamID, bool Use) = 0;
 
+   // For BatchImporter, which imports several files at once.  Called on
+   // the main thread, which asks the user any questions here.  Return true
+   // if Import may then be called on another thread, with null tags: such
+   // an Import shows no dialogs and reports progress only through the
+   // callback.  Otherwise the file is imported as usual, later.
+   virtual bool PrepareConcurrentImport(TrackFactory * WXUNUSED(trackFactory),
+                                        const ProgressCallback & WXUNUSED(progress))
+   { return false; }
+
+   // After a concurrent Import, called on the main thread to read the
+   // metadata that Import would have read into tags
+   virtual void ImportTags(Tags * WXUNUSED(tags)) {}
+
 protected:
+   // Update the progress dialog, or call the callback of a concurrent
+   // import; returns as ProgressDialog::Update does
+   int UpdateProgress(wxULongLong_t current, wxULongLong_t total)
+   {
+      if (mProgressCallback)
+         return mProgressCallback(total ? (double)current / total : 1.0)
+            ? eProgressSuccess : eProgressCancelled;
+      return mProgress->Update(current, total);
+   }
+
    wxString mFilename;
    Maybe<ProgressDialog> mProgress;
+   ProgressCallback mProgressCallback;
 };
 
 
@@ -174,7 +174,7 @@ void ODComputeSummaryTask::Update()
    {
       if(mWaveTracks[j])
       {
-         BlockArray *blocks;
+         const BlockArray *blocks;
          Sequence *seq;
 
          //gather all the blockfiles that we should process in the wavetrack.
@@ -197,7 +197,7 @@ void ODComputeSummaryTask::Update()
             for(i=0; i<(int)blocks->size(); i++)
             {
                //if there is data but no summary, this blockfile needs summarizing.
-               SeqBlock &block = (*blocks)[i];
+               const SeqBlock &block = (*blocks)[i];
                const auto &file = block.f;
                if(file->IsDataAvailable() && !file->IsSummaryAvailable())
                {
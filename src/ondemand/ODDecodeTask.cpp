@@ -133,7 +133,7 @@ void ODDecodeTask::Update()
    {
       if(mWaveTracks[j])
       {
-         BlockArray *blocks;
+         const BlockArray *blocks;
          Sequence *seq;
 
          //gather all the blockfiles that we should process in the wavetrack.
@@ -151,7 +151,7 @@ void ODDecodeTask::Update()
             for (i = 0; i<(int)blocks->size(); i++)
             {
                //since we have more than one ODBlockFile, we will need type flags to cast.
-               SeqBlock &block = (*blocks)[i];
+               const SeqBlock &block = (*blocks)[i];
                const auto &file = block.f;
                std::shared_ptr<ODDecodeBlockFile> oddbFile;
                if (!file->IsDataAvailable() &&
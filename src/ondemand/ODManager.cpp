@@ -20,6 +20,7 @@ ODTask requests and internals.
 #include "ODTaskThread.h"
 #include "ODWaveTrackTaskQueue.h"
 #include "../Project.h"
+#include "../WorkerPool.h"
 #include <NonGuiThread.h>
 #include <wx/utils.h>
 #include <wx/wx.h>
@@ -57,6 +58,7 @@ ODManager::ODManager()
    mTerminate = false;
    mTerminated = false;
    mPause = gPause;
+   mQueueSignalled = false;
 
    //must set up the queue condition
    mQueueNotEmptyCond = std::make_unique<ODCondition>(&mQueueNotEmptyCondLock);
@@ -86,29 +88,22 @@ ODManager::~ODManager()
    }
    mTerminatedMutex.Unlock();
 
+   //let the running slices finish and stop the workers.
+   mScheduler.reset();
+
    //get rid of all the queues.  The queues get rid of the tasks, so we don't worry abut them.
    //nothing else should be running on OD related threads at this point, so we don't lock.
    mQueues.clear();
 }
 
 ///Adds a task to running queue.  Thread-safe.
+///The scheduler keeps running it until it is complete; it holds it while paused.
 void ODManager::AddTask(ODTask* task)
 {
-   mTasksMutex.Lock();
-   mTasks.push_back(task);
-   mTasksMutex.Unlock();
-   //signal the queue not empty condition.
-   bool paused;
-
-   mPauseLock.Lock();
-   paused=mPause;
-   mPauseLock.Unlock();
-
-   //don't signal if we are paused since if we wake up the loop it will start processing other tasks while paused
-   if(!paused)
-      mQueueNotEmptyCond->Signal();
+   mScheduler->Submit(task);
 }
 
+///Wakes the manager loop, which is done by the workers after each slice of a task.
 void ODManager::SignalTaskQueueLoop()
 {
    bool paused;
@@ -118,24 +113,22 @@ void ODManager::SignalTaskQueueLoop()
    mPauseLock.Unlock();
    //don't signal if we are paused
    if(!paused)
+   {
+      ODLocker locker{ &mQueueNotEmptyCondLock };
+      mQueueSignalled = true;
       mQueueNotEmptyCond->Signal();
+   }
 }
 
-///removes a task from the active task queue
-void ODManager::RemoveTaskIfInQueue(ODTask* task)
+///Cancels a task and waits until no worker thread is running it.
+///The task may then be deleted.  Must not be called from a worker thread.
+void ODManager::CancelTask(ODTask* task)
 {
-   mTasksMutex.Lock();
-   //linear search okay for now, (probably only 1-5 tasks exist at a time.)
-   for(unsigned int i=0;i<mTasks.size();i++)
-   {
-      if(mTasks[i]==task)
-      {
-         mTasks.erase(mTasks.begin()+i);
-         break;
-      }
-   }
-   mTasksMutex.Unlock();
-
+   //the workers are already stopped if the manager is being destroyed.
+   if(mScheduler)
+      mScheduler->Cancel(task);
+   else
+      task->Cancel();
 }
 
 ///Adds a NEW task to the queue.  Creates a queue if the tracks associated with the task is not in the list
@@ -211,11 +204,14 @@ bool ODManager::IsInstanceCreated()
    return ret;
 }
 
-///Launches a thread for the manager and starts accepting Tasks.
+///Launches a thread for the manager and the worker threads, and starts accepting Tasks.
 void ODManager::Init()
 {
-   mCurrentThreads = 0;
-   mMaxThreads = 5;
+   //one worker per processor.  The GUI and manager threads mostly sleep.
+   mScheduler = std::make_unique<ODScheduler>(
+      WorkerPool::GetProcessorCount(),
+      [this]{ SignalTaskQueueLoop(); });
+   mScheduler->SetPaused(mPause);
 
    //   wxLogDebug(wxT("Initializing ODManager...Creating manager thread"));
    // This is a detached thread, so it deletes itself when it finishes
@@ -231,18 +227,9 @@ void ODManager::Init()
    //destruction of thread is taken care of by thread library
 }
 
-void ODManager::DecrementCurrentThreads()
-{
-   mCurrentThreadsMutex.Lock();
-   mCurrentThreads--;
-   mCurrentThreadsMutex.Unlock();
-}
-
 ///Main loop for managing threads and tasks.
 void ODManager::Start()
 {
-   bool tasksInArray;
-   bool paused;
    int  numQueues=0;
 
    mNeedsDraw=0;
@@ -258,50 +245,18 @@ void ODManager::Start()
 //    printf("ODManager thread running \n");
 
       //we should look at our WaveTrack queues to see if we can process a NEW task to the running queue.
+      //the scheduler's workers run the tasks.
       UpdateQueues();
 
-      //start some threads if necessary
-
-      mTasksMutex.Lock();
-      tasksInArray = mTasks.size()>0;
-      mTasksMutex.Unlock();
-
-      mPauseLock.Lock();
-      paused=mPause;
-      mPauseLock.Unlock();
-
-      mCurrentThreadsMutex.Lock();
-      // keep adding tasks if there is work to do, up to the limit.
-      while(!paused && tasksInArray && (mCurrentThreads < mMaxThreads))
-      {
-         mCurrentThreads++;
-         mCurrentThreadsMutex.Unlock();
-
-         mTasksMutex.Lock();
-         //detach a NEW thread.
-         // This is a detached thread, so it deletes itself when it finishes
-         // ... except on Mac where we we don't use wxThread for reasons unexplained
-         auto thread = safenew ODTaskThread(mTasks[0]);//task);
-         //thread->SetPriority(10);//default is 50.
-         thread->Create();
-         thread->Run();
-
-         mTasks.erase(mTasks.begin());
-         tasksInArray = mTasks.size()>0;
-         mTasksMutex.Unlock();
-
-         mCurrentThreadsMutex.Lock();
-      }
-
-      mCurrentThreadsMutex.Unlock();
       //use a conditon variable to block here instead of a sleep.
 
-      // JKC: If there are no tasks ready to run, or we're paused then
-      // we wait for there to be tasks in the queue.
+      //wait for a worker to finish a slice of a task, which may have completed it,
+      //or for something else to signal a change to the queues.
       {
          ODLocker locker{ &mQueueNotEmptyCondLock };
-         if( (!tasksInArray) || paused)
+         if(!mQueueSignalled)
             mQueueNotEmptyCond->Wait();
+         mQueueSignalled = false;
       }
 
       //if there is some ODTask running, then there will be something in the queue.  If so then redraw to show progress
@@ -345,9 +300,11 @@ void ODManager::Pauser::Pause(bool pause)
       pMan->mPause = pause;
       pMan->mPauseLock.Unlock();
 
+      pMan->mScheduler->SetPaused(pause);
+
       if(!pause)
          //we should check the queue again.
-         pMan->mQueueNotEmptyCond->Signal();
+         pMan->SignalTaskQueueLoop();
    }
    else
    {
@@ -467,6 +424,14 @@ void ODManager::DemandTrackUpdate(WaveTrack* track, double seconds)
    for(unsigned int i=0;i<mQueues.size();i++)
    {
       mQueues[i]->DemandTrackUpdate(track,seconds);
+
+      //the user is waiting on this track, so run its task ahead of the others.
+      if(track && mQueues[i]->ContainsWaveTrack(track))
+      {
+         ODTask* task = mQueues[i]->GetFrontTask();
+         if(task)
+            mScheduler->Boost(task);
+      }
    }
    mQueuesMutex.Unlock();
 }
@@ -11,8 +11,8 @@
 ******************************************************************//**
 
 \class ODManager
-\brief A singleton that manages currently running Tasks on an arbitrary
-number of threads.
+\brief A singleton that manages currently running Tasks on a pool of
+threads, one per processor.
 
 *//*******************************************************************/
 
@@ -22,6 +22,7 @@ number of threads.
 #include <vector>
 #include "ODTask.h"
 #include "ODTaskThread.h"
+#include "ODScheduler.h"
 #include <wx/thread.h>
 #include <wx/wx.h>
 
@@ -55,12 +56,10 @@ class ODManager final
    ///Kills the ODMananger Thread.
    static void Quit();
 
-   ///changes the tasks associated with this Waveform to process the task from a different point in the track
+   ///changes the tasks associated with this Waveform to process the task from a different point in the track,
+   ///and runs them before the tasks of other tracks
    void DemandTrackUpdate(WaveTrack* track, double seconds);
 
-   ///Reduces the count of current threads running.  Meant to be called when ODTaskThreads end in their own threads.  Thread-safe.
-   void DecrementCurrentThreads();
-
    ///Adds a wavetrack, creates a queue member.
    void AddNewTask(movable_ptr<ODTask> &&mtask, bool lockMutex=true);
 
@@ -83,7 +82,8 @@ class ODManager final
    ///Adds a task to the running queue.  Threas-safe.
    void AddTask(ODTask* task);
 
-   void RemoveTaskIfInQueue(ODTask* task);
+   ///Cancels the task, removes it from the running queue, and waits for it to stop running, so it can be deleted.
+   void CancelTask(ODTask* task);
 
    ///sets a flag that is set if we have loaded some OD blockfiles from PCM.
    static void MarkLoadedODFlag();
@@ -127,7 +127,7 @@ class ODManager final
    //private constructor - DELETE with static method Quit()
    friend std::default_delete < ODManager > ;
    ~ODManager();
-   ///Launches a thread for the manager and starts accepting Tasks.
+   ///Launches a thread for the manager and the worker threads, and starts accepting Tasks.
    void Init();
 
    ///Start the main loop for the manager.
@@ -143,10 +143,8 @@ class ODManager final
    std::vector<movable_ptr<ODWaveTrackTaskQueue>> mQueues;
    ODLock mQueuesMutex;
 
-   //List of current Task to do.
-   std::vector<ODTask*> mTasks;
-   //mutex for above variable
-   ODLock mTasksMutex;
+   //Runs the current Tasks.
+   std::unique_ptr<ODScheduler> mScheduler;
 
    //global pause switch for OD
    volatile bool mPause;
@@ -154,14 +152,6 @@ class ODManager final
 
    volatile int mNeedsDraw;
 
-   ///Number of threads currently running.   Accessed thru multiple threads
-   volatile int mCurrentThreads;
-   //mutex for above variable
-   ODLock mCurrentThreadsMutex;
-
-   ///Maximum number of threads allowed out.
-   int mMaxThreads;
-
    volatile bool mTerminate;
    ODLock mTerminateMutex;
 
@@ -171,6 +161,8 @@ class ODManager final
    //for the queue not empty comdition
    ODLock         mQueueNotEmptyCondLock;
    std::unique_ptr<ODCondition> mQueueNotEmptyCond;
+   //set when signalled, so that a signal while the loop is busy is not lost
+   bool           mQueueSignalled;
 
 #ifdef __WXMAC__
 
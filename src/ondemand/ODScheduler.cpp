@@ -0,0 +1,279 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ODScheduler.cpp
+
+*******************************************************************//**
+
+\class ODScheduler
+\brief Runs the slices of ODTasks on a fixed set of worker threads, one
+per processor, with work stealing.
+
+ODManager used to start a NEW thread for each slice of a task, up to a
+fixed five at a time, whatever the number of processors, and pass the
+tasks between them through one shared list.  Now the threads are started
+once.  Each has its own queue of tasks.  After running a slice of a task
+that is not complete, the worker puts it back at the back of its own
+queue, and so keeps working on it while the data are in the caches.  A
+worker with nothing left to do takes the task at the front of another's
+queue.  Importing many files at once thus keeps every processor busy,
+and never starts more threads than there are processors.
+
+Boosted tasks, those of a track the user is looking at or listening to,
+go in a separate queue that every worker checks first, and go back to it
+after each slice until they are complete.
+
+A task is stopped by cancelling it, which every worker sees before
+running its next slice, instead of by blocking on its locks.
+Cancel() then waits only for a slice already running.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include "ODScheduler.h"
+#include "ODTask.h"
+#include "../WorkerPool.h"
+
+#include <algorithm>
+
+ODScheduler::Worker::Worker()
+: running{ nullptr }
+{
+}
+
+ODScheduler::Worker::~Worker()
+{
+}
+
+ODScheduler::ODScheduler(size_t nThreads, const SliceCallback &onSlice)
+: mOnSlice(onSlice)
+, mThreadCount(0)
+, mQueued(0)
+, mNextWorker(0)
+, mPaused(false)
+, mQuit(false)
+, mWorkCondition(&mLock)
+, mDoneCondition(&mLock)
+{
+   nThreads = std::max<size_t>(1, nThreads);
+
+   // Make all the queues before any thread can look for work in them
+   for (size_t i = 0; i < nThreads; i++)
+      mWorkers.push_back(std::make_unique<Worker>());
+
+   // If a thread can't be started, its queue stays, and the other
+   // workers take the tasks from it
+   for (size_t i = 0; i < nThreads; i++) {
+      auto &worker = *mWorkers[i];
+      worker.thread = std::make_unique<WorkerThread>([this, i]{ WorkerLoop(i); });
+      if (worker.thread->Start())
+         ++mThreadCount;
+      else
+         worker.thread.reset();
+   }
+}
+
+ODScheduler::~ODScheduler()
+{
+   mQuit = true;
+   {
+      ODLocker locker{ &mLock };
+      mWorkCondition.Broadcast();
+   }
+
+   for (auto &worker : mWorkers)
+      if (worker->thread)
+         worker->thread->Join();
+}
+
+bool ODScheduler::Push(std::deque<ODTask*> &tasks, ODTask *task, bool front)
+{
+   // Cancel() sets the flag before it takes any queue lock, so a task
+   // cancelled meanwhile is seen here, or else removed by Cancel()
+   if (task->IsCancelled())
+      return false;
+
+   if (front)
+      tasks.push_front(task);
+   else
+      tasks.push_back(task);
+   ++mQueued;
+   return true;
+}
+
+bool ODScheduler::Erase(std::deque<ODTask*> &tasks, ODTask *task)
+{
+   auto iter = std::find(tasks.begin(), tasks.end(), task);
+   if (iter == tasks.end())
+      return false;
+
+   tasks.erase(iter);
+   --mQueued;
+   return true;
+}
+
+void ODScheduler::Submit(ODTask *task)
+{
+   auto &worker = *mWorkers[mNextWorker++ % mWorkers.size()];
+   {
+      ODLocker locker{ &worker.lock };
+      if (!Push(worker.tasks, task, false))
+         return;
+   }
+   Wake();
+}
+
+void ODScheduler::Boost(ODTask *task)
+{
+   // Holding mLock keeps Cancel() from finishing while the task is in
+   // neither queue
+   ODLocker locker{ &mLock };
+
+   bool found = false;
+   for (auto &worker : mWorkers) {
+      ODLocker queueLocker{ &worker->lock };
+      if (Erase(worker->tasks, task)) {
+         found = true;
+         break;
+      }
+   }
+
+   // A task that is running, or already boosted, is marked too, so that
+   // the worker puts it back in the urgent queue after its slice
+   ODLocker urgentLocker{ &mUrgentLock };
+   if (task->IsCancelled())
+      return;
+   mBoosted.insert(task);
+   if (Erase(mUrgent, task))
+      found = true;
+   if (found)
+      Push(mUrgent, task, true);
+}
+
+void ODScheduler::Cancel(ODTask *task)
+{
+   task->Cancel();
+
+   ODLocker locker{ &mLock };
+   {
+      ODLocker urgentLocker{ &mUrgentLock };
+      Erase(mUrgent, task);
+      mBoosted.erase(task);
+   }
+   for (auto &worker : mWorkers) {
+      ODLocker queueLocker{ &worker->lock };
+      Erase(worker->tasks, task);
+   }
+
+   // A worker that took the task set its running pointer before letting
+   // go of the queue lock, so it is seen here
+   auto isRunning = [&] {
+      for (auto &worker : mWorkers)
+         if (worker->running == task)
+            return true;
+      return false;
+   };
+   while (isRunning())
+      mDoneCondition.Wait();
+}
+
+void ODScheduler::SetPaused(bool paused)
+{
+   mPaused = paused;
+   if (!paused) {
+      ODLocker locker{ &mLock };
+      mWorkCondition.Broadcast();
+   }
+}
+
+void ODScheduler::Wake()
+{
+   ODLocker locker{ &mLock };
+   mWorkCondition.Signal();
+}
+
+ODTask *ODScheduler::Take(size_t index)
+{
+   if (mPaused || mQueued == 0)
+      return nullptr;
+
+   auto &self = *mWorkers[index];
+   auto take = [&](ODLock &lock, std::deque<ODTask*> &tasks, bool back) {
+      ODLocker locker{ &lock };
+      if (tasks.empty())
+         return (ODTask *)nullptr;
+      ODTask *task = back ? tasks.back() : tasks.front();
+      if (back)
+         tasks.pop_back();
+      else
+         tasks.pop_front();
+      --mQueued;
+      self.running = task;
+      return task;
+   };
+
+   // Boosted tasks first, then the most recent of our own, then the
+   // oldest of another worker's, starting with our neighbour
+   if (auto task = take(mUrgentLock, mUrgent, false))
+      return task;
+   if (auto task = take(self.lock, self.tasks, true))
+      return task;
+   const auto nWorkers = mWorkers.size();
+   for (size_t ii = 1; ii < nWorkers; ii++) {
+      auto &victim = *mWorkers[(index + ii) % nWorkers];
+      if (auto task = take(victim.lock, victim.tasks, false))
+         return task;
+   }
+
+   return nullptr;
+}
+
+void ODScheduler::WorkerLoop(size_t index)
+{
+   auto &self = *mWorkers[index];
+   while (!mQuit) {
+      ODTask *task = Take(index);
+      if (!task) {
+         ODLocker locker{ &mLock };
+         if (!mQuit && (mPaused || mQueued == 0))
+            mWorkCondition.Wait();
+         continue;
+      }
+
+      if (!task->IsCancelled()) {
+         //Do at least 5 percent of the task
+         task->DoSome(0.05f);
+
+         //if it is not done, put it back onto our own queue, or, if it
+         //was boosted, ahead of the others until it is done.
+         bool complete = task->PercentComplete() >= 1.0;
+         bool boosted;
+         {
+            ODLocker locker{ &mUrgentLock };
+            boosted = mBoosted.count(task) > 0;
+            if (boosted && complete)
+               mBoosted.erase(task);
+            else if (boosted)
+               Push(mUrgent, task, true);
+         }
+         if (!complete && !boosted) {
+            ODLocker locker{ &self.lock };
+            Push(self.tasks, task, false);
+         }
+      }
+      else {
+         ODLocker locker{ &mUrgentLock };
+         mBoosted.erase(task);
+      }
+
+      self.running = nullptr;
+      {
+         ODLocker locker{ &mLock };
+         mDoneCondition.Broadcast();
+      }
+
+      if (mOnSlice)
+         mOnSlice();
+   }
+}
@@ -0,0 +1,111 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ODScheduler.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_ODSCHEDULER__
+#define __AUDACITY_ODSCHEDULER__
+
+#include "../MemoryX.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <set>
+#include <vector>
+
+#include "ODTaskThread.h"
+
+class ODTask;
+class WorkerThread;
+
+/// A fixed set of threads that run slices of ODTasks, each thread with
+/// its own queue of tasks, and taking work from the others when its own
+/// queue is empty.
+class ODScheduler final
+{
+ public:
+   /// Called on a worker thread after each slice of a task
+   using SliceCallback = std::function<void()>;
+
+   /// Fewer threads may be started if the system refuses to create more.
+   ODScheduler(size_t nThreads, const SliceCallback &onSlice);
+   /// Waits for the running slices, and drops the tasks not yet run
+   ~ODScheduler();
+
+   ODScheduler(const ODScheduler&) PROHIBITED;
+   ODScheduler &operator= (const ODScheduler&) PROHIBITED;
+
+   size_t GetThreadCount() const { return mThreadCount; }
+
+   /// Queue the task to be run.  The workers queue it again after each
+   /// slice until it is complete, so submit it only when it is neither
+   /// queued nor running.  A cancelled task is ignored.  Thread-safe.
+   void Submit(ODTask *task);
+
+   /// Move the task ahead of all tasks not boosted, as when the user wants
+   /// to see or hear its track, and keep it there after each slice until
+   /// it is complete.  A running task is moved after its slice.
+   /// Thread-safe.
+   void Boost(ODTask *task);
+
+   /// Cancel the task, remove it from the queues, and wait until no worker
+   /// is running it, so that it may be deleted.  Must not be called from
+   /// a worker thread.
+   void Cancel(ODTask *task);
+
+   /// Stop starting slices; running slices still finish.
+   void SetPaused(bool paused);
+
+   /// Tasks waiting in the queues
+   size_t GetQueuedCount() const { return mQueued; }
+
+ private:
+   struct Worker {
+      Worker();
+      ~Worker();
+
+      ODLock lock;
+      // Owner pushes and pops at the back; thieves take from the front
+      std::deque<ODTask*> tasks;
+      // The task being run, set while holding the lock of the queue it
+      // was taken from
+      std::atomic<ODTask*> running;
+      std::unique_ptr<WorkerThread> thread;
+   };
+
+   // Queue the task unless cancelled; call with the queue's lock held
+   bool Push(std::deque<ODTask*> &tasks, ODTask *task, bool front);
+   // Remove the task if queued; call with the queue's lock held
+   bool Erase(std::deque<ODTask*> &tasks, ODTask *task);
+   ODTask *Take(size_t index);
+   void Wake();
+   void WorkerLoop(size_t index);
+
+   SliceCallback mOnSlice;
+   size_t mThreadCount;
+
+   std::vector<std::unique_ptr<Worker>> mWorkers;
+
+   // Boosted tasks, taken before any others, and all the tasks boosted
+   // and not yet complete, whether queued or running; both guarded by
+   // mUrgentLock
+   ODLock mUrgentLock;
+   std::deque<ODTask*> mUrgent;
+   std::set<ODTask*> mBoosted;
+
+   std::atomic<size_t> mQueued;
+   std::atomic<size_t> mNextWorker;
+   std::atomic<bool> mPaused;
+   std::atomic<bool> mQuit;
+
+   // Guards sleeping and waking, and serializes Boost and Cancel;
+   // taken before any queue lock
+   ODLock mLock;
+   ODCondition mWorkCondition;
+   ODCondition mDoneCondition;
+};
+
+#endif
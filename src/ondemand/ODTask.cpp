@@ -37,31 +37,12 @@ ODTask::ODTask()
    static int sTaskNumber=0;
    mPercentComplete=0;
    mDoingTask=false;
-   mTerminate = false;
    mNeedsODUpdate=false;
    mIsRunning = false;
 
    mTaskNumber=sTaskNumber++;
 }
 
-//outside code must ensure this task is not scheduled again.
-void ODTask::TerminateAndBlock()
-{
-   //one mutex pair for the value of mTerminate
-   mTerminateMutex.Lock();
-   mTerminate=true;
-   //release all data the derived class may have allocated
-   mTerminateMutex.Unlock();
-
-   //and one mutex pair for the exit of the function
-   mBlockUntilTerminateMutex.Lock();
-//TODO lock mTerminate?
-   mBlockUntilTerminateMutex.Unlock();
-
-   //wait till we are out of doSome() to terminate.
-   Terminate();
-}
-
 ///Do a modular part of the task.  For example, if the task is to load the entire file, load one BlockFile.
 ///Relies on DoSomeInternal(), which is the subclasses must implement.
 ///@param amountWork the percent amount of the total job to do.  1.0 represents the entire job.  the default of 0.0
@@ -69,7 +50,6 @@ void ODTask::TerminateAndBlock()
 void ODTask::DoSome(float amountWork)
 {
    SetIsRunning(true);
-   mBlockUntilTerminateMutex.Lock();
 
 //   printf("%s %i subtask starting on new thread with priority\n", GetTaskName(),GetTaskNumber());
 
@@ -80,15 +60,11 @@ void ODTask::DoSome(float amountWork)
 
 
    //check periodically to see if we should exit.
-   mTerminateMutex.Lock();
-   if(mTerminate)
+   if(IsCancelled())
    {
-      mTerminateMutex.Unlock();
       SetIsRunning(false);
-      mBlockUntilTerminateMutex.Unlock();
       return;
    }
-   mTerminateMutex.Unlock();
 
    Update();
 
@@ -101,31 +77,22 @@ void ODTask::DoSome(float amountWork)
 
    //Do Some of the task.
 
-   mTerminateMutex.Lock();
-   while(PercentComplete() < workUntil && PercentComplete() < 1.0 && !mTerminate)
+   //the scheduler waits for this slice to finish before the task is deleted,
+   //so cancelling only needs to cut the number of iterations short
+   while(PercentComplete() < workUntil && PercentComplete() < 1.0 && !IsCancelled())
    {
       wxThread::This()->Yield();
-      //release within the loop so we can cut the number of iterations short
 
-      DoSomeInternal(); //keep the terminate mutex on so we don't remo
-      mTerminateMutex.Unlock();
+      DoSomeInternal();
       //check to see if ondemand has been called
       if(GetNeedsODUpdate() && PercentComplete() < 1.0)
          ODUpdate();
-
-
-      //But add the mutex lock back before we check the value again.
-      mTerminateMutex.Lock();
    }
-   mTerminateMutex.Unlock();
    mDoingTask=false;
 
-   mTerminateMutex.Lock();
-   //if it is not done, put it back onto the ODManager queue.
-   if(PercentComplete() < 1.0&& !mTerminate)
+   //if it is not done, the ODScheduler puts it back onto its queue.
+   if(PercentComplete() < 1.0 && !IsCancelled())
    {
-      ODManager::Instance()->AddTask(this);
-
       //we did a bit of progress - we should allow a resave.
       ODLocker locker{ &AudacityProject::AllProjectDeleteMutex() };
       for(unsigned i=0; i<gAudacityProjects.size(); i++)
@@ -166,9 +133,7 @@ void ODTask::DoSome(float amountWork)
 
 //      printf("%s %i complete\n", GetTaskName(),GetTaskNumber());
    }
-   mTerminateMutex.Unlock();
    SetIsRunning(false);
-   mBlockUntilTerminateMutex.Unlock();
 }
 
 bool ODTask::IsTaskAssociatedWithProject(AudacityProject* proj)
@@ -28,6 +28,7 @@ in a background thread.
 #include "../Project.h"
 
 #include "../MemoryX.h"
+#include <atomic>
 #include <vector>
 #include <wx/wx.h>
 class WaveTrack;
@@ -35,6 +36,20 @@ class WaveTrack;
 
 DECLARE_EXPORTED_EVENT_TYPE(AUDACITY_DLL_API, EVT_ODTASK_COMPLETE, -1)
 
+/// A flag that can be set once, from any thread, to ask a task to stop.
+/// The task and the ODScheduler test it between units of work.
+class ODCancelToken final
+{
+ public:
+   ODCancelToken() : mCancelled{ false } {}
+
+   void Cancel() { mCancelled = true; }
+   bool IsCancelled() const { return mCancelled; }
+
+ private:
+   std::atomic<bool> mCancelled;
+};
+
 /// A class representing a modular task to be used with the On-Demand structures.
 class ODTask /* not final */
 {
@@ -96,7 +111,11 @@ class ODTask /* not final */
 
    bool IsComplete();
 
-   void TerminateAndBlock();
+   ///asks the task to stop before its next unit of work.  Does not block; use
+   ///ODManager::CancelTask to also wait for a running slice to finish.
+   void Cancel() { mCancelToken.Cancel(); }
+   bool IsCancelled() const { return mCancelToken.IsCancelled(); }
+
    ///releases memory that the ODTask owns.  Subclasses should override.
    virtual void Terminate(){}
 
@@ -151,10 +170,7 @@ class ODTask /* not final */
    ODLock mPercentCompleteMutex;
    volatile bool  mDoingTask;
    volatile bool  mTaskStarted;
-   volatile bool mTerminate;
-   ODLock mTerminateMutex;
-   //for a function not a member var.
-   ODLock mBlockUntilTerminateMutex;
+   ODCancelToken mCancelToken;
 
    std::vector<WaveTrack*> mWaveTracks;
    ODLock     mWaveTrackMutex;
@@ -10,8 +10,9 @@
 
 ******************************************************************//**
 
-\class ODTaskThread
-\brief A thread that executes a part of the task specfied by an ODTask.
+\file ODTaskThread.h
+\brief The locks and conditions used by the On-Demand threads.  The threads
+themselves belong to ODScheduler.
 
 *//*******************************************************************/
 
@@ -36,51 +37,6 @@ class ODTask;
 #include <pthread.h>
 #include <time.h>
 
-class ODTaskThread {
- public:
-   typedef int ExitCode;
-   ODTaskThread(ODTask* task);
-   /*ExitCode*/ void Entry();
-   void Create() {}
-   void Delete() {
-      mDestroy = true;
-      pthread_join(mThread, NULL);
-   }
-   bool TestDestroy() { return mDestroy; }
-   void Sleep(int ms) {
-      struct timespec spec;
-      spec.tv_sec = 0;
-      spec.tv_nsec = ms * 1000 * 1000;
-      nanosleep(&spec, NULL);
-   }
-   static void *callback(void *p) {
-      ODTaskThread *th = (ODTaskThread *)p;
-#if defined(__WXMAC__)
-      /*return (void *)*/ th->Entry();
-      return NULL;
-#else
-      return (void *) th->Entry();
-#endif
-   }
-   void Run() {
-      pthread_create(&mThread, NULL, callback, this);
-   }
-
-   ///Specifies the priority the thread will run at.  Currently doesn't work.
-   ///@param priority value from 0 (min priority) to 100 (max priority)
-   void SetPriority(int priority)
-   {
-      mPriority=priority;
-   }
-
- private:
-   int mPriority;
-   bool mDestroy;
-   pthread_t mThread;
-
-   ODTask* mTask;
-};
-
 class ODLock {
  public:
    ODLock(){
@@ -130,22 +86,6 @@ protected:
 #else
 
 
-class ODTaskThread final : public wxThread
-{
-public:
-   ///Constructs a ODTaskThread
-   ///@param task the task to be launched as an
-   ODTaskThread(ODTask* task);
-
-
-protected:
-   ///Executes a part of the task
-   void* Entry() override;
-   ODTask* mTask;
-
-};
-
-
 //a wrapper for wxMutex.
 class AUDACITY_DLL_API ODLock final : public wxMutex
 {
@@ -192,8 +132,9 @@ public:
       ODLockerBase::reset(p);
       if(p) {
          if (tryOnly) {
+            // Not ours to unlock, so let it go without unlocking it
             if (p->TryLock() != 0)
-               ODLockerBase::reset(nullptr);
+               ODLockerBase::release();
          }
          else
             p->Lock();
@@ -27,12 +27,17 @@ ODWaveTrackTaskQueue::ODWaveTrackTaskQueue()
 
 ODWaveTrackTaskQueue::~ODWaveTrackTaskQueue()
 {
-   //we need to DELETE all ODTasks.  We will have to block or wait until block for the active ones.
+   //we need to DELETE all ODTasks.  We will have to wait for the active ones to finish their slice.
+   //the manager is null only while it is being destroyed, after its workers have stopped.
+   ODManager* manager = ODManager::Instance();
    for(unsigned int i=0;i<mTasks.size();i++)
    {
-      mTasks[i]->TerminateAndBlock();//blocks if active.
-      //small chance we may have rea-added the task back into the queue from a diff thread.  - so remove it if we have.
-      ODManager::Instance()->RemoveTaskIfInQueue(mTasks[i].get());
+      if(manager)
+         manager->CancelTask(mTasks[i].get());//blocks if active.
+      else
+         mTasks[i]->Cancel();
+      //release all data the derived class may have allocated
+      mTasks[i]->Terminate();
       mTasks[i].reset();
    }
 
@@ -306,7 +311,9 @@ void ODWaveTrackTaskQueue::RemoveFrontTask()
    mTasksMutex.Lock();
    if(mTasks.size())
    {
-      //wait for the task to stop running.
+      //wait for the task to stop running.  It is complete, so the worker that ran
+      //it last is at most finishing up.
+      ODManager::Instance()->CancelTask(mTasks[0].get());
       mTasks.erase(mTasks.begin());
    }
    mTasksMutex.Unlock();
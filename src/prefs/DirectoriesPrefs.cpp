@@ -18,6 +18,7 @@
 #include "../Audacity.h"
 
 #include <math.h>
+#include <algorithm>
 
 #include <wx/defs.h>
 #include <wx/intl.h>
@@ -35,7 +36,10 @@
 #include "../Prefs.h"
 #include "../AudacityApp.h"
 #include "../Internat.h"
+#include "../Sequence.h"
 #include "../ShuttleGui.h"
+#include "../blockfile/MappedFileCache.h"
+#include "../blockfile/PCMAliasFileCache.h"
 #include "DirectoriesPrefs.h"
 
 enum {
@@ -63,6 +67,14 @@ DirectoriesPrefs::~DirectoriesPrefs()
 /// Creates the dialog and its contents.
 void DirectoriesPrefs::Populate()
 {
+   // Megabytes per block file.  Larger blocks mean many fewer files for
+   // long recordings, but more to write again for each small edit.
+   static const int blockSizes[] = { 1, 4, 8, 16 };
+   for (auto size : blockSizes) {
+      mBlockSizeChoices.Add(wxString::Format(_("%d MB"), size));
+      mBlockSizeCodes.Add(size);
+   }
+
    //------------------------- Main section --------------------
    // Now construct the GUI itself.
    // Use 'eIsCreatingFromPrefs' so that the GUI is
@@ -100,6 +112,42 @@ void DirectoriesPrefs::PopulateOrExchange(ShuttleGui & S)
    }
    S.EndStatic();
 
+   S.StartStatic(_("Imported files"));
+   {
+      S.StartTwoColumn();
+      {
+         S.TieNumericTextBox(_("Maximum &open aliased files:"),
+                             wxT("/Directories/MaxOpenAliasedFiles"),
+                             (int)PCMAliasFileCache::DefaultMaxOpenFiles,
+                             9);
+      }
+      S.EndTwoColumn();
+   }
+   S.EndStatic();
+
+   S.StartStatic(_("Project files"));
+   {
+      S.StartTwoColumn();
+      {
+         if (MappedFileCache::Supported)
+            S.TieNumericTextBox(_("Memory for &mapped block files (MB):"),
+                                wxT("/Directories/MappedBlockFilesMB"),
+                                (int)MappedFileCache::DefaultMaxMegabytes,
+                                9);
+         S.TieChoice(_("&Block size for new projects:"),
+                     wxT("/Directories/BlockSizeMB"),
+                     1,
+                     mBlockSizeChoices,
+                     mBlockSizeCodes);
+         S.SetSizeHints(mBlockSizeChoices);
+      }
+      S.EndTwoColumn();
+
+      if (MappedFileCache::Supported)
+         S.AddVariableText(_("Set to 0 to read block files without mapping them into memory."));
+   }
+   S.EndStatic();
+
 #ifdef DEPRECATED_AUDIO_CACHE
    // See http://bugzilla.audacityteam.org/show_bug.cgi?id=545.
    S.StartStatic(_("Audio cache"));
@@ -261,6 +309,19 @@ bool DirectoriesPrefs::Apply()
    ShuttleGui S(this, eIsSavingToPrefs);
    PopulateOrExchange(S);
 
+   long maxOpenFiles = gPrefs->Read(wxT("/Directories/MaxOpenAliasedFiles"),
+                                    (long)PCMAliasFileCache::DefaultMaxOpenFiles);
+   PCMAliasFileCache::Get().SetMaxOpenFiles(std::max(0L, maxOpenFiles));
+
+   long mappedMegabytes = gPrefs->Read(wxT("/Directories/MappedBlockFilesMB"),
+                                       (long)MappedFileCache::DefaultMaxMegabytes);
+   MappedFileCache::Get().SetMaxBytes((size_t)std::max(0L, mappedMegabytes) << 20);
+
+   long blockMegabytes = gPrefs->Read(wxT("/Directories/BlockSizeMB"), 1L);
+   if (blockMegabytes < 1 || blockMegabytes > 16)
+      blockMegabytes = 1;
+   Sequence::SetMaxDiskBlockSize((size_t)blockMegabytes << 20);
+
    return true;
 }
 
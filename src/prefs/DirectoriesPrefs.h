@@ -35,6 +35,9 @@ class DirectoriesPrefs final : public PrefsPanel
    wxStaticText *mFreeSpace;
    wxTextCtrl *mTempDir;
 
+   wxArrayString mBlockSizeChoices;
+   wxArrayInt mBlockSizeCodes;
+
    DECLARE_EVENT_TABLE()
 };
 
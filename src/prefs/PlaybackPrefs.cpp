@@ -113,6 +113,21 @@ void PlaybackPrefs::PopulateOrExchange(ShuttleGui & S)
       S.EndThreeColumn();
    }
    S.EndStatic();
+
+   S.StartStatic(_("Mixing"));
+   {
+      S.StartThreeColumn();
+      {
+         // Takes effect at the next start of playback
+         w = S.TieNumericTextBox(_("Mixing &threads:"),
+                                 wxT("/AudioIO/MixerThreads"),
+                                 0,
+                                 9);
+         S.AddUnits(_("(0 for one per processor)"));
+      }
+      S.EndThreeColumn();
+   }
+   S.EndStatic();
 }
 
 bool PlaybackPrefs::Apply()
@@ -70,6 +70,14 @@ void ProjectsPrefs::PopulateOrExchange(ShuttleGui & S)
       S.EndRadioButtonGroup();
    }
    S.EndStatic();
+
+   S.StartStatic(_("Project file format"));
+   {
+      S.TieCheckBox(_("Save projects in &binary format (opens faster, but not in older versions of Audacity)"),
+                    wxT("/FileFormats/SaveProjectBinary"),
+                    false);
+   }
+   S.EndStatic();
 }
 
 bool ProjectsPrefs::Apply()
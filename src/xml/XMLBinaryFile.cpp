@@ -0,0 +1,642 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  XMLBinaryFile.cpp
+
+*******************************************************************//**
+
+\class XMLBinaryFileWriter
+\brief Writes the XML document of a project in a compact binary form,
+which XMLBinaryFileReader reads much faster than expat reads the text.
+
+*//****************************************************************//**
+
+\class XMLBinaryFileReader
+\brief Reads a file written by XMLBinaryFileWriter and passes the results
+through an XMLTagHandler, as XMLFileReader does for an XML file.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include "XMLBinaryFile.h"
+
+#include <wx/defs.h>
+#include <wx/intl.h>
+
+#include <climits>
+#include <string.h>
+
+#include "../Internat.h"
+#include "../blockfile/MappedFileCache.h"
+
+// Unlike the auto-save format (see AutoSaveFile), this one is meant to be
+// the saved project, and so to be moved between machines.  All numbers are
+// little-endian, of fixed sizes, and all strings are UTF-8.
+//
+//    ident             literal XMLBinaryIdent
+//    fields            the "encoded" XML document
+//
+// Each name (element or attribute) is written as a BT_Name field just
+// before its first use, and takes the next 2-byte identifier, counting from
+// zero.  The reader so decodes each name once, not once per element, and a
+// project with 100k block files needs only a handful of names.
+//
+// Attributes are written with the type the project code gives them, and
+// formatted as XMLWriter would write them only when read; the handlers see
+// the same strings as they would from the XML file.
+
+enum BinaryFieldTypes
+{
+   BT_Name = 1,      // type, name length (2), name
+   BT_StartTag,      // type, ID
+   BT_EndTag,        // type only
+   BT_String,        // type, ID, string length (4), string
+   BT_Integer,       // type, ID, value (8)
+   BT_Float,         // type, ID, value (4), digits (4)
+   BT_Double,        // type, ID, value (8), digits (4)
+   BT_Data,          // type, string length (4), string
+};
+
+///
+/// XMLBinaryFileWriter class
+///
+
+namespace {
+   // Bytes buffered before writing to the file
+   const size_t BufferSize = 64 * 1024;
+}
+
+XMLBinaryFileWriter::XMLBinaryFileWriter()
+{
+   mBuffer.reserve(BufferSize);
+}
+
+XMLBinaryFileWriter::~XMLBinaryFileWriter()
+{
+   if (mFile.IsOpened()) {
+      Close();
+   }
+}
+
+void XMLBinaryFileWriter::Open(const wxString &name)
+{
+   if (!mFile.Open(name, wxT("wb")))
+      throw XMLFileWriterException(_("Error Opening File"));
+
+   Put(XMLBinaryIdent, strlen(XMLBinaryIdent));
+}
+
+void XMLBinaryFileWriter::Close()
+{
+   while (mDepth > 0) {
+      EndTag(wxEmptyString);
+   }
+
+   Flush();
+
+   // As in XMLFileWriter::CloseWithoutEndingTags, try to close the file
+   // even if flushing fails.
+   if (!mFile.Flush())
+   {
+      mFile.Close();
+      /* i18n-hint: 'flushing' means writing any remaining queued up changes
+       * to disk that have not yet been written.*/
+      throw XMLFileWriterException(_("Error Flushing File"));
+   }
+
+   if (!mFile.Close())
+      throw XMLFileWriterException(_("Error Closing File"));
+}
+
+void XMLBinaryFileWriter::StartTag(const wxString &name)
+{
+   unsigned short id = GetNameId(name);
+
+   PutByte(BT_StartTag);
+   PutU16(id);
+
+   mDepth++;
+}
+
+void XMLBinaryFileWriter::EndTag(const wxString & WXUNUSED(name))
+{
+   // The reader knows which element is open
+   if (mDepth > 0) {
+      PutByte(BT_EndTag);
+      mDepth--;
+   }
+}
+
+void XMLBinaryFileWriter::WriteAttr(const wxString &name, const wxString &value)
+{
+   unsigned short id = GetNameId(name);
+
+   PutByte(BT_String);
+   PutU16(id);
+   WriteString(value);
+}
+
+void XMLBinaryFileWriter::WriteAttr(const wxString &name, const wxChar *value)
+{
+   WriteAttr(name, wxString(value));
+}
+
+void XMLBinaryFileWriter::WriteAttr(const wxString &name, int value)
+{
+   WriteInteger(name, value);
+}
+
+void XMLBinaryFileWriter::WriteAttr(const wxString &name, bool value)
+{
+   WriteInteger(name, value);
+}
+
+void XMLBinaryFileWriter::WriteAttr(const wxString &name, long value)
+{
+   WriteInteger(name, value);
+}
+
+void XMLBinaryFileWriter::WriteAttr(const wxString &name, long long value)
+{
+   WriteInteger(name, value);
+}
+
+void XMLBinaryFileWriter::WriteAttr(const wxString &name, size_t value)
+{
+   // Formatted as XMLWriter does
+   WriteInteger(name, (long long) value);
+}
+
+void XMLBinaryFileWriter::WriteAttr(const wxString &name, float value, int digits)
+{
+   unsigned short id = GetNameId(name);
+
+   unsigned int bits;
+   static_assert(sizeof(bits) == sizeof(value), "unexpected float size");
+   memcpy(&bits, &value, sizeof(bits));
+
+   PutByte(BT_Float);
+   PutU16(id);
+   PutU32(bits);
+   PutU32(digits);
+}
+
+void XMLBinaryFileWriter::WriteAttr(const wxString &name, double value, int digits)
+{
+   unsigned short id = GetNameId(name);
+
+   unsigned long long bits;
+   static_assert(sizeof(bits) == sizeof(value), "unexpected double size");
+   memcpy(&bits, &value, sizeof(bits));
+
+   PutByte(BT_Double);
+   PutU16(id);
+   PutU64(bits);
+   PutU32(digits);
+}
+
+void XMLBinaryFileWriter::WriteData(const wxString &value)
+{
+   PutByte(BT_Data);
+   WriteString(value);
+}
+
+void XMLBinaryFileWriter::WriteSubTree(const wxString &value)
+{
+   WriteData(value);
+}
+
+void XMLBinaryFileWriter::Write(const wxString &data)
+{
+   WriteData(data);
+}
+
+unsigned short XMLBinaryFileWriter::GetNameId(const wxString &name)
+{
+   XMLBinaryNameMap::const_iterator iter = mNames.find(name);
+   if (iter != mNames.end())
+      return iter->second;
+
+   const wxScopedCharBuffer utf8 = name.utf8_str();
+   const size_t len = utf8.length();
+   if (mNames.size() > USHRT_MAX || len > USHRT_MAX) {
+      wxASSERT(false);
+      mFile.Close();
+      throw XMLFileWriterException(_("Error Writing to File"));
+   }
+
+   unsigned short id = mNames.size();
+   mNames[name] = id;
+
+   PutByte(BT_Name);
+   PutU16(len);
+   Put(utf8.data(), len);
+
+   return id;
+}
+
+void XMLBinaryFileWriter::WriteInteger(const wxString &name, long long value)
+{
+   unsigned short id = GetNameId(name);
+
+   PutByte(BT_Integer);
+   PutU16(id);
+   PutU64(value);
+}
+
+void XMLBinaryFileWriter::WriteString(const wxString &value)
+{
+   const wxScopedCharBuffer utf8 = value.utf8_str();
+   const size_t len = utf8.length();
+
+   PutU32(len);
+   Put(utf8.data(), len);
+}
+
+void XMLBinaryFileWriter::Put(const void *data, size_t len)
+{
+   const char *bytes = static_cast<const char*>(data);
+   mBuffer.insert(mBuffer.end(), bytes, bytes + len);
+
+   if (mBuffer.size() >= BufferSize)
+      Flush();
+}
+
+void XMLBinaryFileWriter::PutByte(unsigned char value)
+{
+   Put(&value, 1);
+}
+
+void XMLBinaryFileWriter::PutU16(unsigned short value)
+{
+   const unsigned char bytes[2] = {
+      (unsigned char)(value), (unsigned char)(value >> 8) };
+   Put(bytes, sizeof(bytes));
+}
+
+void XMLBinaryFileWriter::PutU32(unsigned int value)
+{
+   PutU16(value);
+   PutU16(value >> 16);
+}
+
+void XMLBinaryFileWriter::PutU64(unsigned long long value)
+{
+   PutU32(value);
+   PutU32(value >> 32);
+}
+
+void XMLBinaryFileWriter::Flush()
+{
+   if (mBuffer.empty())
+      return;
+
+   if (mFile.Write(mBuffer.data(), mBuffer.size()) != mBuffer.size())
+   {
+      // When writing fails, we try to close the file before throwing the
+      // exception, so it can at least be deleted.
+      mFile.Close();
+      throw XMLFileWriterException(_("Error Writing to File"));
+   }
+
+   mBuffer.clear();
+}
+
+///
+/// XMLBinaryFileReader class
+///
+
+// Reads the fields from memory, failing at the end of the data instead of
+// reading past it
+class XMLBinaryFileReader::Input
+{
+ public:
+   Input(const char *start, const char *end)
+   : mStart{ start }, mPos{ start }, mEnd{ end } {}
+
+   bool AtEnd() const { return mPos == mEnd; }
+   size_t Offset() const { return mPos - mStart; }
+
+   bool GetByte(unsigned char &value)
+   {
+      if (mPos == mEnd)
+         return false;
+      value = *mPos++;
+      return true;
+   }
+
+   bool GetU16(unsigned short &value)
+   {
+      if (mEnd - mPos < 2)
+         return false;
+      const unsigned char *bytes = (const unsigned char *)mPos;
+      value = bytes[0] | (bytes[1] << 8);
+      mPos += 2;
+      return true;
+   }
+
+   bool GetU32(unsigned int &value)
+   {
+      unsigned short low, high;
+      if (!GetU16(low) || !GetU16(high))
+         return false;
+      value = low | ((unsigned int)high << 16);
+      return true;
+   }
+
+   bool GetU64(unsigned long long &value)
+   {
+      unsigned int low, high;
+      if (!GetU32(low) || !GetU32(high))
+         return false;
+      value = low | ((unsigned long long)high << 32);
+      return true;
+   }
+
+   bool GetString(size_t len, wxString &value)
+   {
+      if ((size_t)(mEnd - mPos) < len)
+         return false;
+      value = wxString::FromUTF8(mPos, len);
+      mPos += len;
+      return true;
+   }
+
+ private:
+   const char *const mStart;
+   const char *mPos;
+   const char *const mEnd;
+};
+
+namespace {
+   // As wxString::Format(wxT("%lld"), value), without the format parsing
+   void FormatInteger(long long value, wxString &result)
+   {
+      wxChar buffer[24];
+      wxChar *const end = buffer + WXSIZEOF(buffer);
+      wxChar *p = end;
+
+      unsigned long long magnitude =
+         value < 0 ? 0ull - (unsigned long long)value : value;
+      do {
+         *--p = wxT('0') + (magnitude % 10);
+         magnitude /= 10;
+      } while (magnitude);
+      if (value < 0)
+         *--p = wxT('-');
+
+      result.assign(p, end - p);
+   }
+}
+
+XMLBinaryFileReader::XMLBinaryFileReader()
+{
+   mBaseHandler = NULL;
+   mErrorStr = wxT("");
+   mHandler.reserve(128);
+   mTags.reserve(128);
+   mInTag = false;
+   mAttrCount = 0;
+}
+
+XMLBinaryFileReader::~XMLBinaryFileReader()
+{
+}
+
+bool XMLBinaryFileReader::Parse(XMLTagHandler *baseHandler,
+                                const wxString &fname)
+{
+   // Map the file if possible, else read it whole
+   std::unique_ptr<MappedFile> mapped{ MappedFile::Map(fname) };
+   std::vector<char> contents;
+   const char *data = NULL;
+   size_t size = 0;
+
+   if (mapped) {
+      data = mapped->GetData();
+      size = mapped->GetSize();
+   }
+   else {
+      wxFFile file(fname, wxT("rb"));
+      if (!file.IsOpened()) {
+         mErrorStr.Printf(_("Could not open file: \"%s\""), fname.c_str());
+         return false;
+      }
+
+      const wxFileOffset length = file.Length();
+      if (length > 0) {
+         contents.resize(length);
+         if (file.Read(contents.data(), length) != (size_t)length) {
+            mErrorStr.Printf(_("Could not open file: \"%s\""), fname.c_str());
+            return false;
+         }
+      }
+      data = contents.data();
+      size = contents.size();
+   }
+
+   const size_t identLen = strlen(XMLBinaryIdent);
+   if (size < identLen || memcmp(data, XMLBinaryIdent, identLen) != 0) {
+      mErrorStr.Printf(_("Could not load file: \"%s\""), fname.c_str());
+      return false;
+   }
+
+   mBaseHandler = baseHandler;
+
+   Input in{ data + identLen, data + size };
+   if (!Parse(in)) {
+      mErrorStr.Printf(_("Error: invalid project data at byte %lu"),
+                       (long unsigned int)(identLen + in.Offset()));
+      return false;
+   }
+
+   // Even though there were no parse errors, we only succeed if
+   // the first-level handler actually got called, and didn't
+   // return false.
+   if (mBaseHandler)
+      return true;
+   else {
+      mErrorStr.Printf(_("Could not load file: \"%s\""), fname.c_str());
+      return false;
+   }
+}
+
+wxString XMLBinaryFileReader::GetErrorStr()
+{
+   return mErrorStr;
+}
+
+bool XMLBinaryFileReader::Parse(Input &in)
+{
+   mNames.clear();
+   mHandler.clear();
+   mTags.clear();
+   mInTag = false;
+   mAttrCount = 0;
+
+   unsigned char type;
+   unsigned short id;
+
+   // Reads the identifier of an attribute's name
+   auto getId = [&] {
+      return mInTag && in.GetU16(id) && id < mNames.size();
+   };
+
+   while (in.GetByte(type)) {
+      switch (type)
+      {
+         case BT_Name:
+         {
+            unsigned short len;
+            wxString name;
+            if (mNames.size() > USHRT_MAX ||
+                !in.GetU16(len) || !in.GetString(len, name))
+               return false;
+            mNames.push_back(name);
+         }
+         break;
+
+         case BT_StartTag:
+         {
+            if (!in.GetU16(id) || id >= mNames.size())
+               return false;
+            if (mInTag)
+               StartElement();
+            mTags.push_back(id);
+            mInTag = true;
+            mAttrCount = 0;
+         }
+         break;
+
+         case BT_EndTag:
+         {
+            if (mInTag)
+               StartElement();
+            if (mTags.empty())
+               return false;
+            EndElement();
+         }
+         break;
+
+         case BT_String:
+         {
+            unsigned int len;
+            if (!getId() || !in.GetU32(len) ||
+                !in.GetString(len, NextAttr(id)))
+               return false;
+         }
+         break;
+
+         case BT_Integer:
+         {
+            unsigned long long value;
+            if (!getId() || !in.GetU64(value))
+               return false;
+            FormatInteger((long long)value, NextAttr(id));
+         }
+         break;
+
+         case BT_Float:
+         {
+            unsigned int bits, digits;
+            if (!getId() || !in.GetU32(bits) || !in.GetU32(digits))
+               return false;
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            NextAttr(id) = Internat::ToString(value, (int)digits);
+         }
+         break;
+
+         case BT_Double:
+         {
+            unsigned long long bits;
+            unsigned int digits;
+            if (!getId() || !in.GetU64(bits) || !in.GetU32(digits))
+               return false;
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            NextAttr(id) = Internat::ToString(value, (int)digits);
+         }
+         break;
+
+         case BT_Data:
+         {
+            unsigned int len;
+            wxString content;
+            if (mInTag)
+               StartElement();
+            if (mTags.empty() || !in.GetU32(len) || !in.GetString(len, content))
+               return false;
+            Content(content);
+         }
+         break;
+
+         default:
+            return false;
+      }
+   }
+
+   // A complete document closes all its elements
+   return !mInTag && mTags.empty();
+}
+
+wxString &XMLBinaryFileReader::NextAttr(unsigned short id)
+{
+   // The strings are reused from tag to tag, keeping their buffers
+   if (mAttrCount == mAttrValues.size()) {
+      mAttrNames.push_back(id);
+      mAttrValues.push_back(wxString{});
+   }
+   else
+      mAttrNames[mAttrCount] = id;
+
+   return mAttrValues[mAttrCount++];
+}
+
+void XMLBinaryFileReader::StartElement()
+{
+   mInTag = false;
+
+   mAttrs.clear();
+   for (size_t i = 0; i < mAttrCount; i++) {
+      mAttrs.push_back(mNames[mAttrNames[i]].c_str());
+      mAttrs.push_back(mAttrValues[i].c_str());
+   }
+   mAttrs.push_back(NULL);
+
+   const wxChar *tag = mNames[mTags.back()].c_str();
+
+   if (mHandler.empty()) {
+      mHandler.push_back(mBaseHandler);
+   }
+   else {
+      if (XMLTagHandler *const handler = mHandler.back())
+         mHandler.push_back(handler->HandleXMLChild(tag));
+      else
+         mHandler.push_back(NULL);
+   }
+
+   if (XMLTagHandler *& handler = mHandler.back()) {
+      if (!handler->HandleXMLTag(tag, mAttrs.data())) {
+         handler = nullptr;
+         if (mHandler.size() == 1)
+            mBaseHandler = nullptr;
+      }
+   }
+}
+
+void XMLBinaryFileReader::EndElement()
+{
+   if (XMLTagHandler *const handler = mHandler.back())
+      handler->HandleXMLEndTag(mNames[mTags.back()].c_str());
+
+   mHandler.pop_back();
+   mTags.pop_back();
+}
+
+void XMLBinaryFileReader::Content(const wxString &content)
+{
+   if (XMLTagHandler *const handler = mHandler.back())
+      handler->HandleXMLContent(content);
+}
@@ -0,0 +1,135 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  XMLBinaryFile.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_XML_BINARY_FILE__
+#define __AUDACITY_XML_BINARY_FILE__
+
+#include "../Audacity.h"
+
+#include <deque>
+#include <vector>
+#include <wx/ffile.h>
+#include <wx/hashmap.h>
+#include <wx/string.h>
+
+#include "XMLTagHandler.h"
+#include "XMLWriter.h"
+
+// The first bytes of a binary project file.  Like those of an XML project,
+// they begin with "<?xml ", and are as long as the signature that
+// AudacityProject::OpenFile reads.
+#define XMLBinaryIdent "<?xml aupbin 1>"
+
+WX_DECLARE_STRING_HASH_MAP_WITH_DECL(unsigned short, XMLBinaryNameMap,
+                                     class AUDACITY_DLL_API);
+
+///
+/// XMLBinaryFileWriter
+///
+class AUDACITY_DLL_API XMLBinaryFileWriter final : public XMLWriter {
+
+ public:
+
+   XMLBinaryFileWriter();
+   virtual ~XMLBinaryFileWriter();
+
+   /// Open the file and write the ident.
+   /// Might throw XMLFileWriterException.
+   void Open(const wxString &name);
+
+   /// End any open tags and close the file.
+   /// Might throw XMLFileWriterException.
+   void Close();
+
+   void StartTag(const wxString &name) override;
+   void EndTag(const wxString &name) override;
+
+   void WriteAttr(const wxString &name, const wxString &value) override;
+   void WriteAttr(const wxString &name, const wxChar *value) override;
+
+   void WriteAttr(const wxString &name, int value) override;
+   void WriteAttr(const wxString &name, bool value) override;
+   void WriteAttr(const wxString &name, long value) override;
+   void WriteAttr(const wxString &name, long long value) override;
+   void WriteAttr(const wxString &name, size_t value) override;
+   void WriteAttr(const wxString &name, float value, int digits = -1) override;
+   void WriteAttr(const wxString &name, double value, int digits = -1) override;
+
+   void WriteData(const wxString &value) override;
+
+   void WriteSubTree(const wxString &value) override;
+
+   /// There is no markup in this format, so text is kept as character data.
+   void Write(const wxString &data) override;
+
+ private:
+
+   // Writes the name to the dictionary on its first use
+   unsigned short GetNameId(const wxString &name);
+   void WriteInteger(const wxString &name, long long value);
+   void WriteString(const wxString &value);
+
+   void Put(const void *data, size_t len);
+   void PutByte(unsigned char value);
+   void PutU16(unsigned short value);
+   void PutU32(unsigned int value);
+   void PutU64(unsigned long long value);
+
+   void Flush();
+
+   wxFFile mFile;
+   std::vector<char> mBuffer;
+   XMLBinaryNameMap mNames;
+};
+
+///
+/// XMLBinaryFileReader
+///
+class AUDACITY_DLL_API XMLBinaryFileReader final {
+ public:
+   XMLBinaryFileReader();
+   ~XMLBinaryFileReader();
+
+   /// Calls the handlers as XMLFileReader::Parse would for the XML
+   /// document written to the XMLBinaryFileWriter.
+   bool Parse(XMLTagHandler *baseHandler,
+              const wxString &fname);
+
+   wxString GetErrorStr();
+
+ private:
+   class Input;
+
+   bool Parse(Input &in);
+
+   // Calls the handler of a start tag, once all its attributes are read
+   void StartElement();
+   void EndElement();
+   void Content(const wxString &content);
+   // Where to put the value of the next attribute of the start tag
+   wxString &NextAttr(unsigned short id);
+
+   XMLTagHandler   *mBaseHandler;
+   using Handlers = std::vector<XMLTagHandler*>;
+   Handlers mHandler;
+   // Names of the open elements, indices in mNames
+   std::vector<unsigned short> mTags;
+   wxString         mErrorStr;
+
+   // A deque, so that the strings don't move as names are added
+   std::deque<wxString> mNames;
+
+   // The start tag whose attributes are being read
+   bool mInTag;
+   std::vector<unsigned short> mAttrNames;
+   std::vector<wxString> mAttrValues;
+   size_t mAttrCount;
+   std::vector<const wxChar*> mAttrs;
+};
+
+#endif
@@ -13,6 +13,7 @@
 #include <wx/arrstr.h>
 #include <wx/dynarray.h>
 #include <wx/ffile.h>
+#include <string.h>
 
 ///
 /// XMLWriter
@@ -97,6 +98,50 @@ protected:
    wxString mMessage;
 };
 
+///
+/// XMLStamp
+///
+/// Combines values into a number that changes when any of them does, so
+/// that the GetXMLStamp functions can tell whether WriteXML would write
+/// anything different, without writing it
+///
+class XMLStamp final {
+
+ public:
+
+   XMLStamp() : mValue(0x9e3779b97f4a7c15ull) {}
+
+   XMLStamp &Add(unsigned long long value)
+   {
+      unsigned long long z = mValue ^ value;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      mValue = (z ^ (z >> 31)) + 0x9e3779b97f4a7c15ull;
+      return *this;
+   }
+
+   XMLStamp &AddDouble(double value)
+   {
+      unsigned long long bits;
+      memcpy(&bits, &value, sizeof(bits));
+      return Add(bits);
+   }
+
+   XMLStamp &AddString(const wxString &value)
+   {
+      Add(value.length());
+      for (const auto c : value)
+         Add((wxChar)c);
+      return *this;
+   }
+
+   unsigned long long Get() const { return mValue; }
+
+ private:
+
+   unsigned long long mValue;
+};
+
 ///
 /// XMLStringWriter
 ///
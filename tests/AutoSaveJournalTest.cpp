@@ -0,0 +1,327 @@
+#include "AutoRecovery.h"
+#include "DirManager.h"
+#include "Prefs.h"
+#include "WaveTrack.h"
+#include "xml/XMLFileReader.h"
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/init.h>
+#include <wx/sstream.h>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <cassert>
+#include <string.h>
+
+// Auto-saves tracks as AudacityProject::AutoSave does, appending records to
+// the file until they outgrow the checkpoint and a NEW one is written, and
+// reads each state back as recovery after a crash would.
+
+// Reads the project that the test writes: its wave tracks, and the records
+// of the journal, as AudacityProject::HandleXMLChild does
+class JournalProjectHandler final : public XMLTagHandler
+{
+public:
+   JournalProjectHandler(TrackFactory &factory, TrackList &tracks)
+   : mFactory(factory), mTracks(tracks)
+   {
+   }
+
+   bool HandleXMLTag(const wxChar *tag, const wxChar **) override
+   {
+      return !wxStrcmp(tag, wxT("project"));
+   }
+
+   XMLTagHandler *HandleXMLChild(const wxChar *tag) override
+   {
+      if (!wxStrcmp(tag, wxT("wavetrack")))
+         return mTracks.Add(mFactory.NewWaveTrack());
+
+      if (!wxStrcmp(tag, wxT("journal"))) {
+         if (!mJournal)
+            mJournal = std::make_unique<JournalRecoveryHandler>(
+               mTracks, *this, [](const wxChar *, const wxChar *) {});
+         return mJournal.get();
+      }
+
+      return NULL;
+   }
+
+private:
+   TrackFactory &mFactory;
+   TrackList &mTracks;
+   std::unique_ptr<JournalRecoveryHandler> mJournal;
+};
+
+class AutoSaveJournalTest
+{
+private:
+   std::shared_ptr<DirManager> mDirManager;
+   std::unique_ptr<TrackFactory> mFactory;
+   std::unique_ptr<TrackList> mTracks;
+   std::unique_ptr<AutoSaveJournal> mJournal;
+   wxString mFileName;
+
+public:
+   AutoSaveJournalTest()
+   {
+      std::cout << "==> Testing AutoSaveJournal\n";
+   }
+
+   void SetUp()
+   {
+      const wxString dir = wxFileName::GetTempDir() + wxFILE_SEP_PATH +
+                           wxT("autosave-journal-test-dir");
+      DirManager::SetTempDir(dir);
+      mDirManager = std::make_shared<DirManager>();
+      mFactory = std::unique_ptr<TrackFactory>
+         { safenew TrackFactory{ mDirManager, nullptr } };
+      mTracks = std::make_unique<TrackList>();
+      mJournal = std::make_unique<AutoSaveJournal>();
+      mFileName = wxFileName(wxFileName::GetTempDir(),
+         wxT("autosave-journal-test.autosave")).GetFullPath();
+
+      const double rate = 44100.0;
+      std::vector<float> buffer((size_t)rate);
+      unsigned seed = 1;
+      for (int i = 0; i < 3; i++) {
+         auto track = mFactory->NewWaveTrack(floatSample, rate);
+         track->SetName(wxString::Format(wxT("Journal %d"), i + 1));
+         for (int seconds = 0; seconds < 5; seconds++) {
+            for (auto &sample : buffer) {
+               seed = seed * 1664525u + 1013904223u;
+               sample = (seed >> 16) / 32768.0f - 1.0f;
+            }
+            track->Append((samplePtr)&buffer[0], floatSample, buffer.size());
+         }
+         track->Flush();
+         mTracks->Add(std::move(track));
+      }
+   }
+
+   void TearDown()
+   {
+      if (wxFileExists(mFileName))
+         wxRemoveFile(mFileName);
+      mJournal.reset();
+      mTracks.reset();
+      mFactory.reset();
+      mDirManager.reset();
+   }
+
+   void TestCheckpoint()
+   {
+      std::cout << "\tthe first auto-save should be a checkpoint, and recover the tracks..." << std::flush;
+
+      assert(!AutoSave());
+
+      TrackList recovered;
+      Recover(recovered);
+      assert(SameTracks(*mTracks, recovered));
+
+      std::cout << "ok\n";
+   }
+
+   void TestAppend()
+   {
+      std::cout << "\ta small change should append a record, and recover the tracks..." << std::flush;
+
+      TrackListIterator iter(mTracks.get());
+      const auto first = static_cast<WaveTrack*>(iter.First());
+      const auto second = static_cast<WaveTrack*>(iter.Next());
+
+      // Two of the three tracks change, so the record is smaller than the
+      // checkpoint
+      first->Clear(1.0, 2.0);
+      second->SetGain(0.5f);
+      assert(AutoSave());
+
+      TrackList recovered;
+      Recover(recovered);
+      assert(SameTracks(*mTracks, recovered));
+
+      std::cout << "ok\n";
+   }
+
+   void TestTruncated()
+   {
+      std::cout << "\ta record cut short should be ignored..." << std::flush;
+
+      TrackList before;
+      Recover(before);
+
+      TrackListIterator iter(mTracks.get());
+      iter.First();
+      const auto second = static_cast<WaveTrack*>(iter.Next());
+
+      const auto length = wxFileName::GetSize(mFileName).GetValue();
+      second->SetGain(0.25f);
+      assert(AutoSave());
+      const auto record = wxFileName::GetSize(mFileName).GetValue() - length;
+
+      TrackList recovered;
+      Recover(recovered, (size_t)record / 2);
+      assert(SameTracks(before, recovered));
+      assert(!SameTracks(*mTracks, recovered));
+
+      std::cout << "ok\n";
+   }
+
+   void TestCompaction()
+   {
+      std::cout << "\trecords outgrowing the checkpoint should write a new one, and recover the tracks..." << std::flush;
+
+      TrackListIterator iter(mTracks.get());
+      iter.First();
+      const auto second = static_cast<WaveTrack*>(iter.Next());
+
+      // Records of one change each, until they outgrow the checkpoint
+      for (int i = 1; AutoSave(); i++) {
+         assert(i <= 100);
+         second->SetGain(i / 64.0f);
+      }
+
+      TrackList recovered;
+      Recover(recovered);
+      assert(SameTracks(*mTracks, recovered));
+
+      std::cout << "ok\n";
+   }
+
+private:
+   static void WriteProjectStart(XMLWriter &xmlFile)
+   {
+      xmlFile.StartTag(wxT("project"));
+      xmlFile.WriteAttr(wxT("rate"), 44100.0);
+   }
+
+   // Appends a record to the file if the journal allows, else writes a NEW
+   // checkpoint, as AudacityProject::AutoSave does.  Returns whether a
+   // record was appended.
+   bool AutoSave()
+   {
+      AutoSaveJournal::State state;
+      WriteProjectStart(*state.head);
+      mJournal->WriteState(*mTracks, state);
+
+      if (mJournal->CanAppend(state)) {
+         AutoSaveFile record(AutoSaveJournal::PieceAllocSize);
+         mJournal->WriteRecord(record, state, [](XMLWriter &) {});
+         if (!mJournal->NeedsCompaction(record)) {
+            wxFFile file(mFileName, wxT("ab"));
+            const bool written =
+               file.IsOpened() && record.Append(file) && file.Flush();
+            assert(written);
+            mJournal->Appended(state, record);
+            return true;
+         }
+      }
+
+      AutoSaveFile buffer;
+      WriteProjectStart(buffer);
+      for (const auto &track : state.tracks)
+         buffer.WriteSubTree(*track.file);
+
+      wxFFile file(mFileName, wxT("wb"));
+      const bool written = file.IsOpened() && buffer.Write(file);
+      assert(written);
+      file.Close();
+      mJournal->Checkpoint(state, buffer.GetLength());
+      return false;
+   }
+
+   // Reads a copy of the auto-save, less its last cut bytes, into tracks
+   void Recover(TrackList &tracks, size_t cut = 0)
+   {
+      std::vector<char> bytes;
+      {
+         wxFFile file(mFileName, wxT("rb"));
+         assert(file.IsOpened());
+         bytes.resize((size_t)file.Length());
+         file.Read(&bytes[0], bytes.size());
+      }
+      bytes.resize(bytes.size() - cut);
+
+      const wxString copy = mFileName + wxT(".copy");
+      {
+         wxFFile file(copy, wxT("wb"));
+         file.Write(&bytes[0], bytes.size());
+      }
+
+      AutoSaveFile decoder;
+      const bool decoded = decoder.Decode(copy);
+      assert(decoded);
+
+      {
+         JournalProjectHandler handler(*mFactory, tracks);
+         XMLFileReader reader;
+         const bool parsed = reader.Parse(&handler, copy);
+         assert(parsed);
+      }
+
+      wxRemoveFile(copy);
+   }
+
+   // Whether the tracks have the same names, gains and samples
+   static bool SameTracks(TrackList &expected, TrackList &actual)
+   {
+      const size_t bufferLen = 65536;
+      std::vector<float> buffer1(bufferLen), buffer2(bufferLen);
+
+      TrackListIterator iter1(&expected), iter2(&actual);
+      Track *t1 = iter1.First(), *t2 = iter2.First();
+      for (; t1 && t2; t1 = iter1.Next(), t2 = iter2.Next()) {
+         if (t1->GetKind() != Track::Wave || t2->GetKind() != Track::Wave ||
+             t1->GetName() != t2->GetName())
+            return false;
+
+         const auto w1 = static_cast<WaveTrack*>(t1);
+         const auto w2 = static_cast<WaveTrack*>(t2);
+         if (w1->GetGain() != w2->GetGain() ||
+             w1->GetEndTime() != w2->GetEndTime())
+            return false;
+
+         const auto len =
+            w1->TimeToLongSamples(w1->GetEndTime()).as_long_long();
+         for (long long pos = 0; pos < len; pos += bufferLen) {
+            const size_t count = std::min<long long>(bufferLen, len - pos);
+            w1->Get((samplePtr)&buffer1[0], floatSample, pos, count);
+            w2->Get((samplePtr)&buffer2[0], floatSample, pos, count);
+            if (memcmp(&buffer1[0], &buffer2[0], count * sizeof(float)))
+               return false;
+         }
+      }
+
+      return !t1 && !t2;
+   }
+};
+
+int main()
+{
+   wxInitializer initializer;
+   if (!initializer.IsOk()) {
+      std::cerr << "Failed to initialize wxWidgets\n";
+      return 1;
+   }
+
+   // Default preferences, kept in memory and never written
+   wxStringInputStream noPrefs(wxEmptyString);
+   gPrefs = new wxFileConfig(noPrefs);
+
+   {
+      AutoSaveJournalTest tester;
+
+      tester.SetUp();
+      tester.TestCheckpoint();
+      tester.TestAppend();
+      tester.TestTruncated();
+      tester.TestCompaction();
+      tester.TearDown();
+   }
+
+   delete gPrefs;
+   gPrefs = NULL;
+
+   return 0;
+}
@@ -0,0 +1,502 @@
+#include "DirManager.h"
+#include "MemoryX.h"
+#include "Prefs.h"
+#include "RealFFTf.h"
+#include "Resample.h"
+#include "Sequence.h"
+#include <wx/filename.h>
+#include <wx/init.h>
+#include <wx/sstream.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Runs without a GUI what BenchmarkDialog::OnRun times -- random cut and
+// paste of chunks of a sequence, and reading it back -- and then block
+// file writing, mixing, Resample::Process, RealFFTf and
+// Sequence::GetWaveDisplay, and writes the results to standard output as
+// JSON, to be compared between builds.  It works on Sequence rather than
+// WaveTrack, because tracks need the rest of the program to link, and so
+// mixes as Mixer::Process does, from the library parts it uses.  Each
+// workload reports its throughput, the 50th and 99th percentiles of the
+// time of one operation, and the memory allocations made while it ran.
+// The edits are checked as in the dialog, and the exit status is 1 if any
+// check failed.
+
+// Counts every allocation made by the program, including those in
+// libaudacity and wxWidgets
+static std::atomic<size_t> gAllocations{ 0 };
+static std::atomic<size_t> gAllocatedBytes{ 0 };
+
+void *operator new(size_t size)
+{
+   ++gAllocations;
+   gAllocatedBytes += size;
+   if (void *p = malloc(size ? size : 1))
+      return p;
+   throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+   free(p);
+}
+
+class BenchmarkSuite
+{
+private:
+   enum {
+      TrackRate = 44100,
+      MixRate = 48000,
+      MixTracks = 4,
+      MixBufferSize = 4096,
+      FFTSize = 2048,
+      DisplayWidth = 1000,
+   };
+
+   using Clock = std::chrono::steady_clock;
+
+   struct Result {
+      std::string name;
+      const char *unit;
+      size_t operations;
+      double seconds;
+      double units;
+      std::vector<double> latencies;   // microseconds
+      size_t allocations;
+      size_t allocatedBytes;
+      bool ok;
+   };
+
+   size_t mMegabytes;
+   size_t mEdits;
+   long mSeed;
+   size_t mBlockKB;
+
+   std::shared_ptr<DirManager> mDirManager;
+   std::vector<Result> mResults;
+
+   // Times op(i) for each i in [0, count); op returns the number of units
+   // it processed, or a negative number if it failed
+   template<typename Op>
+   Result &Measure(const char *name, const char *unit, size_t count,
+                   const Op &op)
+   {
+      Result result{ name, unit, count, 0, 0, {}, 0, 0, true };
+      result.latencies.reserve(count);
+
+      const size_t allocations = gAllocations;
+      const size_t allocatedBytes = gAllocatedBytes;
+      const auto start = Clock::now();
+      for (size_t i = 0; i < count; i++) {
+         const auto before = Clock::now();
+         const double units = op(i);
+         const std::chrono::duration<double, std::micro> elapsed =
+            Clock::now() - before;
+         result.latencies.push_back(elapsed.count());
+         if (units < 0)
+            result.ok = false;
+         else
+            result.units += units;
+      }
+      const std::chrono::duration<double> elapsed = Clock::now() - start;
+      result.seconds = elapsed.count();
+      result.allocations = gAllocations - allocations;
+      result.allocatedBytes = gAllocatedBytes - allocatedBytes;
+
+      mResults.push_back(std::move(result));
+      return mResults.back();
+   }
+
+   std::unique_ptr<Sequence> NewSequence(sampleFormat format)
+   {
+      return std::make_unique<Sequence>(mDirManager, format);
+   }
+
+   // A sequence of the given length, of a sine of the given frequency
+   std::unique_ptr<Sequence> NewSineSequence(size_t length, double frequency)
+   {
+      auto sequence = NewSequence(floatSample);
+      std::vector<float> buffer(sequence->GetMaxBlockSize());
+      for (size_t pos = 0; pos < length; pos += buffer.size()) {
+         const auto len = std::min(buffer.size(), length - pos);
+         for (size_t i = 0; i < len; i++)
+            buffer[i] = (float)sin(2 * M_PI * frequency * (pos + i) / TrackRate);
+         sequence->Append((samplePtr)buffer.data(), floatSample, len);
+      }
+      return sequence;
+   }
+
+public:
+   BenchmarkSuite(size_t megabytes, size_t edits, long seed, size_t blockKB)
+   : mMegabytes(megabytes), mEdits(edits), mSeed(seed), mBlockKB(blockKB)
+   {
+      mDirManager = std::make_shared<DirManager>();
+   }
+
+   ~BenchmarkSuite()
+   {
+      mDirManager.reset();
+   }
+
+   // The workload of BenchmarkDialog::OnRun: a 16-bit sequence of chunks
+   // of constant value, cut and pasted at random, then checked and read
+   void TestEdits()
+   {
+      auto oldBlockSize = mDirManager->GetMaxDiskBlockSize();
+      mDirManager->SetMaxDiskBlockSize(mBlockKB * 1024);
+
+      auto seq = NewSequence(int16Sample);
+
+      srand(mSeed);
+
+      size_t chunkSize = 200 + (rand() % 100);
+      size_t nChunks = (mMegabytes * 1048576) / (chunkSize * sizeof(short));
+      while (nChunks < 20 || chunkSize > (mBlockKB * 1024) / 4) {
+         chunkSize = (chunkSize / 2) + (rand() % 100);
+         nChunks = (mMegabytes * 1048576) / (chunkSize * sizeof(short));
+      }
+
+      std::vector<short> small1(nChunks), small2(nChunks), block(chunkSize);
+      for (size_t i = 0; i < nChunks; i++) {
+         const short v = short(rand());
+         small1[i] = v;
+         std::fill(block.begin(), block.end(), v);
+         seq->Append((samplePtr)block.data(), int16Sample, chunkSize);
+      }
+
+      auto &edits = Measure("sequence_edit", "samples", mEdits,
+                            [&](size_t) -> double {
+         const size_t x0 = rand() % nChunks;
+         const size_t xlen = 1 + (rand() % (nChunks - x0));
+         const size_t y0 = rand() % std::max<size_t>(1, nChunks - xlen);
+
+         // Cut, by copying and deleting, and paste
+         std::unique_ptr<Sequence> tmp;
+         if (!seq->Copy(x0 * chunkSize, (x0 + xlen) * chunkSize, tmp) ||
+             !seq->Delete(x0 * chunkSize, xlen * chunkSize) ||
+             !seq->Paste(y0 * chunkSize, tmp.get()))
+            return -1;
+
+         // The same edit of the chunk values
+         const auto begin = small1.begin();
+         std::copy(begin + x0, begin + x0 + xlen, small2.begin());
+         std::copy(begin + x0 + xlen, small1.end(), begin + x0);
+         std::copy_backward(begin + y0, small1.end() - xlen, small1.end());
+         std::copy(small2.begin(), small2.begin() + xlen, begin + y0);
+
+         return double(xlen * chunkSize);
+      });
+
+      if (seq->GetNumSamples() != sampleCount(nChunks * chunkSize))
+         edits.ok = false;
+
+      // Merges the small blocks that the edits left, as the project does
+      // when idle; the checks below cover the result
+      Measure("sequence_compact", "bytes", 1, [&](size_t) -> double {
+         double bytes = 0;
+         while (const auto written = seq->Compact(~size_t(0)))
+            bytes += written;
+         return bytes;
+      });
+
+      // Checks the data after the edits, as the dialog does
+      for (int pass = 0; pass < 2; pass++) {
+         Measure(pass == 0 ? "sequence_check" : "sequence_reread",
+                 "samples", nChunks, [&](size_t i) -> double {
+            seq->Get((samplePtr)block.data(), int16Sample,
+                     i * chunkSize, chunkSize);
+            for (size_t b = 0; b < chunkSize; b++)
+               if (block[b] != small1[i])
+                  return -1;
+            return double(chunkSize);
+         });
+      }
+
+      mDirManager->SetMaxDiskBlockSize(oldBlockSize);
+   }
+
+   // Writes a float sequence a block at a time, then reads it back
+   void TestBlocks()
+   {
+      auto seq = NewSequence(floatSample);
+      const size_t blockSize = seq->GetMaxBlockSize();
+      const size_t nBlocks =
+         std::max<size_t>(1, (mMegabytes * 1048576) / (blockSize * sizeof(float)));
+
+      std::vector<float> buffer(blockSize);
+      for (size_t i = 0; i < blockSize; i++)
+         buffer[i] = rand() / (float)RAND_MAX - 0.5f;
+
+      Measure("block_write", "samples", nBlocks, [&](size_t) -> double {
+         if (!seq->Append((samplePtr)buffer.data(), floatSample, blockSize))
+            return -1;
+         return double(blockSize);
+      });
+
+      std::vector<float> in(blockSize);
+      Measure("block_read", "samples", nBlocks, [&](size_t i) -> double {
+         if (!seq->Get((samplePtr)in.data(), floatSample,
+                       i * blockSize, blockSize) || in != buffer)
+            return -1;
+         return double(blockSize);
+      });
+   }
+
+   // Mixes sequences down to stereo at another rate, as export does:
+   // what Mixer::MixVariableRates and Mixer::Process do for each track,
+   // reading float samples into a queue, applying the gain, resampling,
+   // and adding the result into each channel with its pan
+   void TestMixer()
+   {
+      const size_t length =
+         (mMegabytes * 1048576) / (MixTracks * sizeof(float));
+      const double factor = double(MixRate) / TrackRate;
+
+      struct Input {
+         std::unique_ptr<Sequence> sequence;
+         std::unique_ptr<Resample> resample;
+         std::vector<float> queue;
+         size_t queueStart, queueLen;
+         size_t pos;
+         float gains[2];
+      };
+      std::vector<Input> inputs(MixTracks);
+      for (size_t i = 0; i < MixTracks; i++) {
+         auto &input = inputs[i];
+         input.sequence = NewSineSequence(length, 220.0 * (i + 1));
+         input.resample = std::make_unique<Resample>(true, factor, factor);
+         input.queue.resize(MixBufferSize * 4);
+         input.queueStart = input.queueLen = input.pos = 0;
+         // Spread the tracks from left to right, at half volume
+         const float pan = float(i) / (MixTracks - 1);
+         input.gains[0] = 0.5f * (1.0f - pan);
+         input.gains[1] = 0.5f * pan;
+      }
+
+      std::vector<float> temp(MixBufferSize), out(2 * MixBufferSize);
+      const size_t count = size_t(length * factor) / MixBufferSize + 1;
+      Measure("mixer", "samples", count, [&](size_t) -> double {
+         std::fill(out.begin(), out.end(), 0.0f);
+         size_t maxOut = 0;
+         for (auto &input : inputs) {
+            size_t got = 0;
+            while (got < MixBufferSize) {
+               if (input.queueLen < MixBufferSize) {
+                  memmove(&input.queue[0], &input.queue[input.queueStart],
+                          input.queueLen * sizeof(float));
+                  input.queueStart = 0;
+                  const auto getLen = std::min(
+                     input.queue.size() - input.queueLen,
+                     length - input.pos);
+                  if (getLen > 0) {
+                     float *dest = &input.queue[input.queueLen];
+                     if (!input.sequence->Get((samplePtr)dest, floatSample,
+                                              input.pos, getLen))
+                        return -1;
+                     for (size_t i = 0; i < getLen; i++)
+                        dest[i] *= 0.8f;
+                     input.pos += getLen;
+                     input.queueLen += getLen;
+                  }
+               }
+
+               const bool last = input.queueLen < MixBufferSize;
+               const auto processLen =
+                  last ? input.queueLen : size_t(MixBufferSize);
+               const auto results = input.resample->Process(factor,
+                  &input.queue[input.queueStart], processLen, last,
+                  &temp[got], MixBufferSize - got);
+               input.queueStart += results.first;
+               input.queueLen -= results.first;
+               got += results.second;
+               if (last)
+                  break;
+            }
+
+            for (size_t i = 0; i < got; i++) {
+               out[2 * i    ] += input.gains[0] * temp[i];
+               out[2 * i + 1] += input.gains[1] * temp[i];
+            }
+            maxOut = std::max(maxOut, got);
+         }
+         return double(maxOut);
+      });
+   }
+
+   void TestResample()
+   {
+      const size_t length = (mMegabytes * 1048576) / sizeof(float);
+      const double factor = double(MixRate) / TrackRate;
+      Resample resample(true, factor, factor);
+
+      std::vector<float> in(length), out(MixBufferSize * 2);
+      for (size_t i = 0; i < length; i++)
+         in[i] = (float)sin(2 * M_PI * 440.0 * i / TrackRate);
+
+      size_t pos = 0;
+      const size_t count = length / MixBufferSize + 1;
+      Measure("resample", "samples", count, [&](size_t i) -> double {
+         const auto len = std::min<size_t>(MixBufferSize, length - pos);
+         const auto results = resample.Process(factor, &in[pos], len,
+                                               i + 1 == count,
+                                               out.data(), out.size());
+         pos += results.first;
+         return double(results.first);
+      });
+   }
+
+   void TestFFT()
+   {
+      HFFT hFFT = GetFFT(FFTSize);
+      std::vector<float> buffer(FFTSize);
+      const size_t count = (mMegabytes * 1048576) / (FFTSize * sizeof(float));
+      Measure("real_fft", "samples", count, [&](size_t) -> double {
+         for (size_t i = 0; i < FFTSize; i++)
+            buffer[i] = rand() / (float)RAND_MAX - 0.5f;
+         RealFFTf(buffer.data(), hFFT);
+         return FFTSize;
+      });
+      ReleaseFFT(hFFT);
+   }
+
+   // Summarizes a sequence for drawing at random zoom levels and
+   // positions, as WaveClip::GetWaveDisplay does when scrolling and zooming
+   void TestWaveDisplay()
+   {
+      const size_t length = (mMegabytes * 1048576) / sizeof(float);
+      auto seq = NewSineSequence(length, 440.0);
+
+      std::vector<float> min(DisplayWidth), max(DisplayWidth),
+         rms(DisplayWidth);
+      std::vector<int> bl(DisplayWidth);
+      std::vector<sampleCount> where(DisplayWidth + 1);
+      Measure("wave_display", "pixels", mEdits, [&](size_t) -> double {
+         // From a sample per pixel to the whole sequence in one screen
+         const double samplesPerPixel =
+            exp(log(double(length) / DisplayWidth) *
+                (rand() / (double)RAND_MAX));
+         const double first = (length - samplesPerPixel * DisplayWidth) *
+            (rand() / (double)RAND_MAX);
+         for (size_t i = 0; i <= DisplayWidth; i++)
+            where[i] = sampleCount(first + samplesPerPixel * i);
+
+         if (!seq->GetWaveDisplay(min.data(), max.data(), rms.data(),
+                                  bl.data(), DisplayWidth, where.data()))
+            return -1;
+         return DisplayWidth;
+      });
+   }
+
+   bool Failed() const
+   {
+      for (const auto &result : mResults)
+         if (!result.ok)
+            return true;
+      return false;
+   }
+
+   static double Percentile(std::vector<double> latencies, double p)
+   {
+      if (latencies.empty())
+         return 0;
+      const size_t n = std::min(latencies.size() - 1,
+                                size_t(p * latencies.size()));
+      std::nth_element(latencies.begin(), latencies.begin() + n,
+                       latencies.end());
+      return latencies[n];
+   }
+
+   void WriteJSON(std::ostream &out) const
+   {
+      out << std::fixed << std::setprecision(3);
+      out << "{\n"
+          << "  \"suite\": \"BenchmarkSuite\",\n"
+          << "  \"parameters\": { \"megabytes\": " << mMegabytes
+          << ", \"edits\": " << mEdits
+          << ", \"seed\": " << mSeed
+          << ", \"block_kb\": " << mBlockKB << " },\n"
+          << "  \"results\": [";
+      const char *separator = "\n";
+      for (const auto &result : mResults) {
+         out << separator
+             << "    { \"name\": \"" << result.name << "\""
+             << ", \"operations\": " << result.operations
+             << ", \"seconds\": " << result.seconds
+             << ", \"throughput\": "
+             << (result.seconds > 0 ? result.units / result.seconds : 0)
+             << ", \"unit\": \"" << result.unit << "/s\""
+             << ", \"p50_us\": " << Percentile(result.latencies, 0.50)
+             << ", \"p99_us\": " << Percentile(result.latencies, 0.99)
+             << ", \"allocations\": " << result.allocations
+             << ", \"allocated_bytes\": " << result.allocatedBytes
+             << ", \"ok\": " << (result.ok ? "true" : "false") << " }";
+         separator = ",\n";
+      }
+      out << "\n  ],\n"
+          << "  \"ok\": " << (Failed() ? "false" : "true") << "\n"
+          << "}\n";
+   }
+};
+
+// usage: BenchmarkSuite [megabytes [edits [seed [block KB [scratch dir]]]]]
+// The block size applies to the edits, to compare the default of 1024 KB
+// with the large blocks that projects may choose.  The block files go in
+// the scratch directory, by default one in TMPDIR or the system's.
+int main(int argc, char **argv)
+{
+   size_t megabytes = argc > 1 ? atoi(argv[1]) : 32;
+   size_t edits = argc > 2 ? atoi(argv[2]) : 100;
+   long seed = argc > 3 ? atol(argv[3]) : 234657;
+   size_t blockKB = argc > 4 ? atoi(argv[4]) : 64;
+
+   if (megabytes < 1 || megabytes > 2000 || edits < 1 || edits > 10000 ||
+       blockKB < 1 || blockKB > 16384) {
+      std::cerr << "usage: BenchmarkSuite [megabytes (1 - 2000) "
+                   "[edits (1 - 10000) [seed [block KB (1 - 16384) "
+                   "[scratch dir]]]]]\n";
+      return 2;
+   }
+
+   wxInitializer initializer;
+   if (!initializer.IsOk()) {
+      std::cerr << "Failed to initialize wxWidgets\n";
+      return 1;
+   }
+
+   // Default preferences, kept in memory and never written
+   wxStringInputStream noPrefs(wxEmptyString);
+   gPrefs = new wxFileConfig(noPrefs);
+   gPrefs->Write(wxT("/GUI/EditClipCanMove"), false);
+
+   bool failed;
+   {
+      const wxString scratch = argc > 5
+         ? wxString::FromUTF8(argv[5])
+         : wxFileName::GetTempDir() + wxFILE_SEP_PATH +
+              wxT("benchmark-suite-dir");
+      DirManager::SetTempDir(scratch);
+      BenchmarkSuite suite(megabytes, edits, seed, blockKB);
+      suite.TestEdits();
+      suite.TestBlocks();
+      suite.TestMixer();
+      suite.TestResample();
+      suite.TestFFT();
+      suite.TestWaveDisplay();
+      suite.WriteJSON(std::cout);
+      failed = suite.Failed();
+   }
+
+   delete gPrefs;
+   gPrefs = NULL;
+
+   return failed ? 1 : 0;
+}
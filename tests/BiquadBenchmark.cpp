@@ -0,0 +1,243 @@
+
+#include "effects/Biquad.h"
+#include "effects/BiquadCascade.h"
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+#include <stdlib.h>
+
+// Times cascades of biquads such as the Classic Filters effect applies,
+// filtered one section of one channel at a time by Biquad_Process, as
+// the effect did, and by BiquadCascade at each vector level that the
+// processor supports.  The blocks vary in length, some shorter than the
+// chains of sections, to exercise the state carried between calls.
+//
+// Biquad_Process is in direct form I, so its rounding differs a little
+// from the cascade's transposed direct form II.  The vector levels do
+// the same operations as the scalar cascade, and must match it closely
+// also when the coefficients change from block to block.
+
+class BiquadBenchmark
+{
+private:
+   enum { Length = 1 << 16 };
+
+   struct Case {
+      const char *name;
+      unsigned nChannels;
+      unsigned nSections;
+   };
+
+   std::vector<float> mInput;
+   size_t mRepeats;
+   bool mFailed{ false };
+
+   // A lowpass section after the RBJ cookbook, with the Q of each
+   // section different so that the cascade is not symmetric
+   static BiquadStruct Lowpass(double frequency, double q)
+   {
+      const double w = 2 * M_PI * frequency / 44100;
+      const double alpha = sin(w) / (2 * q);
+      const double a0 = 1 + alpha;
+      BiquadStruct biquad{};
+      biquad.fNumerCoeffs[0] = (1 - cos(w)) / 2 / a0;
+      biquad.fNumerCoeffs[1] = (1 - cos(w)) / a0;
+      biquad.fNumerCoeffs[2] = (1 - cos(w)) / 2 / a0;
+      biquad.fDenomCoeffs[0] = -2 * cos(w) / a0;
+      biquad.fDenomCoeffs[1] = (1 - alpha) / a0;
+      return biquad;
+   }
+
+   static BiquadStruct Section(unsigned section, unsigned block)
+   {
+      return Lowpass(1000 + 50 * (block % 7), 0.6 + 0.3 * section);
+   }
+
+   // The length of each block, cycling through short and long ones
+   static size_t BlockLength(size_t block)
+   {
+      static const size_t lengths[] = { 4093, 1, 2, 1500, 3, 8192, 5 };
+      return lengths[block % (sizeof(lengths) / sizeof(*lengths))];
+   }
+
+   typedef std::vector<std::vector<float>> Channels;
+
+   // Each channel is the input scaled differently
+   Channels Input(const Case &c)
+   {
+      Channels channels(c.nChannels, mInput);
+      for (unsigned channel = 0; channel < c.nChannels; channel++)
+         for (auto &sample : channels[channel])
+            sample *= 1.0f - 0.1f * channel;
+      return channels;
+   }
+
+   double TimeBiquadProcess(const Case &c, Channels &out)
+   {
+      std::vector<BiquadStruct> biquads(c.nChannels * c.nSections);
+      double elapsed = 0;
+      for (size_t repeat = 0; repeat < mRepeats; repeat++) {
+         out = Input(c);
+         for (unsigned channel = 0; channel < c.nChannels; channel++)
+            for (unsigned section = 0; section < c.nSections; section++)
+               biquads[channel * c.nSections + section] = Section(section, 0);
+         auto start = std::chrono::steady_clock::now();
+         size_t block = 0;
+         for (size_t pos = 0; pos < Length; pos += BlockLength(block++)) {
+            const auto len = std::min<size_t>(BlockLength(block), Length - pos);
+            for (unsigned channel = 0; channel < c.nChannels; channel++)
+               for (unsigned section = 0; section < c.nSections; section++) {
+                  auto &biquad = biquads[channel * c.nSections + section];
+                  biquad.pfIn = biquad.pfOut = &out[channel][pos];
+                  Biquad_Process(&biquad, len);
+               }
+         }
+         std::chrono::duration<double> time =
+            std::chrono::steady_clock::now() - start;
+         elapsed += time.count();
+      }
+      return elapsed;
+   }
+
+   double TimeCascade(const Case &c, BiquadCascade::VectorLevel level,
+                      bool changing, Channels &out)
+   {
+      BiquadCascade cascade;
+      cascade.SetVectorLevel(level);
+      std::vector<float *> pointers(c.nChannels);
+      double elapsed = 0;
+      for (size_t repeat = 0; repeat < mRepeats; repeat++) {
+         out = Input(c);
+         cascade.Configure(c.nChannels, c.nSections);
+         for (unsigned section = 0; section < c.nSections; section++)
+            cascade.SetSection(section, Section(section, 0));
+         auto start = std::chrono::steady_clock::now();
+         size_t block = 0;
+         for (size_t pos = 0; pos < Length; pos += BlockLength(block++)) {
+            const auto len = std::min<size_t>(BlockLength(block), Length - pos);
+            if (changing)
+               for (unsigned section = 0; section < c.nSections; section++)
+                  cascade.SetSection(section, Section(section, block));
+            for (unsigned channel = 0; channel < c.nChannels; channel++)
+               pointers[channel] = &out[channel][pos];
+            cascade.Process(pointers.data(), pointers.data(), len);
+         }
+         std::chrono::duration<double> time =
+            std::chrono::steady_clock::now() - start;
+         elapsed += time.count();
+      }
+      return elapsed;
+   }
+
+   // The largest difference relative to the largest sample expected
+   static double Difference(const Channels &expected, const Channels &out)
+   {
+      double peak = 0, diff = 0;
+      for (size_t channel = 0; channel < expected.size(); channel++)
+         for (size_t i = 0; i < Length; i++) {
+            peak = std::max<double>(peak, fabs(expected[channel][i]));
+            diff = std::max<double>(diff,
+               fabs(expected[channel][i] - out[channel][i]));
+         }
+      return peak > 0 ? diff / peak : diff;
+   }
+
+   void Check(const char *what, bool ok)
+   {
+      if (!ok) {
+         std::cout << "\tFAILED: " << what << "\n";
+         mFailed = true;
+      }
+   }
+
+   static const char *LevelName(BiquadCascade::VectorLevel level)
+   {
+      switch (level) {
+      case BiquadCascade::SSE2: return "SSE2";
+      case BiquadCascade::AVX2: return "AVX2";
+      default: return "scalar";
+      }
+   }
+
+public:
+   BiquadBenchmark(size_t repeats)
+   : mInput(Length), mRepeats(repeats)
+   {
+      srand(1);
+      for (auto &sample : mInput)
+         sample = 2.0f * (rand() / (float)RAND_MAX - 0.5f);
+   }
+
+   void Run()
+   {
+      // Classic Filters has up to five sections, for order ten
+      static const Case cases[] = {
+         { "mono, order 2", 1, 1 },
+         { "mono, order 6", 1, 3 },
+         { "mono, order 10", 1, 5 },
+         { "stereo, order 4", 2, 2 },
+         { "stereo, order 10", 2, 5 },
+         { "8 channels, order 2", 8, 1 },
+      };
+
+      std::cout << "==> Benchmarking biquad cascades, "
+                << mRepeats << " x " << Length << " samples per channel\n";
+      std::cout << "\tcascade               engine         Msamples/s   speedup\n";
+
+      for (const auto &c : cases) {
+         Channels reference;
+         double serial = TimeBiquadProcess(c, reference);
+         Report(c, "Biquad_Process", serial, serial);
+
+         Channels scalar, scalarChanging;
+         Report(c, "scalar",
+                TimeCascade(c, BiquadCascade::Scalar, false, scalar), serial);
+         Check("scalar cascade differs from Biquad_Process",
+               Difference(reference, scalar) < 1e-4);
+         TimeCascade(c, BiquadCascade::Scalar, true, scalarChanging);
+
+         for (int level = BiquadCascade::Scalar + 1;
+              level < BiquadCascade::nVectorLevels; level++) {
+            const auto vectorLevel = (BiquadCascade::VectorLevel)level;
+            if (!BiquadCascade::IsSupported(vectorLevel))
+               continue;
+
+            Channels out;
+            Report(c, LevelName(vectorLevel),
+                   TimeCascade(c, vectorLevel, false, out), serial);
+            Check("vector cascade differs from scalar",
+                  Difference(scalar, out) < 1e-6);
+
+            TimeCascade(c, vectorLevel, true, out);
+            Check("vector cascade differs from scalar as coefficients change",
+                  Difference(scalarChanging, out) < 1e-6);
+         }
+      }
+   }
+
+   void Report(const Case &c, const char *engine, double elapsed,
+               double serial)
+   {
+      std::cout << "\t" << std::left << std::setw(22) << c.name
+                << std::setw(15) << engine << std::right
+                << std::setw(10) << std::fixed << std::setprecision(1)
+                << mRepeats * Length * c.nChannels / elapsed / 1e6
+                << std::setw(10) << std::setprecision(2)
+                << serial / elapsed << "\n";
+   }
+
+   bool Failed() const { return mFailed; }
+};
+
+// usage: BiquadBenchmark [repeats]
+int main(int argc, char **argv)
+{
+   size_t repeats = argc > 1 ? atoi(argv[1]) : 20;
+
+   BiquadBenchmark benchmark(repeats);
+   benchmark.Run();
+
+   return benchmark.Failed() ? 1 : 0;
+}
@@ -0,0 +1,73 @@
+#include "DirManager.h"
+#include "Prefs.h"
+#include "Track.h"
+#include "effects/NoiseReduction.h"
+#include <wx/filename.h>
+#include <wx/init.h>
+#include <wx/sstream.h>
+#include <iostream>
+#include <cassert>
+
+// Reduces noise in one track on this thread and in segments on a pool of
+// threads, as EffectNoiseReduction::Process does for long selections, and
+// requires the same samples, bit for bit.
+
+class NoiseReductionTest
+{
+private:
+   std::shared_ptr<DirManager> mDirManager;
+
+public:
+   NoiseReductionTest()
+   {
+      std::cout << "==> Testing EffectNoiseReduction\n";
+   }
+
+   void SetUp()
+   {
+      DirManager::SetTempDir(wxFileName::GetTempDir() + wxFILE_SEP_PATH +
+                             wxT("noise-reduction-test-dir"));
+      mDirManager = std::make_shared<DirManager>();
+   }
+
+   void TearDown()
+   {
+      mDirManager.reset();
+   }
+
+   void TestParallel()
+   {
+      std::cout << "\treducing noise on a pool should give exactly the samples of one thread..." << std::flush;
+
+      TrackFactory factory{ mDirManager, nullptr };
+      assert(EffectNoiseReduction::CheckParallel(factory));
+
+      std::cout << "ok\n";
+   }
+};
+
+int main()
+{
+   wxInitializer initializer;
+   if (!initializer.IsOk()) {
+      std::cerr << "Failed to initialize wxWidgets\n";
+      return 1;
+   }
+
+   // Default preferences, kept in memory and never written
+   wxStringInputStream noPrefs(wxEmptyString);
+   gPrefs = new wxFileConfig(noPrefs);
+
+   {
+      NoiseReductionTest tester;
+
+      tester.SetUp();
+      tester.TestParallel();
+      tester.TearDown();
+   }
+
+   delete gPrefs;
+   gPrefs = NULL;
+
+   return 0;
+}
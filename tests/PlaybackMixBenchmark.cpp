@@ -0,0 +1,157 @@
+
+#include "RingBuffer.h"
+#include "WorkerPool.h"
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+// Times the playback half of AudioIO::FillBuffers without an audio device:
+// every track has a source of 16-bit samples, standing in for its block
+// files, and a ring buffer.  Each pass converts, applies a gain and
+// resamples a chunk of every track into its ring buffer, on one thread
+// and then on WorkerPools of increasing size, and the rings are emptied
+// between passes as the PortAudio callback would.  The mixed output of
+// every pool size must match that of the single thread.
+
+class PlaybackMixBenchmark
+{
+private:
+   enum {
+      SourceRate = 44100,
+      PlaybackRate = 48000,
+      ChunkSize = 4096,    // about what FillBuffers asks for at once
+   };
+
+   struct Track {
+      std::vector<short> source;
+      double position;
+      float gain;
+      double checksum;
+      RingBuffer ring;
+
+      Track(size_t length, float gain_)
+      : source(length), position(0), gain(gain_), checksum(0),
+        ring(floatSample, PlaybackRate)
+      {
+         for (auto &sample : source)
+            sample = (short)(rand() - RAND_MAX / 2);
+      }
+   };
+
+   size_t mNumTracks;
+   size_t mChunks;
+   bool mFailed{ false };
+
+public:
+   PlaybackMixBenchmark(size_t numTracks, double seconds)
+   : mNumTracks(numTracks)
+   , mChunks((size_t)(seconds * PlaybackRate / ChunkSize) + 1)
+   {
+      std::cout << "==> Benchmarking playback mixing of " << mNumTracks
+                << " tracks, " << seconds << " s of audio\n";
+   }
+
+   // What Mixer::Process does for one track: format conversion, gain
+   // and resampling, written straight into the free space of the ring
+   static void MixTrack(Track &track)
+   {
+      const double step = (double)SourceRate / PlaybackRate;
+      const auto length = track.source.size();
+
+      auto regions = track.ring.GetWritableRegions(ChunkSize);
+      for (const auto &region : regions) {
+         auto dest = (float*)region.ptr;
+         for (size_t i = 0; i < region.len; i++) {
+            auto pos = track.position;
+            auto index = (size_t)pos;
+            auto frac = (float)(pos - index);
+            auto a = track.source[index % length] / 32768.0f;
+            auto b = track.source[(index + 1) % length] / 32768.0f;
+            dest[i] = track.gain * (a + frac * (b - a));
+            track.position = pos + step;
+         }
+      }
+      track.ring.Produced(regions.Total());
+   }
+
+   // Returns seconds of wall time
+   double Run(size_t nThreads, std::vector<double> &checksums)
+   {
+      // The same sources every run
+      srand(1);
+      std::vector<std::unique_ptr<Track>> tracks;
+      for (size_t i = 0; i < mNumTracks; i++)
+         tracks.push_back(std::make_unique<Track>(10 * SourceRate,
+                                                  1.0f / (i + 1)));
+
+      WorkerPool pool(nThreads);
+      std::vector<float> out(ChunkSize);
+
+      auto start = std::chrono::steady_clock::now();
+      for (size_t chunk = 0; chunk < mChunks; chunk++) {
+         pool.ForEach(mNumTracks, [&](size_t ii) {
+            MixTrack(*tracks[ii]);
+         });
+
+         // The callback's share of the work
+         for (auto &track : tracks) {
+            auto got = track->ring.Get((samplePtr)out.data(), floatSample,
+                                       ChunkSize);
+            for (size_t i = 0; i < got; i++)
+               track->checksum += out[i];
+         }
+      }
+      std::chrono::duration<double> elapsed =
+         std::chrono::steady_clock::now() - start;
+
+      checksums.clear();
+      for (auto &track : tracks)
+         checksums.push_back(track->checksum);
+      return elapsed.count();
+   }
+
+   void TestScaling(size_t maxThreads)
+   {
+      std::vector<double> expected, checksums;
+      double serial = 0;
+      const double audioSeconds = (double)mChunks * ChunkSize / PlaybackRate;
+
+      std::cout << "\tthreads    seconds   x realtime   speedup\n";
+      for (size_t nThreads = 1; nThreads <= maxThreads; nThreads *= 2) {
+         double elapsed = Run(nThreads, nThreads == 1 ? expected : checksums);
+         if (nThreads == 1)
+            serial = elapsed;
+         else if (checksums != expected) {
+            std::cout << "\tFAILED: output with " << nThreads
+                      << " threads differs\n";
+            mFailed = true;
+         }
+         std::cout << "\t" << std::setw(7) << nThreads
+                   << std::setw(11) << std::fixed << std::setprecision(3)
+                   << elapsed
+                   << std::setw(13) << std::setprecision(1)
+                   << audioSeconds / elapsed
+                   << std::setw(10) << std::setprecision(2)
+                   << serial / elapsed << "\n";
+      }
+   }
+
+   bool Failed() const { return mFailed; }
+};
+
+// usage: PlaybackMixBenchmark [tracks [seconds [max threads]]]
+int main(int argc, char **argv)
+{
+   size_t numTracks = argc > 1 ? atoi(argv[1]) : 64;
+   double seconds = argc > 2 ? atof(argv[2]) : 5.0;
+   size_t maxThreads = argc > 3
+      ? atoi(argv[3])
+      : std::max<size_t>(4, WorkerPool::GetProcessorCount());
+
+   PlaybackMixBenchmark benchmark(numTracks, seconds);
+   benchmark.TestScaling(maxThreads);
+
+   return benchmark.Failed() ? 1 : 0;
+}
@@ -0,0 +1,180 @@
+
+#include "RingBuffer.h"
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include <stdlib.h>
+
+// Plays the parts of AudioIO: a producer thread that fills the buffer in
+// bursts of uneven cost, as FillBuffers does, and a consumer that drains a
+// fixed amount on a fixed period, as the PortAudio callback does.  Each
+// sample holds its own index, so lost or repeated samples are caught.
+
+class RingBufferTest
+{
+private:
+   enum {
+      BufferSize = 44100,         // one second, as AudioIO sizes them
+      FramesPerCallback = 512,
+      CallbackPeriodUs = 2000,
+      BurstSize = 4096,
+   };
+
+   std::atomic<bool> mStop{ false };
+   unsigned long long mUnderruns{ 0 };
+   unsigned long long mConsumed{ 0 };
+   bool mCorrupt{ false };
+
+public:
+   RingBufferTest()
+   {
+      std::cout << "==> Testing RingBuffer\n";
+      srand(time(NULL));
+   }
+
+   void TestWrapAround()
+   {
+      std::cout << "\tregions should cover wrapped spans exactly..." << std::flush;
+
+      RingBuffer rb(floatSample, 100);
+      std::vector<float> in(70), out(100);
+      float next = 0, expected = 0;
+      for (int round = 0; round < 50; round++) {
+         size_t n = std::min<size_t>(rand() % 70, rb.AvailForPut());
+         for (size_t i = 0; i < n; i++)
+            in[i] = next++;
+         if (rb.Put((samplePtr)in.data(), floatSample, n) != n) {
+            std::cout << "FAILED: short Put\n";
+            mCorrupt = true;
+            return;
+         }
+         auto regions = rb.GetReadableRegions(rand() % 70);
+         size_t total = 0;
+         for (const auto &region : regions)
+            for (size_t i = 0; i < region.len; i++, total++)
+               if (((float*)region.ptr)[i] != expected++) {
+                  std::cout << "FAILED: wrong sample at " << expected - 1 << "\n";
+                  mCorrupt = true;
+                  return;
+               }
+         rb.Consumed(total);
+      }
+      size_t rest = rb.AvailForGet();
+      if (rb.Get((samplePtr)out.data(), floatSample, rest) != rest ||
+          rb.AvailForGet() != 0 || rb.AvailForPut() != 96) {
+         std::cout << "FAILED: wrong count after draining\n";
+         mCorrupt = true;
+         return;
+      }
+      std::cout << "ok\n";
+   }
+
+   void Producer(RingBuffer &rb)
+   {
+      float next = 0;
+      while (!mStop) {
+         // Uneven work per fill, as when mixing tracks of differing cost
+         std::this_thread::sleep_for(
+            std::chrono::microseconds(rand() % (4 * CallbackPeriodUs)));
+
+         auto regions = rb.GetWritableRegions(BurstSize);
+         for (const auto &region : regions)
+            for (size_t i = 0; i < region.len; i++)
+               ((float*)region.ptr)[i] = next++;
+         rb.Produced(regions.Total());
+      }
+   }
+
+   void Consumer(RingBuffer &rb)
+   {
+      float expected = 0;
+      std::vector<float> buffer(FramesPerCallback);
+      auto wake = std::chrono::steady_clock::now();
+      while (!mStop) {
+         wake += std::chrono::microseconds(CallbackPeriodUs);
+         std::this_thread::sleep_until(wake);
+
+         size_t got = rb.Get((samplePtr)buffer.data(), floatSample,
+                             FramesPerCallback);
+         if (got < FramesPerCallback)
+            mUnderruns++;
+         for (size_t i = 0; i < got; i++)
+            if (buffer[i] != expected++)
+               mCorrupt = true;
+         mConsumed += got;
+      }
+   }
+
+   void TestStress(int seconds)
+   {
+      std::cout << "\tproducer and consumer threads should never lose a sample..." << std::flush;
+
+      RingBuffer rb(floatSample, BufferSize);
+      mStop = false;
+      std::thread producer([&]{ Producer(rb); });
+      std::thread consumer([&]{ Consumer(rb); });
+
+      std::this_thread::sleep_for(std::chrono::seconds(seconds));
+      mStop = true;
+      producer.join();
+      consumer.join();
+
+      if (mCorrupt)
+         std::cout << "FAILED: samples lost or repeated\n";
+      else
+         std::cout << "ok\n";
+      std::cout << "\t" << mConsumed << " samples in " << seconds << " s, "
+                << mUnderruns << " underruns\n";
+   }
+
+   void TestThroughput()
+   {
+      std::cout << "\tbulk transfer rate..." << std::flush;
+
+      RingBuffer rb(floatSample, BufferSize);
+      const size_t total = 200 * BufferSize;
+      std::thread consumer([&]{
+         size_t got = 0;
+         while (got < total) {
+            auto regions = rb.GetReadableRegions(BurstSize);
+            if (regions.Total() == 0)
+               std::this_thread::yield();
+            rb.Consumed(regions.Total());
+            got += regions.Total();
+         }
+      });
+
+      std::vector<float> buffer(BurstSize);
+      auto start = std::chrono::steady_clock::now();
+      size_t put = 0;
+      while (put < total) {
+         auto n = rb.Put((samplePtr)buffer.data(), floatSample,
+                         std::min<size_t>(BurstSize, total - put));
+         if (n == 0)
+            std::this_thread::yield();
+         put += n;
+      }
+      consumer.join();
+      std::chrono::duration<double> elapsed =
+         std::chrono::steady_clock::now() - start;
+
+      std::cout << (total / elapsed.count() / 1e6) << " Msamples/s\n";
+   }
+
+   bool Failed() const { return mCorrupt; }
+};
+
+int main(int argc, char **argv)
+{
+   int seconds = argc > 1 ? atoi(argv[1]) : 2;
+
+   RingBufferTest tester;
+   tester.TestWrapAround();
+   tester.TestStress(seconds);
+   tester.TestThroughput();
+
+   return tester.Failed() ? 1 : 0;
+}
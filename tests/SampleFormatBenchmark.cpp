@@ -0,0 +1,204 @@
+
+#include "Dither.h"
+#include "SampleFormatSIMD.h"
+#include <chrono>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Times every conversion of Dither::Apply on contiguous samples, through
+// the scalar loops and through the vectorized converters of each level
+// that the processor supports.  Without dither the vectorized output
+// must equal the scalar output exactly.  With rectangle or triangle
+// dither the noise differs, so the output must instead stay within the
+// noise's bounds of the undithered output, and average out to it.
+
+class SampleFormatBenchmark
+{
+private:
+   enum { Length = 1 << 16 };
+
+   struct Case {
+      const char *name;
+      sampleFormat from, to;
+   };
+
+   std::vector<float> mFloats;
+   std::vector<int> mInt24s;
+   std::vector<short> mInt16s;
+   size_t mRepeats;
+   bool mFailed{ false };
+
+   samplePtr Source(sampleFormat format)
+   {
+      switch (format) {
+      case int16Sample: return (samplePtr)mInt16s.data();
+      case int24Sample: return (samplePtr)mInt24s.data();
+      default: return (samplePtr)mFloats.data();
+      }
+   }
+
+   // The value of sample i of an integer buffer
+   static long Value(const std::vector<char> &buffer, sampleFormat format,
+                     size_t i)
+   {
+      return format == int16Sample
+         ? ((const short *)buffer.data())[i]
+         : ((const int *)buffer.data())[i];
+   }
+
+   double Time(Dither &dither, Dither::DitherType type, const Case &c,
+               std::vector<char> &out)
+   {
+      out.assign(Length * SAMPLE_SIZE(c.to), 0);
+      auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < mRepeats; i++)
+         dither.Apply(type, Source(c.from), c.from,
+                      (samplePtr)out.data(), c.to, Length);
+      std::chrono::duration<double> elapsed =
+         std::chrono::steady_clock::now() - start;
+      return elapsed.count();
+   }
+
+   void Check(const char *what, bool ok)
+   {
+      if (!ok) {
+         std::cout << "\tFAILED: " << what << "\n";
+         mFailed = true;
+      }
+   }
+
+public:
+   SampleFormatBenchmark(size_t repeats)
+   : mFloats(Length), mInt24s(Length), mInt16s(Length), mRepeats(repeats)
+   {
+      srand(1);
+      for (size_t i = 0; i < Length; i++) {
+         // Some samples beyond full scale, to exercise the clipping
+         mFloats[i] = 2.2f * (rand() / (float)RAND_MAX - 0.5f);
+         mInt24s[i] = (rand() % (1 << 24)) - (1 << 23);
+         mInt16s[i] = (short)(rand() - RAND_MAX / 2);
+      }
+      // Full scale and exact halves, where rounding matters
+      mFloats[0] = 1.0f;
+      mFloats[1] = -1.0f;
+      mFloats[2] = 0.5f / 32768;
+      mFloats[3] = 1.5f / 32768;
+      mInt24s[0] = 8388607;
+      mInt24s[1] = -8388608;
+      mInt24s[2] = 128;
+      mInt24s[3] = 384;
+   }
+
+   void Run()
+   {
+      static const Case cases[] = {
+         { "int16 -> float", int16Sample, floatSample },
+         { "int24 -> float", int24Sample, floatSample },
+         { "int16 -> int24", int16Sample, int24Sample },
+         { "float -> int16", floatSample, int16Sample },
+         { "float -> int24", floatSample, int24Sample },
+         { "int24 -> int16", int24Sample, int16Sample },
+      };
+      static const struct {
+         const char *name;
+         Dither::DitherType type;
+      } dithers[] = {
+         { "none", Dither::none },
+         { "rectangle", Dither::rectangle },
+         { "triangle", Dither::triangle },
+      };
+
+      std::cout << "==> Benchmarking sample format conversions, "
+                << mRepeats << " x " << Length << " samples\n";
+      std::cout << "\tconversion       dither       vectorized   Msamples/s   speedup\n";
+
+      const auto best = SampleConverters::GetBestLevel();
+
+      for (const auto &c : cases) {
+         const bool dithering = c.to != floatSample &&
+            !(c.from == int16Sample && c.to == int24Sample);
+         for (const auto &d : dithers) {
+            if (!dithering && d.type != Dither::none)
+               continue;
+
+            Dither scalar;
+            scalar.SetVectorLevel(SampleConverters::Scalar);
+            std::vector<char> expected, reference, out;
+            double serial = Time(scalar, d.type, c, expected);
+            if (d.type != Dither::none) {
+               Dither undithered;
+               undithered.SetVectorLevel(SampleConverters::Scalar);
+               Time(undithered, Dither::none, c, reference);
+            }
+            Report(c.name, d.name, "scalar", serial, serial);
+
+            for (int level = SampleConverters::Scalar + 1;
+                 level <= best; level++) {
+               const auto vectorLevel = (SampleConverters::VectorLevel)level;
+               const auto converters = SampleConverters::Get(vectorLevel);
+               if (!converters)
+                  continue;
+
+               Dither vectorized;
+               vectorized.SetVectorLevel(vectorLevel);
+               double elapsed = Time(vectorized, d.type, c, out);
+               Report(c.name, d.name, converters->name, elapsed, serial);
+
+               if (d.type == Dither::none)
+                  Check(c.name, out == expected);
+               else
+                  CheckDithered(c, d.type == Dither::triangle, reference, out);
+            }
+         }
+      }
+   }
+
+   // Rectangle noise is within half a step, so the rounded output is
+   // within one step of the undithered output; triangle noise is within
+   // one step, so the output is within two
+   void CheckDithered(const Case &c, bool triangle,
+                      const std::vector<char> &reference,
+                      const std::vector<char> &out)
+   {
+      const long bound = triangle ? 2 : 1;
+      double sum = 0;
+      bool ok = true;
+      for (size_t i = 0; i < Length; i++) {
+         const long diff =
+            Value(out, c.to, i) - Value(reference, c.to, i);
+         ok = ok && labs(diff) <= bound;
+         sum += diff;
+      }
+      Check("dither noise out of bounds", ok);
+      Check("dither noise has an offset", fabs(sum / Length) < 0.05);
+   }
+
+   void Report(const char *conversion, const char *dither,
+               const char *level, double elapsed, double serial)
+   {
+      std::cout << "\t" << std::left << std::setw(17) << conversion
+                << std::setw(13) << dither
+                << std::setw(11) << level << std::right
+                << std::setw(12) << std::fixed << std::setprecision(1)
+                << mRepeats * Length / elapsed / 1e6
+                << std::setw(10) << std::setprecision(2)
+                << serial / elapsed << "\n";
+   }
+
+   bool Failed() const { return mFailed; }
+};
+
+// usage: SampleFormatBenchmark [repeats]
+int main(int argc, char **argv)
+{
+   size_t repeats = argc > 1 ? atoi(argv[1]) : 100;
+
+   SampleFormatBenchmark benchmark(repeats);
+   benchmark.Run();
+
+   return benchmark.Failed() ? 1 : 0;
+}
@@ -2,8 +2,10 @@
 #include "Sequence.h"
 #include "DirManager.h"
 #include <wx/hash.h>
+#include <set>
 #include <vector>
 #include <iostream>
+#include <cmath>
 
 class SequenceTest
 {
@@ -131,6 +133,135 @@ public:
       std::cout << "ok\n";
    }
 
+   void TestStatistics()
+   {
+      std::cout << "\tSequence::GetMean() and GetClipCount() should agree with the samples..." << std::flush;
+
+      /* Several blocks, so that regions have whole blocks in the middle
+       * and partial ones at the ends */
+      int appendBufLen = (int)(mSequence->GetMaxBlockSize() * 1.4);
+      SampleBuffer appendBuf(appendBufLen, floatSample);
+      float *samples = (float *)appendBuf.ptr();
+      int i;
+
+      /* A sample clips at the largest 16 bit value, not only at 1.0, so
+       * put some samples at that level and just below it */
+      const float clipLevel = 32767.0f / 32768.0f;
+      const float belowClipLevel = nextafterf(clipLevel, 0.0f);
+
+      for(i = 0; i < 5; i++) {
+         for(int j = 0; j < appendBufLen; j++) {
+            switch (rand() % 50) {
+            case 0: samples[j] = clipLevel; break;
+            case 1: samples[j] = -clipLevel; break;
+            case 2: samples[j] = belowClipLevel; break;
+            case 3: samples[j] = -belowClipLevel; break;
+            default: samples[j] = (rand() % 2001 - 1000) / 1000.0f; break;
+            }
+            mMemorySequence.push_back(samples[j]);
+         }
+         mSequence->Append(appendBuf.ptr(), floatSample, appendBufLen);
+      }
+
+      for(i = 0; i < 10; i++)
+      {
+         int s0 = rand()%mSequence->GetNumSamples().as_long_long();
+         int len = 1 + rand()%(mSequence->GetNumSamples().as_long_long() - s0);
+
+         double sum = 0.0;
+         long long clips = 0;
+         for(int j = s0; j < s0 + len; j++) {
+            sum += mMemorySequence[j];
+            if (fabs(mMemorySequence[j]) >= clipLevel)
+               clips++;
+         }
+
+         double mean;
+         sampleCount count;
+         assert(mSequence->GetMean(s0, len, &mean));
+         assert(fabs(mean - sum / len) < 1e-9);
+         assert(mSequence->GetClipCount(s0, len, &count));
+         assert(count == clips);
+      }
+
+      std::cout << "ok\n";
+   }
+
+   void TestCompact()
+   {
+      std::cout << "\tSequence::Compact() should merge small blocks up to the maximum and keep the samples..." << std::flush;
+
+      const int maxBlock = (int)mSequence->GetMaxBlockSize();
+      // Blocks under half the maximum are small
+      const int minBlock = maxBlock / 2;
+
+      int appendBufLen = (int)(maxBlock * 1.4);
+      SampleBuffer appendBuf(appendBufLen, floatSample);
+      float *samples = (float *)appendBuf.ptr();
+      int i;
+
+      for(i = 0; i < 5; i++) {
+         for(int j = 0; j < appendBufLen; j++)
+            samples[j] = (rand() % 2001 - 1000) / 1000.0f;
+         mSequence->Append(appendBuf.ptr(), floatSample, appendBufLen);
+      }
+
+      /* Deletions leave small blocks at both ends of each gap */
+      for(i = 0; i < 10; i++) {
+         int del = rand()%mSequence->GetNumSamples().as_long_long();
+         int dellen = rand()%(maxBlock / 4);
+         if (del + dellen > mSequence->GetNumSamples().as_long_long())
+            dellen = 0;
+         mSequence->Delete(del, dellen);
+      }
+
+      const int len = (int)mSequence->GetNumSamples().as_long_long();
+      std::vector<float> before(len), after(len);
+      assert(mSequence->Get((samplePtr)&before[0], floatSample, 0, len));
+      const size_t blocksBefore = mSequence->GetBlockArray().size();
+
+      /* Blocks that something else uses are left as they are */
+      std::set<const BlockFile*> inUse;
+      for(const auto &block : mSequence->GetBlockArray())
+         inUse.insert(&*block.f);
+      assert(mSequence->Compact(len * sizeof(float), &inUse) == 0);
+      assert(mSequence->GetBlockArray().size() == blocksBefore);
+
+      /* The smallest budget still makes one merge */
+      size_t bytes = mSequence->Compact(1);
+      assert(bytes > 0);
+      assert(mSequence->GetBlockArray().size() < blocksBefore);
+      assert(mSequence->Get((samplePtr)&after[0], floatSample, 0, len));
+      assert(before == after);
+
+      /* Then there is enough budget for all of it */
+      mSequence->Compact(len * sizeof(float));
+      assert(mSequence->GetNumSamples() == len);
+      assert(mSequence->Get((samplePtr)&after[0], floatSample, 0, len));
+      assert(before == after);
+
+      /* No block is too long, and no small block has a neighbour that it
+       * would fit with */
+      const BlockArray &blocks = mSequence->GetBlockArray();
+      sampleCount start = 0;
+      for(size_t b = 0; b < blocks.size(); b++) {
+         const int length = (int)blocks[b].f->GetLength();
+         assert(blocks[b].start == start);
+         assert(length <= maxBlock);
+         if (b + 1 < blocks.size()) {
+            const int next = (int)blocks[b + 1].f->GetLength();
+            if (length < minBlock || next < minBlock)
+               assert(length + next > maxBlock);
+         }
+         start += length;
+      }
+
+      /* Nothing is left to do */
+      assert(mSequence->Compact(len * sizeof(float)) == 0);
+
+      std::cout << "ok\n";
+   }
+
 };
 
 int main()
@@ -149,6 +280,14 @@ int main()
    tester.TestGetGarbageInput();
    tester.TearDown();
 
+   tester.SetUp();
+   tester.TestStatistics();
+   tester.TearDown();
+
+   tester.SetUp();
+   tester.TestCompact();
+   tester.TearDown();
+
    return 0;
 }
 
@@ -0,0 +1,151 @@
+#include "DirManager.h"
+#include "Prefs.h"
+#include "WaveTrack.h"
+#include "WaveTrackStatistics.h"
+#include "WorkerPool.h"
+#include <wx/filename.h>
+#include <wx/init.h>
+#include <wx/sstream.h>
+#include <algorithm>
+#include <vector>
+#include <iostream>
+#include <cassert>
+#include <cmath>
+
+// Compares WaveTrackStatistics, with and without a pool, with what
+// WaveTrack::GetMinMax, GetRMS and GetMean give, over ranges that cover
+// clips, parts of clips, gaps, and clips that they only touch.
+
+class WaveTrackStatisticsTest
+{
+private:
+   std::shared_ptr<DirManager> mDirManager;
+   std::unique_ptr<TrackFactory> mFactory;
+   std::unique_ptr<WaveTrack> mTrack;
+
+public:
+   WaveTrackStatisticsTest()
+   {
+      std::cout << "==> Testing WaveTrackStatistics\n";
+   }
+
+   void SetUp()
+   {
+      DirManager::SetTempDir(wxFileName::GetTempDir() + wxFILE_SEP_PATH +
+                             wxT("wavetrack-statistics-test-dir"));
+      mDirManager = std::make_shared<DirManager>();
+      mFactory = std::unique_ptr<TrackFactory>
+         { safenew TrackFactory{ mDirManager, nullptr } };
+
+      const double rate = 44100.0;
+      mTrack = mFactory->NewWaveTrack(floatSample, rate);
+
+      // Clips at 0 - 1.5, 2 - 3 and 3 - 3.5 seconds, the last two touching;
+      // each of its own range of values, so that a spurious zero would show
+      struct ClipSpec { double offset, duration; float lo, hi; };
+      const ClipSpec specs[] = {
+         { 0.0, 1.5, -0.5f, 0.5f },
+         { 2.0, 1.0, -0.9f, 0.1f },
+         { 3.0, 0.5, 0.2f, 0.8f },
+      };
+      unsigned seed = 1;
+      for (const auto &spec : specs) {
+         WaveClip *const clip = mTrack->CreateClip();
+         clip->SetOffset(spec.offset);
+         std::vector<float> samples((size_t)(spec.duration * rate));
+         for (auto &sample : samples) {
+            seed = seed * 1664525u + 1013904223u;
+            sample = spec.lo + (spec.hi - spec.lo) * (seed >> 8) / 16777216.0f;
+         }
+         clip->Append((samplePtr)&samples[0], floatSample, samples.size());
+         clip->Flush();
+      }
+   }
+
+   void TearDown()
+   {
+      mTrack.reset();
+      mFactory.reset();
+      mDirManager.reset();
+   }
+
+   void TestCompute()
+   {
+      std::cout << "\tstatistics should match those of the track..." << std::flush;
+
+      WaveTrackStatistics statistics;
+      AddRanges(statistics);
+      statistics.Compute();
+      Check(statistics);
+
+      std::cout << "ok\n";
+   }
+
+   void TestComputeInPool()
+   {
+      std::cout << "\tstatistics computed in a pool should match those of the track..." << std::flush;
+
+      WorkerPool pool{ 4 };
+      WaveTrackStatistics statistics;
+      AddRanges(statistics);
+      statistics.Compute(pool);
+      Check(statistics);
+
+      std::cout << "ok\n";
+   }
+
+private:
+   void AddRanges(WaveTrackStatistics &statistics)
+   {
+      const std::pair<double, double> ranges[] = {
+         { 0.0, 4.0 }, { 0.25, 1.0 }, { 1.0, 2.5 }, { 1.5, 2.0 },
+         { 2.9, 3.1 }, { 3.0, 3.25 }, { 3.5, 4.0 }, { 1.7, 1.8 },
+      };
+      for (const auto &range : ranges)
+         statistics.Add(mTrack.get(), range.first, range.second);
+   }
+
+   void Check(const WaveTrackStatistics &statistics)
+   {
+      for (size_t i = 0; i < statistics.size(); i++) {
+         const auto &range = statistics[i];
+         float min, max, rms;
+         double mean;
+         mTrack->GetMinMax(&min, &max, range.t0, range.t1);
+         mTrack->GetRMS(&rms, range.t0, range.t1);
+         const bool haveMean = mTrack->GetMean(&mean, range.t0, range.t1);
+
+         assert(range.min == min);
+         assert(range.max == max);
+         assert(fabs(range.rms - rms) <= 1e-4 * std::max(1.0f, rms));
+         assert(!haveMean || fabs(range.mean - mean) <= 1e-7);
+      }
+   }
+};
+
+int main()
+{
+   wxInitializer initializer;
+   if (!initializer.IsOk()) {
+      std::cerr << "Failed to initialize wxWidgets\n";
+      return 1;
+   }
+
+   // Default preferences, kept in memory and never written
+   wxStringInputStream noPrefs(wxEmptyString);
+   gPrefs = new wxFileConfig(noPrefs);
+
+   {
+      WaveTrackStatisticsTest tester;
+
+      tester.SetUp();
+      tester.TestCompute();
+      tester.TestComputeInPool();
+      tester.TearDown();
+   }
+
+   delete gPrefs;
+   gPrefs = NULL;
+
+   return 0;
+}
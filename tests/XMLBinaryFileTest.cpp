@@ -0,0 +1,183 @@
+#include "xml/XMLBinaryFile.h"
+#include "xml/XMLFileReader.h"
+#include "xml/XMLWriter.h"
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/init.h>
+#include <vector>
+#include <iostream>
+#include <cassert>
+
+// Writes one document as XML and in the binary form, reads each back with
+// its reader, and requires the handlers to be called with the same tags and
+// attribute strings in the same order.
+
+// Records each start tag, attribute and end tag it is called with, for the
+// element and all its children.  The content of the XML file is only the
+// indentation, which the binary form leaves out, so it is not recorded.
+class RecordingHandler final : public XMLTagHandler
+{
+public:
+   RecordingHandler(std::vector<wxString> &events)
+   : mEvents(events)
+   {
+   }
+
+   bool HandleXMLTag(const wxChar *tag, const wxChar **attrs) override
+   {
+      mEvents.push_back(wxString(wxT("<")) + tag);
+      while (*attrs) {
+         const wxChar *attr = *attrs++;
+         const wxChar *value = *attrs++;
+         if (!value)
+            break;
+         mEvents.push_back(wxString(attr) + wxT("=") + value);
+      }
+      return true;
+   }
+
+   void HandleXMLEndTag(const wxChar *tag) override
+   {
+      mEvents.push_back(wxString(wxT("</")) + tag);
+   }
+
+   XMLTagHandler *HandleXMLChild(const wxChar *) override
+   {
+      return this;
+   }
+
+private:
+   std::vector<wxString> &mEvents;
+};
+
+class XMLBinaryFileTest
+{
+private:
+   wxString mXMLFileName;
+   wxString mBinaryFileName;
+
+public:
+   XMLBinaryFileTest()
+   {
+      std::cout << "==> Testing XMLBinaryFile\n";
+   }
+
+   void SetUp()
+   {
+      mXMLFileName = wxFileName(wxFileName::GetTempDir(),
+         wxT("xml-binary-file-test.xml")).GetFullPath();
+      mBinaryFileName = wxFileName(wxFileName::GetTempDir(),
+         wxT("xml-binary-file-test.aupbin")).GetFullPath();
+   }
+
+   void TearDown()
+   {
+      if (wxFileExists(mXMLFileName))
+         wxRemoveFile(mXMLFileName);
+      if (wxFileExists(mBinaryFileName))
+         wxRemoveFile(mBinaryFileName);
+   }
+
+   void TestRoundTrip()
+   {
+      std::cout << "\treading the binary form should give the tags and attributes of the XML..." << std::flush;
+
+      XMLFileWriter xmlFile;
+      xmlFile.Open(mXMLFileName, wxT("wb"));
+      WriteDocument(xmlFile);
+      xmlFile.Close();
+
+      XMLBinaryFileWriter binaryFile;
+      binaryFile.Open(mBinaryFileName);
+      WriteDocument(binaryFile);
+      binaryFile.Close();
+
+      std::vector<wxString> xmlEvents;
+      {
+         RecordingHandler handler(xmlEvents);
+         XMLFileReader reader;
+         const bool parsed = reader.Parse(&handler, mXMLFileName);
+         assert(parsed);
+      }
+
+      std::vector<wxString> binaryEvents;
+      {
+         RecordingHandler handler(binaryEvents);
+         XMLBinaryFileReader reader;
+         const bool parsed = reader.Parse(&handler, mBinaryFileName);
+         assert(parsed);
+      }
+
+      assert(!xmlEvents.empty());
+      assert(xmlEvents == binaryEvents);
+
+      std::cout << "ok\n";
+   }
+
+private:
+   // A project-like document with attributes of every type, strings that
+   // need escaping, and many elements of the same names
+   static void WriteDocument(XMLWriter &xmlFile)
+   {
+      xmlFile.StartTag(wxT("project"));
+      xmlFile.WriteAttr(wxT("xmlns"), wxT("http://audacity.sourceforge.net/xml/"));
+      xmlFile.WriteAttr(wxT("projname"), wxString(wxT("a < b & \"c\" > 'd'")));
+      xmlFile.WriteAttr(wxT("title"),
+         wxString::FromUTF8("caf\xc3\xa9 \xe2\x99\xab"));
+      xmlFile.WriteAttr(wxT("rate"), 44100.0);
+      xmlFile.WriteAttr(wxT("sel0"), 1.0 / 3.0, 10);
+      xmlFile.WriteAttr(wxT("snapto"), true);
+
+      for (int t = 0; t < 3; t++) {
+         xmlFile.StartTag(wxT("wavetrack"));
+         xmlFile.WriteAttr(wxT("name"), wxString::Format(wxT("Track %d"), t));
+         xmlFile.WriteAttr(wxT("channel"), t - 1);
+         xmlFile.WriteAttr(wxT("linked"), false);
+         xmlFile.WriteAttr(wxT("gain"), 0.1f * (t + 1));
+         xmlFile.WriteAttr(wxT("pan"), -0.25f, 3);
+
+         xmlFile.StartTag(wxT("waveclip"));
+         xmlFile.WriteAttr(wxT("offset"), 0.5 * t, 8);
+         xmlFile.StartTag(wxT("sequence"));
+         xmlFile.WriteAttr(wxT("maxsamples"), (size_t)262144);
+         xmlFile.WriteAttr(wxT("numsamples"), (long long)1 << 40);
+         for (long b = 0; b < 1000; b++) {
+            xmlFile.StartTag(wxT("waveblock"));
+            xmlFile.WriteAttr(wxT("start"), b * 262144L);
+            xmlFile.StartTag(wxT("simpleblockfile"));
+            xmlFile.WriteAttr(wxT("filename"),
+               wxString::Format(wxT("e%07lx.au"), b + 1000 * t));
+            xmlFile.WriteAttr(wxT("min"), -1.0f / (b + 1));
+            xmlFile.WriteAttr(wxT("max"), 1.0f / (b + 1));
+            xmlFile.EndTag(wxT("simpleblockfile"));
+            xmlFile.EndTag(wxT("waveblock"));
+         }
+         xmlFile.EndTag(wxT("sequence"));
+         xmlFile.StartTag(wxT("envelope"));
+         xmlFile.WriteAttr(wxT("numpoints"), 0);
+         xmlFile.EndTag(wxT("envelope"));
+         xmlFile.EndTag(wxT("waveclip"));
+
+         xmlFile.EndTag(wxT("wavetrack"));
+      }
+
+      xmlFile.EndTag(wxT("project"));
+   }
+};
+
+int main()
+{
+   wxInitializer initializer;
+   if (!initializer.IsOk()) {
+      std::cerr << "Failed to initialize wxWidgets\n";
+      return 1;
+   }
+
+   XMLBinaryFileTest tester;
+
+   tester.SetUp();
+   tester.TestRoundTrip();
+   tester.TearDown();
+
+   return 0;
+}